@@ -466,6 +466,11 @@ void EditorComponent::Load()
 
 	loadmodel_workload.priority = wi::jobsystem::Priority::Low;
 
+	if (main->config.GetSection("options").Has("history_budget"))
+	{
+		historyMemoryBudget = size_t(std::max(1, main->config.GetSection("options").GetInt("history_budget"))) * 1024ull * 1024ull;
+	}
+
 	loadmodel_font.SetText("Loading model...");
 	loadmodel_font.anim.typewriter.time = 2;
 	loadmodel_font.anim.typewriter.looped = true;
@@ -2859,10 +2864,9 @@ void EditorComponent::Update(float dt)
 		archive << translator.isTranslator;
 		archive << translator.isRotator;
 		archive << translator.isScalator;
+		// The selected entities move rigidly with the translator, so the translator's start and end transforms describe the change of all of them:
 		translator.transform_start.Serialize(archive, seri);
 		translator.transform.Serialize(archive, seri);
-		archive << translator.matrices_start;
-		archive << translator.matrices_current;
 	}
 
 	componentsWnd.emitterWnd.UpdateData();
@@ -4711,8 +4715,24 @@ void EditorComponent::RecordEntity(wi::Archive& archive, wi::ecs::Entity entity)
 	const wi::vector<Entity> entities = { entity };
 	RecordEntity(archive, entities);
 }
+// Returns the operation type that was written first into the history entry that is being recorded
+static EditorComponent::HistoryOperationType GetHistoryOperationType(const wi::Archive& archive)
+{
+	int64_t type = EditorComponent::HISTORYOP_NONE; // the type was written as int, which is stored as int64_t
+	if (!archive.IsReadMode() && archive.GetPos() >= sizeof(wi::Archive::Header) + sizeof(type))
+	{
+		std::memcpy(&type, archive.GetData() + sizeof(wi::Archive::Header), sizeof(type));
+	}
+	return (EditorComponent::HistoryOperationType)type;
+}
 void EditorComponent::RecordEntity(wi::Archive& archive, const wi::vector<wi::ecs::Entity>& entities)
 {
+	if (GetHistoryOperationType(archive) == HISTORYOP_COMPONENT_DATA)
+	{
+		RecordComponents(archive, entities);
+		return;
+	}
+
 	Scene& scene = GetCurrentScene();
 	EntitySerializer seri;
 
@@ -4723,26 +4743,402 @@ void EditorComponent::RecordEntity(wi::Archive& archive, const wi::vector<wi::ec
 	}
 }
 
+void EditorComponent::SnapshotComponents(const wi::vector<wi::ecs::Entity>& entities, ComponentSnapshot& snapshot, wi::vector<wi::Resource>& resources) const
+{
+	const Scene& scene = GetCurrentScene();
+
+	// The components of the descendants are recorded too, like with recursive entity serialization:
+	wi::unordered_map<Entity, wi::vector<Entity>> children;
+	for (size_t i = 0; i < scene.hierarchy.GetCount(); ++i)
+	{
+		children[scene.hierarchy[i].parentID].push_back(scene.hierarchy.GetEntity(i));
+	}
+	wi::unordered_set<Entity> visited;
+	wi::vector<Entity> stack = entities;
+	wi::vector<Entity> gathered;
+	while (!stack.empty())
+	{
+		const Entity entity = stack.back();
+		stack.pop_back();
+		if (entity == INVALID_ENTITY || visited.count(entity) > 0)
+			continue;
+		visited.insert(entity);
+		gathered.push_back(entity);
+		auto it = children.find(entity);
+		if (it != children.end())
+		{
+			stack.insert(stack.end(), it->second.begin(), it->second.end());
+		}
+	}
+	std::sort(gathered.begin(), gathered.end());
+
+	wi::Archive scratch;
+	EntitySerializer seri;
+	seri.componentlibrary = const_cast<wi::ecs::ComponentLibrary*>(&scene.componentLibrary);
+	for (auto& it : scene.componentLibrary.entries)
+	{
+		seri.library_versions[it.first] = it.second.version;
+	}
+	snapshot.states.clear();
+	for (uint32_t type = 0; type < (uint32_t)componentRecording.types.size(); ++type)
+	{
+		auto it = scene.componentLibrary.entries.find(componentRecording.types[type]);
+		if (it == scene.componentLibrary.entries.end())
+			continue;
+		wi::ecs::ComponentManager_Interface* manager = it->second.component_manager.get();
+		seri.version = it->second.version;
+		for (Entity entity : gathered)
+		{
+			if (!manager->Contains(entity))
+				continue;
+			ComponentSnapshot::State& state = snapshot.states.emplace_back();
+			state.entity = entity;
+			state.type = type;
+			state.offset = scratch.GetPos();
+			manager->Component_Serialize(entity, scratch, seri);
+			state.size = scratch.GetPos() - state.offset;
+		}
+	}
+	wi::jobsystem::Wait(seri.ctx);
+	snapshot.data.resize(scratch.GetPos());
+	std::memcpy(snapshot.data.data(), scratch.GetData(), snapshot.data.size());
+
+	for (auto& name : seri.resource_registration)
+	{
+		if (wi::resourcemanager::Contains(name))
+		{
+			resources.push_back(wi::resourcemanager::Load(name));
+		}
+	}
+}
+
+void EditorComponent::RecordComponents(wi::Archive& archive, const wi::vector<wi::ecs::Entity>& entities)
+{
+	ComponentRecording& recording = componentRecording;
+	if (recording.archive != &archive)
+	{
+		// First call, the state before the operation is only remembered:
+		recording = {};
+		recording.archive = &archive;
+		for (auto& it : GetCurrentScene().componentLibrary.entries)
+		{
+			recording.types.push_back(it.first);
+		}
+		recording.entities = entities;
+		SnapshotComponents(recording.entities, recording.before, recording.resources);
+		return;
+	}
+
+	// Second call, the changed components are written:
+	wi::vector<Entity> all_entities = recording.entities;
+	all_entities.insert(all_entities.end(), entities.begin(), entities.end());
+	ComponentSnapshot after;
+	wi::vector<wi::Resource> resources;
+	SnapshotComponents(all_entities, after, resources);
+
+	struct Change
+	{
+		const ComponentSnapshot::State* before = nullptr;
+		const ComponentSnapshot::State* after = nullptr;
+	};
+	wi::vector<Change> changes;
+	auto key = [](const ComponentSnapshot::State& state) {
+		return (uint64_t(state.type) << 32ull) | uint64_t(state.entity);
+	};
+	size_t index_before = 0;
+	size_t index_after = 0;
+	while (index_before < recording.before.states.size() || index_after < after.states.size())
+	{
+		const ComponentSnapshot::State* state_before = index_before < recording.before.states.size() ? &recording.before.states[index_before] : nullptr;
+		const ComponentSnapshot::State* state_after = index_after < after.states.size() ? &after.states[index_after] : nullptr;
+		if (state_before != nullptr && state_after != nullptr && key(*state_before) == key(*state_after))
+		{
+			if (state_before->size != state_after->size || std::memcmp(recording.before.data.data() + state_before->offset, after.data.data() + state_after->offset, state_before->size) != 0)
+			{
+				changes.push_back({ state_before, state_after });
+			}
+			index_before++;
+			index_after++;
+		}
+		else if (state_after == nullptr || (state_before != nullptr && key(*state_before) < key(*state_after)))
+		{
+			changes.push_back({ state_before, nullptr }); // component removed
+			index_before++;
+		}
+		else
+		{
+			changes.push_back({ nullptr, state_after }); // component created
+			index_after++;
+		}
+	}
+
+	// Only the types of the changed components are written:
+	wi::vector<uint32_t> type_remap(recording.types.size(), ~0u);
+	wi::vector<std::string> types;
+	for (auto& change : changes)
+	{
+		const uint32_t type = change.before != nullptr ? change.before->type : change.after->type;
+		if (type_remap[type] == ~0u)
+		{
+			type_remap[type] = (uint32_t)types.size();
+			types.push_back(recording.types[type]);
+		}
+	}
+	archive << types;
+
+	auto write_bytes = [&](const uint8_t* data, size_t size) {
+		archive << size;
+		for (size_t i = 0; i < size; ++i)
+		{
+			archive << data[i];
+		}
+	};
+	wi::vector<uint8_t> patch;
+	archive << changes.size();
+	for (auto& change : changes)
+	{
+		const ComponentSnapshot::State& state = change.before != nullptr ? *change.before : *change.after;
+		const uint8_t* data_before = change.before != nullptr ? recording.before.data.data() + change.before->offset : nullptr;
+		const uint8_t* data_after = change.after != nullptr ? after.data.data() + change.after->offset : nullptr;
+
+		// If the size didn't change, only the modified byte ranges are stored as (offset, size, data before, data after) segments,
+		//	these are applied to the current state of the component when undoing or redoing:
+		patch.clear();
+		if (data_before != nullptr && data_after != nullptr && change.before->size == change.after->size)
+		{
+			const size_t size = change.after->size;
+			size_t offset = 0;
+			while (offset < size)
+			{
+				if (data_before[offset] == data_after[offset])
+				{
+					offset++;
+					continue;
+				}
+				// The segment ends when enough matching bytes follow that a new segment would cost less:
+				size_t end = offset + 1;
+				size_t matching = 0;
+				while (end < size && matching < sizeof(uint32_t))
+				{
+					matching = data_before[end] == data_after[end] ? matching + 1 : 0;
+					end++;
+				}
+				end -= matching;
+				const uint32_t segment[] = { uint32_t(offset), uint32_t(end - offset) };
+				patch.insert(patch.end(), (const uint8_t*)segment, (const uint8_t*)segment + sizeof(segment));
+				patch.insert(patch.end(), data_before + offset, data_before + end);
+				patch.insert(patch.end(), data_after + offset, data_after + end);
+				offset = end;
+			}
+		}
+		const bool patched = !patch.empty() && patch.size() < change.before->size + change.after->size;
+
+		uint8_t flags = 0;
+		flags |= data_before != nullptr ? COMPONENT_CHANGE_BEFORE : 0;
+		flags |= data_after != nullptr ? COMPONENT_CHANGE_AFTER : 0;
+		flags |= patched ? COMPONENT_CHANGE_PATCHED : 0;
+		archive << state.entity;
+		archive << type_remap[state.type];
+		archive << flags;
+		if (patched)
+		{
+			write_bytes(patch.data(), patch.size());
+			continue;
+		}
+		if (data_before != nullptr)
+		{
+			write_bytes(data_before, change.before->size);
+		}
+		if (data_after != nullptr)
+		{
+			write_bytes(data_after, change.after->size);
+		}
+	}
+
+	// The resources are kept alive by the history entry, so they can be restored even if nothing else uses them:
+	EditorScene& editorscene = GetCurrentEditorScene();
+	if (!changes.empty() && !editorscene.history.empty() && &editorscene.history.back().archive == &archive)
+	{
+		auto& entry_resources = editorscene.history.back().resources;
+		entry_resources.insert(entry_resources.end(), recording.resources.begin(), recording.resources.end());
+		entry_resources.insert(entry_resources.end(), resources.begin(), resources.end());
+	}
+	recording = {};
+}
+
+void EditorComponent::ConsumeComponents(wi::Archive& archive, bool undo)
+{
+	Scene& scene = GetCurrentScene();
+
+	wi::vector<std::string> types;
+	archive >> types;
+	size_t count = 0;
+	archive >> count;
+
+	EntitySerializer seri;
+	seri.allow_remap = false;
+	seri.componentlibrary = &scene.componentLibrary;
+	for (auto& it : scene.componentLibrary.entries)
+	{
+		seri.library_versions[it.first] = it.second.version;
+	}
+
+	// The serialized components of the restored state are collected into one archive:
+	struct Restore
+	{
+		Entity entity = INVALID_ENTITY;
+		uint32_t type = 0;
+		bool exists = false;
+		size_t offset = 0;
+	};
+	wi::vector<Restore> restores(count);
+	wi::vector<uint8_t> data(archive.GetData(), archive.GetData() + sizeof(wi::Archive::Header));
+	wi::Archive scratch;
+	for (auto& restore : restores)
+	{
+		uint8_t flags = 0;
+		archive >> restore.entity;
+		archive >> restore.type;
+		archive >> flags;
+		const uint8_t* data_before = nullptr;
+		const uint8_t* data_after = nullptr;
+		size_t size_before = 0;
+		size_t size_after = 0;
+		if (flags & COMPONENT_CHANGE_PATCHED)
+		{
+			const uint8_t* patch = nullptr;
+			size_t patch_size = 0;
+			archive.MapVector(patch, patch_size);
+			auto it = scene.componentLibrary.entries.find(types[restore.type]);
+			restore.exists = it != scene.componentLibrary.entries.end() && it->second.component_manager->Contains(restore.entity);
+			if (!restore.exists)
+				continue;
+
+			// The current state of the component is serialized and the recorded byte ranges are swapped in:
+			scratch.SetReadModeAndResetPos(false);
+			seri.version = it->second.version;
+			it->second.component_manager->Component_Serialize(restore.entity, scratch, seri);
+			wi::jobsystem::Wait(seri.ctx);
+			restore.offset = data.size();
+			data.insert(data.end(), scratch.GetData() + sizeof(wi::Archive::Header), scratch.GetData() + scratch.GetPos());
+			const size_t size = data.size() - restore.offset;
+			const uint8_t* patch_end = patch + patch_size;
+			while (patch < patch_end)
+			{
+				uint32_t segment[2];
+				std::memcpy(segment, patch, sizeof(segment));
+				patch += sizeof(segment);
+				if (size_t(segment[0]) + size_t(segment[1]) <= size)
+				{
+					std::memcpy(data.data() + restore.offset + segment[0], undo ? patch : patch + segment[1], segment[1]);
+				}
+				patch += segment[1] * 2;
+			}
+			continue;
+		}
+		if (flags & COMPONENT_CHANGE_BEFORE)
+		{
+			archive.MapVector(data_before, size_before);
+		}
+		if (flags & COMPONENT_CHANGE_AFTER)
+		{
+			archive.MapVector(data_after, size_after);
+		}
+		restore.exists = (flags & (undo ? COMPONENT_CHANGE_BEFORE : COMPONENT_CHANGE_AFTER)) != 0;
+		restore.offset = data.size();
+		if (undo)
+		{
+			data.insert(data.end(), data_before, data_before + size_before);
+		}
+		else
+		{
+			data.insert(data.end(), data_after, data_after + size_after);
+		}
+	}
+
+	wi::Archive restore_archive(data.data(), data.size());
+	for (auto& restore : restores)
+	{
+		auto it = scene.componentLibrary.entries.find(types[restore.type]);
+		if (it == scene.componentLibrary.entries.end())
+			continue;
+		// The component is recreated, like the whole entity was recreated before:
+		it->second.component_manager->Remove(restore.entity);
+		if (restore.exists)
+		{
+			seri.version = it->second.version;
+			restore_archive.Jump(restore.offset);
+			it->second.component_manager->Component_Serialize(restore.entity, restore_archive, seri);
+		}
+	}
+	wi::jobsystem::Wait(seri.ctx);
+}
+
 void EditorComponent::ResetHistory()
 {
 	EditorScene& editorscene = GetCurrentEditorScene();
 	editorscene.historyPos = -1;
 	editorscene.history.clear();
+	editorscene.historyMemory = 0;
+	componentRecording = {};
 }
 wi::Archive& EditorComponent::AdvanceHistory()
 {
 	EditorScene& editorscene = GetCurrentEditorScene();
+	if (!editorscene.history.empty())
+	{
+		FinishHistoryEntry(editorscene, editorscene.history.back());
+	}
+
 	editorscene.historyPos++;
 
 	while (static_cast<int>(editorscene.history.size()) > editorscene.historyPos)
 	{
+		editorscene.historyMemory -= editorscene.history.back().GetMemorySize();
 		editorscene.history.pop_back();
 	}
 
+	// Remove the oldest entries if the history uses too much memory:
+	size_t remove_count = 0;
+	while (editorscene.historyMemory > historyMemoryBudget && remove_count < editorscene.history.size())
+	{
+		editorscene.historyMemory -= editorscene.history[remove_count].GetMemorySize();
+		remove_count++;
+	}
+	if (remove_count > 0)
+	{
+		editorscene.history.erase(editorscene.history.begin(), editorscene.history.begin() + remove_count);
+		editorscene.historyPos -= (int)remove_count;
+	}
+
 	editorscene.history.emplace_back();
-	editorscene.history.back().SetReadModeAndResetPos(false);
+	editorscene.history.back().archive.SetReadModeAndResetPos(false);
+
+	return editorscene.history.back().archive;
+}
+void EditorComponent::FinishHistoryEntry(EditorScene& editorscene, EditorScene::HistoryEntry& entry)
+{
+	if (entry.finished)
+		return;
+	entry.finished = true;
+
+	if (componentRecording.archive == &entry.archive)
+	{
+		// The second RecordEntity() didn't happen, so there are no changes:
+		entry.archive << wi::vector<std::string>();
+		entry.archive << size_t(0);
+		componentRecording = {};
+	}
 
-	return editorscene.history.back();
+	// The finished entries are stored compressed:
+	wi::vector<uint8_t> compressed;
+	if (wi::helper::Compress(entry.archive.GetData(), entry.archive.GetPos(), compressed) && compressed.size() < entry.archive.GetPos())
+	{
+		entry.compressed = std::move(compressed);
+		entry.compressed.shrink_to_fit();
+		entry.archive = wi::Archive();
+	}
+	editorscene.historyMemory += entry.GetMemorySize();
 }
 void EditorComponent::ConsumeHistoryOperation(bool undo)
 {
@@ -4757,8 +5153,23 @@ void EditorComponent::ConsumeHistoryOperation(bool undo)
 
 		Scene& scene = GetCurrentScene();
 
-		wi::Archive& archive = editorscene.history[editorscene.historyPos];
-		archive.SetReadModeAndResetPos(true);
+		FinishHistoryEntry(editorscene, editorscene.history.back());
+
+		// The finished history entries are compressed:
+		EditorScene::HistoryEntry& entry = editorscene.history[editorscene.historyPos];
+		wi::vector<uint8_t> decompressed;
+		wi::Archive decompressed_archive;
+		wi::Archive* archive_ptr = &entry.archive;
+		if (!entry.compressed.empty() && wi::helper::Decompress(entry.compressed.data(), entry.compressed.size(), decompressed))
+		{
+			decompressed_archive = wi::Archive(decompressed.data(), decompressed.size());
+			archive_ptr = &decompressed_archive;
+		}
+		else
+		{
+			entry.archive.SetReadModeAndResetPos(true);
+		}
+		wi::Archive& archive = *archive_ptr;
 
 		int temp;
 		archive >> temp;
@@ -4777,23 +5188,13 @@ void EditorComponent::ConsumeHistoryOperation(bool undo)
 				wi::scene::TransformComponent end;
 				start.Serialize(archive, seri);
 				end.Serialize(archive, seri);
-				wi::vector<XMFLOAT4X4> matrices_start;
-				wi::vector<XMFLOAT4X4> matrices_end;
-				archive >> matrices_start;
-				archive >> matrices_end;
 
+				// The selection is moved from its current state by the same delta transform that moved the translator:
 				translator.PreTranslate();
-				if (undo)
-				{
-					translator.transform = start;
-					translator.matrices_current = matrices_start;
-				}
-				else
-				{
-					translator.transform = end;
-					translator.matrices_current = matrices_end;
-				}
-				translator.transform.UpdateTransform();
+				const XMMATRIX delta = undo ?
+					XMMatrixInverse(nullptr, XMLoadFloat4x4(&end.world)) * XMLoadFloat4x4(&start.world) :
+					XMMatrixInverse(nullptr, XMLoadFloat4x4(&start.world)) * XMLoadFloat4x4(&end.world);
+				XMStoreFloat4x4(&translator.transform.world, XMLoadFloat4x4(&translator.transform.world) * delta);
 				translator.PostTranslate();
 			}
 			break;
@@ -4945,43 +5346,7 @@ void EditorComponent::ConsumeHistoryOperation(bool undo)
 			}
 			break;
 		case HISTORYOP_COMPONENT_DATA:
-			{
-				Scene before, after;
-				wi::vector<Entity> entities_before, entities_after;
-
-				archive >> entities_before;
-				for (auto& x : entities_before)
-				{
-					EntitySerializer seri;
-					seri.allow_remap = false;
-					before.Entity_Serialize(archive, seri);
-				}
-
-				archive >> entities_after;
-				for (auto& x : entities_after)
-				{
-					EntitySerializer seri;
-					seri.allow_remap = false;
-					after.Entity_Serialize(archive, seri);
-				}
-
-				if (undo)
-				{
-					for (auto& x : entities_before)
-					{
-						scene.Entity_Remove(x);
-					}
-					scene.Merge(before);
-				}
-				else
-				{
-					for (auto& x : entities_after)
-					{
-						scene.Entity_Remove(x);
-					}
-					scene.Merge(after);
-				}
-			}
+			ConsumeComponents(archive, undo);
 			break;
 		case HISTORYOP_PAINTTOOL:
 			paintToolWnd.ConsumeHistoryOperation(archive, undo);
@@ -5142,6 +5507,7 @@ void EditorComponent::Open(std::string filename)
 	RegisterRecentlyUsed(filename);
 
 	size_t camera_count_prev = GetCurrentScene().cameras.GetCount();
+	const bool optimize_meshes = type != FileType::WISCENE && generalWnd.optimizeImportedMeshesCheckBox.GetCheck();
 
 	wi::jobsystem::Execute(loadmodel_workload, [=] (wi::jobsystem::JobArgs) {
 		wi::backlog::post("[Editor] started loading model: " + filename);
@@ -5163,6 +5529,34 @@ void EditorComponent::Open(std::string filename)
 			ImportModel_FBX(filename, *scene);
 		}
 
+		if (optimize_meshes && scene->meshes.GetCount() > 0)
+		{
+			wi::vector<MeshComponent::OptimizationStatistics> statistics(scene->meshes.GetCount());
+			wi::jobsystem::context ctx;
+			wi::jobsystem::Dispatch(ctx, (uint32_t)scene->meshes.GetCount(), 1, [&](wi::jobsystem::JobArgs args) {
+				scene->meshes[args.jobIndex].Optimize(&statistics[args.jobIndex]);
+			});
+			wi::jobsystem::Wait(ctx);
+
+			// The ACMR of all meshes is weighted by triangle count:
+			double triangles = 0;
+			double transformed_before = 0;
+			double transformed_after = 0;
+			for (size_t i = 0; i < statistics.size(); ++i)
+			{
+				const double mesh_triangles = double(scene->meshes[i].indices.size() / 3);
+				triangles += mesh_triangles;
+				transformed_before += statistics[i].acmr_before * mesh_triangles;
+				transformed_after += statistics[i].acmr_after * mesh_triangles;
+			}
+			if (triangles > 0)
+			{
+				char text[256];
+				snprintf(text, arraysize(text), "[Editor] optimized %d meshes, ACMR: %.3f -> %.3f", (int)statistics.size(), transformed_before / triangles, transformed_after / triangles);
+				wi::backlog::post(text);
+			}
+		}
+
 		wi::eventhandler::Subscribe_Once(wi::eventhandler::EVENT_THREAD_SAFE_POINT, [=] (uint64_t userdata) {
 
 			if (type == FileType::WISCENE && GetCurrentEditorScene().path.empty())
@@ -173,6 +173,42 @@ public:
 	void RecordEntity(wi::Archive& archive, wi::ecs::Entity entity);
 	void RecordEntity(wi::Archive& archive, const wi::vector<wi::ecs::Entity>& entities);
 
+	// HISTORYOP_COMPONENT_DATA records the components of the entities (and their descendants) with the first RecordEntity(),
+	//	and the second RecordEntity() writes only the components that changed since then into the history
+	struct ComponentSnapshot
+	{
+		struct State
+		{
+			wi::ecs::Entity entity = wi::ecs::INVALID_ENTITY;
+			uint32_t type = 0; // index into ComponentRecording::types
+			size_t offset = 0; // serialized component in data
+			size_t size = 0;
+		};
+		wi::vector<State> states; // sorted by type, then entity
+		wi::vector<uint8_t> data;
+	};
+	enum COMPONENT_CHANGE_FLAGS : uint8_t
+	{
+		COMPONENT_CHANGE_BEFORE = 1 << 0, // the component existed before the operation
+		COMPONENT_CHANGE_AFTER = 1 << 1, // the component exists after the operation
+		COMPONENT_CHANGE_PATCHED = 1 << 2, // only the changed byte ranges are stored
+	};
+	struct ComponentRecording
+	{
+		const wi::Archive* archive = nullptr; // the history entry that is waiting for the second RecordEntity()
+		wi::vector<std::string> types; // component library names
+		wi::vector<wi::ecs::Entity> entities;
+		ComponentSnapshot before;
+		wi::vector<wi::Resource> resources; // keep the resources of the recorded components alive until the record is finished
+	} componentRecording;
+	void SnapshotComponents(const wi::vector<wi::ecs::Entity>& entities, ComponentSnapshot& snapshot, wi::vector<wi::Resource>& resources) const;
+	void RecordComponents(wi::Archive& archive, const wi::vector<wi::ecs::Entity>& entities);
+	void ConsumeComponents(wi::Archive& archive, bool undo);
+
+	// The oldest history entries are removed when the history of a scene uses more memory than this
+	//	Only the recorded history data is counted, the resources that are kept alive by the entries are not, because they are usually shared with the scene
+	size_t historyMemoryBudget = 256ull * 1024ull * 1024ull;
+
 	void ResetHistory();
 	wi::Archive& AdvanceHistory();
 	void ConsumeHistoryOperation(bool undo);
@@ -207,8 +243,17 @@ public:
 		wi::scene::CameraComponent camera;
 		wi::scene::TransformComponent camera_transform;
 		wi::scene::TransformComponent camera_target;
-		wi::vector<wi::Archive> history;
+		struct HistoryEntry
+		{
+			wi::Archive archive;
+			wi::vector<uint8_t> compressed; // the archive data is compressed here when the entry is finished
+			wi::vector<wi::Resource> resources; // the resources of the recorded components are kept alive to be able to restore them
+			bool finished = false;
+			size_t GetMemorySize() const { return compressed.empty() ? archive.GetSize() : compressed.size(); }
+		};
+		wi::vector<HistoryEntry> history;
 		int historyPos = -1;
+		size_t historyMemory = 0; // memory size of the finished history entries
 		wi::gui::Button tabSelectButton;
 		wi::gui::Button tabCloseButton;
 	};
@@ -219,6 +264,7 @@ public:
 	wi::scene::Scene& GetCurrentScene() { return scenes[current_scene].get()->scene; }
 	const wi::scene::Scene& GetCurrentScene() const { return scenes[current_scene].get()->scene; }
 	void SetCurrentScene(int index);
+	void FinishHistoryEntry(EditorScene& editorscene, EditorScene::HistoryEntry& entry);
 	void RefreshSceneList();
 	void NewScene();
 
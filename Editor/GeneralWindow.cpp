@@ -274,6 +274,18 @@ void GeneralWindow::Create(EditorComponent* _editor)
 	});
 	AddWidget(&saveCompressionCheckBox);
 
+	optimizeImportedMeshesCheckBox.Create("Optimize imported meshes: ");
+	optimizeImportedMeshesCheckBox.SetTooltip("Set whether to run the meshoptimizer library on the meshes of imported models (OBJ, GLTF, FBX...) for better GPU vertex cache, overdraw and vertex fetch efficiency.\nThe ACMR (average cache miss ratio) before and after the optimization will be written to the backlog.");
+	if (editor->main->config.GetSection("options").Has("optimize_imported_meshes"))
+	{
+		optimizeImportedMeshesCheckBox.SetCheck(editor->main->config.GetSection("options").GetBool("optimize_imported_meshes"));
+	}
+	optimizeImportedMeshesCheckBox.OnClick([&](wi::gui::EventArgs args) {
+		editor->main->config.GetSection("options").Set("optimize_imported_meshes", args.bValue);
+		editor->main->config.Commit();
+	});
+	AddWidget(&optimizeImportedMeshesCheckBox);
+
 	transformToolOpacitySlider.Create(0, 1, 1, 100, "Transform Tool Opacity: ");
 	transformToolOpacitySlider.SetTooltip("You can control the transparency of the object placement tool");
 	transformToolOpacitySlider.SetSize(XMFLOAT2(100, 18));
@@ -1265,6 +1277,7 @@ void GeneralWindow::ResizeLayout()
 	layout.add(saveModeComboBox);
 
 	layout.add_right(saveCompressionCheckBox);
+	layout.add_right(optimizeImportedMeshesCheckBox);
 
 	layout.add(themeCombo);
 	themeEditorButton.SetPos(XMFLOAT2(themeCombo.GetPos().x - themeCombo.GetLeftTextWidth() - themeEditorButton.GetSize().x - layout.padding * 2, themeCombo.GetPos().y));
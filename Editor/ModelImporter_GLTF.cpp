@@ -592,6 +592,7 @@ void ImportModel_GLTF(const std::string& fileName, Scene& scene)
 	state.name = name;
 
 	// Create materials:
+	const size_t material_offset = scene.materials.GetCount();
 	for (auto& x : state.gltfModel.materials)
 	{
 		Entity materialEntity = scene.Entity_CreateMaterial(x.name);
@@ -1019,27 +1020,64 @@ void ImportModel_GLTF(const std::string& fileName, Scene& scene)
 			}
 		}
 		ImportMetadata(state, materialEntity, x.extras);
+	}
+	const size_t material_count = scene.materials.GetCount();
 
-		material.CreateRenderData();
+	// The textures are decoded in parallel, each with the flags of the first material slot that uses it,
+	//	the material render data is created after that from the loaded resources:
+	wi::jobsystem::context ctx;
+	wi::vector<std::pair<std::string, wi::resourcemanager::Flags>> texture_loads;
+	wi::unordered_set<std::string> texture_names;
+	for (size_t i = material_offset; i < material_count; ++i)
+	{
+		MaterialComponent& material = scene.materials[i];
+		for (uint32_t slot = 0; slot < MaterialComponent::TEXTURESLOT_COUNT; ++slot)
+		{
+			const std::string& textureName = material.textures[slot].name;
+			if (!textureName.empty() && texture_names.insert(textureName).second)
+			{
+				texture_loads.push_back({ textureName, material.GetTextureSlotResourceFlags(MaterialComponent::TEXTURESLOT(slot)) });
+			}
+		}
 	}
+	wi::jobsystem::Dispatch(ctx, (uint32_t)texture_loads.size(), 1, [&](wi::jobsystem::JobArgs args) {
+		wi::resourcemanager::Load(texture_loads[args.jobIndex].first, texture_loads[args.jobIndex].second);
+	});
 
 	// Create meshes:
+	//	The mesh entities are created in order, then the vertex data is extracted in parallel
+	const size_t mesh_offset = scene.meshes.GetCount();
 	for (auto& x : state.gltfModel.meshes)
 	{
 		Entity meshEntity = scene.Entity_CreateMesh(x.name);
 		scene.Component_Attach(meshEntity, state.rootEntity);
-		MeshComponent& mesh = *scene.meshes.GetComponent(meshEntity);
 
 		for (auto& prim : x.primitives)
 		{
-			mesh.subsets.push_back(MeshComponent::MeshSubset());
 			if (scene.materials.GetCount() == 0)
 			{
 				// Create a material last minute if there was none
 				scene.materials.Create(CreateEntity());
 			}
+			if (prim.attributes.count("COLOR_0") > 0)
+			{
+				MaterialComponent* material = scene.materials.GetComponent(scene.materials.GetEntity(std::max(0, prim.material)));
+				if (material != nullptr)
+				{
+					material->SetUseVertexColors(true);
+				}
+			}
+		}
+		ImportMetadata(state, meshEntity, x.extras);
+	}
+	wi::jobsystem::Dispatch(ctx, (uint32_t)state.gltfModel.meshes.size(), 1, [&](wi::jobsystem::JobArgs args) {
+		const tinygltf::Mesh& x = state.gltfModel.meshes[args.jobIndex];
+		MeshComponent& mesh = scene.meshes[mesh_offset + args.jobIndex];
+
+		for (auto& prim : x.primitives)
+		{
+			mesh.subsets.push_back(MeshComponent::MeshSubset());
 			mesh.subsets.back().materialID = scene.materials.GetEntity(std::max(0, prim.material));
-			MaterialComponent* material = scene.materials.GetComponent(mesh.subsets.back().materialID);
 			uint32_t vertexOffset = (uint32_t)mesh.vertex_positions.size();
 
 			const size_t index_remap[] = {
@@ -1389,10 +1427,6 @@ void ImportModel_GLTF(const std::string& fileName, Scene& scene)
 				}
 				else if (!attr_name.compare("COLOR_0"))
 				{
-					if(material != nullptr)
-					{
-						material->SetUseVertexColors(true);
-					}
 					mesh.vertex_colors.resize(vertexOffset + vertexCount);
 					if (accessor.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT)
 					{
@@ -1618,8 +1652,13 @@ void ImportModel_GLTF(const std::string& fileName, Scene& scene)
 			mesh.ComputeNormals(MeshComponent::COMPUTE_NORMALS_SMOOTH_FAST);
 		}
 
-		ImportMetadata(state, meshEntity, x.extras);
 		mesh.CreateRenderData(); // tangents are generated inside if needed, which must be done before FlipZAxis!
+	});
+	wi::jobsystem::Wait(ctx);
+
+	for (size_t i = material_offset; i < material_count; ++i)
+	{
+		scene.materials[i].CreateRenderData();
 	}
 
 	// Create armatures:
@@ -1692,6 +1731,14 @@ void ImportModel_GLTF(const std::string& fileName, Scene& scene)
 	}
 
 	// Create animations:
+	//	The animation entities are created in order, then the keyframes are converted in parallel
+	struct AnimationSamplerImport
+	{
+		const tinygltf::AnimationSampler* sampler = nullptr;
+		Entity animation = INVALID_ENTITY;
+		Entity data = INVALID_ENTITY;
+	};
+	wi::vector<AnimationSamplerImport> animation_samplers;
 	for (auto& anim : state.gltfModel.animations)
 	{
 		Entity entity = CreateEntity();
@@ -1720,84 +1767,8 @@ void ImportModel_GLTF(const std::string& fileName, Scene& scene)
 
 			animationcomponent.samplers[i].data = CreateEntity();
 			scene.Component_Attach(animationcomponent.samplers[i].data, entity);
-			AnimationDataComponent& animationdata = scene.animation_datas.Create(animationcomponent.samplers[i].data);
-
-			// AnimationSampler input = keyframe times
-			{
-				const tinygltf::Accessor& accessor = state.gltfModel.accessors[sam.input];
-				const tinygltf::BufferView& bufferView = state.gltfModel.bufferViews[accessor.bufferView];
-				const tinygltf::Buffer& buffer = state.gltfModel.buffers[bufferView.buffer];
-
-				assert(accessor.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT);
-
-				int stride = accessor.ByteStride(bufferView);
-				size_t count = accessor.count;
-
-				animationdata.keyframe_times.resize(count);
-
-				const unsigned char* data = buffer.data.data() + accessor.byteOffset + bufferView.byteOffset;
-
-				assert(stride == 4);
-
-				for (size_t j = 0; j < count; ++j)
-				{
-					float time = ((float*)data)[j];
-					animationdata.keyframe_times[j] = time;
-					animationcomponent.start = std::min(animationcomponent.start, time);
-					animationcomponent.end = std::max(animationcomponent.end, time);
-				}
-
-			}
-
-			// AnimationSampler output = keyframe data
-			{
-				const tinygltf::Accessor& accessor = state.gltfModel.accessors[sam.output];
-				const tinygltf::BufferView& bufferView = state.gltfModel.bufferViews[accessor.bufferView];
-				const tinygltf::Buffer& buffer = state.gltfModel.buffers[bufferView.buffer];
-
-				int stride = accessor.ByteStride(bufferView);
-				size_t count = accessor.count;
-
-				const unsigned char* data = buffer.data.data() + accessor.byteOffset + bufferView.byteOffset;
-
-				switch (accessor.type)
-				{
-				case TINYGLTF_TYPE_SCALAR:
-				{
-					assert(stride == sizeof(float));
-					animationdata.keyframe_data.resize(count);
-					for (size_t j = 0; j < count; ++j)
-					{
-						animationdata.keyframe_data[j] = ((float*)data)[j];
-					}
-				}
-				break;
-				case TINYGLTF_TYPE_VEC3:
-				{
-					assert(stride == sizeof(XMFLOAT3));
-					animationdata.keyframe_data.resize(count * 3);
-					for (size_t j = 0; j < count; ++j)
-					{
-						((XMFLOAT3*)animationdata.keyframe_data.data())[j] = ((XMFLOAT3*)data)[j];
-					}
-				}
-				break;
-				case TINYGLTF_TYPE_VEC4:
-				{
-					assert(stride == sizeof(XMFLOAT4));
-					animationdata.keyframe_data.resize(count * 4);
-					for (size_t j = 0; j < count; ++j)
-					{
-						((XMFLOAT4*)animationdata.keyframe_data.data())[j] = ((XMFLOAT4*)data)[j];
-					}
-				}
-				break;
-				default: assert(0); break;
-
-				}
-
-			}
-
+			scene.animation_datas.Create(animationcomponent.samplers[i].data);
+			animation_samplers.push_back({ &sam, entity, animationcomponent.samplers[i].data });
 		}
 
 		for (size_t i = 0; i < anim.channels.size(); ++i)
@@ -1832,6 +1803,96 @@ void ImportModel_GLTF(const std::string& fileName, Scene& scene)
 		ImportMetadata(state, entity, anim.extras);
 	}
 
+	wi::jobsystem::Dispatch(ctx, (uint32_t)animation_samplers.size(), 1, [&](wi::jobsystem::JobArgs args) {
+		const tinygltf::AnimationSampler& sam = *animation_samplers[args.jobIndex].sampler;
+		AnimationDataComponent& animationdata = *scene.animation_datas.GetComponent(animation_samplers[args.jobIndex].data);
+
+		// AnimationSampler input = keyframe times
+		{
+			const tinygltf::Accessor& accessor = state.gltfModel.accessors[sam.input];
+			const tinygltf::BufferView& bufferView = state.gltfModel.bufferViews[accessor.bufferView];
+			const tinygltf::Buffer& buffer = state.gltfModel.buffers[bufferView.buffer];
+
+			assert(accessor.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT);
+
+			int stride = accessor.ByteStride(bufferView);
+			size_t count = accessor.count;
+
+			animationdata.keyframe_times.resize(count);
+
+			const unsigned char* data = buffer.data.data() + accessor.byteOffset + bufferView.byteOffset;
+
+			assert(stride == 4);
+
+			for (size_t j = 0; j < count; ++j)
+			{
+				float time = ((float*)data)[j];
+				animationdata.keyframe_times[j] = time;
+			}
+
+		}
+
+		// AnimationSampler output = keyframe data
+		{
+			const tinygltf::Accessor& accessor = state.gltfModel.accessors[sam.output];
+			const tinygltf::BufferView& bufferView = state.gltfModel.bufferViews[accessor.bufferView];
+			const tinygltf::Buffer& buffer = state.gltfModel.buffers[bufferView.buffer];
+
+			int stride = accessor.ByteStride(bufferView);
+			size_t count = accessor.count;
+
+			const unsigned char* data = buffer.data.data() + accessor.byteOffset + bufferView.byteOffset;
+
+			switch (accessor.type)
+			{
+			case TINYGLTF_TYPE_SCALAR:
+			{
+				assert(stride == sizeof(float));
+				animationdata.keyframe_data.resize(count);
+				for (size_t j = 0; j < count; ++j)
+				{
+					animationdata.keyframe_data[j] = ((float*)data)[j];
+				}
+			}
+			break;
+			case TINYGLTF_TYPE_VEC3:
+			{
+				assert(stride == sizeof(XMFLOAT3));
+				animationdata.keyframe_data.resize(count * 3);
+				for (size_t j = 0; j < count; ++j)
+				{
+					((XMFLOAT3*)animationdata.keyframe_data.data())[j] = ((XMFLOAT3*)data)[j];
+				}
+			}
+			break;
+			case TINYGLTF_TYPE_VEC4:
+			{
+				assert(stride == sizeof(XMFLOAT4));
+				animationdata.keyframe_data.resize(count * 4);
+				for (size_t j = 0; j < count; ++j)
+				{
+					((XMFLOAT4*)animationdata.keyframe_data.data())[j] = ((XMFLOAT4*)data)[j];
+				}
+			}
+			break;
+			default: assert(0); break;
+
+			}
+
+		}
+	});
+	wi::jobsystem::Wait(ctx);
+	for (auto& x : animation_samplers)
+	{
+		AnimationComponent& animationcomponent = *scene.animations.GetComponent(x.animation);
+		const AnimationDataComponent& animationdata = *scene.animation_datas.GetComponent(x.data);
+		for (float time : animationdata.keyframe_times)
+		{
+			animationcomponent.start = std::min(animationcomponent.start, time);
+			animationcomponent.end = std::max(animationcomponent.end, time);
+		}
+	}
+
 	// Create lights:
 	int lightIndex = 0;
 	for (auto& x : state.gltfModel.lights)
@@ -56,41 +56,92 @@ static void RasterizeTriangle(uint8_t *dest, int destWidth, const int *t0, const
 	}
 }
 
-struct Atlas_Dim
+// Result of the xatlas unwrap, this is independent of the scene so it can be computed on any thread and reused:
+struct MeshAtlas
 {
 	uint32_t width = 0;
 	uint32_t height = 0;
+	uint32_t vertex_count = 0; // vertex count of the source mesh, xrefs index into this
+	uint32_t index_count = 0; // index count of the source mesh
+	uint64_t last_used = 0; // for evicting the least recently used atlases from the cache
+	wi::vector<uint32_t> indices;
+	wi::vector<uint32_t> xrefs; // for every atlas vertex, the index of the original vertex. Empty if the mesh already contains this atlas
+	wi::vector<XMFLOAT2> atlas;
 };
-static Atlas_Dim GenerateMeshAtlas(Scene& scene, Entity entity, uint32_t resolution)
+struct MeshAtlasInput
 {
-	MeshComponent& meshcomponent = *scene.meshes.GetComponent(entity);
-	SoftBodyPhysicsComponent* softbody = scene.softbodies.GetComponent(entity);
+	Entity meshID = INVALID_ENTITY;
+	size_t hash = 0;
+	wi::vector<XMFLOAT3> positions;
+	wi::vector<XMFLOAT3> normals;
+	wi::vector<XMFLOAT2> uvset_0;
+	wi::vector<uint32_t> indices;
+	MeshAtlas result;
+	std::string error;
+};
+
+// Atlases are cached by mesh content hash, so unwrapping unchanged meshes again is instant:
+static wi::unordered_map<size_t, MeshAtlas> atlas_cache;
+static uint64_t atlas_cache_usage = 0;
+static constexpr size_t atlas_cache_capacity = 64;
+static wi::jobsystem::context atlas_workload;
+
+// Removes the least recently used atlases until the cache fits the capacity:
+static void TrimAtlasCache()
+{
+	while (atlas_cache.size() > atlas_cache_capacity)
+	{
+		auto oldest = atlas_cache.begin();
+		for (auto it = atlas_cache.begin(); it != atlas_cache.end(); ++it)
+		{
+			if (it->second.last_used < oldest->second.last_used)
+			{
+				oldest = it;
+			}
+		}
+		atlas_cache.erase(oldest);
+	}
+}
 
-	Atlas_Dim dim;
+static size_t HashMeshAtlasInput(const MeshComponent& mesh, uint32_t resolution)
+{
+	size_t hash = 0;
+	wi::helper::hash_combine(hash, resolution);
+	wi::helper::hash_combine(hash, wi::helper::HashByteData((const uint8_t*)mesh.vertex_positions.data(), mesh.vertex_positions.size() * sizeof(XMFLOAT3)));
+	wi::helper::hash_combine(hash, wi::helper::HashByteData((const uint8_t*)mesh.vertex_normals.data(), mesh.vertex_normals.size() * sizeof(XMFLOAT3)));
+	wi::helper::hash_combine(hash, wi::helper::HashByteData((const uint8_t*)mesh.vertex_uvset_0.data(), mesh.vertex_uvset_0.size() * sizeof(XMFLOAT2)));
+	wi::helper::hash_combine(hash, wi::helper::HashByteData((const uint8_t*)mesh.vertex_atlas.data(), mesh.vertex_atlas.size() * sizeof(XMFLOAT2)));
+	wi::helper::hash_combine(hash, wi::helper::HashByteData((const uint8_t*)mesh.indices.data(), mesh.indices.size() * sizeof(uint32_t)));
+	return hash;
+}
 
+// This only works on the copied mesh data, it doesn't access the scene:
+static void GenerateMeshAtlas(MeshAtlasInput& input, uint32_t resolution)
+{
 	xatlas::Atlas* atlas = xatlas::Create();
 
 	// Prepare mesh to be processed by xatlas:
 	{
 		xatlas::MeshDecl mesh;
-		mesh.vertexCount = (int)meshcomponent.vertex_positions.size();
-		mesh.vertexPositionData = meshcomponent.vertex_positions.data();
+		mesh.vertexCount = (int)input.positions.size();
+		mesh.vertexPositionData = input.positions.data();
 		mesh.vertexPositionStride = sizeof(float) * 3;
-		if (!meshcomponent.vertex_normals.empty()) {
-			mesh.vertexNormalData = meshcomponent.vertex_normals.data();
+		if (!input.normals.empty()) {
+			mesh.vertexNormalData = input.normals.data();
 			mesh.vertexNormalStride = sizeof(float) * 3;
 		}
-		if (!meshcomponent.vertex_uvset_0.empty()) {
-			mesh.vertexUvData = meshcomponent.vertex_uvset_0.data();
+		if (!input.uvset_0.empty()) {
+			mesh.vertexUvData = input.uvset_0.data();
 			mesh.vertexUvStride = sizeof(float) * 2;
 		}
-		mesh.indexCount = (int)meshcomponent.indices.size();
-		mesh.indexData = meshcomponent.indices.data();
+		mesh.indexCount = (int)input.indices.size();
+		mesh.indexData = input.indices.data();
 		mesh.indexFormat = xatlas::IndexFormat::UInt32;
 		xatlas::AddMeshError error = xatlas::AddMesh(atlas, mesh);
 		if (error != xatlas::AddMeshError::Success) {
-			wi::helper::messageBox(xatlas::StringForEnum(error), "Adding mesh to xatlas failed!");
-			return dim;
+			input.error = xatlas::StringForEnum(error);
+			xatlas::Destroy(atlas);
+			return;
 		}
 	}
 
@@ -108,215 +159,236 @@ static Atlas_Dim GenerateMeshAtlas(Scene& scene, Entity entity, uint32_t resolut
 		packoptions.padding = 2;
 
 		xatlas::Generate(atlas, chartoptions, packoptions);
-		dim.width = atlas->width;
-		dim.height = atlas->height;
-
-		xatlas::Mesh& mesh = atlas->meshes[0];
-
-		// Note: we must recreate all vertex buffers, because the index buffer will be different (the atlas could have removed shared vertices)
-		meshcomponent.indices.clear();
-		meshcomponent.indices.resize(mesh.indexCount);
-		wi::vector<XMFLOAT3> positions(mesh.vertexCount);
-		wi::vector<XMFLOAT2> atlas(mesh.vertexCount);
-		wi::vector<XMFLOAT3> normals;
-		wi::vector<uint8_t> winds;
-		wi::vector<XMFLOAT4> tangents;
-		wi::vector<XMFLOAT2> uvset_0;
-		wi::vector<XMFLOAT2> uvset_1;
-		wi::vector<uint32_t> colors;
-		wi::vector<XMUINT4> boneindices;
-		wi::vector<XMFLOAT4> boneweights;
-		wi::vector<XMUINT4> boneindices2;
-		wi::vector<XMFLOAT4> boneweights2;
-		wi::vector<float> softbodyweights;
-		if (!meshcomponent.vertex_normals.empty())
-		{
-			normals.resize(mesh.vertexCount);
-		}
-		if (!meshcomponent.vertex_windweights.empty())
-		{
-			winds.resize(mesh.vertexCount);
-		}
-		if (!meshcomponent.vertex_tangents.empty())
-		{
-			tangents.resize(mesh.vertexCount);
-		}
-		if (!meshcomponent.vertex_uvset_0.empty())
-		{
-			uvset_0.resize(mesh.vertexCount);
-		}
-		if (!meshcomponent.vertex_uvset_1.empty())
-		{
-			uvset_1.resize(mesh.vertexCount);
-		}
-		if (!meshcomponent.vertex_colors.empty())
-		{
-			colors.resize(mesh.vertexCount);
-		}
-		if (!meshcomponent.vertex_boneindices.empty())
-		{
-			boneindices.resize(mesh.vertexCount);
-		}
-		if (!meshcomponent.vertex_boneweights.empty())
-		{
-			boneweights.resize(mesh.vertexCount);
-		}
-		if (!meshcomponent.vertex_boneindices2.empty())
-		{
-			boneindices2.resize(mesh.vertexCount);
-		}
-		if (!meshcomponent.vertex_boneweights2.empty())
-		{
-			boneweights2.resize(mesh.vertexCount);
-		}
-		if (softbody != nullptr && !softbody->weights.empty())
-		{
-			softbodyweights.resize(mesh.vertexCount);
-		}
 
-		for (uint32_t j = 0; j < mesh.indexCount; ++j)
+		MeshAtlas& result = input.result;
+		result.width = atlas->width;
+		result.height = atlas->height;
+		result.vertex_count = (uint32_t)input.positions.size();
+		result.index_count = (uint32_t)input.indices.size();
+
+		const xatlas::Mesh& mesh = atlas->meshes[0];
+		result.indices.assign(mesh.indexArray, mesh.indexArray + mesh.indexCount);
+		result.xrefs.resize(mesh.vertexCount);
+		result.atlas.resize(mesh.vertexCount);
+		for (uint32_t j = 0; j < mesh.vertexCount; ++j)
 		{
-			const uint32_t ind = mesh.indexArray[j];
-			const xatlas::Vertex &v = mesh.vertexArray[ind];
-			meshcomponent.indices[j] = ind;
-			atlas[ind].x = v.uv[0] / float(dim.width);
-			atlas[ind].y = v.uv[1] / float(dim.height);
-			positions[ind] = meshcomponent.vertex_positions[v.xref];
-			if (!normals.empty())
-			{
-				normals[ind] = meshcomponent.vertex_normals[v.xref];
-			}
-			if (!winds.empty())
-			{
-				winds[ind] = meshcomponent.vertex_windweights[v.xref];
-			}
-			if (!tangents.empty())
-			{
-				tangents[ind] = meshcomponent.vertex_tangents[v.xref];
-			}
-			if (!uvset_0.empty())
-			{
-				uvset_0[ind] = meshcomponent.vertex_uvset_0[v.xref];
-			}
-			if (!uvset_1.empty())
-			{
-				uvset_1[ind] = meshcomponent.vertex_uvset_1[v.xref];
-			}
-			if (!colors.empty())
-			{
-				colors[ind] = meshcomponent.vertex_colors[v.xref];
-			}
-			if (!boneindices.empty())
-			{
-				boneindices[ind] = meshcomponent.vertex_boneindices[v.xref];
-			}
-			if (!boneweights.empty())
-			{
-				boneweights[ind] = meshcomponent.vertex_boneweights[v.xref];
-			}
-			if (!boneindices2.empty())
-			{
-				boneindices2[ind] = meshcomponent.vertex_boneindices2[v.xref];
-			}
-			if (!boneweights2.empty())
-			{
-				boneweights2[ind] = meshcomponent.vertex_boneweights2[v.xref];
-			}
-			if (softbody != nullptr && !softbodyweights.empty())
-			{
-				softbodyweights[ind] = softbody->weights[v.xref];
-			}
+			const xatlas::Vertex& v = mesh.vertexArray[j];
+			result.xrefs[j] = v.xref;
+			result.atlas[j].x = v.uv[0] / float(result.width);
+			result.atlas[j].y = v.uv[1] / float(result.height);
 		}
+	}
+
+	//// DEBUG
+	//{
+	//	const uint32_t width = objectcomponent.lightmapWidth;
+	//	const uint32_t height = objectcomponent.lightmapHeight;
+	//	objectcomponent.lightmapTextureData.resize(width * height * 4);
+	//	const xatlas::OutputMesh *mesh = xatlas::GetOutputMeshes(atlas)[0];
+	//	// Rasterize mesh triangles.
+	//	const uint8_t white[] = { 255, 255, 255 };
+	//	for (uint32_t j = 0; j < mesh->indexCount; j += 3) {
+	//		int verts[3][2];
+	//		uint8_t color[4];
+	//		for (int k = 0; k < 3; k++) {
+	//			const xatlas::OutputVertex &v = mesh->vertexArray[mesh->indexArray[j + k]];
+	//			verts[k][0] = int(v.uv[0]);
+	//			verts[k][1] = int(v.uv[1]);
+	//			color[k] = rand() % 255;
+	//		}
+	//		color[3] = 255;
+	//		if (!verts[0][0] && !verts[0][1] && !verts[1][0] && !verts[1][1] && !verts[2][0] && !verts[2][1])
+	//			continue; // Skip triangles that weren't atlased.
+	//		RasterizeTriangle(objectcomponent.lightmapTextureData.data(), width, verts[0], verts[1], verts[2], color);
+	//		RasterizeLine(objectcomponent.lightmapTextureData.data(), width, verts[0], verts[1], white);
+	//		RasterizeLine(objectcomponent.lightmapTextureData.data(), width, verts[1], verts[2], white);
+	//		RasterizeLine(objectcomponent.lightmapTextureData.data(), width, verts[2], verts[0], white);
+	//	}
+	//}
+
+	xatlas::Destroy(atlas);
+}
+
+// Rebuilds the mesh with the atlas, this must be called on the main thread
+//	returns false if the atlas was not generated from this mesh, in that case the mesh is not modified
+static bool ApplyMeshAtlas(Scene& scene, Entity entity, const MeshAtlas& result)
+{
+	if (result.xrefs.empty())
+		return true; // mesh already contains this atlas
+
+	MeshComponent& meshcomponent = *scene.meshes.GetComponent(entity);
+	if (meshcomponent.vertex_positions.size() != result.vertex_count || meshcomponent.indices.size() != result.index_count)
+		return false; // the xrefs would index out of the vertex arrays
+	SoftBodyPhysicsComponent* softbody = scene.softbodies.GetComponent(entity);
+
+	const size_t vertexCount = result.xrefs.size();
+
+	// Note: we must recreate all vertex buffers, because the index buffer will be different (the atlas could have removed shared vertices)
+	meshcomponent.indices = result.indices;
+	wi::vector<XMFLOAT3> positions(vertexCount);
+	wi::vector<XMFLOAT3> normals;
+	wi::vector<uint8_t> winds;
+	wi::vector<XMFLOAT4> tangents;
+	wi::vector<XMFLOAT2> uvset_0;
+	wi::vector<XMFLOAT2> uvset_1;
+	wi::vector<uint32_t> colors;
+	wi::vector<XMUINT4> boneindices;
+	wi::vector<XMFLOAT4> boneweights;
+	wi::vector<XMUINT4> boneindices2;
+	wi::vector<XMFLOAT4> boneweights2;
+	wi::vector<float> softbodyweights;
+	if (!meshcomponent.vertex_normals.empty())
+	{
+		normals.resize(vertexCount);
+	}
+	if (!meshcomponent.vertex_windweights.empty())
+	{
+		winds.resize(vertexCount);
+	}
+	if (!meshcomponent.vertex_tangents.empty())
+	{
+		tangents.resize(vertexCount);
+	}
+	if (!meshcomponent.vertex_uvset_0.empty())
+	{
+		uvset_0.resize(vertexCount);
+	}
+	if (!meshcomponent.vertex_uvset_1.empty())
+	{
+		uvset_1.resize(vertexCount);
+	}
+	if (!meshcomponent.vertex_colors.empty())
+	{
+		colors.resize(vertexCount);
+	}
+	if (!meshcomponent.vertex_boneindices.empty())
+	{
+		boneindices.resize(vertexCount);
+	}
+	if (!meshcomponent.vertex_boneweights.empty())
+	{
+		boneweights.resize(vertexCount);
+	}
+	if (!meshcomponent.vertex_boneindices2.empty())
+	{
+		boneindices2.resize(vertexCount);
+	}
+	if (!meshcomponent.vertex_boneweights2.empty())
+	{
+		boneweights2.resize(vertexCount);
+	}
+	if (softbody != nullptr && !softbody->weights.empty())
+	{
+		softbodyweights.resize(vertexCount);
+	}
 
-		meshcomponent.vertex_positions = positions;
-		meshcomponent.vertex_atlas = atlas;
+	for (size_t ind = 0; ind < vertexCount; ++ind)
+	{
+		const uint32_t xref = result.xrefs[ind];
+		positions[ind] = meshcomponent.vertex_positions[xref];
 		if (!normals.empty())
 		{
-			meshcomponent.vertex_normals = normals;
+			normals[ind] = meshcomponent.vertex_normals[xref];
 		}
 		if (!winds.empty())
 		{
-			meshcomponent.vertex_windweights = winds;
+			winds[ind] = meshcomponent.vertex_windweights[xref];
 		}
 		if (!tangents.empty())
 		{
-			meshcomponent.vertex_tangents = tangents;
+			tangents[ind] = meshcomponent.vertex_tangents[xref];
 		}
 		if (!uvset_0.empty())
 		{
-			meshcomponent.vertex_uvset_0 = uvset_0;
+			uvset_0[ind] = meshcomponent.vertex_uvset_0[xref];
 		}
 		if (!uvset_1.empty())
 		{
-			meshcomponent.vertex_uvset_1 = uvset_1;
+			uvset_1[ind] = meshcomponent.vertex_uvset_1[xref];
 		}
 		if (!colors.empty())
 		{
-			meshcomponent.vertex_colors = colors;
+			colors[ind] = meshcomponent.vertex_colors[xref];
 		}
 		if (!boneindices.empty())
 		{
-			meshcomponent.vertex_boneindices = boneindices;
+			boneindices[ind] = meshcomponent.vertex_boneindices[xref];
 		}
 		if (!boneweights.empty())
 		{
-			meshcomponent.vertex_boneweights = boneweights;
+			boneweights[ind] = meshcomponent.vertex_boneweights[xref];
 		}
 		if (!boneindices2.empty())
 		{
-			meshcomponent.vertex_boneindices2 = boneindices2;
+			boneindices2[ind] = meshcomponent.vertex_boneindices2[xref];
 		}
 		if (!boneweights2.empty())
 		{
-			meshcomponent.vertex_boneweights2 = boneweights2;
+			boneweights2[ind] = meshcomponent.vertex_boneweights2[xref];
 		}
 		if (softbody != nullptr && !softbodyweights.empty())
 		{
-			softbody->weights = softbodyweights;
+			softbodyweights[ind] = softbody->weights[xref];
 		}
-		meshcomponent.CreateRenderData();
-
-		if (softbody != nullptr)
-		{
-			// Recreate softbody
-			softbody->physicsobject = {};
-			softbody->physicsIndices.clear();
-			softbody->physicsToGraphicsVertexMapping.clear();
-			softbody->CreateFromMesh(meshcomponent);
-		}
-
 	}
 
-	//// DEBUG
-	//{
-	//	const uint32_t width = objectcomponent.lightmapWidth;
-	//	const uint32_t height = objectcomponent.lightmapHeight;
-	//	objectcomponent.lightmapTextureData.resize(width * height * 4);
-	//	const xatlas::OutputMesh *mesh = xatlas::GetOutputMeshes(atlas)[0];
-	//	// Rasterize mesh triangles.
-	//	const uint8_t white[] = { 255, 255, 255 };
-	//	for (uint32_t j = 0; j < mesh->indexCount; j += 3) {
-	//		int verts[3][2];
-	//		uint8_t color[4];
-	//		for (int k = 0; k < 3; k++) {
-	//			const xatlas::OutputVertex &v = mesh->vertexArray[mesh->indexArray[j + k]];
-	//			verts[k][0] = int(v.uv[0]);
-	//			verts[k][1] = int(v.uv[1]);
-	//			color[k] = rand() % 255;
-	//		}
-	//		color[3] = 255;
-	//		if (!verts[0][0] && !verts[0][1] && !verts[1][0] && !verts[1][1] && !verts[2][0] && !verts[2][1])
-	//			continue; // Skip triangles that weren't atlased.
-	//		RasterizeTriangle(objectcomponent.lightmapTextureData.data(), width, verts[0], verts[1], verts[2], color);
-	//		RasterizeLine(objectcomponent.lightmapTextureData.data(), width, verts[0], verts[1], white);
-	//		RasterizeLine(objectcomponent.lightmapTextureData.data(), width, verts[1], verts[2], white);
-	//		RasterizeLine(objectcomponent.lightmapTextureData.data(), width, verts[2], verts[0], white);
-	//	}
-	//}
-
-	xatlas::Destroy(atlas);
+	meshcomponent.vertex_positions = positions;
+	meshcomponent.vertex_atlas = result.atlas;
+	if (!normals.empty())
+	{
+		meshcomponent.vertex_normals = normals;
+	}
+	if (!winds.empty())
+	{
+		meshcomponent.vertex_windweights = winds;
+	}
+	if (!tangents.empty())
+	{
+		meshcomponent.vertex_tangents = tangents;
+	}
+	if (!uvset_0.empty())
+	{
+		meshcomponent.vertex_uvset_0 = uvset_0;
+	}
+	if (!uvset_1.empty())
+	{
+		meshcomponent.vertex_uvset_1 = uvset_1;
+	}
+	if (!colors.empty())
+	{
+		meshcomponent.vertex_colors = colors;
+	}
+	if (!boneindices.empty())
+	{
+		meshcomponent.vertex_boneindices = boneindices;
+	}
+	if (!boneweights.empty())
+	{
+		meshcomponent.vertex_boneweights = boneweights;
+	}
+	if (!boneindices2.empty())
+	{
+		meshcomponent.vertex_boneindices2 = boneindices2;
+	}
+	if (!boneweights2.empty())
+	{
+		meshcomponent.vertex_boneweights2 = boneweights2;
+	}
+	if (softbody != nullptr && !softbodyweights.empty())
+	{
+		softbody->weights = softbodyweights;
+	}
+	meshcomponent.CreateRenderData();
 
-	return dim;
+	if (softbody != nullptr)
+	{
+		// Recreate softbody
+		softbody->physicsobject = {};
+		softbody->physicsIndices.clear();
+		softbody->physicsToGraphicsVertexMapping.clear();
+		softbody->CreateFromMesh(meshcomponent);
+	}
+	return true;
 }
 
 
@@ -580,6 +652,12 @@ void ObjectWindow::Create(EditorComponent* _editor)
 	generateLightmapButton.SetSize(XMFLOAT2(wid, hei));
 	generateLightmapButton.OnClick([&](wi::gui::EventArgs args) {
 
+		if (wi::jobsystem::IsBusy(atlas_workload))
+		{
+			wi::backlog::post("[Editor] lightmap atlas generation is still in progress, please wait until it finishes!", wi::backlog::LogLevel::Warning);
+			return;
+		}
+
 		Scene& scene = editor->GetCurrentScene();
 
 		enum UV_GEN_TYPE
@@ -590,9 +668,10 @@ void ObjectWindow::Create(EditorComponent* _editor)
 			UV_GEN_GENERATE_ATLAS,
 		};
 		UV_GEN_TYPE gen_type = (UV_GEN_TYPE)lightmapSourceUVSetComboBox.GetSelected();
+		const uint32_t resolution = (uint32_t)lightmapResolutionSlider.GetValue();
 
-		wi::unordered_set<ObjectComponent*> gen_objects;
-		wi::unordered_map<Entity, Atlas_Dim> gen_meshes;
+		wi::unordered_set<Entity> gen_objects;
+		wi::unordered_set<Entity> gen_meshes;
 
 		for (auto& x : this->editor->translator.selected)
 		{
@@ -603,53 +682,153 @@ void ObjectWindow::Create(EditorComponent* _editor)
 
 				if (meshcomponent != nullptr)
 				{
-					gen_objects.insert(objectcomponent);
-					gen_meshes[objectcomponent->meshID] = Atlas_Dim();
+					gen_objects.insert(x.entity);
+					gen_meshes.insert(objectcomponent->meshID);
 				}
 			}
 
 		}
 
-		wi::jobsystem::context ctx;
-
-		for (auto& it : gen_meshes)
+		if (gen_type != UV_GEN_GENERATE_ATLAS)
 		{
-			MeshComponent& mesh = *scene.meshes.GetComponent(it.first);
-			if (gen_type == UV_GEN_COPY_UVSET_0)
-			{
-				mesh.vertex_atlas = mesh.vertex_uvset_0;
-				mesh.CreateRenderData();
-			}
-			else if (gen_type == UV_GEN_COPY_UVSET_1)
+			for (Entity meshID : gen_meshes)
 			{
-				mesh.vertex_atlas = mesh.vertex_uvset_1;
-				mesh.CreateRenderData();
+				MeshComponent& mesh = *scene.meshes.GetComponent(meshID);
+				if (gen_type == UV_GEN_COPY_UVSET_0)
+				{
+					mesh.vertex_atlas = mesh.vertex_uvset_0;
+					mesh.CreateRenderData();
+				}
+				else if (gen_type == UV_GEN_COPY_UVSET_1)
+				{
+					mesh.vertex_atlas = mesh.vertex_uvset_1;
+					mesh.CreateRenderData();
+				}
 			}
-			else if (gen_type == UV_GEN_GENERATE_ATLAS)
+
+			for (Entity entity : gen_objects)
 			{
-				wi::jobsystem::Execute(ctx, [&](wi::jobsystem::JobArgs args) {
-					it.second = GenerateMeshAtlas(scene, it.first, (uint32_t)lightmapResolutionSlider.GetValue());
-				});
+				ObjectComponent& object = *scene.objects.GetComponent(entity);
+				object.ClearLightmap();
+				object.lightmapWidth = object.lightmapHeight = resolution;
+				object.SetLightmapRenderRequest(true);
 			}
+
+			scene.SetAccelerationStructureUpdateRequested(true);
+			return;
 		}
-		wi::jobsystem::Wait(ctx);
 
-		for (auto& x : gen_objects)
+		// Only the meshes that are not in the cache need to be unwrapped, their data is copied so the scene can be freely used meanwhile:
+		auto inputs = std::make_shared<wi::vector<MeshAtlasInput>>();
+		for (Entity meshID : gen_meshes)
 		{
-			x->ClearLightmap();
-			if (gen_type == UV_GEN_GENERATE_ATLAS)
+			const MeshComponent& mesh = *scene.meshes.GetComponent(meshID);
+			const size_t hash = HashMeshAtlasInput(mesh, resolution);
+			if (atlas_cache.count(hash) > 0)
+				continue;
+			MeshAtlasInput& input = inputs->emplace_back();
+			input.meshID = meshID;
+			input.hash = hash;
+			input.positions = mesh.vertex_positions;
+			input.normals = mesh.vertex_normals;
+			input.uvset_0 = mesh.vertex_uvset_0;
+			input.indices = mesh.indices;
+		}
+
+		wi::vector<Entity> objects(gen_objects.begin(), gen_objects.end());
+		wi::vector<Entity> meshes(gen_meshes.begin(), gen_meshes.end());
+
+		// Applying the atlases modifies the scene, so it must be done on the main thread:
+		auto apply = [this, inputs, objects, meshes, resolution]() {
+			std::string errors;
+			atlas_cache_usage++;
+			for (auto& input : *inputs)
 			{
-				x->lightmapWidth = gen_meshes.at(x->meshID).width;
-				x->lightmapHeight = gen_meshes.at(x->meshID).height;
+				if (input.error.empty())
+				{
+					atlas_cache[input.hash] = std::move(input.result);
+				}
+				else
+				{
+					errors += input.error + "\n";
+				}
 			}
-			else
+			if (!errors.empty())
+			{
+				wi::helper::messageBox(errors, "Adding mesh to xatlas failed!");
+			}
+
+			Scene& scene = editor->GetCurrentScene();
+			wi::unordered_map<Entity, XMUINT2> dims;
+			for (Entity meshID : meshes)
 			{
-				x->lightmapWidth = x->lightmapHeight = (uint32_t)lightmapResolutionSlider.GetValue();
+				const MeshComponent* mesh = scene.meshes.GetComponent(meshID);
+				if (mesh == nullptr)
+					continue;
+				auto it = atlas_cache.find(HashMeshAtlasInput(*mesh, resolution));
+				if (it == atlas_cache.end())
+					continue; // failed, or the mesh was modified while the atlas was generating
+				MeshAtlas& result = it->second;
+				result.last_used = atlas_cache_usage;
+				if (!ApplyMeshAtlas(scene, meshID, result))
+				{
+					atlas_cache.erase(it); // hash collision with a different mesh, don't reuse it
+					continue;
+				}
+				dims[meshID] = XMUINT2(result.width, result.height);
+				if (!result.xrefs.empty())
+				{
+					// The modified mesh already contains the atlas, remember this so it won't be unwrapped again:
+					MeshAtlas& applied = atlas_cache[HashMeshAtlasInput(*mesh, resolution)];
+					applied.width = dims[meshID].x;
+					applied.height = dims[meshID].y;
+					applied.vertex_count = (uint32_t)mesh->vertex_positions.size();
+					applied.index_count = (uint32_t)mesh->indices.size();
+					applied.last_used = atlas_cache_usage;
+				}
 			}
-			x->SetLightmapRenderRequest(true);
+			TrimAtlasCache();
+
+			for (Entity entity : objects)
+			{
+				ObjectComponent* object = scene.objects.GetComponent(entity);
+				if (object == nullptr)
+					continue;
+				auto it = dims.find(object->meshID);
+				if (it == dims.end())
+					continue;
+				object->ClearLightmap();
+				object->lightmapWidth = it->second.x;
+				object->lightmapHeight = it->second.y;
+				object->SetLightmapRenderRequest(true);
+			}
+
+			scene.SetAccelerationStructureUpdateRequested(true);
+		};
+
+		if (inputs->empty())
+		{
+			apply();
+			return;
 		}
 
-		scene.SetAccelerationStructureUpdateRequested(true);
+		wi::backlog::post("[Editor] generating lightmap atlas for " + std::to_string(inputs->size()) + " meshes...");
+
+		atlas_workload.priority = wi::jobsystem::Priority::Low;
+		wi::jobsystem::Execute(atlas_workload, [inputs, resolution, apply](wi::jobsystem::JobArgs) {
+			wi::Timer timer;
+			wi::jobsystem::context ctx;
+			ctx.priority = wi::jobsystem::Priority::Low;
+			wi::jobsystem::Dispatch(ctx, (uint32_t)inputs->size(), 1, [inputs, resolution](wi::jobsystem::JobArgs args) {
+				GenerateMeshAtlas((*inputs)[args.jobIndex], resolution);
+			});
+			wi::jobsystem::Wait(ctx);
+			wi::backlog::post("[Editor] lightmap atlas generation finished in " + std::to_string(timer.elapsed_seconds()) + " seconds");
+
+			wi::eventhandler::Subscribe_Once(wi::eventhandler::EVENT_THREAD_SAFE_POINT, [apply](uint64_t userdata) {
+				apply();
+			});
+		});
 
 	});
 	AddWidget(&generateLightmapButton);
@@ -73,6 +73,21 @@ void ScriptWindow::Create(EditorComponent* _editor)
 	});
 	AddWidget(&playonceCheckBox);
 
+	isolatedCheckBox.Create("Isolated: ");
+	isolatedCheckBox.SetTooltip("Run the script in parallel with other isolated scripts, on a separate lua state.\nIsolated scripts can only modify their own entity, other scene modifications must be deferred with RunOnMainThread().");
+	isolatedCheckBox.SetSize(XMFLOAT2(hei, hei));
+	isolatedCheckBox.OnClick([=](wi::gui::EventArgs args) {
+		wi::scene::Scene& scene = editor->GetCurrentScene();
+		for (auto& x : editor->translator.selected)
+		{
+			ScriptComponent* script = scene.scripts.GetComponent(x.entity);
+			if (script == nullptr)
+				continue;
+			script->SetIsolated(args.bValue);
+		}
+	});
+	AddWidget(&isolatedCheckBox);
+
 	playstopButton.Create("");
 	playstopButton.SetTooltip("Play / Stop script");
 	playstopButton.SetSize(XMFLOAT2(wid, hei));
@@ -117,6 +132,7 @@ void ScriptWindow::SetEntity(wi::ecs::Entity entity)
 			fileButton.SetText("Open File...");
 		}
 		playonceCheckBox.SetCheck(script->IsPlayingOnlyOnce());
+		isolatedCheckBox.SetCheck(script->IsIsolated());
 	}
 	else
 	{
@@ -159,10 +175,14 @@ void ScriptWindow::ResizeLayout()
 
 		playonceCheckBox.SetVisible(true);
 		playonceCheckBox.SetPos(XMFLOAT2(playstopButton.GetPos().x - playonceCheckBox.GetSize().x - 4, playstopButton.GetPos().y));
+
+		isolatedCheckBox.SetVisible(true);
+		isolatedCheckBox.SetPos(XMFLOAT2(playonceCheckBox.GetPos().x, playstopButton.GetPos().y + playstopButton.GetSize().y + 4));
 	}
 	else
 	{
 		playstopButton.SetVisible(false);
 		playonceCheckBox.SetVisible(false);
+		isolatedCheckBox.SetVisible(false);
 	}
 }
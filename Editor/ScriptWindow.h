@@ -12,6 +12,7 @@ public:
 
 	wi::gui::Button fileButton;
 	wi::gui::CheckBox playonceCheckBox;
+	wi::gui::CheckBox isolatedCheckBox;
 	wi::gui::Button playstopButton;
 
 	void Update(const wi::Canvas& canvas, float dt) override;
@@ -276,6 +276,7 @@ void SoundWindow::Create(EditorComponent* _editor)
 void WaveGraph::Render(const wi::Canvas& canvas, wi::graphics::CommandList cmd) const
 {
 	GraphicsDevice* device = wi::graphics::GetDevice();
+	wi::image::FlushBatch(cmd); // the parent window must be drawn before the wave, custom draws can't be batched
 	device->EventBegin("Sound Wave", cmd);
 
 	static bool shaders_loaded = false;
@@ -297,7 +298,7 @@ void WaveGraph::Render(const wi::Canvas& canvas, wi::graphics::CommandList cmd)
 	XMFLOAT4 base_color = font.params.color;
 	base_color.w = 1;
 
-	if (sound == nullptr || !sound->soundResource.IsValid())
+	if (sound == nullptr || !sound->soundResource.IsValid() || wi::audio::GetSampleInfo(&sound->soundResource.GetSound()).samples == nullptr)
 	{
 		// Vertices for straight line:
 		Vertex vert;
@@ -301,7 +301,6 @@ void Translator::Update(const CameraComponent& camera, const XMFLOAT4& currentMo
 					dragStarted = true;
 					transform_start = transform;
 					XMStoreFloat3(&intersection_start, intersection);
-					matrices_start = matrices_current;
 				}
 				XMVECTOR intersectionPrev = XMLoadFloat3(&intersection_start);
 
@@ -400,7 +399,6 @@ void Translator::Update(const CameraComponent& camera, const XMFLOAT4& currentMo
 					dragStarted = true;
 					transform_start = transform;
 					XMStoreFloat3(&intersection_start, intersection);
-					matrices_start = matrices_current;
 				}
 				XMVECTOR intersectionPrev = XMLoadFloat3(&intersection_start);
 
@@ -79,7 +79,6 @@ public:
 	bool IsInteracting() const { return state != TRANSLATOR_IDLE; }
 
 	wi::scene::TransformComponent transform_start;
-	wi::vector<XMFLOAT4X4> matrices_start;
 	wi::vector<XMFLOAT4X4> matrices_current;
 };
 
@@ -1,4 +1,9 @@
 #include "stdafx.h"
+#include "wiGraphicsDevice_Null.h"
+
+// Only the declarations are needed for the reference decode, the implementation is compiled into the engine library:
+#define STB_VORBIS_HEADER_ONLY
+#include "Utility/stb_vorbis.c"
 
 #define CONTENT_DIR "../../Content/"
 
@@ -27,6 +32,26 @@ enum TEST_TYPE
 	INVERSEKINEMATICSTEST,
 	INSTANCESTEST,
 	CONTAINERPERF,
+	RADIXSORTPERF,
+	ECSLOOKUPPERF,
+	AUDIOSTREAMTEST,
+	AUDIOVOICEPOOLTEST,
+	NETWORKBATCHPERF,
+	NETWORKCHANNELTEST,
+	SNAPSHOTREPLICATIONTEST,
+	LUAISOLATEDSCRIPTPERF,
+	LUAMATHPERF,
+	LUAGCPERF,
+	PATHHIERARCHYPERF,
+	PATHQUERYBATCHPERF,
+	FONTATLASPERF,
+	FONTLAYOUTPERF,
+	IMAGEBATCHPERF,
+	MESHOPTIMIZEPERF,
+	OCEANCPUPERF,
+	HAIRGENERATIONPERF,
+	EMITTERCPUPERF,
+	HIERARCHYIKTEST,
 };
 
 // Controller Test UI Data, info down below will be using Xbox Controller as reference
@@ -159,6 +184,26 @@ void TestsRenderer::Load()
 	testSelector.AddItem("Inverse Kinematics", INVERSEKINEMATICSTEST);
 	testSelector.AddItem("65k Instances", INSTANCESTEST);
 	testSelector.AddItem("Container perf", CONTAINERPERF);
+	testSelector.AddItem("Radix sort perf", RADIXSORTPERF);
+	testSelector.AddItem("ECS lookup perf", ECSLOOKUPPERF);
+	testSelector.AddItem("Audio stream decode", AUDIOSTREAMTEST);
+	testSelector.AddItem("Audio voice pool", AUDIOVOICEPOOLTEST);
+	testSelector.AddItem("Network batch perf", NETWORKBATCHPERF);
+	testSelector.AddItem("Network reliable channel", NETWORKCHANNELTEST);
+	testSelector.AddItem("Scene snapshot replication", SNAPSHOTREPLICATIONTEST);
+	testSelector.AddItem("Lua isolated scripts perf", LUAISOLATEDSCRIPTPERF);
+	testSelector.AddItem("Lua math perf", LUAMATHPERF);
+	testSelector.AddItem("Lua GC budget perf", LUAGCPERF);
+	testSelector.AddItem("Path hierarchy perf", PATHHIERARCHYPERF);
+	testSelector.AddItem("Path query batch perf", PATHQUERYBATCHPERF);
+	testSelector.AddItem("Font atlas perf", FONTATLASPERF);
+	testSelector.AddItem("Font layout cache perf", FONTLAYOUTPERF);
+	testSelector.AddItem("Image batching perf", IMAGEBATCHPERF);
+	testSelector.AddItem("Mesh optimize (ACMR)", MESHOPTIMIZEPERF);
+	testSelector.AddItem("Ocean CPU simulation", OCEANCPUPERF);
+	testSelector.AddItem("Hair particle generation perf", HAIRGENERATIONPERF);
+	testSelector.AddItem("Emitter CPU simulation perf", EMITTERCPUPERF);
+	testSelector.AddItem("Hierarchy update with IK", HIERARCHYIKTEST);
 	testSelector.SetMaxVisibleItemCount(10);
 	testSelector.OnSelect([=](wi::gui::EventArgs args) {
 
@@ -171,6 +216,8 @@ void TestsRenderer::Load()
 		wi::scene::GetScene().weather = WeatherComponent();
 		this->ClearSprites();
 		this->ClearFonts();
+		GetGUI().RemoveWidget(&imageBatchWindow);
+		GetGUI().SetBatchingEnabled(false);
 		if (wi::lua::GetLuaState() != nullptr) {
             wi::lua::KillProcesses();
         }
@@ -419,6 +466,74 @@ void TestsRenderer::Load()
 			ContainerTest();
 			break;
 
+		case RADIXSORTPERF:
+			RadixSortTest();
+			break;
+
+		case ECSLOOKUPPERF:
+			EntityLookupTest();
+			break;
+
+		case AUDIOSTREAMTEST:
+			AudioStreamTest();
+			break;
+
+		case AUDIOVOICEPOOLTEST:
+			AudioVoicePoolTest();
+			break;
+
+		case NETWORKBATCHPERF:
+			NetworkBatchTest();
+			break;
+
+		case NETWORKCHANNELTEST:
+			NetworkChannelTest();
+			break;
+
+		case SNAPSHOTREPLICATIONTEST:
+			SnapshotReplicationTest();
+			break;
+
+		case LUAISOLATEDSCRIPTPERF:
+			LuaIsolatedScriptTest();
+			break;
+		case LUAMATHPERF:
+			LuaMathTest();
+			break;
+		case LUAGCPERF:
+			LuaGarbageCollectionTest();
+			break;
+		case PATHHIERARCHYPERF:
+			PathHierarchyTest();
+			break;
+		case PATHQUERYBATCHPERF:
+			PathQueryBatchTest();
+			break;
+		case FONTATLASPERF:
+			FontAtlasTest();
+			break;
+		case FONTLAYOUTPERF:
+			FontLayoutTest();
+			break;
+		case IMAGEBATCHPERF:
+			ImageBatchTest();
+			break;
+		case MESHOPTIMIZEPERF:
+			MeshOptimizeTest();
+			break;
+		case OCEANCPUPERF:
+			OceanCPUTest();
+			break;
+		case HAIRGENERATIONPERF:
+			HairGenerationTest();
+			break;
+		case EMITTERCPUPERF:
+			EmittedParticleCPUTest();
+			break;
+		case HIERARCHYIKTEST:
+			HierarchyIKTest();
+			break;
+
 		default:
 			assert(0);
 			break;
@@ -618,6 +733,35 @@ void TestsRenderer::Update(float dt)
 	}
 	break;
 
+	case IMAGEBATCHPERF:
+	{
+		// The GUI is rendered with and without batching in alternating frames, the counters of the last frame are shown for both:
+		const bool batching = GetGUI().IsBatchingEnabled();
+		imageBatchStatistics[batching] = wi::image::GetDrawStatistics();
+		wi::image::ResetDrawStatistics();
+		GetGUI().SetBatchingEnabled(!batching);
+
+		const wi::image::DrawStatistics& immediate = imageBatchStatistics[0];
+		const wi::image::DrawStatistics& batched = imageBatchStatistics[1];
+		auto row = [](const char* name, uint32_t a, uint32_t b) {
+			return std::string(name) + ": " + std::to_string(a) + " -> " + std::to_string(b) + "\n";
+		};
+		std::string ss = "Image batching test (immediate -> batched, all 2D draws of the last frame):\n\n";
+		ss += row("images", immediate.images, batched.images);
+		ss += row("texts", immediate.texts, batched.texts);
+		ss += row("draw calls", immediate.draw_calls, batched.draw_calls);
+		ss += row("pipeline binds", immediate.pipeline_binds, batched.pipeline_binds);
+		ss += row("constant buffer binds", immediate.constant_buffer_binds, batched.constant_buffer_binds);
+		ss += row("GPU allocations", immediate.gpu_allocations, batched.gpu_allocations);
+		ss += "batched images: " + std::to_string(batched.batched_images) + "\n";
+		ss += "batched texts: " + std::to_string(batched.batched_texts) + "\n";
+		ss += "batch layers: " + std::to_string(batched.batch_layers) + "\n";
+		ss += "batch flushes: " + std::to_string(batched.batch_flushes) + "\n";
+		ss += "fewer draw calls: " + std::string(batched.draw_calls > 0 && batched.draw_calls < immediate.draw_calls ? "yes" : "NO") + "\n";
+		imageBatchFont.SetText(ss);
+	}
+	break;
+
 	}
 
     RenderPath3D::Update(dt);
@@ -1257,3 +1401,1948 @@ void TestsRenderer::ContainerTest()
 	font.params.size = 24;
 	this->AddFont(&font);
 }
+void TestsRenderer::RadixSortTest()
+{
+	wi::Timer timer;
+
+	// This is laid out like the renderer's RenderBatch, which is sorted by a 64-bit key every frame:
+	struct Batch
+	{
+		uint32_t meshIndex;
+		uint32_t instanceIndex;
+		uint16_t distance;
+		uint8_t camera_mask;
+		uint8_t lod_override;
+		uint32_t sort_bits;
+
+		constexpr uint64_t GetSortKey() const
+		{
+			return uint64_t(distance) | (uint64_t(meshIndex & 0xFFFF) << 16ull) | (uint64_t(sort_bits) << 32ull);
+		}
+	};
+
+	std::string ss = "Radix sort test:\n";
+	ss += "You can find out more in Tests.cpp, RadixSortTest() function.\n";
+
+	for (size_t elements : { 1000, 10000, 100000, 1000000 })
+	{
+		wi::vector<Batch> source(elements);
+		for (size_t i = 0; i < elements; ++i)
+		{
+			Batch& batch = source[i];
+			batch.meshIndex = wi::random::GetRandom(0, 1000);
+			batch.instanceIndex = uint32_t(i);
+			batch.distance = (uint16_t)wi::random::GetRandom(0, 65535);
+			batch.camera_mask = 0xFF;
+			batch.lod_override = 0xFF;
+			batch.sort_bits = wi::random::GetRandom(0, 8);
+		}
+
+		ss += "\n" + std::to_string(elements) + " elements:\n";
+
+		wi::vector<Batch> batches = source;
+		timer.record();
+		std::sort(batches.begin(), batches.end(), [](const Batch& a, const Batch& b) {
+			return a.GetSortKey() < b.GetSortKey();
+		});
+		ss += "std::sort: " + std::to_string(timer.elapsed_milliseconds()) + " ms\n";
+
+		wi::vector<Batch> batches_radix = source;
+		wi::vector<Batch> scratch;
+		timer.record();
+		wi::radixsort::sort(batches_radix, scratch, [](const Batch& batch) {
+			return batch.GetSortKey();
+		});
+		ss += "wi::radixsort::sort: " + std::to_string(timer.elapsed_milliseconds()) + " ms\n";
+
+		bool match = true;
+		for (size_t i = 0; i < elements; ++i)
+		{
+			match &= batches[i].GetSortKey() == batches_radix[i].GetSortKey();
+		}
+		if (!match)
+		{
+			ss += "ERROR: sorting results don't match!\n";
+		}
+	}
+
+	static wi::SpriteFont font;
+	font = wi::SpriteFont(ss);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 2;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 24;
+	this->AddFont(&font);
+}
+
+void TestsRenderer::EntityLookupTest()
+{
+	wi::Timer timer;
+
+	// Same component count as the "65k Instances" test, Scene::Update time of that can be seen in the profiler
+	const size_t elements = 65536;
+	const size_t lookups = 10000000;
+
+	std::string ss = "ECS lookup test for " + std::to_string(elements) + " components, " + std::to_string(lookups) + " lookups:\n";
+	ss += "You can find out more in Tests.cpp, EntityLookupTest() function.\n\n";
+
+	// Entities are interleaved with other entities like in a real scene:
+	wi::vector<Entity> entities(elements);
+	for (size_t i = 0; i < elements; ++i)
+	{
+		entities[i] = CreateEntity();
+		CreateEntity();
+	}
+	wi::vector<uint32_t> order(lookups);
+	for (size_t i = 0; i < lookups; ++i)
+	{
+		order[i] = wi::random::GetRandom(0u, uint32_t(elements - 1));
+	}
+
+	wi::ecs::EntityLookup_HashMap lookup_hashmap;
+	wi::ecs::EntityLookup_SparseSet lookup_sparseset;
+
+	timer.record();
+	for (size_t i = 0; i < elements; ++i)
+	{
+		lookup_hashmap.set(entities[i], i);
+	}
+	ss += "hash map insertion: " + std::to_string(timer.elapsed_milliseconds()) + " ms\n";
+
+	timer.record();
+	for (size_t i = 0; i < elements; ++i)
+	{
+		lookup_sparseset.set(entities[i], i);
+	}
+	ss += "sparse set insertion: " + std::to_string(timer.elapsed_milliseconds()) + " ms\n";
+
+	size_t checksum_hashmap = 0;
+	timer.record();
+	for (size_t i = 0; i < lookups; ++i)
+	{
+		checksum_hashmap += lookup_hashmap.find(entities[order[i]]);
+	}
+	ss += "hash map lookup: " + std::to_string(timer.elapsed_milliseconds()) + " ms\n";
+
+	size_t checksum_sparseset = 0;
+	timer.record();
+	for (size_t i = 0; i < lookups; ++i)
+	{
+		checksum_sparseset += lookup_sparseset.find(entities[order[i]]);
+	}
+	ss += "sparse set lookup: " + std::to_string(timer.elapsed_milliseconds()) + " ms\n";
+
+	if (checksum_hashmap != checksum_sparseset)
+	{
+		ss += "ERROR: lookup results don't match!\n";
+	}
+
+	wi::ecs::ComponentManager<TransformComponent> transforms;
+	for (size_t i = 0; i < elements; ++i)
+	{
+		transforms.Create(entities[i]);
+	}
+	timer.record();
+	for (size_t i = 0; i < lookups; ++i)
+	{
+		TransformComponent* transform = transforms.GetComponent(entities[order[i]]);
+		transform->translation_local.x += 1;
+	}
+	ss += "\nComponentManager::GetComponent(): " + std::to_string(timer.elapsed_milliseconds()) + " ms\n";
+
+	static wi::SpriteFont font;
+	font = wi::SpriteFont(ss);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 2;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 24;
+	this->AddFont(&font);
+}
+
+void TestsRenderer::AudioStreamTest()
+{
+	std::string ss = "Audio stream decode test for models/water.ogg:\n\n";
+
+	wi::vector<uint8_t> filedata;
+	wi::audio::StreamDecoder decoder;
+	short* reference = nullptr;
+	int reference_channels = 0;
+	int reference_sample_rate = 0;
+	int reference_count = -1;
+	if (wi::helper::FileRead(CONTENT_DIR "models/water.ogg", filedata) &&
+		wi::audio::CreateStreamDecoder(filedata.data(), filedata.size(), &decoder))
+	{
+		const wi::audio::SampleInfo info = wi::audio::GetSampleInfo(&decoder);
+		ss += "channels: " + std::to_string(info.channel_count) + ", sample rate: " + std::to_string(info.sample_rate) + ", samples: " + std::to_string(info.sample_count) + "\n";
+
+		wi::Timer timer;
+
+		// Reference: the whole file decoded by stb_vorbis in one call, this is how non-streaming sounds are loaded:
+		timer.record();
+		reference_count = stb_vorbis_decode_memory(filedata.data(), (int)filedata.size(), &reference_channels, &reference_sample_rate, &reference);
+		ss += "stb_vorbis_decode_memory: " + std::to_string(timer.elapsed_milliseconds()) + " ms, " + std::to_string(std::max(0, reference_count) * reference_channels * sizeof(short) / 1024) + " KB PCM\n";
+
+		// Streaming decode in the same block size that streaming sound instances use:
+		const size_t block_samples = 8192;
+		wi::vector<short> block(block_samples * info.channel_count);
+		size_t stream_count = 0;
+		size_t mismatch_count = 0;
+		double first_block_time = 0;
+		timer.record();
+		while (reference_count >= 0)
+		{
+			const size_t count = wi::audio::DecodeStream(&decoder, block.data(), block_samples);
+			if (stream_count == 0)
+			{
+				first_block_time = timer.elapsed_milliseconds();
+			}
+			if (count == 0)
+				break;
+			for (size_t i = 0; i < count * info.channel_count; ++i)
+			{
+				const size_t idx = stream_count * info.channel_count + i;
+				if (idx >= size_t(reference_count) * reference_channels || reference[idx] != block[i])
+				{
+					mismatch_count++;
+				}
+			}
+			stream_count += count;
+		}
+		ss += "streaming decode: " + std::to_string(timer.elapsed_milliseconds()) + " ms total, first block: " + std::to_string(first_block_time) + " ms, " + std::to_string(block.size() * sizeof(short) / 1024) + " KB PCM per block\n";
+
+		// Seeking back to the middle must produce the reference samples again:
+		size_t seek_mismatch_count = 0;
+		const size_t seek_sample = stream_count / 2;
+		if (reference_count >= 0 && wi::audio::SeekStream(&decoder, seek_sample))
+		{
+			const size_t count = wi::audio::DecodeStream(&decoder, block.data(), block_samples);
+			for (size_t i = 0; i < count * info.channel_count; ++i)
+			{
+				const size_t idx = seek_sample * info.channel_count + i;
+				if (idx >= size_t(reference_count) * reference_channels || reference[idx] != block[i])
+				{
+					seek_mismatch_count++;
+				}
+			}
+		}
+		else
+		{
+			seek_mismatch_count = ~0ull;
+		}
+
+		ss += "\n";
+		if (reference_count < 0)
+		{
+			ss += "ERROR: stb_vorbis_decode_memory failed!\n";
+		}
+		else if (reference_channels != (int)info.channel_count || reference_sample_rate != (int)info.sample_rate)
+		{
+			ss += "ERROR: sample format doesn't match the reference!\n";
+		}
+		else if (size_t(reference_count) != stream_count)
+		{
+			ss += "ERROR: sample counts don't match! reference: " + std::to_string(reference_count) + ", stream: " + std::to_string(stream_count) + "\n";
+		}
+		else if (mismatch_count > 0)
+		{
+			ss += "ERROR: " + std::to_string(mismatch_count) + " samples don't match the reference!\n";
+		}
+		else if (seek_mismatch_count > 0)
+		{
+			ss += "ERROR: samples after seeking don't match the reference!\n";
+		}
+		else
+		{
+			ss += "Streaming decode matches the stb_vorbis reference decode.\n";
+		}
+		free(reference);
+	}
+	else
+	{
+		ss += "ERROR: failed to open Ogg stream!\n";
+	}
+
+	static wi::SpriteFont font;
+	font = wi::SpriteFont(ss);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 2;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 24;
+	this->AddFont(&font);
+}
+
+void TestsRenderer::AudioVoicePoolTest()
+{
+	std::string ss = "Audio voice pool test:\n\n";
+
+	wi::audio::Sound sound;
+	if (!wi::audio::CreateSound(CONTENT_DIR "models/water.wav", &sound))
+	{
+		ss += "ERROR: failed to create sound, audio might not be available!\n";
+	}
+	else
+	{
+		const uint32_t instance_count = 512;
+		const uint32_t budget = 32;
+		const uint32_t prev_budget = wi::audio::GetVoiceBudget();
+		wi::audio::SetVoiceBudget(budget);
+
+		wi::Timer timer;
+		wi::vector<wi::audio::SoundInstance> instances(instance_count);
+		timer.record();
+		for (auto& instance : instances)
+		{
+			wi::audio::CreateSoundInstance(&sound, &instance);
+			wi::audio::SetVolume(wi::random::GetRandom(0u, 1000u) / 1000.0f * 0.1f, &instance);
+		}
+		ss += std::to_string(instance_count) + " sound instances created: " + std::to_string(timer.elapsed_milliseconds()) + " ms\n";
+
+		timer.record();
+		for (auto& instance : instances)
+		{
+			wi::audio::Play(&instance);
+		}
+		ss += std::to_string(instance_count) + " sound instances played: " + std::to_string(timer.elapsed_milliseconds()) + " ms\n";
+
+		timer.record();
+		wi::audio::UpdateVoices();
+		ss += "voice update (redistribution): " + std::to_string(timer.elapsed_milliseconds()) + " ms\n";
+
+		timer.record();
+		wi::audio::UpdateVoices();
+		ss += "voice update (steady): " + std::to_string(timer.elapsed_milliseconds()) + " ms\n";
+
+		const wi::audio::VoiceStatistics stats = wi::audio::GetVoiceStatistics();
+		ss += "\nvoice budget: " + std::to_string(budget) + "\n";
+		ss += "real voices: " + std::to_string(stats.real_voices) + "\n";
+		ss += "virtual voices: " + std::to_string(stats.virtual_voices) + "\n";
+		ss += "pooled voices: " + std::to_string(stats.pooled_voices) + "\n";
+		ss += "created voices (total): " + std::to_string(stats.created_voices) + "\n";
+
+		// The real voices must be given to the loudest instances:
+		float quietest_real = 1;
+		float loudest_virtual = 0;
+		for (auto& instance : instances)
+		{
+			const float volume = wi::audio::GetVolume(&instance);
+			if (wi::audio::IsVirtual(&instance))
+			{
+				loudest_virtual = std::max(loudest_virtual, volume);
+			}
+			else
+			{
+				quietest_real = std::min(quietest_real, volume);
+			}
+		}
+
+		ss += "\n";
+		if (stats.real_voices > budget)
+		{
+			ss += "ERROR: voice budget exceeded!\n";
+		}
+		else if (loudest_virtual > quietest_real)
+		{
+			ss += "ERROR: a virtual voice is louder than a real voice!\n";
+		}
+		else
+		{
+			ss += "The loudest instances are playing on real voices.\n";
+		}
+
+		for (auto& instance : instances)
+		{
+			wi::audio::Stop(&instance);
+		}
+		instances.clear();
+		wi::audio::SetVoiceBudget(prev_budget);
+	}
+
+	static wi::SpriteFont font;
+	font = wi::SpriteFont(ss);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 2;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 24;
+	this->AddFont(&font);
+}
+
+void TestsRenderer::NetworkBatchTest()
+{
+	std::string ss = "Network batch perf test (loopback UDP):\n\n";
+
+	const size_t packet_count = 64 * 1024;
+	const size_t packet_size = 512;
+	const size_t batch_size = 64;
+
+	wi::network::Connection connection;
+	connection.ipaddress = { 127,0,0,1 }; // localhost
+	connection.port = 12346;
+
+	wi::network::Socket sender;
+	wi::network::Socket receiver;
+	if (!wi::network::CreateSocket(&sender) || !wi::network::CreateSocket(&receiver) || !wi::network::ListenPort(&receiver, connection.port))
+	{
+		ss += "ERROR: failed to create sockets!\n";
+	}
+	else
+	{
+		// All packet buffers are allocated up front, the send and receive loops don't allocate:
+		wi::vector<uint8_t> send_memory(packet_size * batch_size);
+		wi::vector<uint8_t> receive_memory(packet_size * batch_size);
+		wi::vector<wi::network::Datagram> send_datagrams(batch_size);
+		wi::vector<wi::network::Datagram> receive_datagrams(batch_size);
+		for (size_t i = 0; i < batch_size; ++i)
+		{
+			send_datagrams[i].connection = connection;
+			send_datagrams[i].data = send_memory.data() + i * packet_size;
+			send_datagrams[i].dataSize = packet_size;
+			receive_datagrams[i].data = receive_memory.data() + i * packet_size;
+			receive_datagrams[i].capacity = packet_size;
+		}
+
+		auto report = [&](const char* name, double milliseconds, size_t received, size_t corrupted) {
+			const double seconds = std::max(milliseconds, 0.001) / 1000.0;
+			ss += std::string(name) + ": " + std::to_string(milliseconds) + " ms, " + std::to_string(uint64_t(received / seconds)) + " packets/s, " + std::to_string(uint64_t(received * packet_size / seconds / (1024 * 1024))) + " MB/s";
+			ss += ", received: " + std::to_string(received) + " / " + std::to_string(packet_count);
+			if (corrupted > 0)
+			{
+				ss += ", ERROR: " + std::to_string(corrupted) + " corrupted packets!";
+			}
+			ss += "\n";
+		};
+
+		// The packets are sent in rounds of batch size, and each round is received before the next one,
+		//	so that the socket receive buffer doesn't overflow and drop packets:
+		wi::Timer timer;
+		{
+			size_t received = 0;
+			size_t corrupted = 0;
+			uint32_t sequence = 0;
+			timer.record();
+			for (size_t round = 0; round < packet_count / batch_size; ++round)
+			{
+				for (size_t i = 0; i < batch_size; ++i)
+				{
+					std::memcpy(send_memory.data(), &sequence, sizeof(sequence));
+					sequence++;
+					wi::network::Send(&sender, &connection, send_memory.data(), packet_size);
+				}
+				for (size_t i = 0; i < batch_size && wi::network::CanReceive(&receiver, 1000); ++i)
+				{
+					wi::network::Connection sender_connection;
+					wi::network::Receive(&receiver, &sender_connection, receive_memory.data(), packet_size);
+					uint32_t value;
+					std::memcpy(&value, receive_memory.data(), sizeof(value));
+					corrupted += value != uint32_t(round * batch_size + i) ? 1 : 0;
+					received++;
+				}
+			}
+			report("Send + CanReceive + Receive (per packet)", timer.elapsed_milliseconds(), received, corrupted);
+		}
+
+		wi::network::SetNonBlocking(&receiver, true);
+		{
+			size_t received = 0;
+			size_t corrupted = 0;
+			uint32_t sequence = 0;
+			timer.record();
+			for (size_t round = 0; round < packet_count / batch_size; ++round)
+			{
+				for (size_t i = 0; i < batch_size; ++i)
+				{
+					std::memcpy(send_datagrams[i].data, &sequence, sizeof(sequence));
+					sequence++;
+				}
+				wi::network::SendBatch(&sender, send_datagrams.data(), batch_size);
+
+				size_t round_received = 0;
+				wi::Timer round_timer;
+				while (round_received < batch_size && round_timer.elapsed_milliseconds() < 10)
+				{
+					const size_t count = wi::network::ReceiveBatch(&receiver, receive_datagrams.data() + round_received, batch_size - round_received);
+					for (size_t i = round_received; i < round_received + count; ++i)
+					{
+						uint32_t value;
+						std::memcpy(&value, receive_datagrams[i].data, sizeof(value));
+						corrupted += (value != uint32_t(round * batch_size + i) || receive_datagrams[i].dataSize != packet_size) ? 1 : 0;
+					}
+					round_received += count;
+				}
+				received += round_received;
+			}
+			report("SendBatch + ReceiveBatch (non-blocking)", timer.elapsed_milliseconds(), received, corrupted);
+		}
+		wi::network::SetNonBlocking(&receiver, false);
+	}
+
+	static wi::SpriteFont font;
+	font = wi::SpriteFont(ss);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 2;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 24;
+	this->AddFont(&font);
+}
+
+void TestsRenderer::NetworkChannelTest()
+{
+	std::string ss = "Network reliable channel test (loopback UDP with simulated network conditions):\n\n";
+
+	const uint32_t message_count = 2000;
+	const float frame_time = 1.0f / 60.0f;
+
+	wi::network::ChannelDesc desc;
+	desc.simulated_packet_loss = 0.2f;
+	desc.simulated_latency = 0.05f;
+	desc.simulated_jitter = 0.02f;
+	ss += "packet loss: " + std::to_string(int(desc.simulated_packet_loss * 100)) + "%, latency: " + std::to_string(int(desc.simulated_latency * 1000)) + " ms, jitter: " + std::to_string(int(desc.simulated_jitter * 1000)) + " ms\n";
+
+	// Two endpoints that both send and receive through their own channel:
+	wi::network::Connection connection_a;
+	connection_a.port = 12347;
+	wi::network::Connection connection_b;
+	connection_b.port = 12348;
+	wi::network::Socket socket_a;
+	wi::network::Socket socket_b;
+	wi::network::Channel channel_a;
+	wi::network::Channel channel_b;
+	bool success = wi::network::CreateSocket(&socket_a) && wi::network::CreateSocket(&socket_b);
+	success = success && wi::network::ListenPort(&socket_a, connection_a.port) && wi::network::ListenPort(&socket_b, connection_b.port);
+	success = success && wi::network::SetNonBlocking(&socket_a) && wi::network::SetNonBlocking(&socket_b);
+	success = success && wi::network::CreateChannel(&socket_a, &connection_b, &desc, &channel_a);
+	desc.simulation_seed = 2;
+	success = success && wi::network::CreateChannel(&socket_b, &connection_a, &desc, &channel_b);
+	if (!success)
+	{
+		ss += "ERROR: failed to create sockets!\n";
+	}
+	else
+	{
+		// Every 50th message is large, so that it needs to be fragmented:
+		auto message_size = [](uint32_t index) {
+			return index % 50 == 0 ? size_t(20000) : size_t(16 + (index * 7) % 300);
+		};
+		auto message_value = [](uint32_t index, size_t offset) {
+			return uint8_t(index * 31 + offset);
+		};
+
+		wi::vector<uint8_t> receive_memory(1500 * 64);
+		wi::vector<wi::network::Datagram> datagrams(64);
+		for (size_t i = 0; i < datagrams.size(); ++i)
+		{
+			datagrams[i].data = receive_memory.data() + i * 1500;
+			datagrams[i].capacity = 1500;
+		}
+		auto receive_packets = [&](wi::network::Socket& sock, wi::network::Channel& channel) {
+			size_t count;
+			while ((count = wi::network::ReceiveBatch(&sock, datagrams.data(), datagrams.size())) > 0)
+			{
+				for (size_t i = 0; i < count; ++i)
+				{
+					wi::network::ProcessChannelPacket(&channel, datagrams[i].data, datagrams[i].dataSize);
+				}
+			}
+		};
+
+		uint32_t sent = 0;
+		uint32_t received = 0;
+		uint32_t received_unreliable = 0;
+		uint32_t errors = 0;
+		uint32_t frame = 0;
+		wi::vector<uint8_t> message;
+		wi::Timer timer;
+		for (; frame < 10000 && received < message_count; ++frame)
+		{
+			for (int i = 0; i < 8 && sent < message_count; ++i)
+			{
+				message.resize(message_size(sent));
+				for (size_t j = 0; j < message.size(); ++j)
+				{
+					message[j] = message_value(sent, j);
+				}
+				if (!wi::network::SendChannelMessage(&channel_a, message.data(), message.size()))
+					break; // too many messages are waiting for acknowledgement, try again next frame
+				sent++;
+			}
+			wi::network::SendChannelMessage(&channel_a, &frame, sizeof(frame), false);
+
+			wi::network::UpdateChannel(&channel_a, frame_time);
+			wi::network::UpdateChannel(&channel_b, frame_time);
+			receive_packets(socket_b, channel_b);
+			receive_packets(socket_a, channel_a);
+
+			while (wi::network::ReceiveChannelMessage(&channel_b, message))
+			{
+				if (message.size() == sizeof(frame))
+				{
+					received_unreliable++;
+					continue;
+				}
+				bool valid = message.size() == message_size(received);
+				for (size_t j = 0; j < message.size() && valid; ++j)
+				{
+					valid = message[j] == message_value(received, j);
+				}
+				errors += valid ? 0 : 1;
+				received++;
+			}
+		}
+
+		const wi::network::ChannelStatistics stats = wi::network::GetChannelStatistics(&channel_a);
+		ss += "\nreliable messages received: " + std::to_string(received) + " / " + std::to_string(message_count) + "\n";
+		ss += "unreliable messages received: " + std::to_string(received_unreliable) + " / " + std::to_string(frame) + "\n";
+		ss += "simulated time: " + std::to_string(frame * frame_time) + " s, real time: " + std::to_string(timer.elapsed_milliseconds()) + " ms\n";
+		ss += "round trip time: " + std::to_string(int(stats.rtt * 1000)) + " ms\n";
+		ss += "packets sent: " + std::to_string(stats.packets_sent) + ", acknowledged: " + std::to_string(stats.packets_acked) + ", dropped by simulation: " + std::to_string(stats.packets_dropped_by_simulation) + "\n";
+		ss += "messages resent: " + std::to_string(stats.messages_resent) + ", bytes sent: " + std::to_string(stats.bytes_sent) + "\n\n";
+
+		if (received < message_count)
+		{
+			ss += "ERROR: not all reliable messages were received!\n";
+		}
+		else if (errors > 0)
+		{
+			ss += "ERROR: " + std::to_string(errors) + " messages were corrupted or out of order!\n";
+		}
+		else
+		{
+			ss += "All reliable messages were received in order.\n";
+		}
+	}
+
+	static wi::SpriteFont font;
+	font = wi::SpriteFont(ss);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 2;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 24;
+	this->AddFont(&font);
+}
+
+void TestsRenderer::SnapshotReplicationTest()
+{
+	std::string ss = "Scene snapshot replication test (delta snapshots with delayed acknowledgements and lost snapshots):\n\n";
+
+	const uint32_t entity_count = 5000;
+	const uint32_t moved_per_frame = 50;
+	const int frame_count = 100;
+	const int ack_delay = 3; // frames until the writer receives the acknowledgement
+	const float snapshot_loss = 0.1f;
+
+	Scene source;
+	Scene destination;
+	wi::random::RNG rng;
+	for (uint32_t i = 0; i < entity_count; ++i)
+	{
+		Entity entity = CreateEntity();
+		source.names.Create(entity).name = "entity" + std::to_string(i);
+		source.layers.Create(entity);
+		TransformComponent& transform = source.transforms.Create(entity);
+		transform.Translate(XMFLOAT3(rng.next_float() * 100, rng.next_float() * 10, rng.next_float() * 100));
+		transform.RotateRollPitchYaw(XMFLOAT3(0, rng.next_float() * XM_2PI, 0));
+		transform.UpdateTransform();
+	}
+
+	wi::scene::SnapshotWriter writer;
+	wi::scene::SnapshotReader reader;
+	wi::vector<std::pair<uint32_t, int>> acks; // snapshot id, arrival frame
+	wi::Archive archive;
+	size_t full_size = 0;
+	size_t delta_size = 0;
+	size_t delta_count = 0;
+	size_t full_count = 0;
+	size_t lost = 0;
+	double write_time = 0;
+	double apply_time = 0;
+	for (int frame = 0; frame < frame_count; ++frame)
+	{
+		// Simulate gameplay, the change versions are reported like the transform update system would:
+		source.transforms.AdvanceVersion();
+		for (uint32_t i = 0; i < moved_per_frame; ++i)
+		{
+			const size_t index = rng.next_uint(0, source.transforms.GetCount() - 1);
+			TransformComponent& transform = source.transforms[index];
+			transform.Translate(XMFLOAT3(rng.next_float() - 0.5f, 0, rng.next_float() - 0.5f));
+			transform.RotateRollPitchYaw(XMFLOAT3(0, rng.next_float() - 0.5f, 0));
+			transform.UpdateTransform();
+			source.transforms.SetChanged(index);
+		}
+		if (frame % 10 == 5)
+		{
+			Entity entity = source.transforms.GetEntity(rng.next_uint(0, source.transforms.GetCount() - 1));
+			source.names.Remove(entity);
+			source.layers.Remove(entity);
+			source.transforms.Remove(entity);
+		}
+		if (frame % 10 == 7)
+		{
+			Entity entity = CreateEntity();
+			source.names.Create(entity).name = "spawned" + std::to_string(frame);
+			source.transforms.Create(entity).Translate(XMFLOAT3(rng.next_float() * 100, 0, rng.next_float() * 100));
+		}
+
+		wi::Timer timer;
+		archive.SetReadModeAndResetPos(false);
+		writer.Write(source, archive);
+		write_time += timer.elapsed_milliseconds();
+
+		const wi::scene::SnapshotWriter::Statistics& stats = writer.GetStatistics();
+		if (stats.baseline_id == 0)
+		{
+			full_size += stats.snapshot_size;
+			full_count++;
+		}
+		else
+		{
+			delta_size += stats.snapshot_size;
+			delta_count++;
+		}
+
+		// The first and the last snapshots are always delivered, so that the final state can be verified:
+		if (frame > 0 && frame < frame_count - 1 && rng.next_float() < snapshot_loss)
+		{
+			lost++;
+		}
+		else
+		{
+			timer.record();
+			wi::Archive received(archive.GetData(), archive.GetPos());
+			uint32_t snapshot_id = 0;
+			if (reader.Apply(destination, received, &snapshot_id))
+			{
+				acks.push_back(std::make_pair(snapshot_id, frame + ack_delay));
+			}
+			apply_time += timer.elapsed_milliseconds();
+		}
+
+		for (size_t i = 0; i < acks.size();)
+		{
+			if (acks[i].second <= frame)
+			{
+				writer.Acknowledge(acks[i].first);
+				acks.erase(acks.begin() + i);
+				continue;
+			}
+			i++;
+		}
+	}
+
+	// Verify that the destination scene matches the source:
+	size_t errors = 0;
+	if (source.transforms.GetCount() != destination.transforms.GetCount() || source.names.GetCount() != destination.names.GetCount() || source.layers.GetCount() != destination.layers.GetCount())
+	{
+		errors++;
+	}
+	for (size_t i = 0; i < source.transforms.GetCount(); ++i)
+	{
+		const TransformComponent& transform = source.transforms[i];
+		const Entity entity = reader.GetLocalEntity(source.transforms.GetEntity(i));
+		const TransformComponent* replicated = destination.transforms.GetComponent(entity);
+		const NameComponent* name = source.names.GetComponent(source.transforms.GetEntity(i));
+		const NameComponent* replicated_name = destination.names.GetComponent(entity);
+		if (replicated == nullptr || wi::math::Distance(transform.translation_local, replicated->translation_local) > writer.position_precision * 2)
+		{
+			errors++;
+		}
+		else if (std::abs(XMVectorGetX(XMQuaternionDot(XMLoadFloat4(&transform.rotation_local), XMLoadFloat4(&replicated->rotation_local)))) < 0.9999f)
+		{
+			errors++;
+		}
+		else if ((name == nullptr) != (replicated_name == nullptr) || (name != nullptr && name->name != replicated_name->name))
+		{
+			errors++;
+		}
+	}
+
+	ss += "entities: " + std::to_string(entity_count) + ", moved per frame: " + std::to_string(moved_per_frame) + ", frames: " + std::to_string(frame_count) + "\n";
+	ss += "acknowledgement delay: " + std::to_string(ack_delay) + " frames, lost snapshots: " + std::to_string(lost) + "\n\n";
+	ss += "full snapshots: " + std::to_string(full_count) + ", average size: " + std::to_string(full_count > 0 ? full_size / full_count : 0) + " bytes\n";
+	ss += "delta snapshots: " + std::to_string(delta_count) + ", average size: " + std::to_string(delta_count > 0 ? delta_size / delta_count : 0) + " bytes\n";
+	ss += "average write time: " + std::to_string(write_time / frame_count) + " ms, average apply time: " + std::to_string(apply_time / std::max(1, frame_count - int(lost))) + " ms\n\n";
+	if (errors > 0)
+	{
+		ss += "ERROR: " + std::to_string(errors) + " replicated entities don't match the source scene!\n";
+	}
+	else
+	{
+		ss += "The replicated scene matches the source scene.\n";
+	}
+
+	static wi::SpriteFont font;
+	font = wi::SpriteFont(ss);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 2;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 24;
+	this->AddFont(&font);
+}
+
+void TestsRenderer::LuaIsolatedScriptTest()
+{
+	std::string ss = "Lua isolated scripts performance test:\n\n";
+
+	const uint32_t script_count = 2000;
+	const int frame_count = 5;
+
+	// Every script does some work, keeps a per-entity frame counter, and defers a counter increment to the main state on the third frame:
+	static const std::string source =
+		"local sum = 0;"
+		"for i = 1, 1000 do sum = sum + math.sin(i * 0.001 + GetEntity()); end;"
+		"script_frames = script_frames or {};"
+		"script_frames[GetEntity()] = (script_frames[GetEntity()] or 0) + 1;"
+		"if script_frames[GetEntity()] == 3 then RunOnMainThread(\"isolated_test_counter = (isolated_test_counter or 0) + 1\"); end;";
+
+	Scene scene;
+	scene.dt = 1.0f / 60.0f;
+	for (uint32_t i = 0; i < script_count; ++i)
+	{
+		Entity entity = CreateEntity();
+		ScriptComponent& script = scene.scripts.Create(entity);
+		std::string str = source;
+		wi::lua::AttachScriptParameters(str, "isolated_test.lua", wi::lua::GeneratePID(), "local function GetEntity() return " + std::to_string(entity) + "; end;", "");
+		wi::lua::CompileText(str, script.script);
+		script.Play();
+	}
+
+	auto run = [&](bool isolated) {
+		wi::lua::RunText("script_frames = nil; isolated_test_counter = nil;");
+		for (size_t i = 0; i < scene.scripts.GetCount(); ++i)
+		{
+			scene.scripts[i].SetIsolated(isolated);
+		}
+		wi::lua::GetWorkerStateCount(); // create the worker states up front, so that it is not measured
+		wi::jobsystem::context ctx;
+		wi::Timer timer;
+		for (int frame = 0; frame < frame_count; ++frame)
+		{
+			scene.RunScriptUpdateSystem(ctx);
+		}
+		const double time = timer.elapsed_milliseconds() / frame_count;
+
+		lua_State* L = wi::lua::GetLuaState();
+		lua_getglobal(L, "isolated_test_counter");
+		const int counter = lua_isnumber(L, -1) ? (int)lua_tointeger(L, -1) : 0;
+		lua_pop(L, 1);
+
+		ss += std::string(isolated ? "isolated: " : "main state: ") + std::to_string(time) + " ms / frame";
+		ss += ", deferred counter: " + std::to_string(counter) + " / " + std::to_string(script_count) + "\n";
+		return time;
+	};
+
+	ss += "scripts: " + std::to_string(script_count) + ", lua worker states: " + std::to_string(wi::lua::GetWorkerStateCount()) + "\n\n";
+	const double serial_time = run(false);
+	const double isolated_time = run(true);
+	ss += "\nspeedup: " + std::to_string(serial_time / std::max(0.001, isolated_time)) + "x\n";
+	wi::lua::RunText("script_frames = nil; isolated_test_counter = nil;");
+
+	static wi::SpriteFont font;
+	font = wi::SpriteFont(ss);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 2;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 24;
+	this->AddFont(&font);
+}
+
+void TestsRenderer::LuaMathTest()
+{
+	std::string ss = "Lua math performance test:\n\n";
+
+	const int iterations = 1000000;
+
+	// Both scripts compute the same result, first with the math functions that return new objects, then with the in-place functions:
+	const std::string allocating =
+		"local pos = Vector(0, 0, 0); local vel = Vector(1, 2, 3); local rot = matrix.RotationY(0.001);"
+		"for i = 1, " + std::to_string(iterations) + " do "
+		"	vel = vector.Transform(vel, rot);"
+		"	pos = vector.Add(pos, vector.Multiply(vel, 0.01));"
+		"end;"
+		"lua_math_test_result = pos.GetX();";
+	const std::string inplace =
+		"local pos = Vector(0, 0, 0); local vel = Vector(1, 2, 3); local rot = matrix.RotationY(0.001); local step = Vector();"
+		"for i = 1, " + std::to_string(iterations) + " do "
+		"	vel.TransformInPlace(rot);"
+		"	step.CopyFrom(vel);"
+		"	step.MultiplyInPlace(0.01);"
+		"	pos.AddInPlace(step);"
+		"end;"
+		"lua_math_test_result = pos.GetX();";
+
+	lua_State* L = wi::lua::GetLuaState();
+	auto run = [&](const char* name, const std::string& script) {
+		lua_gc(L, LUA_GCCOLLECT);
+		const size_t memory_before = wi::lua::GetAllocatedMemory();
+		wi::Timer timer;
+		wi::lua::RunText(script);
+		const double time = timer.elapsed_milliseconds();
+		const size_t memory_after = wi::lua::GetAllocatedMemory();
+
+		lua_getglobal(L, "lua_math_test_result");
+		const double result = lua_tonumber(L, -1);
+		lua_pop(L, 1);
+
+		ss += std::string(name) + ": " + std::to_string(time) + " ms, result: " + std::to_string(result);
+		ss += ", garbage left: " + std::to_string((int64_t(memory_after) - int64_t(memory_before)) / 1024) + " KB\n";
+	};
+
+	ss += "iterations: " + std::to_string(iterations) + "\n\n";
+	run("allocating", allocating);
+	run("in-place", inplace);
+	wi::lua::RunText("lua_math_test_result = nil;");
+	lua_gc(L, LUA_GCCOLLECT);
+
+	static wi::SpriteFont font;
+	font = wi::SpriteFont(ss);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 2;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 24;
+	this->AddFont(&font);
+}
+
+void TestsRenderer::LuaGarbageCollectionTest()
+{
+	std::string ss = "Lua garbage collection budget test:\n\n";
+
+	const int frame_count = 300;
+
+	// Every simulated frame creates a lot of garbage and keeps some of it alive for a while:
+	wi::lua::RunText(
+		"lua_gc_test_keep = {};"
+		"function lua_gc_test_frame()"
+		"	local t = {};"
+		"	for i = 1, 20000 do t[i % 100 + 1] = { Vector(i, i, i), tostring(i) }; end;"
+		"	lua_gc_test_keep[#lua_gc_test_keep % 500 + 1] = t;"
+		"end;"
+	);
+
+	const wi::lua::GarbageCollectionMode prev_mode = wi::lua::GetGarbageCollectionMode();
+	auto run = [&](wi::lua::GarbageCollectionMode mode) {
+		wi::lua::RunText("lua_gc_test_keep = {};");
+		lua_gc(wi::lua::GetLuaState(), LUA_GCCOLLECT);
+		wi::lua::SetGarbageCollectionMode(mode);
+		const uint64_t cycles = wi::lua::GetGarbageCollectionStatistics().cycles;
+
+		double total_time = 0;
+		double max_time = 0;
+		size_t max_memory = 0;
+		uint32_t forced_steps = 0;
+		for (int frame = 0; frame < frame_count; ++frame)
+		{
+			wi::Timer timer;
+			wi::lua::RunText("lua_gc_test_frame();");
+			wi::lua::CollectGarbage();
+			const double time = timer.elapsed_milliseconds();
+			total_time += time;
+			max_time = std::max(max_time, time);
+			max_memory = std::max(max_memory, wi::lua::GetAllocatedMemory());
+			forced_steps += wi::lua::GetGarbageCollectionStatistics().forced_steps;
+		}
+
+		ss += std::string(mode == wi::lua::GarbageCollectionMode::Automatic ? "automatic" : "budgeted") + ":\n";
+		ss += "\tframe time average: " + std::to_string(total_time / frame_count) + " ms, max: " + std::to_string(max_time) + " ms\n";
+		ss += "\tmax memory: " + std::to_string(max_memory / 1024) + " KB";
+		if (mode == wi::lua::GarbageCollectionMode::Budgeted)
+		{
+			ss += ", cycles: " + std::to_string(wi::lua::GetGarbageCollectionStatistics().cycles - cycles);
+			ss += ", forced steps: " + std::to_string(forced_steps);
+		}
+		ss += "\n\n";
+	};
+
+	ss += "frames: " + std::to_string(frame_count) + ", budget: " + std::to_string(wi::lua::GetGarbageCollectionBudget()) + " ms\n\n";
+	run(wi::lua::GarbageCollectionMode::Automatic);
+	run(wi::lua::GarbageCollectionMode::Budgeted);
+	wi::lua::SetGarbageCollectionMode(prev_mode);
+	wi::lua::RunText("lua_gc_test_keep = nil; lua_gc_test_frame = nil;");
+	lua_gc(wi::lua::GetLuaState(), LUA_GCCOLLECT);
+
+	static wi::SpriteFont font;
+	font = wi::SpriteFont(ss);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 2;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 24;
+	this->AddFont(&font);
+}
+
+// Ground plane at voxel height 12 with random walls, for the path finding tests:
+static void CreatePathTestVoxelGrid(wi::VoxelGrid& voxelgrid, uint32_t resolution, wi::random::RNG& rng)
+{
+	voxelgrid.init(resolution, 16, resolution);
+	voxelgrid.set_voxelsize(0.5f);
+	for (uint32_t z = 0; z < resolution; ++z)
+	{
+		for (uint32_t x = 0; x < resolution; ++x)
+		{
+			voxelgrid.set_voxel(XMUINT3(x, 12, z), true);
+		}
+	}
+	for (int wall = 0; wall < 200; ++wall)
+	{
+		const uint32_t x = rng.next_uint(0u, resolution - 1);
+		const uint32_t z = rng.next_uint(0u, resolution - 1);
+		const uint32_t length = rng.next_uint(8u, 48u);
+		const bool along_x = rng.next_uint(0u, 1u) == 0;
+		for (uint32_t i = 0; i < length; ++i)
+		{
+			for (uint32_t y = 6; y < 12; ++y)
+			{
+				voxelgrid.set_voxel(along_x ? XMUINT3(std::min(resolution - 1, x + i), y, z) : XMUINT3(x, y, std::min(resolution - 1, z + i)), true);
+			}
+		}
+	}
+}
+void TestsRenderer::PathHierarchyTest()
+{
+	std::string ss = "Path hierarchy test:\n\n";
+
+	const uint32_t resolution = 256;
+	wi::VoxelGrid voxelgrid;
+	wi::random::RNG rng(1);
+	CreatePathTestVoxelGrid(voxelgrid, resolution, rng);
+
+	wi::PathHierarchy hierarchy;
+	hierarchy.agent_height = 2;
+	wi::Timer timer;
+	hierarchy.build(voxelgrid);
+	ss += "voxel grid: " + std::to_string(resolution) + " x 16 x " + std::to_string(resolution) + ", cluster size: " + std::to_string(hierarchy.cluster_size) + "\n";
+	ss += "build: " + std::to_string(timer.elapsed_milliseconds()) + " ms, clusters: " + std::to_string(hierarchy.get_cluster_count());
+	ss += ", nodes: " + std::to_string(hierarchy.get_node_count()) + ", edges: " + std::to_string(hierarchy.get_edge_count());
+	ss += ", memory: " + std::to_string(hierarchy.get_memory_size() / 1024) + " KB\n\n";
+
+	// Same random queries with and without the hierarchy:
+	const int query_count = 50;
+	wi::PathQuery query;
+	query.agent_height = 2;
+	double time_voxels = 0;
+	double time_hierarchy = 0;
+	int success_voxels = 0;
+	int success_hierarchy = 0;
+	for (int i = 0; i < query_count; ++i)
+	{
+		const XMFLOAT3 start = voxelgrid.coord_to_world(XMUINT3(rng.next_uint(0u, resolution - 1), 12, rng.next_uint(0u, resolution - 1)));
+		const XMFLOAT3 goal = voxelgrid.coord_to_world(XMUINT3(rng.next_uint(0u, resolution - 1), 12, rng.next_uint(0u, resolution - 1)));
+		timer.record();
+		query.process(start, goal, voxelgrid);
+		time_voxels += timer.elapsed_milliseconds();
+		success_voxels += query.is_succesful() ? 1 : 0;
+		timer.record();
+		query.process(start, goal, voxelgrid, hierarchy);
+		time_hierarchy += timer.elapsed_milliseconds();
+		success_hierarchy += query.is_succesful() ? 1 : 0;
+	}
+	ss += "queries: " + std::to_string(query_count) + "\n";
+	ss += "voxel search: " + std::to_string(time_voxels / query_count) + " ms average, found: " + std::to_string(success_voxels) + "\n";
+	ss += "hierarchical search: " + std::to_string(time_hierarchy / query_count) + " ms average, found: " + std::to_string(success_hierarchy) + "\n\n";
+
+	// Incremental update after a local modification:
+	const XMFLOAT3 corner0 = voxelgrid.coord_to_world(XMUINT3(100, 6, 100));
+	const XMFLOAT3 corner1 = voxelgrid.coord_to_world(XMUINT3(110, 11, 110));
+	voxelgrid.inject_aabb(wi::primitive::AABB(wi::math::Min(corner0, corner1), wi::math::Max(corner0, corner1)));
+	timer.record();
+	hierarchy.update(voxelgrid);
+	ss += "update after obstacle: " + std::to_string(timer.elapsed_milliseconds()) + " ms, rebuilt clusters: " + std::to_string(hierarchy.get_rebuilt_cluster_count()) + "\n";
+
+	// A copied voxel grid with the same version but different voxels must not be treated as up to date:
+	wi::VoxelGrid othergrid = voxelgrid;
+	std::fill(othergrid.voxels.begin(), othergrid.voxels.end(), 0ull);
+	othergrid.version = voxelgrid.version;
+	hierarchy.update(othergrid);
+	ss += std::string("rebuilt for copied grid: ") + (hierarchy.get_rebuilt_cluster_count() > 0 && hierarchy.get_node_count() == 0 ? "yes" : "NO") + "\n";
+
+	static wi::SpriteFont font;
+	font = wi::SpriteFont(ss);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 2;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 24;
+	this->AddFont(&font);
+}
+
+void TestsRenderer::PathQueryBatchTest()
+{
+	std::string ss = "Path query batch test:\n\n";
+
+	const uint32_t resolution = 256;
+	wi::VoxelGrid voxelgrid;
+	wi::random::RNG rng(2);
+	CreatePathTestVoxelGrid(voxelgrid, resolution, rng);
+
+	const int query_count = 256;
+	wi::vector<wi::PathQuery> queries(query_count);
+	wi::PathQueryBatch batch;
+	for (int i = 0; i < query_count; ++i)
+	{
+		wi::PathQuery& query = queries[i];
+		query.agent_height = 2;
+		wi::PathQueryBatch::Request& request = batch.requests.emplace_back();
+		request.query = &query;
+		request.startpos = voxelgrid.coord_to_world(XMUINT3(rng.next_uint(0u, resolution - 1), 12, rng.next_uint(0u, resolution - 1)));
+		request.goalpos = voxelgrid.coord_to_world(XMUINT3(rng.next_uint(0u, resolution - 1), 12, rng.next_uint(0u, resolution - 1)));
+	}
+
+	auto count_successful = [&]() {
+		int count = 0;
+		for (const wi::PathQuery& query : queries)
+		{
+			count += query.is_succesful() ? 1 : 0;
+		}
+		return count;
+	};
+
+	wi::Timer timer;
+	for (const wi::PathQueryBatch::Request& request : batch.requests)
+	{
+		request.query->process(request.startpos, request.goalpos, voxelgrid);
+	}
+	const double time_serial = timer.elapsed_milliseconds();
+	const int success_serial = count_successful();
+
+	// The first batch allocates the scratch storage of the workers, the second one reuses it:
+	double time_batch[2] = {};
+	for (int i = 0; i < arraysize(time_batch); ++i)
+	{
+		timer.record();
+		wi::jobsystem::context ctx;
+		batch.process(ctx, voxelgrid);
+		wi::jobsystem::Wait(ctx);
+		time_batch[i] = timer.elapsed_milliseconds();
+	}
+	const int success_batch = count_successful();
+
+	ss += "voxel grid: " + std::to_string(resolution) + " x 16 x " + std::to_string(resolution) + ", queries: " + std::to_string(query_count);
+	ss += ", threads: " + std::to_string(wi::jobsystem::GetThreadCount() + 1) + "\n\n";
+	ss += "serial: " + std::to_string(time_serial) + " ms, found: " + std::to_string(success_serial) + "\n";
+	ss += "batch (first): " + std::to_string(time_batch[0]) + " ms\n";
+	ss += "batch (reused scratch): " + std::to_string(time_batch[1]) + " ms, found: " + std::to_string(success_batch) + "\n";
+	ss += "scratch memory: " + std::to_string(batch.get_memory_size() / 1024) + " KB\n";
+
+	static wi::SpriteFont font;
+	font = wi::SpriteFont(ss);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 2;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 24;
+	this->AddFont(&font);
+}
+
+void TestsRenderer::FontAtlasTest()
+{
+	std::string ss = "Font atlas test:\n\n";
+
+	std::string characters;
+	for (char c = '!'; c <= '~'; ++c)
+	{
+		characters += c;
+	}
+
+	// Every step requests all the characters in a new font size, like new text appearing in the UI:
+	const int step_count = 40;
+	const uint32_t repack_count = wi::font::GetAtlasStatistics().repack_count;
+	double total_time = 0;
+	double max_time = 0;
+	uint32_t rendered_glyphs = 0;
+	size_t uploaded_bytes = 0;
+	for (int step = 0; step < step_count; ++step)
+	{
+		wi::font::Params params;
+		params.size = 100 + step; // sizes that the UI most likely doesn't use yet
+		wi::font::TextSize(characters, params);
+
+		wi::Timer timer;
+		wi::font::UpdateAtlas(GetDPIScaling());
+		const double time = timer.elapsed_milliseconds();
+		total_time += time;
+		max_time = std::max(max_time, time);
+
+		const wi::font::AtlasStatistics statistics = wi::font::GetAtlasStatistics();
+		rendered_glyphs += statistics.rendered_glyphs;
+		uploaded_bytes += statistics.uploaded_bytes;
+	}
+
+	const wi::font::AtlasStatistics statistics = wi::font::GetAtlasStatistics();
+	ss += "updates: " + std::to_string(step_count) + ", rendered glyphs: " + std::to_string(rendered_glyphs) + ", job system threads: " + std::to_string(wi::jobsystem::GetThreadCount() + 1) + "\n";
+	ss += "update time average: " + std::to_string(total_time / step_count) + " ms, max: " + std::to_string(max_time) + " ms\n";
+	ss += "full repacks: " + std::to_string(statistics.repack_count - repack_count) + ", uploaded: " + std::to_string(uploaded_bytes / 1024) + " KB\n";
+	ss += "atlas: " + std::to_string(statistics.atlas_width) + " x " + std::to_string(statistics.atlas_height) + ", glyphs: " + std::to_string(statistics.glyph_count) + "\n";
+
+	static wi::SpriteFont font;
+	font = wi::SpriteFont(ss);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 2;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 24;
+	this->AddFont(&font);
+}
+
+void TestsRenderer::FontLayoutTest()
+{
+	std::string ss = "Font layout cache test:\n\n";
+
+	// Static labels, like the texts of a GUI that are laid out every frame:
+	wi::vector<std::string> labels;
+	for (int i = 0; i < 200; ++i)
+	{
+		labels.push_back("Static label number " + std::to_string(i) + " of the user interface");
+	}
+	wi::font::Params params;
+	params.size = 20;
+
+	// Make sure that the glyphs are in the atlas, because incomplete layouts are not cached:
+	for (auto& label : labels)
+	{
+		wi::font::TextSize(label, params);
+	}
+	wi::font::UpdateAtlas(GetDPIScaling());
+
+	const bool enabled = wi::font::IsLayoutCacheEnabled();
+	const int frame_count = 100;
+	double times[2] = {};
+	XMFLOAT2 sizes[2] = {};
+	for (int cached = 0; cached < 2; ++cached)
+	{
+		wi::font::SetLayoutCacheEnabled(cached != 0);
+		wi::Timer timer;
+		for (int frame = 0; frame < frame_count; ++frame)
+		{
+			for (auto& label : labels)
+			{
+				const XMFLOAT2 size = wi::font::TextSize(label, params);
+				sizes[cached].x += size.x;
+				sizes[cached].y += size.y;
+			}
+		}
+		times[cached] = timer.elapsed_milliseconds();
+	}
+	wi::font::SetLayoutCacheEnabled(enabled);
+
+	const wi::font::LayoutCacheStatistics statistics = wi::font::GetLayoutCacheStatistics();
+	ss += "labels: " + std::to_string(labels.size()) + ", frames: " + std::to_string(frame_count) + "\n";
+	ss += "without cache: " + std::to_string(times[0]) + " ms\n";
+	ss += "with cache: " + std::to_string(times[1]) + " ms\n";
+	ss += "results match: " + std::string(sizes[0].x == sizes[1].x && sizes[0].y == sizes[1].y ? "yes" : "no") + "\n";
+	ss += "total cache hits: " + std::to_string(statistics.hits) + ", misses: " + std::to_string(statistics.misses) + "\n";
+
+	static wi::SpriteFont font;
+	font = wi::SpriteFont(ss);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 2;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 24;
+	this->AddFont(&font);
+}
+
+void TestsRenderer::ImageBatchTest()
+{
+	// A window that is full of widgets, the GUI renders them with and without batching in alternating frames while this test is active:
+	static bool created = false;
+	if (!created)
+	{
+		created = true;
+		imageBatchWindow.Create("Image batching", wi::gui::Window::WindowControls::ALL);
+		imageBatchWindow.SetSize(XMFLOAT2(860, 520));
+		for (size_t i = 0; i < arraysize(imageBatchButtons); ++i)
+		{
+			wi::gui::Button& button = imageBatchButtons[i];
+			button.Create("B" + std::to_string(i));
+			button.SetSize(XMFLOAT2(48, 20));
+			button.SetPos(XMFLOAT2(4 + float(i % 16) * 52, 4 + float(i / 16) * 24));
+			imageBatchWindow.AddWidget(&button);
+		}
+	}
+	imageBatchWindow.SetPos(XMFLOAT2(GetLogicalWidth() / 2 - 430, GetLogicalHeight() / 2 - 260));
+	GetGUI().AddWidget(&imageBatchWindow);
+	GetGUI().SetBatchingEnabled(true);
+	imageBatchStatistics[0] = {};
+	imageBatchStatistics[1] = {};
+	wi::image::ResetDrawStatistics();
+
+	imageBatchFont = wi::SpriteFont("");
+	imageBatchFont.params.posX = 20;
+	imageBatchFont.params.posY = 60;
+	imageBatchFont.params.size = 20;
+	this->AddFont(&imageBatchFont);
+}
+
+void TestsRenderer::MeshOptimizeTest()
+{
+	wi::Timer timer;
+	Scene& scene = wi::scene::GetScene();
+
+	// UV sphere with the triangles shuffled, like meshes that were exported without optimization:
+	Entity materialEntity = scene.Entity_CreateMaterial("meshoptimize_material");
+	Entity meshEntity = scene.Entity_CreateMesh("meshoptimize_mesh");
+	MeshComponent& mesh = *scene.meshes.GetComponent(meshEntity);
+	const uint32_t rings = 256;
+	const uint32_t segments = 512;
+	for (uint32_t ring = 0; ring <= rings; ++ring)
+	{
+		const float theta = XM_PI * float(ring) / float(rings);
+		for (uint32_t segment = 0; segment <= segments; ++segment)
+		{
+			const float phi = XM_2PI * float(segment) / float(segments);
+			const XMFLOAT3 normal = XMFLOAT3(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+			mesh.vertex_positions.push_back(normal);
+			mesh.vertex_normals.push_back(normal);
+			mesh.vertex_uvset_0.push_back(XMFLOAT2(float(segment) / float(segments), float(ring) / float(rings)));
+		}
+	}
+	// The upper and lower hemispheres are separate subsets:
+	for (uint32_t half = 0; half < 2; ++half)
+	{
+		wi::vector<XMUINT3> triangles;
+		for (uint32_t ring = half * rings / 2; ring < (half + 1) * rings / 2; ++ring)
+		{
+			for (uint32_t segment = 0; segment < segments; ++segment)
+			{
+				const uint32_t a = ring * (segments + 1) + segment;
+				const uint32_t b = a + segments + 1;
+				triangles.push_back(XMUINT3(a, a + 1, b));
+				triangles.push_back(XMUINT3(a + 1, b + 1, b));
+			}
+		}
+		for (size_t i = triangles.size() - 1; i > 0; --i)
+		{
+			std::swap(triangles[i], triangles[wi::random::GetRandom(0, (int)i)]);
+		}
+		MeshComponent::MeshSubset& subset = mesh.subsets.emplace_back();
+		subset.materialID = materialEntity;
+		subset.indexOffset = (uint32_t)mesh.indices.size();
+		subset.indexCount = (uint32_t)triangles.size() * 3;
+		for (auto& x : triangles)
+		{
+			mesh.indices.push_back(x.x);
+			mesh.indices.push_back(x.y);
+			mesh.indices.push_back(x.z);
+		}
+	}
+
+	std::string ss = "Mesh optimize test:\n";
+	ss += "You can find out more in Tests.cpp, MeshOptimizeTest() function.\n\n";
+	ss += "vertices: " + std::to_string(mesh.vertex_positions.size()) + ", triangles: " + std::to_string(mesh.indices.size() / 3) + "\n";
+
+	MeshComponent::OptimizationStatistics statistics;
+	timer.record();
+	mesh.Optimize(&statistics);
+	ss += "MeshComponent::Optimize(): " + std::to_string(timer.elapsed_milliseconds()) + " ms\n\n";
+	ss += "ACMR: " + std::to_string(statistics.acmr_before) + " -> " + std::to_string(statistics.acmr_after) + "\n";
+	ss += "overdraw: " + std::to_string(statistics.overdraw_before) + " -> " + std::to_string(statistics.overdraw_after) + "\n";
+	ss += "overfetch: " + std::to_string(statistics.overfetch_before) + " -> " + std::to_string(statistics.overfetch_after) + "\n";
+
+	Entity objectEntity = scene.Entity_CreateObject("meshoptimize_object");
+	scene.objects.GetComponent(objectEntity)->meshID = meshEntity;
+	scene.transforms.GetComponent(objectEntity)->Translate(XMFLOAT3(0, 2, 4));
+
+	static wi::SpriteFont font;
+	font = wi::SpriteFont(ss);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 4;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 24;
+	this->AddFont(&font);
+}
+
+void TestsRenderer::OceanCPUTest()
+{
+	wi::Timer timer;
+
+	wi::Ocean::OceanParameters params;
+	const float time = 12.5f;
+	const XMFLOAT3 positions[] = {
+		XMFLOAT3(0, 0, 0),
+		XMFLOAT3(3.7f, 0, -12.1f),
+		XMFLOAT3(-25.3f, 0, 40.9f),
+		XMFLOAT3(104.2f, 0, 7.5f),
+	};
+
+	std::string ss = "Ocean CPU simulation test:\n";
+	ss += "You can find out more in Tests.cpp, OceanCPUTest() function.\n\n";
+
+	// The high resolution simulation is the reference for the reduced resolution ones:
+	wi::Ocean reference;
+	reference.Create(params);
+	reference.UpdateDisplacementMapCPU(time, 256);
+
+	for (uint32_t dim : { 32u, 64u, 128u })
+	{
+		wi::Ocean ocean;
+		ocean.Create(params);
+		timer.record();
+		ocean.UpdateDisplacementMapCPU(time, dim);
+		const double elapsed = timer.elapsed_milliseconds();
+
+		float max_error = 0;
+		for (auto& position : positions)
+		{
+			max_error = std::max(max_error, std::abs(ocean.GetDisplacedPosition(position).y - reference.GetDisplacedPosition(position).y));
+		}
+		ss += "dim " + std::to_string(dim) + ": " + std::to_string(elapsed) + " ms, max height error: " + std::to_string(max_error) + "\n";
+	}
+
+	// The simulation only depends on the parameters and time, so servers and clients must agree on these displaced positions
+	//	(with the default 64 resolution that the scene uses, the tolerance allows for math library differences between platforms):
+	const XMFLOAT3 expected[arraysize(positions)] = {
+		XMFLOAT3(0.303690f, 2.602777f, -0.497894f),
+		XMFLOAT3(3.809298f, 1.671863f, -11.593831f),
+		XMFLOAT3(-27.696676f, -1.262854f, 39.739750f),
+		XMFLOAT3(102.992546f, 1.449382f, 6.213596f),
+	};
+	wi::Ocean ocean;
+	ocean.Create(params);
+	ocean.UpdateDisplacementMapCPU(time);
+	float max_expected_error = 0;
+	for (size_t i = 0; i < arraysize(positions); ++i)
+	{
+		const XMFLOAT3 displaced = ocean.GetDisplacedPosition(positions[i]);
+		max_expected_error = std::max(max_expected_error, std::abs(displaced.x - expected[i].x));
+		max_expected_error = std::max(max_expected_error, std::abs(displaced.y - expected[i].y));
+		max_expected_error = std::max(max_expected_error, std::abs(displaced.z - expected[i].z));
+	}
+	ss += "\nmax error from expected positions: " + std::to_string(max_expected_error) + (max_expected_error < 0.001f ? " (OK)" : " (ERROR: simulation doesn't match!)") + "\n";
+
+	static wi::SpriteFont font;
+	font = wi::SpriteFont(ss);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 2;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 24;
+	this->AddFont(&font);
+}
+
+void TestsRenderer::HairGenerationTest()
+{
+	wi::Timer timer;
+
+	// Large terrain-like grid, where only parts of the surface have grass:
+	const uint32_t grid_dim = 1024;
+	MeshComponent mesh;
+	mesh.vertex_positions.resize(grid_dim * grid_dim);
+	for (uint32_t y = 0; y < grid_dim; ++y)
+	{
+		for (uint32_t x = 0; x < grid_dim; ++x)
+		{
+			mesh.vertex_positions[y * grid_dim + x] = XMFLOAT3(float(x), 0, float(y));
+		}
+	}
+	for (uint32_t y = 0; y < grid_dim - 1; ++y)
+	{
+		for (uint32_t x = 0; x < grid_dim - 1; ++x)
+		{
+			const uint32_t a = y * grid_dim + x;
+			const uint32_t b = a + grid_dim;
+			mesh.indices.push_back(a);
+			mesh.indices.push_back(a + 1);
+			mesh.indices.push_back(b);
+			mesh.indices.push_back(a + 1);
+			mesh.indices.push_back(b + 1);
+			mesh.indices.push_back(b);
+		}
+	}
+	MeshComponent::MeshSubset& subset = mesh.subsets.emplace_back();
+	subset.indexOffset = 0;
+	subset.indexCount = (uint32_t)mesh.indices.size();
+
+	wi::HairParticleSystem hair;
+	hair.vertex_lengths.resize(mesh.vertex_positions.size());
+	for (auto& x : hair.vertex_lengths)
+	{
+		x = wi::random::GetRandom(0, 9) < 2 ? 1.0f : 0.0f;
+	}
+
+	std::string ss = "Hair particle generation test:\n";
+	ss += "You can find out more in Tests.cpp, HairGenerationTest() function.\n\n";
+	ss += "triangles: " + std::to_string(mesh.indices.size() / 3) + "\n";
+
+	// Reference result, processing triangles in order on one thread:
+	timer.record();
+	wi::vector<uint32_t> reference;
+	for (size_t i = 0; i < mesh.indices.size(); i += 3)
+	{
+		const uint32_t i0 = mesh.indices[i + 0];
+		const uint32_t i1 = mesh.indices[i + 1];
+		const uint32_t i2 = mesh.indices[i + 2];
+		if (hair.vertex_lengths[i0] > 0 || hair.vertex_lengths[i1] > 0 || hair.vertex_lengths[i2] > 0)
+		{
+			reference.push_back(i0);
+			reference.push_back(i1);
+			reference.push_back(i2);
+		}
+	}
+	ss += "serial: " + std::to_string(timer.elapsed_milliseconds()) + " ms\n";
+
+	timer.record();
+	hair.CreateFromMesh(mesh);
+	ss += "HairParticleSystem::CreateFromMesh(): " + std::to_string(timer.elapsed_milliseconds()) + " ms\n";
+	ss += "used triangles: " + std::to_string(hair.indices.size() / 3) + "\n";
+	ss += std::string("matches serial: ") + (hair.indices == reference ? "yes" : "NO") + "\n";
+
+	static wi::SpriteFont font;
+	font = wi::SpriteFont(ss);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 2;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 24;
+	this->AddFont(&font);
+}
+
+void TestsRenderer::EmittedParticleCPUTest()
+{
+	wi::Timer timer;
+
+	// Force field pulling the particles, colliders would come from the scene update:
+	Scene scene;
+	Entity forceEntity = scene.Entity_CreateForce("force", XMFLOAT3(0, 5, 0));
+	ForceFieldComponent& force = *scene.forces.GetComponent(forceEntity);
+	force.type = ForceFieldComponent::Type::Point;
+	force.gravity = 10;
+	force.range = 20;
+
+	auto create_emitter = [](wi::EmittedParticleSystem& emitter) {
+		emitter.SetCPUSimulationEnabled(true);
+		emitter.SetVolumeEnabled(true);
+		emitter.SetMaxParticleCount(100000);
+		emitter.count = 50000;
+		emitter.life = 2;
+		emitter.velocity = XMFLOAT3(0, 4, 0);
+		emitter.gravity = XMFLOAT3(0, -9.8f, 0);
+		emitter.drag = 0.99f;
+	};
+	TransformComponent transform;
+	transform.UpdateTransform();
+
+	const float dt = 1.0f / 60.0f;
+	const int frames = 120;
+
+	std::string ss = "Emitted particle CPU simulation test:\n";
+	ss += "You can find out more in Tests.cpp, EmittedParticleCPUTest() function.\n\n";
+
+	wi::EmittedParticleSystem emitter;
+	create_emitter(emitter);
+	double total = 0;
+	double peak = 0;
+	for (int i = 0; i < frames; ++i)
+	{
+		timer.record();
+		emitter.UpdateCPU(transform, dt);
+		emitter.SimulateCPU(scene, nullptr, nullptr);
+		const double elapsed = timer.elapsed_milliseconds();
+		total += elapsed;
+		peak = std::max(peak, elapsed);
+	}
+	ss += "simulated frames: " + std::to_string(frames) + "\n";
+	ss += "alive particles: " + std::to_string(emitter.GetStatistics().aliveCount_afterSimulation) + "\n";
+	ss += "average frame: " + std::to_string(total / frames) + " ms\n";
+	ss += "peak frame: " + std::to_string(peak) + " ms\n";
+
+	// The CPU simulation is deterministic, so repeating it must give the same result:
+	wi::EmittedParticleSystem emitter2;
+	create_emitter(emitter2);
+	for (int i = 0; i < frames; ++i)
+	{
+		emitter2.UpdateCPU(transform, dt);
+		emitter2.SimulateCPU(scene, nullptr, nullptr);
+	}
+	const wi::EmittedParticleSystem::ParticlesCPU& a = emitter.GetParticlesCPU();
+	const wi::EmittedParticleSystem::ParticlesCPU& b = emitter2.GetParticlesCPU();
+	bool deterministic = a.count == b.count;
+	for (uint32_t i = 0; deterministic && i < a.count; ++i)
+	{
+		deterministic =
+			a.position_x[i] == b.position_x[i] &&
+			a.position_y[i] == b.position_y[i] &&
+			a.position_z[i] == b.position_z[i];
+	}
+	ss += std::string("deterministic: ") + (deterministic ? "yes" : "NO") + "\n";
+
+	// Single particles checked against the behaviour of emittedparticle_simulateCS with closed form or hand computed values:
+	auto create_single = [](wi::EmittedParticleSystem& emitter, const XMFLOAT3& startVelocity, float lifetime) {
+		emitter.SetCPUSimulationEnabled(true);
+		emitter.count = 0;
+		emitter.size = 0.1f;
+		emitter.life = lifetime;
+		emitter.random_factor = 0;
+		emitter.random_life = 0;
+		emitter.random_color = 0;
+		emitter.velocity = startVelocity;
+		emitter.gravity = XMFLOAT3(0, 0, 0);
+		emitter.drag = 1;
+	};
+	auto simulate = [&](wi::EmittedParticleSystem& emitter, const Scene& simscene, float step, int steps) {
+		for (int i = 0; i < steps; ++i)
+		{
+			emitter.UpdateCPU(transform, step);
+			emitter.SimulateCPU(simscene, nullptr, nullptr);
+		}
+	};
+	auto near_equal = [](double a, double b) {
+		return std::abs(a - b) <= 1e-4 * std::max(1.0, std::abs(b));
+	};
+	Scene emptyscene;
+	const float step = 1.0f / 64.0f; // exactly representable, so that lifetime checks don't depend on rounding
+
+	// Gravity and drag: v_k = d * (v_(k-1) + g * dt), p_k = p_(k-1) + (v_(k-1) + g * dt) * dt
+	{
+		const int N = 60;
+		const double d = 0.98;
+		const XMFLOAT3 v0 = XMFLOAT3(1, 2, 0);
+		const XMFLOAT3 p0 = XMFLOAT3(0, 10, 0);
+		wi::EmittedParticleSystem single;
+		create_single(single, v0, 10);
+		single.gravity = XMFLOAT3(0, -9.8f, 0);
+		single.drag = (float)d;
+		single.Burst(1, p0);
+		simulate(single, emptyscene, step, N);
+		const wi::EmittedParticleSystem::ParticlesCPU& particles = single.GetParticlesCPU();
+		const double dN = std::pow(d, N);
+		const double S1 = d * (1 - dN) / (1 - d); // sum of d^k for k = [1, N]
+		const double gdt = -9.8 * step;
+		const double expected_vx = dN * v0.x;
+		const double expected_vy = dN * v0.y + gdt * S1;
+		const double expected_px = p0.x + step / d * (v0.x * S1);
+		const double expected_py = p0.y + step / d * (v0.y * S1 + gdt * d / (1 - d) * (N - S1));
+		const bool success =
+			particles.count == 1 &&
+			near_equal(particles.velocity_x[0], expected_vx) &&
+			near_equal(particles.velocity_y[0], expected_vy) &&
+			near_equal(particles.position_x[0], expected_px) &&
+			near_equal(particles.position_y[0], expected_py);
+		ss += std::string("gravity and drag: ") + (success ? "yes" : "NO") + "\n";
+	}
+
+	// Sphere collider at origin with radius 1, particle of size 0.1 falling on it from y = 1.2 with speed 1, dt = 1/8:
+	//	after integration y = 1.075, penetration = 1.075 - 1 - 0.1 = -0.025, so the velocity is reflected to +1 and both are pushed out by 0.025
+	{
+		Scene colliderscene;
+		ColliderComponent collider;
+		collider.shape = ColliderComponent::Shape::Sphere;
+		collider.sphere = wi::primitive::Sphere(XMFLOAT3(0, 0, 0), 1);
+		colliderscene.colliders_gpu = &collider;
+		colliderscene.collider_count_gpu = 1;
+		wi::EmittedParticleSystem single;
+		create_single(single, XMFLOAT3(0, -1, 0), 10);
+		single.Burst(1, XMFLOAT3(0, 1.2f, 0));
+		simulate(single, colliderscene, 0.125f, 1);
+		colliderscene.colliders_gpu = nullptr;
+		colliderscene.collider_count_gpu = 0;
+		const wi::EmittedParticleSystem::ParticlesCPU& particles = single.GetParticlesCPU();
+		const bool success =
+			particles.count == 1 &&
+			near_equal(particles.position_y[0], 1.1) &&
+			near_equal(particles.velocity_y[0], 1.025) &&
+			near_equal(particles.velocity_x[0], 0);
+		ss += std::string("sphere collider bounce: ") + (success ? "yes" : "NO") + "\n";
+	}
+
+	// Plane collider at origin facing up with radius 10, same particle falling from y = 0.2:
+	//	after integration y = 0.075, distance to plane minus size = -0.025, so it bounces the same way as from the sphere
+	{
+		Scene colliderscene;
+		ColliderComponent collider;
+		collider.shape = ColliderComponent::Shape::Plane;
+		collider.plane.origin = XMFLOAT3(0, 0, 0);
+		collider.plane.normal = XMFLOAT3(0, 1, 0);
+		XMStoreFloat4x4(&collider.plane.projection, XMMatrixInverse(nullptr, XMMatrixScaling(10, 1, 10)));
+		colliderscene.colliders_gpu = &collider;
+		colliderscene.collider_count_gpu = 1;
+		wi::EmittedParticleSystem single;
+		create_single(single, XMFLOAT3(0, -1, 0), 10);
+		single.Burst(1, XMFLOAT3(0, 0.2f, 0));
+		simulate(single, colliderscene, 0.125f, 1);
+		colliderscene.colliders_gpu = nullptr;
+		colliderscene.collider_count_gpu = 0;
+		const wi::EmittedParticleSystem::ParticlesCPU& particles = single.GetParticlesCPU();
+		const bool success =
+			particles.count == 1 &&
+			near_equal(particles.position_y[0], 0.1) &&
+			near_equal(particles.velocity_y[0], 1.025);
+		ss += std::string("plane collider bounce: ") + (success ? "yes" : "NO") + "\n";
+	}
+
+	// Point force with gravity 10 and range 20 placed 5 units above a resting particle, dt = 1/8:
+	//	force = gravity * (1 - distance / range) towards the force field, it is applied in the next step
+	{
+		wi::EmittedParticleSystem single;
+		create_single(single, XMFLOAT3(0, 0, 0), 10);
+		single.Burst(1, XMFLOAT3(0, 0, 0));
+		simulate(single, scene, 0.125f, 1);
+		const wi::EmittedParticleSystem::ParticlesCPU& particles = single.GetParticlesCPU();
+		bool success =
+			particles.count == 1 &&
+			near_equal(particles.position_y[0], 0) &&
+			near_equal(particles.force_y[0], 10 * (1 - 5.0 / 20.0));
+		simulate(single, scene, 0.125f, 1);
+		const double expected_vy = 7.5 * 0.125;
+		const double expected_py = expected_vy * 0.125;
+		success = success &&
+			particles.count == 1 &&
+			near_equal(particles.velocity_y[0], expected_vy) &&
+			near_equal(particles.position_y[0], expected_py) &&
+			near_equal(particles.force_y[0], 10 * (1 - (5 - expected_py) / 20.0)) &&
+			near_equal(particles.force_x[0], 0);
+		ss += std::string("point force falloff: ") + (success ? "yes" : "NO") + "\n";
+	}
+
+	// Lifetime of 0.5 seconds is exactly 32 steps of 1/64, the particle must be alive after 31 and removed after 32:
+	{
+		wi::EmittedParticleSystem single;
+		create_single(single, XMFLOAT3(0, 0, 0), 0.5f);
+		single.Burst(1, XMFLOAT3(0, 0, 0));
+		simulate(single, emptyscene, step, 31);
+		bool success = single.GetParticlesCPU().count == 1 && near_equal(single.GetParticlesCPU().life[0], step);
+		simulate(single, emptyscene, step, 1);
+		success = success && single.GetParticlesCPU().count == 0 && single.GetStatistics().aliveCount_afterSimulation == 0;
+		ss += std::string("expiry at max life: ") + (success ? "yes" : "NO") + "\n";
+	}
+
+	static wi::SpriteFont font;
+	font = wi::SpriteFont(ss);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 2;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 24;
+	this->AddFont(&font);
+}
+
+void TestsRenderer::HierarchyIKTest()
+{
+	// IK and springs write world matrices without modifying local transforms, the hierarchy update must not keep those when they stop:
+	Scene scene;
+	Entity root = scene.Entity_CreateObject("root");
+	Entity upper = scene.Entity_CreateObject("upper");
+	Entity lower = scene.Entity_CreateObject("lower");
+	Entity effector = scene.Entity_CreateObject("effector");
+	Entity attachment = scene.Entity_CreateObject("attachment"); // not part of the IK chain, only follows the effector
+	Entity target = scene.Entity_CreateObject("target");
+	scene.transforms.GetComponent(upper)->Translate(XMFLOAT3(0, 1, 0));
+	scene.transforms.GetComponent(lower)->Translate(XMFLOAT3(0, 2, 0));
+	scene.transforms.GetComponent(effector)->Translate(XMFLOAT3(0, 3, 0));
+	scene.transforms.GetComponent(attachment)->Translate(XMFLOAT3(0.5f, 3, 0));
+	scene.transforms.GetComponent(target)->Translate(XMFLOAT3(2, 1, 0));
+	for (Entity entity : { upper, lower, effector, attachment, target })
+	{
+		scene.transforms.GetComponent(entity)->UpdateTransform(); // world positions are used by attaching
+	}
+	scene.Component_Attach(upper, root);
+	scene.Component_Attach(lower, upper);
+	scene.Component_Attach(effector, lower);
+	scene.Component_Attach(attachment, effector);
+
+	InverseKinematicsComponent& ik = scene.inverse_kinematics.Create(effector);
+	ik.target = target;
+	ik.chain_length = 2;
+	ik.iteration_count = 10;
+
+	// World matrix computed from the local transforms of the parent chain:
+	auto rest_world = [&](Entity entity) {
+		XMMATRIX W = XMMatrixIdentity();
+		while (entity != INVALID_ENTITY)
+		{
+			W = W * scene.transforms.GetComponent(entity)->GetLocalMatrix();
+			const HierarchyComponent* hier = scene.hierarchy.GetComponent(entity);
+			entity = hier == nullptr ? INVALID_ENTITY : hier->parentID;
+		}
+		return W;
+	};
+	auto matches = [&](Entity entity, const XMMATRIX& expected) {
+		const XMMATRIX W = XMLoadFloat4x4(&scene.transforms.GetComponent(entity)->world);
+		for (int i = 0; i < 4; ++i)
+		{
+			if (!XMVector4LessOrEqual(XMVectorAbs(W.r[i] - expected.r[i]), XMVectorReplicate(0.001f)))
+				return false;
+		}
+		return true;
+	};
+	auto position = [&](Entity entity) {
+		return scene.transforms.GetComponent(entity)->GetPosition();
+	};
+
+	const float dt = 1.0f / 60.0f;
+	for (int i = 0; i < 10; ++i)
+	{
+		scene.Update(dt);
+	}
+	const XMFLOAT3 effector_ik = position(effector);
+	const bool ik_moved_effector = wi::math::Distance(effector_ik, position(target)) < wi::math::Distance(XMFLOAT3(0, 3, 0), position(target));
+	const XMMATRIX attachment_expected = scene.transforms.GetComponent(attachment)->GetLocalMatrix() * XMLoadFloat4x4(&scene.transforms.GetComponent(effector)->world);
+	const bool attachment_follows = matches(attachment, attachment_expected);
+
+	// Static frames with IK still active, the unchanged hierarchy must keep the IK result:
+	scene.Update(dt);
+	scene.Update(dt);
+	const bool ik_stable = wi::math::Distance(effector_ik, position(effector)) < 0.01f;
+
+	// Disable IK, nothing else changes, so only the dirty marking from IK can make the hierarchy restore the rest pose:
+	ik.SetDisabled();
+	scene.Update(dt);
+	scene.Update(dt);
+	bool restored = true;
+	for (Entity entity : { upper, lower, effector, attachment })
+	{
+		restored &= matches(entity, rest_world(entity));
+	}
+
+	// Springs also write world matrices directly. A root spring with a child attachment keeps simulating, and a parented spring gets disabled:
+	Entity spring_bone = scene.Entity_CreateObject("spring_bone");
+	Entity spring_attachment = scene.Entity_CreateObject("spring_attachment");
+	Entity disabled_bone = scene.Entity_CreateObject("disabled_spring_bone");
+	Entity disabled_attachment = scene.Entity_CreateObject("disabled_spring_attachment");
+	scene.transforms.GetComponent(spring_bone)->Translate(XMFLOAT3(5, 0, 0));
+	scene.transforms.GetComponent(spring_attachment)->Translate(XMFLOAT3(6, 0, 0));
+	scene.transforms.GetComponent(disabled_bone)->Translate(XMFLOAT3(8, 0, 0));
+	scene.transforms.GetComponent(disabled_attachment)->Translate(XMFLOAT3(9, 0, 0));
+	for (Entity entity : { spring_bone, spring_attachment, disabled_bone, disabled_attachment })
+	{
+		scene.transforms.GetComponent(entity)->UpdateTransform();
+	}
+	scene.Component_Attach(spring_attachment, spring_bone);
+	scene.Component_Attach(disabled_bone, root);
+	scene.Component_Attach(disabled_attachment, disabled_bone);
+	for (Entity entity : { spring_bone, disabled_bone })
+	{
+		SpringComponent& spring = scene.springs.Create(entity);
+		spring.gravityDir = XMFLOAT3(0, -1, 0);
+		spring.gravityPower = 10;
+		spring.windForce = 0;
+	}
+
+	for (int i = 0; i < 120; ++i)
+	{
+		scene.Update(dt);
+	}
+	const bool springs_moved = !matches(spring_bone, rest_world(spring_bone)) && !matches(disabled_bone, rest_world(disabled_bone));
+	const bool spring_attachment_consistent = matches(spring_attachment, rest_world(spring_attachment));
+	const XMMATRIX spring_world = XMLoadFloat4x4(&scene.transforms.GetComponent(spring_bone)->world);
+	scene.Update(dt);
+	const bool spring_stable = matches(spring_bone, spring_world);
+
+	// Disable one spring, its last pose must not stay in the world matrices:
+	scene.springs.GetComponent(disabled_bone)->SetDisabled();
+	scene.Update(dt);
+	scene.Update(dt);
+	const bool spring_restored = matches(disabled_bone, rest_world(disabled_bone)) && matches(disabled_attachment, rest_world(disabled_attachment));
+	const bool spring_still_active = !matches(spring_bone, rest_world(spring_bone)) && matches(spring_bone, spring_world);
+
+	std::string ss = "Hierarchy update with IK test:\n";
+	ss += "You can find out more in Tests.cpp, HierarchyIKTest() function.\n\n";
+	ss += std::string("IK moved effector towards target: ") + (ik_moved_effector ? "yes" : "NO") + "\n";
+	ss += std::string("attachment follows IK effector: ") + (attachment_follows ? "yes" : "NO") + "\n";
+	ss += std::string("IK result stable on static frames: ") + (ik_stable ? "yes" : "NO") + "\n";
+	ss += std::string("rest pose restored after disabling IK: ") + (restored ? "yes" : "NO") + "\n";
+	ss += std::string("springs moved their bones: ") + (springs_moved ? "yes" : "NO") + "\n";
+	ss += std::string("spring attachment follows its local chain: ") + (spring_attachment_consistent ? "yes" : "NO") + "\n";
+	ss += std::string("spring result stable on static frames: ") + (spring_stable ? "yes" : "NO") + "\n";
+	ss += std::string("rest pose restored after disabling a spring: ") + (spring_restored ? "yes" : "NO") + "\n";
+	ss += std::string("other spring unaffected: ") + (spring_still_active ? "yes" : "NO") + "\n";
+
+	static wi::SpriteFont font;
+	font = wi::SpriteFont(ss);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 2;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 24;
+	this->AddFont(&font);
+}
+
+int RunHeadlessRenderBenchmark()
+{
+	wi::graphics::GraphicsDevice_Null device;
+	wi::graphics::GetDevice() = &device;
+	wi::initializer::InitializeComponentsImmediate();
+
+	// Grid of objects with shadow casting lights, so that culling, shadow and draw call generation all have work:
+	Scene& scene = wi::scene::GetScene();
+	const int grid_dim = 32;
+	for (int x = 0; x < grid_dim; ++x)
+	{
+		for (int z = 0; z < grid_dim; ++z)
+		{
+			Entity entity = scene.Entity_CreateCube("cube");
+			TransformComponent& transform = *scene.transforms.GetComponent(entity);
+			transform.Translate(XMFLOAT3(float(x - grid_dim / 2) * 3, 1, float(z - grid_dim / 2) * 3));
+		}
+	}
+	scene.Entity_CreatePlane("floor");
+	for (int i = 0; i < 8; ++i)
+	{
+		Entity entity = scene.Entity_CreateLight("light", XMFLOAT3(float(i * 8 - 28), 6, 0), XMFLOAT3(1, 1, 1), 10, 20);
+		scene.lights.GetComponent(entity)->SetCastShadow(true);
+	}
+
+	TransformComponent camera_transform;
+	camera_transform.Translate(XMFLOAT3(0, 20, -50));
+	camera_transform.RotateRollPitchYaw(XMFLOAT3(XM_PI / 8, 0, 0));
+	camera_transform.UpdateTransform();
+	CameraComponent& camera = wi::scene::GetCamera();
+	camera.TransformCamera(camera_transform);
+	camera.UpdateCamera();
+
+	wi::RenderPath3D path;
+	path.init(1920, 1080);
+	path.Load();
+	path.Start();
+
+	const int warmup_frames = 10;
+	const int frames = 300;
+	const float dt = 1.0f / 60.0f;
+	double total = 0;
+	double peak = 0;
+	wi::graphics::GraphicsDevice_Null::Statistics statistics;
+	wi::Timer timer;
+	for (int i = 0; i < warmup_frames + frames; ++i)
+	{
+		timer.record();
+		path.PreUpdate();
+		path.Update(dt);
+		path.PostUpdate();
+		path.PreRender();
+		path.Render();
+		path.PostRender();
+		device.SubmitCommandLists();
+		const double elapsed = timer.elapsed_milliseconds();
+		if (i >= warmup_frames)
+		{
+			total += elapsed;
+			peak = std::max(peak, elapsed);
+		}
+		statistics = device.GetFrameStatistics();
+	}
+
+	std::string ss = "Headless RenderPath3D benchmark (null device):\n";
+	ss += "objects: " + std::to_string(scene.objects.GetCount()) + ", lights: " + std::to_string(scene.lights.GetCount()) + "\n";
+	ss += "frames: " + std::to_string(frames) + " at " + std::to_string(path.width) + "x" + std::to_string(path.height) + "\n";
+	ss += "average frame CPU time: " + std::to_string(total / frames) + " ms\n";
+	ss += "peak frame CPU time: " + std::to_string(peak) + " ms\n";
+	ss += "command lists: " + std::to_string(statistics.commandlists) + "\n";
+	ss += "render passes: " + std::to_string(statistics.renderpasses) + "\n";
+	ss += "draws: " + std::to_string(statistics.draws) + "\n";
+	ss += "dispatches: " + std::to_string(statistics.dispatches) + "\n";
+	ss += "pipeline binds: " + std::to_string(statistics.pipeline_binds) + "\n";
+	ss += "barriers: " + std::to_string(statistics.barriers) + "\n";
+	wi::backlog::post(ss);
+
+	path.Stop();
+	wi::jobsystem::ShutDown();
+
+	// Smoke test result, the frame must have recorded work:
+	return (statistics.draws > 0 && statistics.dispatches > 0) ? 0 : 1;
+}
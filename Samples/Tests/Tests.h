@@ -5,6 +5,10 @@ class TestsRenderer : public wi::RenderPath3D
 	wi::gui::Label label;
 	wi::gui::ComboBox testSelector;
 	wi::ecs::Entity ik_entity = wi::ecs::INVALID_ENTITY;
+	wi::gui::Window imageBatchWindow;
+	wi::gui::Button imageBatchButtons[320];
+	wi::SpriteFont imageBatchFont;
+	wi::image::DrawStatistics imageBatchStatistics[2]; // immediate, batched
 public:
 	void Load() override;
 	void Update(float dt) override;
@@ -15,6 +19,26 @@ public:
 	void RunSpriteTest();
 	void RunNetworkTest();
 	void ContainerTest();
+	void RadixSortTest();
+	void EntityLookupTest();
+	void AudioStreamTest();
+	void AudioVoicePoolTest();
+	void NetworkBatchTest();
+	void NetworkChannelTest();
+	void SnapshotReplicationTest();
+	void LuaIsolatedScriptTest();
+	void LuaMathTest();
+	void LuaGarbageCollectionTest();
+	void PathHierarchyTest();
+	void PathQueryBatchTest();
+	void FontAtlasTest();
+	void FontLayoutTest();
+	void ImageBatchTest();
+	void MeshOptimizeTest();
+	void OceanCPUTest();
+	void HairGenerationTest();
+	void EmittedParticleCPUTest();
+	void HierarchyIKTest();
 };
 
 class Tests : public wi::Application
@@ -24,3 +48,6 @@ public:
 	void Initialize() override;
 };
 
+// Renders a generated scene with RenderPath3D on the null graphics device without window and GPU, and logs CPU frame times and command statistics
+//	Started by the "headless_benchmark" command line argument, returns the process exit code
+int RunHeadlessRenderBenchmark();
@@ -69,6 +69,12 @@ int main(int argc, char *argv[])
 
     wi::arguments::Parse(argc, argv);
 
+    if (wi::arguments::HasArgument("headless_benchmark"))
+    {
+        // No window and no GPU, the renderer runs on the null graphics device:
+        return RunHeadlessRenderBenchmark();
+    }
+
     sdl2::sdlsystem_ptr_t system = sdl2::make_sdlsystem(SDL_INIT_EVERYTHING | SDL_INIT_EVENTS);
     if (*system) {
         throw sdl2::SDLError("Error creating SDL2 system");
@@ -33,6 +33,12 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
 
 	wi::arguments::Parse(lpCmdLine); // if you wish to use command line arguments, here is a good place to parse them...
 
+	if (wi::arguments::HasArgument("headless_benchmark"))
+	{
+		// No window and no GPU, the renderer runs on the null graphics device:
+		return RunHeadlessRenderBenchmark();
+	}
+
     // Initialize global strings
     LoadStringW(hInstance, IDS_APP_TITLE, szTitle, MAX_LOADSTRING);
     LoadStringW(hInstance, IDC_WICKEDENGINETESTS, szWindowClass, MAX_LOADSTRING);
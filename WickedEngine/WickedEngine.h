@@ -27,6 +27,7 @@
 #include "wiSprite.h"
 #include "wiSpriteFont.h"
 #include "wiScene.h"
+#include "wiScene_Replication.h"
 #include "wiECS.h"
 #include "wiEmittedParticle.h"
 #include "wiHairParticle.h"
@@ -53,6 +54,7 @@
 #include "wiArchive.h"
 #include "wiSpinLock.h"
 #include "wiRectPacker.h"
+#include "wiRadixSort.h"
 #include "wiProfiler.h"
 #include "wiOcean.h"
 #include "wiFFTGenerator.h"
@@ -61,6 +63,7 @@
 #include "wiGPUSortLib.h"
 #include "wiJobSystem.h"
 #include "wiNetwork.h"
+#include "wiNetworkChannel.h"
 #include "wiEventHandler.h"
 #include "wiShaderCompiler.h"
 #include "wiCanvas.h"
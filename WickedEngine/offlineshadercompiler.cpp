@@ -216,6 +216,7 @@ wi::vector<ShaderEntry> shaders = {
 
 	{"emittedparticlePS_soft", wi::graphics::ShaderStage::PS },
 	{"imagePS", wi::graphics::ShaderStage::PS },
+	{"imagePS_batched", wi::graphics::ShaderStage::PS },
 	{"emittedparticlePS_soft_lighting", wi::graphics::ShaderStage::PS },
 	{"oceanSurfacePS", wi::graphics::ShaderStage::PS },
 	{"hairparticlePS", wi::graphics::ShaderStage::PS },
@@ -259,6 +260,7 @@ wi::vector<ShaderEntry> shaders = {
 	{"impostorPS_prepass_depthonly", wi::graphics::ShaderStage::PS },
 	{"forceFieldVisualizerPS", wi::graphics::ShaderStage::PS },
 	{"fontPS", wi::graphics::ShaderStage::PS },
+	{"fontPS_batched", wi::graphics::ShaderStage::PS },
 	{"envMap_skyPS_static", wi::graphics::ShaderStage::PS },
 	{"envMap_skyPS_dynamic", wi::graphics::ShaderStage::PS },
 	{"envMapPS", wi::graphics::ShaderStage::PS },
@@ -279,7 +281,9 @@ wi::vector<ShaderEntry> shaders = {
 	{"hairparticleVS", wi::graphics::ShaderStage::VS },
 	{"emittedparticleVS", wi::graphics::ShaderStage::VS },
 	{"imageVS", wi::graphics::ShaderStage::VS },
+	{"imageVS_batched", wi::graphics::ShaderStage::VS },
 	{"fontVS", wi::graphics::ShaderStage::VS },
+	{"fontVS_batched", wi::graphics::ShaderStage::VS },
 	{"voxelVS", wi::graphics::ShaderStage::VS },
 	{"vertexcolorVS", wi::graphics::ShaderStage::VS },
 	{"volumetriclight_directionalVS", wi::graphics::ShaderStage::VS },
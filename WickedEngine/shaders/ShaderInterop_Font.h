@@ -31,6 +31,41 @@ struct FontConstants
 
 	float4x4 transform;
 };
+
+// Batched texts are drawn with one instanced draw, every instance is a glyph quad that refers to the FontBatchInstance of its text:
+struct FontBatchInstance
+{
+	float4 transform0; // rows of the transform matrix
+	float4 transform1;
+	float4 transform2;
+	float4 transform3;
+
+	uint2 color; // packed half4
+	uint2 softness_bolden_hdrscaling; // packed half3 | uint16 flags
+
+	int texture_index;
+	uint clip_lefttop; // packed uint16 pair, scissor rect in pixels
+	uint clip_rightbottom; // packed uint16 pair, scissor rect in pixels
+	uint padding;
+};
+
+struct alignas(16) FontBatchConstants
+{
+	int buffer_index;
+	uint instance_offset; // offset of the FontBatchInstance array in the buffer
+	uint glyph_offset; // offset of the glyph -> FontBatchInstance index array in the buffer
+	uint vertex_offset; // offset of the FontVertex array in the buffer
+
+	uint first_glyph; // first glyph of the draw call
+	uint padding0;
+	uint padding1;
+	uint padding2;
+};
+
+#ifdef FONT_BATCHED
+CONSTANTBUFFER(font_batch, FontBatchConstants, CBSLOT_FONT);
+#else
 CONSTANTBUFFER(font, FontConstants, CBSLOT_FONT);
+#endif // FONT_BATCHED
 
 #endif // WI_SHADERINTEROP_FONT_H
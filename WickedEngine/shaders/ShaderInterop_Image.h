@@ -59,6 +59,28 @@ struct alignas(16) ImageConstants
 	uint gradient_uv_start; // packed half2
 	uint gradient_uv_end; // packed half2
 };
+// Batched images are drawn as one indexed triangle list, every vertex refers to the ImageConstants of its image:
+struct ImageBatchVertex
+{
+	float4 pos;
+	uint instance; // index of the image's constants in the batch
+	uint corner; // quad corner [0, 3], or rounded corner vertex (0: center)
+	uint clip_lefttop; // packed uint16 pair, scissor rect in pixels
+	uint clip_rightbottom; // packed uint16 pair, scissor rect in pixels
+};
+
+struct alignas(16) ImageBatchConstants
+{
+	int buffer_index;
+	uint vertex_offset; // offset of the ImageBatchVertex array in the buffer
+	uint instance_offset; // offset of the ImageConstants array in the buffer
+	uint padding;
+};
+
+#ifdef IMAGE_BATCHED
+CONSTANTBUFFER(image_batch, ImageBatchConstants, CBSLOT_IMAGE);
+#else
 CONSTANTBUFFER(image, ImageConstants, CBSLOT_IMAGE);
+#endif // IMAGE_BATCHED
 
 #endif // WI_SHADERINTEROP_IMAGE_H
@@ -6,10 +6,29 @@ struct VertextoPixel
 	float4 pos : SV_Position;
 	float2 uv : TEXCOORD0;
 	float2 bary : TEXCOORD1;
+#ifdef FONT_BATCHED
+	nointerpolation uint instance : TEXCOORD2;
+	nointerpolation uint4 clip : TEXCOORD3;
+#endif // FONT_BATCHED
 };
 
+#ifdef FONT_BATCHED
+// The constants of the batched texts are loaded from the batch buffer:
+static FontConstants font;
+#endif // FONT_BATCHED
+
 float4 main(VertextoPixel input) : SV_TARGET
 {
+#ifdef FONT_BATCHED
+	// The scissor rects of the batched texts are applied here, so that texts with different scissors can be batched:
+	if (any(input.pos.xy < input.clip.xy) || any(input.pos.xy >= input.clip.zw))
+		discard;
+	FontBatchInstance text = bindless_buffers[descriptor_index(font_batch.buffer_index)].Load<FontBatchInstance>(font_batch.instance_offset + input.instance * sizeof(FontBatchInstance));
+	font.texture_index = text.texture_index;
+	font.color = text.color;
+	font.softness_bolden_hdrscaling = text.softness_bolden_hdrscaling;
+#endif // FONT_BATCHED
+
 	Texture2D<half4> tex = bindless_textures_half4[descriptor_index(font.texture_index)];
 	half value = tex.SampleLevel(sampler_linear_clamp, input.uv, 0).r;
 	half4 color = unpack_half4(font.color);
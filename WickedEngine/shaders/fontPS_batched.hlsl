@@ -0,0 +1,2 @@
+#define FONT_BATCHED
+#include "fontPS.hlsl"
@@ -6,15 +6,37 @@ struct VertextoPixel
 	float4 pos : SV_Position;
 	float2 uv : TEXCOORD0;
 	float2 bary : TEXCOORD1;
+#ifdef FONT_BATCHED
+	nointerpolation uint instance : TEXCOORD2;
+	nointerpolation uint4 clip : TEXCOORD3;
+#endif // FONT_BATCHED
 };
 
 VertextoPixel main(uint vertexID : SV_VertexID, uint instanceID : SV_InstanceID)
 {
+	VertextoPixel Out;
+
+#ifdef FONT_BATCHED
+	// Every instance is a glyph of the batch, which refers to the constants of its text:
+	ByteAddressBuffer buffer = bindless_buffers[descriptor_index(font_batch.buffer_index)];
+	uint glyph = font_batch.first_glyph + instanceID;
+	uint instance = buffer.Load(font_batch.glyph_offset + glyph * sizeof(uint));
+	FontBatchInstance text = buffer.Load<FontBatchInstance>(font_batch.instance_offset + instance * sizeof(FontBatchInstance));
+	FontVertex vertex = buffer.Load<FontVertex>(font_batch.vertex_offset + (glyph * 4 + vertexID) * sizeof(FontVertex));
+	Out.pos = mul(float4(asfloat(vertex.pos), 0, 1), float4x4(text.transform0, text.transform1, text.transform2, text.transform3));
+	Out.instance = instance;
+	Out.clip = uint4(
+		text.clip_lefttop & 0xFFFF,
+		text.clip_lefttop >> 16u,
+		text.clip_rightbottom & 0xFFFF,
+		text.clip_rightbottom >> 16u
+	);
+#else
 	uint vID = instanceID * 4 + vertexID;
 	FontVertex vertex = bindless_buffers[descriptor_index(font.buffer_index)].Load<FontVertex>(font.buffer_offset + vID * sizeof(FontVertex));
-
-	VertextoPixel Out;
 	Out.pos = mul(font.transform, float4(asfloat(vertex.pos), 0, 1));
+#endif // FONT_BATCHED
+
 	Out.uv = vertex.uv;
 	switch (vertexID)
 	{
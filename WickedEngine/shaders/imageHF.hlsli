@@ -3,6 +3,20 @@
 #include "globals.hlsli"
 #include "ShaderInterop_Image.h"
 
+#ifdef IMAGE_BATCHED
+// The constants of the batched images are loaded from the batch buffer:
+static ImageConstants image;
+
+ImageBatchVertex load_image_batch_vertex(uint vertexID)
+{
+	return bindless_buffers[descriptor_index(image_batch.buffer_index)].Load<ImageBatchVertex>(image_batch.vertex_offset + vertexID * sizeof(ImageBatchVertex));
+}
+ImageConstants load_image_batch_instance(uint instance)
+{
+	return bindless_buffers[descriptor_index(image_batch.buffer_index)].Load<ImageConstants>(image_batch.instance_offset + instance * sizeof(ImageConstants));
+}
+#endif // IMAGE_BATCHED
+
 float Wedge2D(float2 v, float2 w)
 {
 	return v.x * w.y - v.y * w.x;
@@ -14,6 +28,10 @@ struct VertextoPixel
 	float4 screen : TEXCOORD0;
 	float2 q : TEXCOORD1;
 	float2 edge : TEXCOORD2;
+#ifdef IMAGE_BATCHED
+	nointerpolation uint instance : TEXCOORD3;
+	nointerpolation uint4 clip : TEXCOORD4;
+#endif // IMAGE_BATCHED
 
 	float2 uv_screen()
 	{
@@ -2,6 +2,13 @@
 
 float4 main(VertextoPixel input) : SV_TARGET
 {
+#ifdef IMAGE_BATCHED
+	// The scissor rects of the batched images are applied here, so that images with different scissors can be batched:
+	if (any(input.pos.xy < input.clip.xy) || any(input.pos.xy >= input.clip.zw))
+		discard;
+	image = load_image_batch_instance(input.instance);
+#endif // IMAGE_BATCHED
+
 	SamplerState sam = bindless_samplers[descriptor_index(image.sampler_index)];
 
 	const half hdr_scaling = unpack_half2(image.hdr_scaling_aspect).x;
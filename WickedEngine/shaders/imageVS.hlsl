@@ -8,6 +8,40 @@ static const float2 QUAD_EDGE[] = {
 	float2(1, -1),
 };
 
+#ifdef IMAGE_BATCHED
+VertextoPixel main(uint vI : SV_VertexID)
+{
+	ImageBatchVertex vertex = load_image_batch_vertex(vI);
+	image = load_image_batch_instance(vertex.instance);
+
+	VertextoPixel Out;
+	Out.pos = vertex.pos;
+
+	// Set up inverse bilinear interpolation
+	Out.q = Out.pos.xy - image.b0;
+
+	if (image.flags & IMAGE_FLAG_CORNER_ROUNDING)
+	{
+		// triangle fan, complex shape; center vertex is not edge, rest are edge:
+		Out.edge = vertex.corner == 0 ? 0 : 1;
+	}
+	else
+	{
+		// simple rectange shape, edge weight is based on uvs:
+		Out.edge = QUAD_EDGE[vertex.corner];
+	}
+
+	Out.screen = Out.pos;
+	Out.instance = vertex.instance;
+	Out.clip = uint4(
+		vertex.clip_lefttop & 0xFFFF,
+		vertex.clip_lefttop >> 16u,
+		vertex.clip_rightbottom & 0xFFFF,
+		vertex.clip_rightbottom >> 16u
+	);
+	return Out;
+}
+#else
 VertextoPixel main(uint vI : SV_VertexID)
 {
 	VertextoPixel Out;
@@ -40,4 +74,4 @@ VertextoPixel main(uint vI : SV_VertexID)
 	Out.screen = Out.pos;
 	return Out;
 }
-
+#endif // IMAGE_BATCHED
@@ -0,0 +1,2 @@
+#define IMAGE_BATCHED
+#include "imageVS.hlsl"
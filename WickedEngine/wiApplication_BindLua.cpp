@@ -550,10 +550,9 @@ namespace wi::lua
 
 	void Application_BindLua::Bind()
 	{
-		static bool initialized = false;
-		if (!initialized)
+		static const char binding_key = 0;
+		if (wi::lua::BeginBinding(&binding_key))
 		{
-			initialized = true;
 			Luna<Application_BindLua>::Register(wi::lua::GetLuaState());
 
 			wi::lua::RegisterFunc("SetProfilerEnabled", SetProfilerEnabled);
@@ -646,10 +645,9 @@ FadeType = {
 
 	void Canvas_BindLua::Bind()
 	{
-		static bool initialized = false;
-		if (!initialized)
+		static const char binding_key = 0;
+		if (wi::lua::BeginBinding(&binding_key))
 		{
-			initialized = true;
 			Luna<Canvas_BindLua>::Register(wi::lua::GetLuaState());
 		}
 	}
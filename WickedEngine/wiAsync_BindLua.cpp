@@ -24,10 +24,9 @@ namespace wi::lua
 
 	void Async_BindLua::Bind()
 	{
-		static bool initialized = false;
-		if (!initialized)
+		static const char binding_key = 0;
+		if (wi::lua::BeginBinding(&binding_key))
 		{
-			initialized = true;
 			Luna<Async_BindLua>::Register(wi::lua::GetLuaState());
 		}
 	}
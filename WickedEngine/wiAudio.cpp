@@ -3,11 +3,16 @@
 #include "wiHelper.h"
 #include "wiTimer.h"
 #include "wiVector.h"
+#include "wiJobSystem.h"
+#include "wiSpinLock.h"
 
 #define STB_VORBIS_HEADER_ONLY
 #include "Utility/stb_vorbis.c"
 
 #include <sstream>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
 
 template<typename T>
 static constexpr T AlignTo(T value, T alignment)
@@ -15,6 +20,258 @@ static constexpr T AlignTo(T value, T alignment)
 	return ((value + alignment - T(1)) / alignment) * alignment;
 }
 
+namespace wi::audio
+{
+	struct StreamDecoderInternal
+	{
+		stb_vorbis* vorbis = nullptr;
+		stb_vorbis_info info = {};
+		size_t sample_count = 0;
+
+		~StreamDecoderInternal()
+		{
+			if (vorbis != nullptr)
+			{
+				stb_vorbis_close(vorbis);
+			}
+		}
+	};
+	StreamDecoderInternal* to_internal(const StreamDecoder* param)
+	{
+		return static_cast<StreamDecoderInternal*>(param->internal_state.get());
+	}
+
+	bool CreateStreamDecoder(const uint8_t* data, size_t size, StreamDecoder* decoder)
+	{
+		int error = 0;
+		stb_vorbis* vorbis = stb_vorbis_open_memory(data, (int)size, &error, nullptr);
+		if (vorbis == nullptr)
+		{
+			return false;
+		}
+		std::shared_ptr<StreamDecoderInternal> decoderinternal = std::make_shared<StreamDecoderInternal>();
+		decoderinternal->vorbis = vorbis;
+		decoderinternal->info = stb_vorbis_get_info(vorbis);
+		decoderinternal->sample_count = (size_t)stb_vorbis_stream_length_in_samples(vorbis);
+		decoder->internal_state = decoderinternal;
+		return true;
+	}
+	SampleInfo GetSampleInfo(const StreamDecoder* decoder)
+	{
+		SampleInfo info = {};
+		if (decoder != nullptr && decoder->IsValid())
+		{
+			auto decoderinternal = to_internal(decoder);
+			info.sample_count = decoderinternal->sample_count;
+			info.sample_rate = (int)decoderinternal->info.sample_rate;
+			info.channel_count = (uint32_t)decoderinternal->info.channels;
+		}
+		return info;
+	}
+	size_t DecodeStream(StreamDecoder* decoder, short* output, size_t sample_count)
+	{
+		if (decoder == nullptr || !decoder->IsValid() || sample_count == 0)
+			return 0;
+		auto decoderinternal = to_internal(decoder);
+		const int channels = decoderinternal->info.channels;
+		const int num_shorts = (int)std::min(sample_count * channels, size_t(INT32_MAX));
+		return (size_t)stb_vorbis_get_samples_short_interleaved(decoderinternal->vorbis, channels, output, num_shorts);
+	}
+	bool SeekStream(StreamDecoder* decoder, size_t sample)
+	{
+		if (decoder == nullptr || !decoder->IsValid())
+			return false;
+		auto decoderinternal = to_internal(decoder);
+		if (sample == 0)
+		{
+			return stb_vorbis_seek_start(decoderinternal->vorbis) != 0;
+		}
+		return stb_vorbis_seek(decoderinternal->vorbis, (unsigned int)sample) != 0;
+	}
+
+	// Playback state of a streaming sound instance, shared by the platform implementations
+	//	The decoded audio is written to a small ring of buffers, a buffer is only overwritten after the voice consumed it
+	struct SoundStream
+	{
+		static constexpr uint32_t buffer_count = 3;
+		static constexpr uint32_t buffer_samples = 8192; // samples per channel in one buffer
+
+		StreamDecoder decoder;
+		uint32_t channel_count = 1;
+		wi::vector<short> buffers[buffer_count];
+		uint32_t next_buffer = 0;
+
+		// sample positions (per channel) in the stream:
+		size_t begin = 0;
+		size_t end = 0;
+		size_t loop_begin = 0;
+		size_t loop_end = 0;
+		size_t cursor = 0;
+
+		bool looped = false;
+		bool finished = false;
+		bool shutdown = false;
+		std::mutex locker;
+
+		wi::jobsystem::context ctx;
+		std::atomic_bool refill_pending{ false };
+
+		bool Init(const uint8_t* data, size_t size, const SoundInstance* instance)
+		{
+			if (!CreateStreamDecoder(data, size, &decoder))
+				return false;
+			const SampleInfo info = GetSampleInfo(&decoder);
+			channel_count = info.channel_count;
+			for (auto& buffer : buffers)
+			{
+				buffer.resize(buffer_samples * channel_count);
+			}
+
+			const size_t sample_rate = (size_t)info.sample_rate;
+			begin = std::min(info.sample_count, size_t(instance->begin * sample_rate));
+			end = info.sample_count;
+			if (instance->length > 0)
+			{
+				end = std::min(end, begin + size_t(instance->length * sample_rate));
+			}
+			loop_begin = std::min(end, begin + size_t(instance->loop_begin * sample_rate));
+			loop_end = end;
+			if (instance->loop_length > 0)
+			{
+				loop_end = std::min(end, loop_begin + size_t(instance->loop_length * sample_rate));
+			}
+			looped = instance->IsLooped() && loop_end > loop_begin;
+
+			ctx.priority = wi::jobsystem::Priority::Streaming;
+			return SeekTo(begin);
+		}
+
+		// Sets the decoding position to a sample of the stream, must be called while holding the lock (or during init)
+		bool SeekTo(size_t sample)
+		{
+			cursor = sample;
+			finished = false;
+			return SeekStream(&decoder, cursor);
+		}
+
+		// Decodes the next block of the stream into the next ring buffer, must be called while holding the lock
+		//	data		: receives the decoded interleaved samples
+		//	end_of_stream	: set to true if this is the last block of the stream
+		//	returns the number of samples per channel that were decoded
+		uint32_t Decode(const short** data, bool* end_of_stream)
+		{
+			short* dst = buffers[next_buffer].data();
+			next_buffer = (next_buffer + 1) % buffer_count;
+			*data = dst;
+
+			uint32_t written = 0;
+			while (!finished && written < buffer_samples)
+			{
+				const size_t range_end = looped ? loop_end : end;
+				if (cursor >= range_end)
+				{
+					if (looped)
+					{
+						cursor = loop_begin;
+						SeekStream(&decoder, cursor);
+						continue;
+					}
+					finished = true;
+					break;
+				}
+				const size_t count = std::min(size_t(buffer_samples - written), range_end - cursor);
+				const size_t decoded = DecodeStream(&decoder, dst + written * channel_count, count);
+				if (decoded == 0)
+				{
+					// The stream ended earlier than expected, so the real end is used from now:
+					end = std::min(end, cursor);
+					loop_end = std::min(loop_end, end);
+					looped = looped && loop_end > loop_begin;
+					continue;
+				}
+				cursor += decoded;
+				written += (uint32_t)decoded;
+			}
+			if (!looped && cursor >= end)
+			{
+				finished = true;
+			}
+			*end_of_stream = finished;
+			return written;
+		}
+	};
+
+	static std::atomic<uint32_t> voice_budget{ 64 };
+	static constexpr float voice_audibility_threshold = 0.001f; // instances that are quieter than this (-60 dB) don't get a real voice
+
+	void SetVoiceBudget(uint32_t count)
+	{
+		voice_budget.store(std::max(1u, count));
+	}
+	uint32_t GetVoiceBudget()
+	{
+		return voice_budget.load();
+	}
+
+	// Playback state of a sound instance, shared by the platform implementations
+	//	While the instance doesn't have a real voice (it is virtualized), the playback is only tracked in time with this,
+	//	so it can be continued from the right position when the instance gets a real voice again
+	struct VirtualVoice
+	{
+		float priority = 1;
+		float volume = 1;
+		float attenuation = 1; // the largest 3D output matrix coefficient, 1 if the instance is not 3D
+		bool playing = false; // Play() was called and the playback wasn't paused, stopped or finished since
+		bool ended = true;
+
+		// playback region in samples (per channel), relative to the beginning of the instance:
+		uint32_t sample_rate = 0;
+		uint64_t length = 0;
+		uint64_t loop_begin = 0;
+		uint64_t loop_end = 0;
+		bool looped = false;
+
+		uint64_t position = 0; // playback position at the time the real voice was attached or detached
+		uint64_t samples_played = 0; // samples played before the current real voice was attached
+		uint64_t voice_samples_base = 0; // samples played counter of the current real voice when it was attached
+
+		// Advances the playback position, returns true if the end of playback was reached
+		bool Advance(uint64_t samples)
+		{
+			samples_played += samples;
+			position += samples;
+			if (looped && loop_end > loop_begin)
+			{
+				if (position >= loop_end)
+				{
+					position = loop_begin + (position - loop_begin) % (loop_end - loop_begin);
+				}
+				return false;
+			}
+			if (position >= length)
+			{
+				position = length;
+				return true;
+			}
+			return false;
+		}
+		bool IsFinished() const
+		{
+			return !(looped && loop_end > loop_begin) && position >= length;
+		}
+		// Instances with higher audibility are more likely to get real voices
+		float GetAudibility() const
+		{
+			return priority * volume * attenuation;
+		}
+		void Rewind()
+		{
+			position = 0;
+			samples_played = 0;
+		}
+	};
+}
+
 #ifdef _WIN32
 
 #include <wrl/client.h> // ComPtr
@@ -70,6 +327,10 @@ namespace wi::audio
 		XAUDIO2FX_I3DL2_PRESET_PLATE,
 	};
 
+	struct PooledVoice;
+	struct SoundInstanceInternal;
+	static void DestroyPooledVoice(PooledVoice* voice);
+
 	struct AudioInternal
 	{
 		bool success = false;
@@ -83,6 +344,15 @@ namespace wi::audio
 		uint32_t termination_data = 0;
 		XAUDIO2_BUFFER termination_mark = {};
 
+		// Voice pool:
+		std::mutex voice_locker;
+		wi::vector<SoundInstanceInternal*> instances;
+		wi::vector<SoundInstanceInternal*> voice_candidates;
+		wi::vector<PooledVoice*> voices;
+		wi::vector<PooledVoice*> free_voices;
+		uint64_t created_voice_count = 0;
+		wi::Timer voice_timer;
+
 		AudioInternal()
 		{
 			wi::Timer timer;
@@ -187,6 +457,11 @@ namespace wi::audio
 		}
 		~AudioInternal()
 		{
+			for (PooledVoice* voice : voices)
+			{
+				DestroyPooledVoice(voice);
+			}
+
 			if (reverbSubmix != nullptr)
 				reverbSubmix->DestroyVoice();
 
@@ -217,24 +492,91 @@ namespace wi::audio
 	{
 		std::shared_ptr<AudioInternal> audio;
 		WAVEFORMATEX wfx = {};
-		wi::vector<uint8_t> audioData;
+		wi::vector<uint8_t> audioData; // for streaming sounds, this contains the compressed file data
+		bool streaming = false;
+		size_t stream_sample_count = 0;
 	};
-	struct SoundInstanceInternal : public IXAudio2VoiceCallback
+	struct SoundInstanceInternal : public VirtualVoice
 	{
 		std::shared_ptr<AudioInternal> audio;
 		std::shared_ptr<SoundInternal> soundinternal;
-		IXAudio2SourceVoice* sourceVoice = nullptr;
-		XAUDIO2_VOICE_DETAILS voiceDetails = {};
+		PooledVoice* voice = nullptr;
+		IXAudio2SourceVoice* sourceVoice = nullptr; // nullptr while the instance is virtualized
+		SUBMIX_TYPE type = SUBMIX_TYPE_SOUNDEFFECT;
+		bool reverb = false;
+		size_t instance_index = ~0ull;
+		XAUDIO2_BUFFER buffer = {};
+		std::unique_ptr<SoundStream> stream;
+
+		// 3D parameters are kept, so they can be applied when the instance gets a real voice:
+		bool has3D = false;
+		float frequencyRatio = 1;
+		float LPFDirectCoefficient = 0;
+		float LPFReverbCoefficient = 0;
 		wi::vector<float> outputMatrix;
+		wi::vector<float> reverbLevels;
 		wi::vector<float> channelAzimuths;
-		XAUDIO2_BUFFER buffer = {};
-		bool ended = true;
 
-		~SoundInstanceInternal()
+		~SoundInstanceInternal();
+
+		// Decodes and submits stream buffers until the ring of buffers is full
+		void RefillStream()
+		{
+			std::scoped_lock lck(stream->locker);
+			if (stream->shutdown || sourceVoice == nullptr)
+				return;
+			XAUDIO2_VOICE_STATE state = {};
+			sourceVoice->GetState(&state, XAUDIO2_VOICE_NOSAMPLESPLAYED);
+			uint32_t queued = state.BuffersQueued;
+			while (queued < SoundStream::buffer_count && !stream->finished)
+			{
+				const short* data = nullptr;
+				bool end_of_stream = false;
+				const uint32_t samples = stream->Decode(&data, &end_of_stream);
+				if (samples > 0)
+				{
+					XAUDIO2_BUFFER streambuffer = {};
+					streambuffer.pAudioData = (const BYTE*)data;
+					streambuffer.AudioBytes = samples * stream->channel_count * sizeof(short);
+					streambuffer.Flags = end_of_stream ? XAUDIO2_END_OF_STREAM : 0;
+					xaudio_check(sourceVoice->SubmitSourceBuffer(&streambuffer));
+				}
+				else if (end_of_stream)
+				{
+					xaudio_check(sourceVoice->SubmitSourceBuffer(&audio->termination_mark));
+				}
+				queued++;
+			}
+		}
+		// Schedules a stream refill on the streaming thread, this is safe to call from the audio thread
+		void RequestRefill()
 		{
-			sourceVoice->Stop();
-			sourceVoice->DestroyVoice();
+			if (stream->refill_pending.exchange(true))
+				return;
+			wi::jobsystem::Execute(stream->ctx, [this](wi::jobsystem::JobArgs args) {
+				stream->refill_pending.store(false);
+				RefillStream();
+			});
 		}
+	};
+
+	// Real voice that is reused by sound instances, the voice callbacks are forwarded to the current owner instance
+	struct PooledVoice : public IXAudio2VoiceCallback
+	{
+		IXAudio2SourceVoice* sourceVoice = nullptr;
+		uint32_t channel_count = 0;
+		uint32_t sample_rate = 0;
+		SoundInstanceInternal* owner = nullptr; // protected by locker, because callbacks are called from the audio thread
+		wi::SpinLock locker;
+		std::atomic<uint64_t> buffers_ended{ 0 }; // incremented by the audio thread for every returned buffer, including flushed ones
+
+		// Previous owners whose flushed buffers were not returned yet, the voice might still read their memory (protected by voice_locker):
+		struct PendingBuffers
+		{
+			const SoundInstanceInternal* instance = nullptr;
+			uint64_t buffers_ended = 0; // the buffers are returned when the voice's buffers_ended counter reaches this
+		};
+		wi::vector<PendingBuffers> pending;
 
 		// Called just before this voice's processing pass begins.
 		STDMETHOD_(void, OnVoiceProcessingPassStart) (THIS_ UINT32 BytesRequired)
@@ -250,19 +592,28 @@ namespace wi::audio
 		// (as marked with the XAUDIO2_END_OF_STREAM flag on the last buffer).
 		STDMETHOD_(void, OnStreamEnd) (THIS)
 		{
-			ended = true;
+			std::scoped_lock lck(locker);
+			if (owner != nullptr)
+			{
+				owner->ended = true;
+			}
 		}
 
 		// Called when this voice is about to start processing a new buffer.
 		STDMETHOD_(void, OnBufferStart) (THIS_ void* pBufferContext)
 		{
-			ended = false;
 		}
 
 		// Called when this voice has just finished processing a buffer.
 		// The buffer can now be reused or destroyed.
 		STDMETHOD_(void, OnBufferEnd) (THIS_ void* pBufferContext)
 		{
+			buffers_ended.fetch_add(1);
+			std::scoped_lock lck(locker);
+			if (owner != nullptr && owner->stream != nullptr)
+			{
+				owner->RequestRefill();
+			}
 		}
 
 		// Called when this voice has just reached the end position of a loop.
@@ -279,6 +630,260 @@ namespace wi::audio
 		{
 		}
 	};
+	static void DestroyPooledVoice(PooledVoice* voice)
+	{
+		voice->sourceVoice->DestroyVoice();
+		delete voice;
+	}
+
+	// Applies the last 3D parameters of the instance to its real voice
+	static void ApplyVoice3D(SoundInstanceInternal* instanceinternal)
+	{
+		IXAudio2SourceVoice* sourceVoice = instanceinternal->sourceVoice;
+		AudioInternal& audio = *instanceinternal->audio;
+		const uint32_t SrcChannelCount = instanceinternal->soundinternal->wfx.nChannels;
+		const uint32_t DstChannelCount = audio.masteringVoiceDetails.InputChannels;
+
+		xaudio_check(sourceVoice->SetFrequencyRatio(instanceinternal->frequencyRatio));
+
+		xaudio_check(sourceVoice->SetOutputMatrix(
+			audio.submixVoices[instanceinternal->type],
+			SrcChannelCount,
+			DstChannelCount,
+			instanceinternal->outputMatrix.data()
+		));
+
+		XAUDIO2_FILTER_PARAMETERS FilterParametersDirect = { LowPassFilter, 2.0f * sinf(X3DAUDIO_PI / 6.0f * instanceinternal->LPFDirectCoefficient), 1.0f };
+		xaudio_check(sourceVoice->SetOutputFilterParameters(audio.submixVoices[instanceinternal->type], &FilterParametersDirect));
+
+		if (instanceinternal->reverb)
+		{
+			xaudio_check(sourceVoice->SetOutputMatrix(audio.reverbSubmix, SrcChannelCount, 1, instanceinternal->reverbLevels.data()));
+
+			XAUDIO2_FILTER_PARAMETERS FilterParametersReverb = { LowPassFilter, 2.0f * sinf(X3DAUDIO_PI / 6.0f * instanceinternal->LPFReverbCoefficient), 1.0f };
+			xaudio_check(sourceVoice->SetOutputFilterParameters(audio.reverbSubmix, &FilterParametersReverb));
+		}
+	}
+
+	// Gives a real voice to the instance and continues playback from its position, the voice_locker must be held
+	static bool AttachVoice(SoundInstanceInternal* instanceinternal)
+	{
+		AudioInternal& audio = *instanceinternal->audio;
+		const WAVEFORMATEX& wfx = instanceinternal->soundinternal->wfx;
+
+		XAUDIO2_SEND_DESCRIPTOR SFXSend[] = {
+			{ XAUDIO2_SEND_USEFILTER, audio.submixVoices[instanceinternal->type] },
+			{ XAUDIO2_SEND_USEFILTER, audio.reverbSubmix }, // this should be last to enable/disable reverb simply
+		};
+		XAUDIO2_VOICE_SENDS SFXSendList = {
+			instanceinternal->reverb ? (uint32_t)arraysize(SFXSend) : 1,
+			SFXSend
+		};
+
+		PooledVoice* voice = nullptr;
+		for (size_t i = 0; i < audio.free_voices.size(); ++i)
+		{
+			if (audio.free_voices[i]->channel_count == wfx.nChannels && audio.free_voices[i]->sample_rate == wfx.nSamplesPerSec)
+			{
+				voice = audio.free_voices[i];
+				audio.free_voices[i] = audio.free_voices.back();
+				audio.free_voices.pop_back();
+				break;
+			}
+		}
+
+		if (voice == nullptr)
+		{
+			if (!audio.free_voices.empty() && audio.voices.size() >= voice_budget.load())
+			{
+				// The pool is full, but none of the free voices have the right format, so one of them is replaced:
+				PooledVoice* replaced = audio.free_voices.back();
+				audio.free_voices.pop_back();
+				audio.voices.erase(std::find(audio.voices.begin(), audio.voices.end(), replaced));
+				DestroyPooledVoice(replaced);
+			}
+
+			voice = new PooledVoice;
+			HRESULT hr = xaudio_check(audio.audioEngine->CreateSourceVoice(&voice->sourceVoice, &wfx,
+				0, XAUDIO2_DEFAULT_FREQ_RATIO, voice, &SFXSendList, NULL));
+			if (FAILED(hr))
+			{
+				delete voice;
+				return false;
+			}
+			voice->channel_count = wfx.nChannels;
+			voice->sample_rate = wfx.nSamplesPerSec;
+			audio.voices.push_back(voice);
+			audio.created_voice_count++;
+		}
+		else
+		{
+			// This also resets the output matrices and filters that were set by the previous owner:
+			xaudio_check(voice->sourceVoice->SetOutputVoices(&SFXSendList));
+			xaudio_check(voice->sourceVoice->SetFrequencyRatio(1));
+		}
+
+		{
+			std::scoped_lock lck(voice->locker);
+			voice->owner = instanceinternal;
+		}
+		instanceinternal->voice = voice;
+
+		XAUDIO2_VOICE_STATE state = {};
+		voice->sourceVoice->GetState(&state, 0);
+		instanceinternal->voice_samples_base = state.SamplesPlayed;
+		instanceinternal->ended = false;
+
+		xaudio_check(voice->sourceVoice->SetVolume(instanceinternal->volume));
+
+		if (instanceinternal->stream != nullptr)
+		{
+			{
+				std::scoped_lock lck(instanceinternal->stream->locker);
+				instanceinternal->sourceVoice = voice->sourceVoice;
+				instanceinternal->stream->looped = instanceinternal->looped;
+				instanceinternal->stream->SeekTo(instanceinternal->stream->begin + (size_t)instanceinternal->position);
+			}
+			instanceinternal->RefillStream();
+		}
+		else
+		{
+			instanceinternal->sourceVoice = voice->sourceVoice;
+			XAUDIO2_BUFFER buffer = instanceinternal->buffer;
+			buffer.PlayBegin = (UINT32)instanceinternal->position;
+			buffer.PlayLength = (UINT32)(instanceinternal->length - instanceinternal->position);
+			xaudio_check(instanceinternal->sourceVoice->SubmitSourceBuffer(&buffer));
+		}
+
+		if (instanceinternal->has3D)
+		{
+			ApplyVoice3D(instanceinternal);
+		}
+
+		if (instanceinternal->playing)
+		{
+			xaudio_check(instanceinternal->sourceVoice->Start());
+		}
+		return true;
+	}
+
+	// Takes away the real voice of the instance and remembers the playback position, the voice_locker must be held
+	static void DetachVoice(SoundInstanceInternal* instanceinternal)
+	{
+		PooledVoice* voice = instanceinternal->voice;
+		if (voice == nullptr)
+			return;
+
+		xaudio_check(voice->sourceVoice->Stop());
+
+		XAUDIO2_VOICE_STATE state = {};
+		voice->sourceVoice->GetState(&state, 0);
+		if (instanceinternal->ended && !instanceinternal->looped)
+		{
+			// The end of stream resets the samples played counter of the voice:
+			instanceinternal->samples_played += instanceinternal->length - instanceinternal->position;
+			instanceinternal->position = instanceinternal->length;
+		}
+		else if (state.SamplesPlayed >= instanceinternal->voice_samples_base)
+		{
+			instanceinternal->Advance(state.SamplesPlayed - instanceinternal->voice_samples_base);
+		}
+
+		if (instanceinternal->stream != nullptr)
+		{
+			std::scoped_lock lck(instanceinternal->stream->locker);
+			instanceinternal->sourceVoice = nullptr;
+		}
+		else
+		{
+			instanceinternal->sourceVoice = nullptr;
+		}
+
+		// The flushed buffers are only returned later by the audio thread, until then the instance's memory must stay alive:
+		voice->pending.erase(std::remove_if(voice->pending.begin(), voice->pending.end(), [voice](const PooledVoice::PendingBuffers& pending) {
+			return voice->buffers_ended.load() >= pending.buffers_ended;
+		}), voice->pending.end());
+		voice->sourceVoice->GetState(&state, XAUDIO2_VOICE_NOSAMPLESPLAYED);
+		if (state.BuffersQueued > 0)
+		{
+			voice->pending.push_back({ instanceinternal, voice->buffers_ended.load() + state.BuffersQueued });
+		}
+
+		xaudio_check(voice->sourceVoice->FlushSourceBuffers());
+		{
+			std::scoped_lock lck(voice->locker);
+			voice->owner = nullptr;
+		}
+		instanceinternal->voice = nullptr;
+		instanceinternal->audio->free_voices.push_back(voice);
+	}
+
+	// Makes sure that no real voice reads the buffers of the instance anymore, so its stream and sound data can be freed. The voice_locker must be held
+	static void ReleaseVoiceBuffers(SoundInstanceInternal* instanceinternal)
+	{
+		AudioInternal& audio = *instanceinternal->audio;
+		wi::vector<PooledVoice*> referencing_voices;
+		for (PooledVoice* voice : audio.voices)
+		{
+			bool referenced = false;
+			for (size_t i = 0; i < voice->pending.size();)
+			{
+				const PooledVoice::PendingBuffers& pending = voice->pending[i];
+				if (pending.instance == instanceinternal || voice->buffers_ended.load() >= pending.buffers_ended)
+				{
+					referenced |= pending.instance == instanceinternal && voice->buffers_ended.load() < pending.buffers_ended;
+					voice->pending[i] = voice->pending.back();
+					voice->pending.pop_back();
+					continue;
+				}
+				i++;
+			}
+			if (referenced)
+			{
+				referencing_voices.push_back(voice);
+			}
+		}
+
+		// The audio thread didn't return the flushed buffers yet, destroying the voice is the only way to make sure that it stops reading them:
+		for (PooledVoice* voice : referencing_voices)
+		{
+			SoundInstanceInternal* owner = voice->owner;
+			if (owner != nullptr)
+			{
+				DetachVoice(owner); // the voice could have been reused by an other instance since then, it will get a new voice
+			}
+			audio.free_voices.erase(std::find(audio.free_voices.begin(), audio.free_voices.end(), voice));
+			audio.voices.erase(std::find(audio.voices.begin(), audio.voices.end(), voice));
+			DestroyPooledVoice(voice);
+			if (owner != nullptr)
+			{
+				AttachVoice(owner);
+			}
+		}
+	}
+
+	SoundInstanceInternal::~SoundInstanceInternal()
+	{
+		if (stream != nullptr)
+		{
+			std::scoped_lock lck(stream->locker);
+			stream->shutdown = true;
+		}
+		if (instance_index < ~0ull)
+		{
+			std::scoped_lock lck(audio->voice_locker);
+			DetachVoice(this);
+			ReleaseVoiceBuffers(this);
+			audio->instances[instance_index] = audio->instances.back();
+			audio->instances[instance_index]->instance_index = instance_index;
+			audio->instances.pop_back();
+		}
+		if (stream != nullptr)
+		{
+			wi::jobsystem::Wait(stream->ctx);
+		}
+	}
+
 	SoundInternal* to_internal(const Sound* param)
 	{
 		return static_cast<SoundInternal*>(param->internal_state.get());
@@ -422,87 +1027,233 @@ namespace wi::audio
 
 		return true;
 	}
+	bool CreateSoundStreaming(const std::string& filename, Sound* sound)
+	{
+		wi::vector<uint8_t> filedata;
+		bool success = wi::helper::FileRead(filename, filedata);
+		if (!success)
+		{
+			return false;
+		}
+		return CreateSoundStreaming(filedata.data(), filedata.size(), sound);
+	}
+	bool CreateSoundStreaming(const uint8_t* data, size_t size, Sound* sound)
+	{
+		if (audio_internal == nullptr || !audio_internal->IsValid())
+			return false;
+
+		StreamDecoder decoder;
+		if (!CreateStreamDecoder(data, size, &decoder))
+		{
+			// Not an Ogg file, it can't be streamed:
+			return CreateSound(data, size, sound);
+		}
+		const SampleInfo info = GetSampleInfo(&decoder);
+
+		std::shared_ptr<SoundInternal> soundinternal = std::make_shared<SoundInternal>();
+		soundinternal->audio = audio_internal;
+		soundinternal->streaming = true;
+		soundinternal->stream_sample_count = info.sample_count;
+		soundinternal->audioData.resize(size);
+		memcpy(soundinternal->audioData.data(), data, size);
+
+		soundinternal->wfx.wFormatTag = WAVE_FORMAT_PCM;
+		soundinternal->wfx.nChannels = (WORD)info.channel_count;
+		soundinternal->wfx.nSamplesPerSec = (DWORD)info.sample_rate;
+		soundinternal->wfx.wBitsPerSample = sizeof(short) * 8;
+		soundinternal->wfx.nBlockAlign = (WORD)info.channel_count * sizeof(short);
+		soundinternal->wfx.nAvgBytesPerSec = soundinternal->wfx.nSamplesPerSec * soundinternal->wfx.nBlockAlign;
+
+		sound->internal_state = soundinternal;
+		return true;
+	}
 	bool CreateSoundInstance(const Sound* sound, SoundInstance* instance)
 	{
 		if (audio_internal == nullptr || !audio_internal->IsValid())
 			return false;
 		if (sound == nullptr || !sound->IsValid())
 			return false;
-		HRESULT hr;
 		const auto& soundinternal = std::static_pointer_cast<SoundInternal>(sound->internal_state);
 		std::shared_ptr<SoundInstanceInternal> instanceinternal = std::make_shared<SoundInstanceInternal>();
-		instance->internal_state = instanceinternal;
 
 		instanceinternal->audio = audio_internal;
 		instanceinternal->soundinternal = soundinternal;
-
-		XAUDIO2_SEND_DESCRIPTOR SFXSend[] = {
-			{ XAUDIO2_SEND_USEFILTER, instanceinternal->audio->submixVoices[instance->type] },
-			{ XAUDIO2_SEND_USEFILTER, instanceinternal->audio->reverbSubmix }, // this should be last to enable/disable reverb simply
-		};
-		XAUDIO2_VOICE_SENDS SFXSendList = {
-			(instance->IsEnableReverb() && instanceinternal->audio->reverbSubmix != nullptr) ? (uint32_t)arraysize(SFXSend) : 1,
-			SFXSend
-		};
-
-		hr = xaudio_check(instanceinternal->audio->audioEngine->CreateSourceVoice(&instanceinternal->sourceVoice, &soundinternal->wfx,
-			0, XAUDIO2_DEFAULT_FREQ_RATIO, instanceinternal.get(), &SFXSendList, NULL));
-
-		if (FAILED(hr))
-		{
-			return false;
-		}
-
-		instanceinternal->sourceVoice->GetVoiceDetails(&instanceinternal->voiceDetails);
-		
-		instanceinternal->outputMatrix.resize(size_t(instanceinternal->voiceDetails.InputChannels) * size_t(instanceinternal->audio->masteringVoiceDetails.InputChannels));
-		instanceinternal->channelAzimuths.resize(instanceinternal->voiceDetails.InputChannels);
+		instanceinternal->type = instance->type;
+		instanceinternal->reverb = instance->IsEnableReverb() && audio_internal->reverbSubmix != nullptr;
+		instanceinternal->priority = instance->priority;
+		instanceinternal->sample_rate = soundinternal->wfx.nSamplesPerSec;
+
+		// The real voice is not created here, it will be taken from the voice pool when the instance is played
+		const uint32_t channel_count = soundinternal->wfx.nChannels;
+		instanceinternal->outputMatrix.resize(size_t(channel_count) * size_t(audio_internal->masteringVoiceDetails.InputChannels));
+		instanceinternal->reverbLevels.resize(channel_count);
+		instanceinternal->channelAzimuths.resize(channel_count);
 		for (size_t i = 0; i < instanceinternal->channelAzimuths.size(); ++i)
 		{
 			instanceinternal->channelAzimuths[i] = X3DAUDIO_2PI * float(i) / float(instanceinternal->channelAzimuths.size());
 		}
 
-		const uint32_t bytes_per_second = soundinternal->wfx.nSamplesPerSec * soundinternal->wfx.nChannels * sizeof(short);
-		instanceinternal->buffer.pAudioData = soundinternal->audioData.data();
-		instanceinternal->buffer.AudioBytes = (uint32_t)soundinternal->audioData.size();
-		if (instance->begin > 0)
+		if (soundinternal->streaming)
 		{
-			const uint32_t bytes_from_beginning = AlignTo(std::min(instanceinternal->buffer.AudioBytes, uint32_t(instance->begin * bytes_per_second)), 4u);
-			instanceinternal->buffer.pAudioData += bytes_from_beginning;
-			instanceinternal->buffer.AudioBytes -= bytes_from_beginning;
+			instanceinternal->stream = std::make_unique<SoundStream>();
+			if (!instanceinternal->stream->Init(soundinternal->audioData.data(), soundinternal->audioData.size(), instance))
+			{
+				return false;
+			}
+			const SoundStream& stream = *instanceinternal->stream;
+			instanceinternal->length = stream.end - stream.begin;
+			instanceinternal->loop_begin = stream.loop_begin - stream.begin;
+			instanceinternal->loop_end = stream.loop_end - stream.begin;
+			instanceinternal->looped = stream.looped;
 		}
-		if (instance->length > 0)
+		else
 		{
-			instanceinternal->buffer.AudioBytes = AlignTo(std::min(instanceinternal->buffer.AudioBytes, uint32_t(instance->length * bytes_per_second)), 4u);
+			const uint32_t bytes_per_second = soundinternal->wfx.nSamplesPerSec * soundinternal->wfx.nChannels * sizeof(short);
+			instanceinternal->buffer.pAudioData = soundinternal->audioData.data();
+			instanceinternal->buffer.AudioBytes = (uint32_t)soundinternal->audioData.size();
+			if (instance->begin > 0)
+			{
+				const uint32_t bytes_from_beginning = AlignTo(std::min(instanceinternal->buffer.AudioBytes, uint32_t(instance->begin * bytes_per_second)), 4u);
+				instanceinternal->buffer.pAudioData += bytes_from_beginning;
+				instanceinternal->buffer.AudioBytes -= bytes_from_beginning;
+			}
+			if (instance->length > 0)
+			{
+				instanceinternal->buffer.AudioBytes = AlignTo(std::min(instanceinternal->buffer.AudioBytes, uint32_t(instance->length * bytes_per_second)), 4u);
+			}
+
+			uint32_t num_remaining_samples = instanceinternal->buffer.AudioBytes / (soundinternal->wfx.nChannels * sizeof(short));
+			instanceinternal->length = num_remaining_samples;
+			if (instance->loop_begin > 0)
+			{
+				instanceinternal->buffer.LoopBegin = AlignTo(std::min(num_remaining_samples, uint32_t(instance->loop_begin * soundinternal->wfx.nSamplesPerSec)), 4u);
+				num_remaining_samples -= instanceinternal->buffer.LoopBegin;
+			}
+			instanceinternal->buffer.LoopLength = AlignTo(std::min(num_remaining_samples, uint32_t(instance->loop_length * soundinternal->wfx.nSamplesPerSec)), 4u);
+
+			instanceinternal->buffer.Flags = XAUDIO2_END_OF_STREAM;
+			instanceinternal->buffer.LoopCount = instance->IsLooped() ? XAUDIO2_LOOP_INFINITE : 0;
+			if (instanceinternal->buffer.LoopCount == 0)
+			{
+				instanceinternal->buffer.LoopBegin = 0;
+				instanceinternal->buffer.LoopLength = 0;
+			}
+
+			instanceinternal->loop_begin = instanceinternal->buffer.LoopBegin;
+			instanceinternal->loop_end = instanceinternal->buffer.LoopLength > 0 ? instanceinternal->loop_begin + instanceinternal->buffer.LoopLength : instanceinternal->length;
+			instanceinternal->looped = instanceinternal->buffer.LoopCount > 0;
 		}
 
-		uint32_t num_remaining_samples = instanceinternal->buffer.AudioBytes / (soundinternal->wfx.nChannels * sizeof(short));
-		if (instance->loop_begin > 0)
 		{
-			instanceinternal->buffer.LoopBegin = AlignTo(std::min(num_remaining_samples, uint32_t(instance->loop_begin * soundinternal->wfx.nSamplesPerSec)), 4u);
-			num_remaining_samples -= instanceinternal->buffer.LoopBegin;
+			std::scoped_lock lck(audio_internal->voice_locker);
+			instanceinternal->instance_index = audio_internal->instances.size();
+			audio_internal->instances.push_back(instanceinternal.get());
 		}
-		instanceinternal->buffer.LoopLength = AlignTo(std::min(num_remaining_samples, uint32_t(instance->loop_length * soundinternal->wfx.nSamplesPerSec)), 4u);
 
-		instanceinternal->buffer.Flags = XAUDIO2_END_OF_STREAM;
-		instanceinternal->buffer.LoopCount = instance->IsLooped() ? XAUDIO2_LOOP_INFINITE : 0;
+		instance->internal_state = instanceinternal;
+		return true;
+	}
 
-		hr = xaudio_check(instanceinternal->sourceVoice->SubmitSourceBuffer(&instanceinternal->buffer));
+	// Gives the real voices to the most audible instances, the voice_locker must be held
+	static void ReassignVoices(AudioInternal& audio)
+	{
+		const double elapsed = audio.voice_timer.record_elapsed_seconds();
+		const uint32_t budget = voice_budget.load();
 
-		if (FAILED(hr))
+		auto& candidates = audio.voice_candidates;
+		candidates.clear();
+		for (SoundInstanceInternal* instanceinternal : audio.instances)
 		{
-			return false;
+			if (instanceinternal->voice == nullptr)
+			{
+				if (!instanceinternal->playing)
+					continue;
+				// Virtualized instances are only tracked in time:
+				if (instanceinternal->Advance(uint64_t(elapsed * instanceinternal->sample_rate + 0.5)))
+				{
+					instanceinternal->playing = false;
+					instanceinternal->ended = true;
+					continue;
+				}
+			}
+			else if (instanceinternal->playing && instanceinternal->ended)
+			{
+				// The real voice finished playing, it can be used by other instances:
+				DetachVoice(instanceinternal);
+				instanceinternal->playing = false;
+				continue;
+			}
+			candidates.push_back(instanceinternal);
 		}
 
-		return true;
+		// The most audible playing instances get the real voices, paused instances can keep theirs if there are enough:
+		const size_t real_count = std::min(candidates.size(), size_t(budget));
+		if (candidates.size() > real_count)
+		{
+			std::nth_element(candidates.begin(), candidates.begin() + real_count, candidates.end(), [](const SoundInstanceInternal* a, const SoundInstanceInternal* b) {
+				if (a->playing != b->playing)
+					return a->playing;
+				return a->GetAudibility() > b->GetAudibility();
+			});
+		}
+
+		// Voices are detached first, so that they can be reused by the newly attached instances:
+		for (size_t i = 0; i < candidates.size(); ++i)
+		{
+			SoundInstanceInternal* instanceinternal = candidates[i];
+			if (instanceinternal->voice != nullptr && (i >= real_count || (instanceinternal->playing && instanceinternal->GetAudibility() <= voice_audibility_threshold)))
+			{
+				DetachVoice(instanceinternal);
+			}
+		}
+		for (size_t i = 0; i < real_count; ++i)
+		{
+			SoundInstanceInternal* instanceinternal = candidates[i];
+			if (instanceinternal->voice == nullptr && instanceinternal->playing && instanceinternal->GetAudibility() > voice_audibility_threshold)
+			{
+				AttachVoice(instanceinternal);
+			}
+		}
+
+		// If the budget was lowered, the unused voices above the budget are destroyed:
+		while (audio.voices.size() > budget && !audio.free_voices.empty())
+		{
+			PooledVoice* voice = audio.free_voices.back();
+			audio.free_voices.pop_back();
+			audio.voices.erase(std::find(audio.voices.begin(), audio.voices.end(), voice));
+			DestroyPooledVoice(voice);
+		}
 	}
+
 	void Play(SoundInstance* instance)
 	{
 		if (instance != nullptr && instance->IsValid())
 		{
 			auto instanceinternal = to_internal(instance);
-			xaudio_check(instanceinternal->sourceVoice->Start());
+			std::scoped_lock lck(instanceinternal->audio->voice_locker);
+			if (instanceinternal->playing)
+				return;
+			if (instanceinternal->voice == nullptr && instanceinternal->IsFinished())
+				return; // finished playback needs to be stopped to restart
+			instanceinternal->playing = true;
+			if (instanceinternal->sourceVoice != nullptr)
+			{
+				xaudio_check(instanceinternal->sourceVoice->Start());
+				return;
+			}
+			instanceinternal->ended = false;
 
+			// If there is room in the voice budget, the real voice is attached immediately even if the instance is not audible yet,
+			//	otherwise the voices are reassigned now, so playback doesn't depend on UpdateVoices() being called every frame:
+			AudioInternal& audio = *instanceinternal->audio;
+			if (audio.voices.size() - audio.free_voices.size() < voice_budget.load())
+			{
+				AttachVoice(instanceinternal);
+			}
+			else
+			{
+				ReassignVoices(audio);
+			}
 		}
 	}
 	void Pause(SoundInstance* instance)
@@ -510,8 +1261,12 @@ namespace wi::audio
 		if (instance != nullptr && instance->IsValid())
 		{
 			auto instanceinternal = to_internal(instance);
-			xaudio_check(instanceinternal->sourceVoice->Stop()); // preserves cursor position
-
+			std::scoped_lock lck(instanceinternal->audio->voice_locker);
+			instanceinternal->playing = false;
+			if (instanceinternal->sourceVoice != nullptr)
+			{
+				xaudio_check(instanceinternal->sourceVoice->Stop()); // preserves cursor position
+			}
 		}
 	}
 	void Stop(SoundInstance* instance)
@@ -519,17 +1274,13 @@ namespace wi::audio
 		if (instance != nullptr && instance->IsValid())
 		{
 			auto instanceinternal = to_internal(instance);
-			xaudio_check(instanceinternal->sourceVoice->Stop()); // preserves cursor position
-
-			xaudio_check(instanceinternal->sourceVoice->FlushSourceBuffers()); // reset submitted audio buffer
-
-			if (!instanceinternal->ended) // if already ended, don't submit end again, it can cause high pitched jerky sound
-			{
-				xaudio_check(instanceinternal->sourceVoice->SubmitSourceBuffer(&audio_internal->termination_mark)); // mark this as terminated, this resets XAUDIO2_VOICE_STATE::SamplesPlayed to zero
-
-			}
-			xaudio_check(instanceinternal->sourceVoice->SubmitSourceBuffer(&instanceinternal->buffer)); // resubmit
-
+			std::scoped_lock lck(instanceinternal->audio->voice_locker);
+			if (!instanceinternal->playing && instanceinternal->voice == nullptr && instanceinternal->position == 0)
+				return; // already stopped
+			DetachVoice(instanceinternal); // the voice goes back to the pool
+			instanceinternal->Rewind();
+			instanceinternal->playing = false;
+			instanceinternal->ended = true;
 		}
 	}
 	void SetVolume(float volume, SoundInstance* instance)
@@ -542,6 +1293,10 @@ namespace wi::audio
 		else
 		{
 			auto instanceinternal = to_internal(instance);
+			std::scoped_lock lck(instanceinternal->audio->voice_locker);
+			if (instanceinternal->volume == volume)
+				return;
+			instanceinternal->volume = volume;
 			if (instanceinternal->sourceVoice != nullptr)
 				xaudio_check(instanceinternal->sourceVoice->SetVolume(volume));
 		}
@@ -557,8 +1312,7 @@ namespace wi::audio
 		else
 		{
 			auto instanceinternal = to_internal(instance);
-			if(instanceinternal->sourceVoice != nullptr)
-				instanceinternal->sourceVoice->GetVolume(&volume);
+			volume = instanceinternal->volume;
 		}
 		return volume;
 	}
@@ -567,14 +1321,23 @@ namespace wi::audio
 		if (instance != nullptr && instance->IsValid())
 		{
 			auto instanceinternal = to_internal(instance);
-			if (instanceinternal->buffer.LoopCount == 0)
+			std::scoped_lock lck(instanceinternal->audio->voice_locker);
+			if (!instanceinternal->looped)
 				return;
-			xaudio_check(instanceinternal->sourceVoice->ExitLoop());
-
-			if (instanceinternal->ended)
+			instanceinternal->looped = false;
+			if (instanceinternal->stream != nullptr)
+			{
+				// The stream will be decoded until the end instead of jumping back to the loop begin:
+				std::scoped_lock stream_lck(instanceinternal->stream->locker);
+				instanceinternal->stream->looped = false;
+				return;
+			}
+			instanceinternal->buffer.LoopCount = 0;
+			instanceinternal->buffer.LoopBegin = 0;
+			instanceinternal->buffer.LoopLength = 0;
+			if (instanceinternal->sourceVoice != nullptr)
 			{
-				instanceinternal->buffer.LoopCount = 0;
-				xaudio_check(instanceinternal->sourceVoice->SubmitSourceBuffer(&instanceinternal->buffer));
+				xaudio_check(instanceinternal->sourceVoice->ExitLoop());
 			}
 		}
 	}
@@ -595,9 +1358,14 @@ namespace wi::audio
 		{
 			auto soundinternal = to_internal(sound);
 			info.channel_count = soundinternal->wfx.nChannels;
+			info.sample_rate = soundinternal->wfx.nSamplesPerSec;
+			if (soundinternal->streaming)
+			{
+				info.sample_count = soundinternal->stream_sample_count;
+				return info;
+			}
 			info.samples = (const short*)soundinternal->audioData.data();
 			info.sample_count = soundinternal->audioData.size() / (info.channel_count * sizeof(short));
-			info.sample_rate = soundinternal->wfx.nSamplesPerSec;
 		}
 		return info;
 	}
@@ -606,14 +1374,58 @@ namespace wi::audio
 		if (instance != nullptr && instance->IsValid())
 		{
 			auto instanceinternal = to_internal(instance);
-			XAUDIO2_VOICE_STATE state = {};
+			std::scoped_lock lck(instanceinternal->audio->voice_locker);
+			uint64_t samples_played = instanceinternal->samples_played;
 			if (instanceinternal->sourceVoice != nullptr)
+			{
+				XAUDIO2_VOICE_STATE state = {};
 				instanceinternal->sourceVoice->GetState(&state, 0);
-			return state.SamplesPlayed;
+				if (state.SamplesPlayed >= instanceinternal->voice_samples_base)
+				{
+					samples_played += state.SamplesPlayed - instanceinternal->voice_samples_base;
+				}
+			}
+			return samples_played;
 		}
 		return 0ull;
 	}
 
+	void UpdateVoices()
+	{
+		if (audio_internal == nullptr || !audio_internal->IsValid())
+			return;
+		AudioInternal& audio = *audio_internal;
+		std::scoped_lock lck(audio.voice_locker);
+		ReassignVoices(audio);
+	}
+	bool IsVirtual(const SoundInstance* instance)
+	{
+		if (instance != nullptr && instance->IsValid())
+		{
+			auto instanceinternal = to_internal(instance);
+			return instanceinternal->voice == nullptr;
+		}
+		return false;
+	}
+	VoiceStatistics GetVoiceStatistics()
+	{
+		VoiceStatistics stats;
+		if (audio_internal == nullptr || !audio_internal->IsValid())
+			return stats;
+		std::scoped_lock lck(audio_internal->voice_locker);
+		stats.real_voices = uint32_t(audio_internal->voices.size() - audio_internal->free_voices.size());
+		stats.pooled_voices = (uint32_t)audio_internal->free_voices.size();
+		stats.created_voices = audio_internal->created_voice_count;
+		for (const SoundInstanceInternal* instanceinternal : audio_internal->instances)
+		{
+			if (instanceinternal->playing && instanceinternal->voice == nullptr)
+			{
+				stats.virtual_voices++;
+			}
+		}
+		return stats;
+	}
+
 	void SetSubmixVolume(SUBMIX_TYPE type, float volume)
 	{
 		if(audio_internal->submixVoices[type] != nullptr)
@@ -631,6 +1443,7 @@ namespace wi::audio
 		if (instance != nullptr && instance->IsValid())
 		{
 			auto instanceinternal = to_internal(instance);
+			std::scoped_lock lck(instanceinternal->audio->voice_locker);
 
 			X3DAUDIO_LISTENER listener = {};
 			listener.Position = instance3D.listenerPos;
@@ -645,7 +1458,7 @@ namespace wi::audio
 			emitter.Velocity = instance3D.emitterVelocity;
 			emitter.InnerRadius = instance3D.emitterRadius;
 			emitter.InnerRadiusAngle = X3DAUDIO_PI / 4.0f;
-			emitter.ChannelCount = instanceinternal->voiceDetails.InputChannels;
+			emitter.ChannelCount = instanceinternal->soundinternal->wfx.nChannels;
 			emitter.pChannelAzimuths = instanceinternal->channelAzimuths.data();
 			emitter.ChannelRadius = 0.1f;
 			emitter.CurveDistanceScaler = 1;
@@ -663,33 +1476,23 @@ namespace wi::audio
 			//flags |= X3DAUDIO_CALCULATE_REDIRECT_TO_LFE;
 
 			X3DAUDIO_DSP_SETTINGS settings = {};
-			settings.SrcChannelCount = instanceinternal->voiceDetails.InputChannels;
+			settings.SrcChannelCount = instanceinternal->soundinternal->wfx.nChannels;
 			settings.DstChannelCount = instanceinternal->audio->masteringVoiceDetails.InputChannels;
 			settings.pMatrixCoefficients = instanceinternal->outputMatrix.data();
 
 			X3DAudioCalculate(instanceinternal->audio->audio3D, &listener, &emitter, flags, &settings);
 
-			xaudio_check(instanceinternal->sourceVoice->SetFrequencyRatio(settings.DopplerFactor));
-
-			xaudio_check(instanceinternal->sourceVoice->SetOutputMatrix(
-				instanceinternal->audio->submixVoices[instance->type],
-				settings.SrcChannelCount,
-				settings.DstChannelCount,
-				settings.pMatrixCoefficients
-			));
-
-			
-			XAUDIO2_FILTER_PARAMETERS FilterParametersDirect = { LowPassFilter, 2.0f * sinf(X3DAUDIO_PI / 6.0f * settings.LPFDirectCoefficient), 1.0f };
-			xaudio_check(instanceinternal->sourceVoice->SetOutputFilterParameters(instanceinternal->audio->submixVoices[instance->type], &FilterParametersDirect));
+			// The results are stored, because virtualized instances will only apply them when they get a real voice:
+			instanceinternal->has3D = true;
+			instanceinternal->frequencyRatio = settings.DopplerFactor;
+			instanceinternal->LPFDirectCoefficient = settings.LPFDirectCoefficient;
+			instanceinternal->LPFReverbCoefficient = settings.LPFReverbCoefficient;
+			std::fill(instanceinternal->reverbLevels.begin(), instanceinternal->reverbLevels.end(), settings.ReverbLevel);
+			instanceinternal->attenuation = *std::max_element(instanceinternal->outputMatrix.begin(), instanceinternal->outputMatrix.end());
 
-
-			if (instance->IsEnableReverb() && instanceinternal->audio->reverbSubmix != nullptr)
+			if (instanceinternal->sourceVoice != nullptr)
 			{
-				xaudio_check(instanceinternal->sourceVoice->SetOutputMatrix(instanceinternal->audio->reverbSubmix, settings.SrcChannelCount, 1, &settings.ReverbLevel));
-
-				XAUDIO2_FILTER_PARAMETERS FilterParametersReverb = { LowPassFilter, 2.0f * sinf(X3DAUDIO_PI / 6.0f * settings.LPFReverbCoefficient), 1.0f };
-				xaudio_check(instanceinternal->sourceVoice->SetOutputFilterParameters(instanceinternal->audio->reverbSubmix, &FilterParametersReverb));
-
+				ApplyVoice3D(instanceinternal);
 			}
 		}
 	}
@@ -752,6 +1555,10 @@ namespace wi::audio
 		FAUDIOFX_I3DL2_PRESET_PLATE,
 	};
 
+	struct PooledVoice;
+	struct SoundInstanceInternal;
+	static void DestroyPooledVoice(PooledVoice* voice);
+
 	struct AudioInternal{
 		bool success = false;
 		FAudio *audioEngine;
@@ -764,6 +1571,15 @@ namespace wi::audio
 		uint32_t termination_data = 0;
 		FAudioBuffer termination_mark = {};
 
+		// Voice pool:
+		std::mutex voice_locker;
+		wi::vector<SoundInstanceInternal*> instances;
+		wi::vector<SoundInstanceInternal*> voice_candidates;
+		wi::vector<PooledVoice*> voices;
+		wi::vector<PooledVoice*> free_voices;
+		uint64_t created_voice_count = 0;
+		wi::Timer voice_timer;
+
 		AudioInternal(){
 			wi::Timer timer;
 
@@ -864,6 +1680,11 @@ namespace wi::audio
 				  (int)std::round(timer.elapsed()));
 		}
 		~AudioInternal(){
+			for (PooledVoice* voice : voices)
+			{
+				DestroyPooledVoice(voice);
+			}
+
 			if(reverbSubmix != nullptr)
 				FAudioVoice_DestroyVoice(reverbSubmix);
 
@@ -889,24 +1710,381 @@ namespace wi::audio
 	struct SoundInternal{
 		std::shared_ptr<AudioInternal> audio;
 		FAudioWaveFormatEx wfx = {};
-		wi::vector<uint8_t> audioData;
+		wi::vector<uint8_t> audioData; // for streaming sounds, this contains the compressed file data
+		bool streaming = false;
+		size_t stream_sample_count = 0;
 	};
-	struct SoundInstanceInternal{
+	struct SoundInstanceInternal : public VirtualVoice {
 		std::shared_ptr<AudioInternal> audio;
 		std::shared_ptr<SoundInternal> soundinternal;
-		FAudioSourceVoice* sourceVoice = nullptr;
-		FAudioVoiceDetails voiceDetails = {};
+		PooledVoice* voice = nullptr;
+		FAudioSourceVoice* sourceVoice = nullptr; // nullptr while the instance is virtualized
+		SUBMIX_TYPE type = SUBMIX_TYPE_SOUNDEFFECT;
+		bool reverb = false;
+		size_t instance_index = ~0ull;
+		FAudioBuffer buffer = {};
+		std::unique_ptr<SoundStream> stream;
+
+		// 3D parameters are kept, so they can be applied when the instance gets a real voice:
+		bool has3D = false;
+		float frequencyRatio = 1;
+		float LPFDirectCoefficient = 0;
+		float LPFReverbCoefficient = 0;
 		wi::vector<float> outputMatrix;
+		wi::vector<float> reverbLevels;
 		wi::vector<float> channelAzimuths;
-		FAudioBuffer buffer = {};
-		bool ended = true;
 
-		~SoundInstanceInternal(){
-			FAudioSourceVoice_Stop(sourceVoice, 0, FAUDIO_COMMIT_NOW);
-			FAudioVoice_DestroyVoice(sourceVoice);
+		~SoundInstanceInternal();
+
+		// Decodes and submits stream buffers until the ring of buffers is full
+		void RefillStream()
+		{
+			std::scoped_lock lck(stream->locker);
+			if (stream->shutdown || sourceVoice == nullptr)
+				return;
+			FAudioVoiceState state = {};
+			FAudioSourceVoice_GetState(sourceVoice, &state, FAUDIO_VOICE_NOSAMPLESPLAYED);
+			uint32_t queued = state.BuffersQueued;
+			while (queued < SoundStream::buffer_count && !stream->finished)
+			{
+				const short* data = nullptr;
+				bool end_of_stream = false;
+				const uint32_t samples = stream->Decode(&data, &end_of_stream);
+				uint32_t res = 0;
+				if (samples > 0)
+				{
+					FAudioBuffer streambuffer = {};
+					streambuffer.pAudioData = (const uint8_t*)data;
+					streambuffer.AudioBytes = samples * stream->channel_count * sizeof(short);
+					streambuffer.Flags = end_of_stream ? FAUDIO_END_OF_STREAM : 0;
+					res = FAudioSourceVoice_SubmitSourceBuffer(sourceVoice, &streambuffer, nullptr);
+				}
+				else if (end_of_stream)
+				{
+					res = FAudioSourceVoice_SubmitSourceBuffer(sourceVoice, &audio->termination_mark, nullptr);
+				}
+				assert(res == 0);
+				queued++;
+			}
+		}
+		// Schedules a stream refill on the streaming thread, this is safe to call from the audio thread
+		void RequestRefill()
+		{
+			if (stream->refill_pending.exchange(true))
+				return;
+			wi::jobsystem::Execute(stream->ctx, [this](wi::jobsystem::JobArgs args) {
+				stream->refill_pending.store(false);
+				RefillStream();
+			});
 		}
 	};
 
+	// Real voice that is reused by sound instances, the voice callbacks are forwarded to the current owner instance
+	struct PooledVoice : public FAudioVoiceCallback {
+		FAudioSourceVoice* sourceVoice = nullptr;
+		uint32_t channel_count = 0;
+		uint32_t sample_rate = 0;
+		SoundInstanceInternal* owner = nullptr; // protected by locker, because callbacks are called from the audio thread
+		wi::SpinLock locker;
+		std::atomic<uint64_t> buffers_ended{ 0 }; // incremented by the audio thread for every returned buffer, including flushed ones
+
+		// Previous owners whose flushed buffers were not returned yet, the voice might still read their memory (protected by voice_locker):
+		struct PendingBuffers
+		{
+			const SoundInstanceInternal* instance = nullptr;
+			uint64_t buffers_ended = 0; // the buffers are returned when the voice's buffers_ended counter reaches this
+		};
+		wi::vector<PendingBuffers> pending;
+
+		PooledVoice() : FAudioVoiceCallback() {
+			OnBufferEnd = [](FAudioVoiceCallback* callback, void* pBufferContext) {
+				PooledVoice* voice = static_cast<PooledVoice*>(callback);
+				voice->buffers_ended.fetch_add(1);
+				std::scoped_lock lck(voice->locker);
+				if (voice->owner != nullptr && voice->owner->stream != nullptr)
+				{
+					voice->owner->RequestRefill();
+				}
+			};
+			OnStreamEnd = [](FAudioVoiceCallback* callback) {
+				PooledVoice* voice = static_cast<PooledVoice*>(callback);
+				std::scoped_lock lck(voice->locker);
+				if (voice->owner != nullptr)
+				{
+					voice->owner->ended = true;
+				}
+			};
+		}
+	};
+	static void DestroyPooledVoice(PooledVoice* voice)
+	{
+		FAudioVoice_DestroyVoice(voice->sourceVoice);
+		delete voice;
+	}
+
+	// Applies the last 3D parameters of the instance to its real voice
+	static void ApplyVoice3D(SoundInstanceInternal* instanceinternal)
+	{
+		FAudioSourceVoice* sourceVoice = instanceinternal->sourceVoice;
+		AudioInternal& audio = *instanceinternal->audio;
+		const uint32_t SrcChannelCount = instanceinternal->soundinternal->wfx.nChannels;
+		const uint32_t DstChannelCount = audio.masteringVoiceDetails.InputChannels;
+
+		uint32_t res;
+
+		res = FAudioSourceVoice_SetFrequencyRatio(sourceVoice, instanceinternal->frequencyRatio, FAUDIO_COMMIT_NOW);
+		assert(res == 0);
+
+		res = FAudioVoice_SetOutputMatrix(
+			sourceVoice,
+			audio.submixVoices[instanceinternal->type],
+			SrcChannelCount,
+			DstChannelCount,
+			instanceinternal->outputMatrix.data(),
+			FAUDIO_COMMIT_NOW);
+		assert(res == 0);
+
+		FAudioFilterParameters FilterParametersDirect = { FAudioLowPassFilter, 2.0f * sinf(F3DAUDIO_PI / 6.0f * instanceinternal->LPFDirectCoefficient), 1.0f };
+		res = FAudioVoice_SetOutputFilterParameters(sourceVoice, audio.submixVoices[instanceinternal->type], &FilterParametersDirect, FAUDIO_COMMIT_NOW);
+		assert(res == 0);
+
+		if (instanceinternal->reverb)
+		{
+			res = FAudioVoice_SetOutputMatrix(sourceVoice, audio.reverbSubmix, SrcChannelCount, 1, instanceinternal->reverbLevels.data(), FAUDIO_COMMIT_NOW);
+			assert(res == 0);
+			FAudioFilterParameters FilterParametersReverb = { FAudioLowPassFilter, 2.0f * sinf(F3DAUDIO_PI / 6.0f * instanceinternal->LPFReverbCoefficient), 1.0f };
+			res = FAudioVoice_SetOutputFilterParameters(sourceVoice, audio.reverbSubmix, &FilterParametersReverb, FAUDIO_COMMIT_NOW);
+			assert(res == 0);
+		}
+	}
+
+	// Gives a real voice to the instance and continues playback from its position, the voice_locker must be held
+	static bool AttachVoice(SoundInstanceInternal* instanceinternal)
+	{
+		AudioInternal& audio = *instanceinternal->audio;
+		const FAudioWaveFormatEx& wfx = instanceinternal->soundinternal->wfx;
+
+		FAudioSendDescriptor SFXSend[] = {
+			{ FAUDIO_SEND_USEFILTER, audio.submixVoices[instanceinternal->type] },
+			{ FAUDIO_SEND_USEFILTER, audio.reverbSubmix }, // this should be last to enable/disable reverb simply
+		};
+		FAudioVoiceSends SFXSendList = {
+			instanceinternal->reverb ? (uint32_t)arraysize(SFXSend) : 1,
+			SFXSend
+		};
+
+		uint32_t res;
+		PooledVoice* voice = nullptr;
+		for (size_t i = 0; i < audio.free_voices.size(); ++i)
+		{
+			if (audio.free_voices[i]->channel_count == wfx.nChannels && audio.free_voices[i]->sample_rate == wfx.nSamplesPerSec)
+			{
+				voice = audio.free_voices[i];
+				audio.free_voices[i] = audio.free_voices.back();
+				audio.free_voices.pop_back();
+				break;
+			}
+		}
+
+		if (voice == nullptr)
+		{
+			if (!audio.free_voices.empty() && audio.voices.size() >= voice_budget.load())
+			{
+				// The pool is full, but none of the free voices have the right format, so one of them is replaced:
+				PooledVoice* replaced = audio.free_voices.back();
+				audio.free_voices.pop_back();
+				audio.voices.erase(std::find(audio.voices.begin(), audio.voices.end(), replaced));
+				DestroyPooledVoice(replaced);
+			}
+
+			voice = new PooledVoice;
+			res = FAudio_CreateSourceVoice(audio.audioEngine, &voice->sourceVoice, (FAudioWaveFormatEx*)&wfx,
+				0, FAUDIO_DEFAULT_FREQ_RATIO, voice, &SFXSendList, NULL);
+			if (res != 0)
+			{
+				assert(0);
+				delete voice;
+				return false;
+			}
+			voice->channel_count = wfx.nChannels;
+			voice->sample_rate = wfx.nSamplesPerSec;
+			audio.voices.push_back(voice);
+			audio.created_voice_count++;
+		}
+		else
+		{
+			// This also resets the output matrices and filters that were set by the previous owner:
+			res = FAudioVoice_SetOutputVoices(voice->sourceVoice, &SFXSendList);
+			assert(res == 0);
+			res = FAudioSourceVoice_SetFrequencyRatio(voice->sourceVoice, 1, FAUDIO_COMMIT_NOW);
+			assert(res == 0);
+		}
+
+		{
+			std::scoped_lock lck(voice->locker);
+			voice->owner = instanceinternal;
+		}
+		instanceinternal->voice = voice;
+
+		FAudioVoiceState state = {};
+		FAudioSourceVoice_GetState(voice->sourceVoice, &state, 0);
+		instanceinternal->voice_samples_base = state.SamplesPlayed;
+		instanceinternal->ended = false;
+
+		res = FAudioVoice_SetVolume(voice->sourceVoice, instanceinternal->volume, FAUDIO_COMMIT_NOW);
+		assert(res == 0);
+
+		if (instanceinternal->stream != nullptr)
+		{
+			{
+				std::scoped_lock lck(instanceinternal->stream->locker);
+				instanceinternal->sourceVoice = voice->sourceVoice;
+				instanceinternal->stream->looped = instanceinternal->looped;
+				instanceinternal->stream->SeekTo(instanceinternal->stream->begin + (size_t)instanceinternal->position);
+			}
+			instanceinternal->RefillStream();
+		}
+		else
+		{
+			instanceinternal->sourceVoice = voice->sourceVoice;
+			FAudioBuffer buffer = instanceinternal->buffer;
+			buffer.PlayBegin = (uint32_t)instanceinternal->position;
+			buffer.PlayLength = (uint32_t)(instanceinternal->length - instanceinternal->position);
+			res = FAudioSourceVoice_SubmitSourceBuffer(instanceinternal->sourceVoice, &buffer, nullptr);
+			assert(res == 0);
+		}
+
+		if (instanceinternal->has3D)
+		{
+			ApplyVoice3D(instanceinternal);
+		}
+
+		if (instanceinternal->playing)
+		{
+			res = FAudioSourceVoice_Start(instanceinternal->sourceVoice, 0, FAUDIO_COMMIT_NOW);
+			assert(res == 0);
+		}
+		return true;
+	}
+
+	// Takes away the real voice of the instance and remembers the playback position, the voice_locker must be held
+	static void DetachVoice(SoundInstanceInternal* instanceinternal)
+	{
+		PooledVoice* voice = instanceinternal->voice;
+		if (voice == nullptr)
+			return;
+
+		uint32_t res = FAudioSourceVoice_Stop(voice->sourceVoice, 0, FAUDIO_COMMIT_NOW);
+		assert(res == 0);
+
+		FAudioVoiceState state = {};
+		FAudioSourceVoice_GetState(voice->sourceVoice, &state, 0);
+		if (instanceinternal->ended && !instanceinternal->looped)
+		{
+			// The end of stream resets the samples played counter of the voice:
+			instanceinternal->samples_played += instanceinternal->length - instanceinternal->position;
+			instanceinternal->position = instanceinternal->length;
+		}
+		else if (state.SamplesPlayed >= instanceinternal->voice_samples_base)
+		{
+			instanceinternal->Advance(state.SamplesPlayed - instanceinternal->voice_samples_base);
+		}
+
+		if (instanceinternal->stream != nullptr)
+		{
+			std::scoped_lock lck(instanceinternal->stream->locker);
+			instanceinternal->sourceVoice = nullptr;
+		}
+		else
+		{
+			instanceinternal->sourceVoice = nullptr;
+		}
+
+		// The flushed buffers are only returned later by the audio thread, until then the instance's memory must stay alive:
+		voice->pending.erase(std::remove_if(voice->pending.begin(), voice->pending.end(), [voice](const PooledVoice::PendingBuffers& pending) {
+			return voice->buffers_ended.load() >= pending.buffers_ended;
+		}), voice->pending.end());
+		FAudioSourceVoice_GetState(voice->sourceVoice, &state, FAUDIO_VOICE_NOSAMPLESPLAYED);
+		if (state.BuffersQueued > 0)
+		{
+			voice->pending.push_back({ instanceinternal, voice->buffers_ended.load() + state.BuffersQueued });
+		}
+
+		res = FAudioSourceVoice_FlushSourceBuffers(voice->sourceVoice);
+		assert(res == 0);
+		{
+			std::scoped_lock lck(voice->locker);
+			voice->owner = nullptr;
+		}
+		instanceinternal->voice = nullptr;
+		instanceinternal->audio->free_voices.push_back(voice);
+	}
+
+	// Makes sure that no real voice reads the buffers of the instance anymore, so its stream and sound data can be freed. The voice_locker must be held
+	static void ReleaseVoiceBuffers(SoundInstanceInternal* instanceinternal)
+	{
+		AudioInternal& audio = *instanceinternal->audio;
+		wi::vector<PooledVoice*> referencing_voices;
+		for (PooledVoice* voice : audio.voices)
+		{
+			bool referenced = false;
+			for (size_t i = 0; i < voice->pending.size();)
+			{
+				const PooledVoice::PendingBuffers& pending = voice->pending[i];
+				if (pending.instance == instanceinternal || voice->buffers_ended.load() >= pending.buffers_ended)
+				{
+					referenced |= pending.instance == instanceinternal && voice->buffers_ended.load() < pending.buffers_ended;
+					voice->pending[i] = voice->pending.back();
+					voice->pending.pop_back();
+					continue;
+				}
+				i++;
+			}
+			if (referenced)
+			{
+				referencing_voices.push_back(voice);
+			}
+		}
+
+		// The audio thread didn't return the flushed buffers yet, destroying the voice is the only way to make sure that it stops reading them:
+		for (PooledVoice* voice : referencing_voices)
+		{
+			SoundInstanceInternal* owner = voice->owner;
+			if (owner != nullptr)
+			{
+				DetachVoice(owner); // the voice could have been reused by an other instance since then, it will get a new voice
+			}
+			audio.free_voices.erase(std::find(audio.free_voices.begin(), audio.free_voices.end(), voice));
+			audio.voices.erase(std::find(audio.voices.begin(), audio.voices.end(), voice));
+			DestroyPooledVoice(voice);
+			if (owner != nullptr)
+			{
+				AttachVoice(owner);
+			}
+		}
+	}
+
+	SoundInstanceInternal::~SoundInstanceInternal(){
+		if (stream != nullptr)
+		{
+			std::scoped_lock lck(stream->locker);
+			stream->shutdown = true;
+		}
+		if (instance_index < ~0ull)
+		{
+			std::scoped_lock lck(audio->voice_locker);
+			DetachVoice(this);
+			ReleaseVoiceBuffers(this);
+			audio->instances[instance_index] = audio->instances.back();
+			audio->instances[instance_index]->instance_index = instance_index;
+			audio->instances.pop_back();
+		}
+		if (stream != nullptr)
+		{
+			wi::jobsystem::Wait(stream->ctx);
+		}
+	}
+
 	SoundInternal* to_internal(const Sound* param)
 	{
 		return static_cast<SoundInternal*>(param->internal_state.get());
@@ -1049,139 +2227,320 @@ namespace wi::audio
 
 		return true;
 	}
+	bool CreateSoundStreaming(const std::string& filename, Sound* sound) {
+		wi::vector<uint8_t> filedata;
+		bool success = wi::helper::FileRead(filename, filedata);
+		if (!success)
+		{
+			return false;
+		}
+		return CreateSoundStreaming(filedata.data(), filedata.size(), sound);
+	}
+	bool CreateSoundStreaming(const uint8_t* data, size_t size, Sound* sound)
+	{
+		if (audio_internal == nullptr || !audio_internal->IsValid())
+			return false;
+
+		StreamDecoder decoder;
+		if (!CreateStreamDecoder(data, size, &decoder))
+		{
+			// Not an Ogg file, it can't be streamed:
+			return CreateSound(data, size, sound);
+		}
+		const SampleInfo info = GetSampleInfo(&decoder);
+
+		std::shared_ptr<SoundInternal> soundinternal = std::make_shared<SoundInternal>();
+		soundinternal->audio = audio_internal;
+		soundinternal->streaming = true;
+		soundinternal->stream_sample_count = info.sample_count;
+		soundinternal->audioData.resize(size);
+		memcpy(soundinternal->audioData.data(), data, size);
+
+		soundinternal->wfx.wFormatTag = FAUDIO_FORMAT_PCM;
+		soundinternal->wfx.nChannels = (uint16_t)info.channel_count;
+		soundinternal->wfx.nSamplesPerSec = (uint32_t)info.sample_rate;
+		soundinternal->wfx.wBitsPerSample = sizeof(short) * 8;
+		soundinternal->wfx.nBlockAlign = (uint16_t)info.channel_count * sizeof(short);
+		soundinternal->wfx.nAvgBytesPerSec = soundinternal->wfx.nSamplesPerSec * soundinternal->wfx.nBlockAlign;
+
+		sound->internal_state = soundinternal;
+		return true;
+	}
 	bool CreateSoundInstance(const Sound* sound, SoundInstance* instance)
 	{
 		if (audio_internal == nullptr || !audio_internal->IsValid())
 			return false;
 		if (sound == nullptr || !sound->IsValid())
 			return false;
-		uint32_t res;
 		const auto& soundinternal = std::static_pointer_cast<SoundInternal>(sound->internal_state);
 		std::shared_ptr<SoundInstanceInternal> instanceinternal = std::make_shared<SoundInstanceInternal>();
-		instance->internal_state = instanceinternal;
 
 		instanceinternal->audio = audio_internal;
 		instanceinternal->soundinternal = soundinternal;
-
-		FAudioSendDescriptor SFXSend[] = {
-			{ FAUDIO_SEND_USEFILTER, instanceinternal->audio->submixVoices[instance->type] },
-			{ FAUDIO_SEND_USEFILTER, instanceinternal->audio->reverbSubmix }, // this should be last to enable/disable reverb simply
-		};
-
-		FAudioVoiceSends SFXSendList = {
-			instance->IsEnableReverb() ? (uint32_t)arraysize(SFXSend) : 1,
-			SFXSend
-		};
-		
-		res = FAudio_CreateSourceVoice(instanceinternal->audio->audioEngine, &instanceinternal->sourceVoice, &soundinternal->wfx,
-			0, FAUDIO_DEFAULT_FREQ_RATIO, NULL, &SFXSendList, NULL);
-		if(res != 0){
-			assert(0);
-			return false;
-		}
-
-		FAudioVoice_GetVoiceDetails(instanceinternal->sourceVoice, &instanceinternal->voiceDetails);
-		instanceinternal->outputMatrix.resize(size_t(instanceinternal->voiceDetails.InputChannels) * size_t(instanceinternal->audio->masteringVoiceDetails.InputChannels));
-		instanceinternal->channelAzimuths.resize(instanceinternal->voiceDetails.InputChannels);
+		instanceinternal->type = instance->type;
+		instanceinternal->reverb = instance->IsEnableReverb() && audio_internal->reverbSubmix != nullptr;
+		instanceinternal->priority = instance->priority;
+		instanceinternal->sample_rate = soundinternal->wfx.nSamplesPerSec;
+
+		// The real voice is not created here, it will be taken from the voice pool when the instance is played
+		const uint32_t channel_count = soundinternal->wfx.nChannels;
+		instanceinternal->outputMatrix.resize(size_t(channel_count) * size_t(audio_internal->masteringVoiceDetails.InputChannels));
+		instanceinternal->reverbLevels.resize(channel_count);
+		instanceinternal->channelAzimuths.resize(channel_count);
 		for (size_t i = 0; i < instanceinternal->channelAzimuths.size(); ++i)
 		{
 			instanceinternal->channelAzimuths[i] = F3DAUDIO_2PI * float(i) / float(instanceinternal->channelAzimuths.size());
 		}
 
-		const uint32_t bytes_per_second = soundinternal->wfx.nSamplesPerSec * soundinternal->wfx.nChannels * sizeof(short);
-		instanceinternal->buffer.pAudioData = soundinternal->audioData.data();
-		instanceinternal->buffer.AudioBytes = (uint32_t)soundinternal->audioData.size();
-		if (instance->begin > 0)
+		if (soundinternal->streaming)
 		{
-			const uint32_t bytes_from_beginning = AlignTo(std::min(instanceinternal->buffer.AudioBytes, uint32_t(instance->begin * bytes_per_second)), 4u);
-			instanceinternal->buffer.pAudioData += bytes_from_beginning;
-			instanceinternal->buffer.AudioBytes -= bytes_from_beginning;
+			instanceinternal->stream = std::make_unique<SoundStream>();
+			if (!instanceinternal->stream->Init(soundinternal->audioData.data(), soundinternal->audioData.size(), instance))
+			{
+				return false;
+			}
+			const SoundStream& stream = *instanceinternal->stream;
+			instanceinternal->length = stream.end - stream.begin;
+			instanceinternal->loop_begin = stream.loop_begin - stream.begin;
+			instanceinternal->loop_end = stream.loop_end - stream.begin;
+			instanceinternal->looped = stream.looped;
 		}
-		if (instance->length > 0)
+		else
 		{
-			instanceinternal->buffer.AudioBytes = AlignTo(std::min(instanceinternal->buffer.AudioBytes, uint32_t(instance->length * bytes_per_second)), 4u);
+			const uint32_t bytes_per_second = soundinternal->wfx.nSamplesPerSec * soundinternal->wfx.nChannels * sizeof(short);
+			instanceinternal->buffer.pAudioData = soundinternal->audioData.data();
+			instanceinternal->buffer.AudioBytes = (uint32_t)soundinternal->audioData.size();
+			if (instance->begin > 0)
+			{
+				const uint32_t bytes_from_beginning = AlignTo(std::min(instanceinternal->buffer.AudioBytes, uint32_t(instance->begin * bytes_per_second)), 4u);
+				instanceinternal->buffer.pAudioData += bytes_from_beginning;
+				instanceinternal->buffer.AudioBytes -= bytes_from_beginning;
+			}
+			if (instance->length > 0)
+			{
+				instanceinternal->buffer.AudioBytes = AlignTo(std::min(instanceinternal->buffer.AudioBytes, uint32_t(instance->length * bytes_per_second)), 4u);
+			}
+
+			uint32_t num_remaining_samples = instanceinternal->buffer.AudioBytes / (soundinternal->wfx.nChannels * sizeof(short));
+			instanceinternal->length = num_remaining_samples;
+			if (instance->loop_begin > 0)
+			{
+				instanceinternal->buffer.LoopBegin = AlignTo(std::min(num_remaining_samples, uint32_t(instance->loop_begin * soundinternal->wfx.nSamplesPerSec)), 4u);
+				num_remaining_samples -= instanceinternal->buffer.LoopBegin;
+			}
+			instanceinternal->buffer.LoopLength = AlignTo(std::min(num_remaining_samples, uint32_t(instance->loop_length * soundinternal->wfx.nSamplesPerSec)), 4u);
+
+			instanceinternal->buffer.Flags = FAUDIO_END_OF_STREAM;
+			instanceinternal->buffer.LoopCount = instance->IsLooped() ? FAUDIO_LOOP_INFINITE : 0;
+			if (instanceinternal->buffer.LoopCount == 0)
+			{
+				instanceinternal->buffer.LoopBegin = 0;
+				instanceinternal->buffer.LoopLength = 0;
+			}
+
+			instanceinternal->loop_begin = instanceinternal->buffer.LoopBegin;
+			instanceinternal->loop_end = instanceinternal->buffer.LoopLength > 0 ? instanceinternal->loop_begin + instanceinternal->buffer.LoopLength : instanceinternal->length;
+			instanceinternal->looped = instanceinternal->buffer.LoopCount > 0;
 		}
 
-		uint32_t num_remaining_samples = instanceinternal->buffer.AudioBytes / (soundinternal->wfx.nChannels * sizeof(short));
-		if (instance->loop_begin > 0)
 		{
-			instanceinternal->buffer.LoopBegin = AlignTo(std::min(num_remaining_samples, uint32_t(instance->loop_begin * soundinternal->wfx.nSamplesPerSec)), 4u);
-			num_remaining_samples -= instanceinternal->buffer.LoopBegin;
+			std::scoped_lock lck(audio_internal->voice_locker);
+			instanceinternal->instance_index = audio_internal->instances.size();
+			audio_internal->instances.push_back(instanceinternal.get());
 		}
-		instanceinternal->buffer.LoopLength = AlignTo(std::min(num_remaining_samples, uint32_t(instance->loop_length * soundinternal->wfx.nSamplesPerSec)), 4u);
 
-		instanceinternal->buffer.Flags = FAUDIO_END_OF_STREAM;
-		instanceinternal->buffer.LoopCount = instance->IsLooped() ? FAUDIO_LOOP_INFINITE : 0;
+		instance->internal_state = instanceinternal;
+		return true;
+	}
+
+	// Gives the real voices to the most audible instances, the voice_locker must be held
+	static void ReassignVoices(AudioInternal& audio)
+	{
+		const double elapsed = audio.voice_timer.record_elapsed_seconds();
+		const uint32_t budget = voice_budget.load();
 
-		res = FAudioSourceVoice_SubmitSourceBuffer(instanceinternal->sourceVoice, &(instanceinternal->buffer), nullptr);
-		if(res != 0){
-			assert(0);
-			return false;
+		auto& candidates = audio.voice_candidates;
+		candidates.clear();
+		for (SoundInstanceInternal* instanceinternal : audio.instances)
+		{
+			if (instanceinternal->voice == nullptr)
+			{
+				if (!instanceinternal->playing)
+					continue;
+				// Virtualized instances are only tracked in time:
+				if (instanceinternal->Advance(uint64_t(elapsed * instanceinternal->sample_rate + 0.5)))
+				{
+					instanceinternal->playing = false;
+					instanceinternal->ended = true;
+					continue;
+				}
+			}
+			else if (instanceinternal->playing && instanceinternal->ended)
+			{
+				// The real voice finished playing, it can be used by other instances:
+				DetachVoice(instanceinternal);
+				instanceinternal->playing = false;
+				continue;
+			}
+			candidates.push_back(instanceinternal);
 		}
 
-		return true;
+		// The most audible playing instances get the real voices, paused instances can keep theirs if there are enough:
+		const size_t real_count = std::min(candidates.size(), size_t(budget));
+		if (candidates.size() > real_count)
+		{
+			std::nth_element(candidates.begin(), candidates.begin() + real_count, candidates.end(), [](const SoundInstanceInternal* a, const SoundInstanceInternal* b) {
+				if (a->playing != b->playing)
+					return a->playing;
+				return a->GetAudibility() > b->GetAudibility();
+			});
+		}
+
+		// Voices are detached first, so that they can be reused by the newly attached instances:
+		for (size_t i = 0; i < candidates.size(); ++i)
+		{
+			SoundInstanceInternal* instanceinternal = candidates[i];
+			if (instanceinternal->voice != nullptr && (i >= real_count || (instanceinternal->playing && instanceinternal->GetAudibility() <= voice_audibility_threshold)))
+			{
+				DetachVoice(instanceinternal);
+			}
+		}
+		for (size_t i = 0; i < real_count; ++i)
+		{
+			SoundInstanceInternal* instanceinternal = candidates[i];
+			if (instanceinternal->voice == nullptr && instanceinternal->playing && instanceinternal->GetAudibility() > voice_audibility_threshold)
+			{
+				AttachVoice(instanceinternal);
+			}
+		}
+
+		// If the budget was lowered, the unused voices above the budget are destroyed:
+		while (audio.voices.size() > budget && !audio.free_voices.empty())
+		{
+			PooledVoice* voice = audio.free_voices.back();
+			audio.free_voices.pop_back();
+			audio.voices.erase(std::find(audio.voices.begin(), audio.voices.end(), voice));
+			DestroyPooledVoice(voice);
+		}
 	}
 
-	void Play(SoundInstance* instance) {
-		if (instance != nullptr && instance->IsValid()){
+	void Play(SoundInstance* instance)
+	{
+		if (instance != nullptr && instance->IsValid())
+		{
 			auto instanceinternal = to_internal(instance);
-			uint32_t res = FAudioSourceVoice_Start(instanceinternal->sourceVoice, 0, FAUDIO_COMMIT_NOW);
-			assert(res == 0);
+			std::scoped_lock lck(instanceinternal->audio->voice_locker);
+			if (instanceinternal->playing)
+				return;
+			if (instanceinternal->voice == nullptr && instanceinternal->IsFinished())
+				return; // finished playback needs to be stopped to restart
+			instanceinternal->playing = true;
+			if (instanceinternal->sourceVoice != nullptr)
+			{
+				uint32_t res = FAudioSourceVoice_Start(instanceinternal->sourceVoice, 0, FAUDIO_COMMIT_NOW);
+				assert(res == 0);
+				return;
+			}
+			instanceinternal->ended = false;
+
+			// If there is room in the voice budget, the real voice is attached immediately even if the instance is not audible yet,
+			//	otherwise the voices are reassigned now, so playback doesn't depend on UpdateVoices() being called every frame:
+			AudioInternal& audio = *instanceinternal->audio;
+			if (audio.voices.size() - audio.free_voices.size() < voice_budget.load())
+			{
+				AttachVoice(instanceinternal);
+			}
+			else
+			{
+				ReassignVoices(audio);
+			}
 		}
 	}
-	void Pause(SoundInstance* instance) {
-		if (instance != nullptr && instance->IsValid()){
+	void Pause(SoundInstance* instance)
+	{
+		if (instance != nullptr && instance->IsValid())
+		{
 			auto instanceinternal = to_internal(instance);
-			uint32_t res = FAudioSourceVoice_Stop(instanceinternal->sourceVoice, 0, FAUDIO_COMMIT_NOW); // preserves cursor position
-			assert(res == 0);
+			std::scoped_lock lck(instanceinternal->audio->voice_locker);
+			instanceinternal->playing = false;
+			if (instanceinternal->sourceVoice != nullptr)
+			{
+				uint32_t res = FAudioSourceVoice_Stop(instanceinternal->sourceVoice, 0, FAUDIO_COMMIT_NOW); // preserves cursor position
+				assert(res == 0);
+			}
 		}
 	}
-	void Stop(SoundInstance* instance) {
-		if (instance != nullptr && instance->IsValid()){
+	void Stop(SoundInstance* instance)
+	{
+		if (instance != nullptr && instance->IsValid())
+		{
 			auto instanceinternal = to_internal(instance);
-			uint32_t res = FAudioSourceVoice_Stop(instanceinternal->sourceVoice, 0, FAUDIO_COMMIT_NOW); // preserves cursor position
-			assert(res == 0);
-			res = FAudioSourceVoice_FlushSourceBuffers(instanceinternal->sourceVoice); // reset submitted audio buffer
-			assert(res == 0);
-			res = FAudioSourceVoice_SubmitSourceBuffer(instanceinternal->sourceVoice, &audio_internal->termination_mark, nullptr); // mark this as terminated, this resets XAUDIO2_VOICE_STATE::SamplesPlayed to zero
-			assert(res == 0);
-			res = FAudioSourceVoice_SubmitSourceBuffer(instanceinternal->sourceVoice, &(instanceinternal->buffer), nullptr);
-			assert(res == 0);
+			std::scoped_lock lck(instanceinternal->audio->voice_locker);
+			if (!instanceinternal->playing && instanceinternal->voice == nullptr && instanceinternal->position == 0)
+				return; // already stopped
+			DetachVoice(instanceinternal); // the voice goes back to the pool
+			instanceinternal->Rewind();
+			instanceinternal->playing = false;
+			instanceinternal->ended = true;
 		}
 	}
-	void SetVolume(float volume, SoundInstance* instance) {
-		if (instance == nullptr || !instance->IsValid()){
+	void SetVolume(float volume, SoundInstance* instance)
+	{
+		if (instance == nullptr || !instance->IsValid())
+		{
 			uint32_t res = FAudioVoice_SetVolume(audio_internal->masteringVoice, volume, FAUDIO_COMMIT_NOW);
 			assert(res == 0);
 		}
-		else {
+		else
+		{
 			auto instanceinternal = to_internal(instance);
-			uint32_t res = FAudioVoice_SetVolume(instanceinternal->sourceVoice, volume, FAUDIO_COMMIT_NOW);
-			assert(res == 0);
+			std::scoped_lock lck(instanceinternal->audio->voice_locker);
+			if (instanceinternal->volume == volume)
+				return;
+			instanceinternal->volume = volume;
+			if (instanceinternal->sourceVoice != nullptr)
+			{
+				uint32_t res = FAudioVoice_SetVolume(instanceinternal->sourceVoice, volume, FAUDIO_COMMIT_NOW);
+				assert(res == 0);
+			}
 		}
 	}
-	float GetVolume(const SoundInstance* instance) {
+	float GetVolume(const SoundInstance* instance)
+	{
 		float volume = 0;
-		if (instance == nullptr || !instance->IsValid()){
+		if (instance == nullptr || !instance->IsValid())
+		{
 			FAudioVoice_GetVolume(audio_internal->masteringVoice, &volume);
 		}
-		else {
+		else
+		{
 			auto instanceinternal = to_internal(instance);
-			FAudioVoice_GetVolume(instanceinternal->sourceVoice, &volume);
+			volume = instanceinternal->volume;
 		}
 		return volume;
 	}
-	void ExitLoop(SoundInstance* instance) {
-		if (instance != nullptr && instance->IsValid()){
+	void ExitLoop(SoundInstance* instance)
+	{
+		if (instance != nullptr && instance->IsValid())
+		{
 			auto instanceinternal = to_internal(instance);
-			if (instanceinternal->buffer.LoopCount == 0)
+			std::scoped_lock lck(instanceinternal->audio->voice_locker);
+			if (!instanceinternal->looped)
 				return;
-			uint32_t res = FAudioSourceVoice_ExitLoop(instanceinternal->sourceVoice, FAUDIO_COMMIT_NOW);
-			assert(res == 0);
-			if (instanceinternal->ended)
+			instanceinternal->looped = false;
+			if (instanceinternal->stream != nullptr)
 			{
-				instanceinternal->buffer.LoopCount = 0;
-				res = FAudioSourceVoice_SubmitSourceBuffer(instanceinternal->sourceVoice, &(instanceinternal->buffer), nullptr);
+				// The stream will be decoded until the end instead of jumping back to the loop begin:
+				std::scoped_lock stream_lck(instanceinternal->stream->locker);
+				instanceinternal->stream->looped = false;
+				return;
+			}
+			instanceinternal->buffer.LoopCount = 0;
+			instanceinternal->buffer.LoopBegin = 0;
+			instanceinternal->buffer.LoopLength = 0;
+			if (instanceinternal->sourceVoice != nullptr)
+			{
+				uint32_t res = FAudioSourceVoice_ExitLoop(instanceinternal->sourceVoice, FAUDIO_COMMIT_NOW);
 				assert(res == 0);
 			}
 		}
@@ -1202,10 +2561,15 @@ namespace wi::audio
 		if (sound != nullptr && sound->IsValid())
 		{
 			auto soundinternal = to_internal(sound);
-			info.samples = (const short*)soundinternal->audioData.data();
-			info.sample_count = soundinternal->audioData.size() / sizeof(short);
 			info.sample_rate = soundinternal->wfx.nSamplesPerSec;
 			info.channel_count = soundinternal->wfx.nChannels;
+			if (soundinternal->streaming)
+			{
+				info.sample_count = soundinternal->stream_sample_count * info.channel_count;
+				return info;
+			}
+			info.samples = (const short*)soundinternal->audioData.data();
+			info.sample_count = soundinternal->audioData.size() / sizeof(short);
 		}
 		return info;
 	}
@@ -1214,13 +2578,58 @@ namespace wi::audio
 		if (instance != nullptr && instance->IsValid())
 		{
 			auto instanceinternal = to_internal(instance);
-			FAudioVoiceState state = {};
-			FAudioSourceVoice_GetState(instanceinternal->sourceVoice, &state, 0);
-			return state.SamplesPlayed;
+			std::scoped_lock lck(instanceinternal->audio->voice_locker);
+			uint64_t samples_played = instanceinternal->samples_played;
+			if (instanceinternal->sourceVoice != nullptr)
+			{
+				FAudioVoiceState state = {};
+				FAudioSourceVoice_GetState(instanceinternal->sourceVoice, &state, 0);
+				if (state.SamplesPlayed >= instanceinternal->voice_samples_base)
+				{
+					samples_played += state.SamplesPlayed - instanceinternal->voice_samples_base;
+				}
+			}
+			return samples_played;
 		}
 		return 0ull;
 	}
 
+	void UpdateVoices()
+	{
+		if (audio_internal == nullptr || !audio_internal->IsValid())
+			return;
+		AudioInternal& audio = *audio_internal;
+		std::scoped_lock lck(audio.voice_locker);
+		ReassignVoices(audio);
+	}
+	bool IsVirtual(const SoundInstance* instance)
+	{
+		if (instance != nullptr && instance->IsValid())
+		{
+			auto instanceinternal = to_internal(instance);
+			return instanceinternal->voice == nullptr;
+		}
+		return false;
+	}
+	VoiceStatistics GetVoiceStatistics()
+	{
+		VoiceStatistics stats;
+		if (audio_internal == nullptr || !audio_internal->IsValid())
+			return stats;
+		std::scoped_lock lck(audio_internal->voice_locker);
+		stats.real_voices = uint32_t(audio_internal->voices.size() - audio_internal->free_voices.size());
+		stats.pooled_voices = (uint32_t)audio_internal->free_voices.size();
+		stats.created_voices = audio_internal->created_voice_count;
+		for (const SoundInstanceInternal* instanceinternal : audio_internal->instances)
+		{
+			if (instanceinternal->playing && instanceinternal->voice == nullptr)
+			{
+				stats.virtual_voices++;
+			}
+		}
+		return stats;
+	}
+
 	void SetSubmixVolume(SUBMIX_TYPE type, float volume) {
 		uint32_t res = FAudioVoice_SetVolume(audio_internal->submixVoices[type], volume, FAUDIO_COMMIT_NOW);
 		assert(res == 0);
@@ -1231,9 +2640,13 @@ namespace wi::audio
 		return volume; 
 	}
 
-	void Update3D(SoundInstance* instance, const SoundInstance3D& instance3D) {
-		if (instance != nullptr && instance->IsValid()){
+	void Update3D(SoundInstance* instance, const SoundInstance3D& instance3D)
+	{
+		if (instance != nullptr && instance->IsValid())
+		{
 			auto instanceinternal = to_internal(instance);
+			std::scoped_lock lck(instanceinternal->audio->voice_locker);
+
 			F3DAUDIO_LISTENER listener = {};
 			listener.Position = (F3DAUDIO_VECTOR){ instance3D.listenerPos.x, instance3D.listenerPos.y, instance3D.listenerPos.z };
 			listener.OrientFront = (F3DAUDIO_VECTOR){ instance3D.listenerFront.x, instance3D.listenerFront.y, instance3D.listenerFront.z };
@@ -1247,7 +2660,7 @@ namespace wi::audio
 			emitter.Velocity = (F3DAUDIO_VECTOR){ instance3D.emitterVelocity.x, instance3D.emitterVelocity.y, instance3D.emitterVelocity.z }; 
 			emitter.InnerRadius = instance3D.emitterRadius;
 			emitter.InnerRadiusAngle = F3DAUDIO_PI / 4.0f;
-			emitter.ChannelCount = instanceinternal->voiceDetails.InputChannels;
+			emitter.ChannelCount = instanceinternal->soundinternal->wfx.nChannels;
 			emitter.pChannelAzimuths = instanceinternal->channelAzimuths.data();
 			emitter.ChannelRadius = 0.1f;
 			emitter.CurveDistanceScaler = 1;
@@ -1265,36 +2678,23 @@ namespace wi::audio
 			// flags |= F3DAUDIO_CALCULATE_REDIRECT_TO_LFE;
 
 			F3DAUDIO_DSP_SETTINGS settings = {};
-			settings.SrcChannelCount = instanceinternal->voiceDetails.InputChannels;
+			settings.SrcChannelCount = instanceinternal->soundinternal->wfx.nChannels;
 			settings.DstChannelCount = instanceinternal->audio->masteringVoiceDetails.InputChannels;
 			settings.pMatrixCoefficients = instanceinternal->outputMatrix.data();
 
 			F3DAudioCalculate(instanceinternal->audio->audio3D, &listener, &emitter, flags, &settings);
 
-			uint32_t res;
-
-			res = FAudioSourceVoice_SetFrequencyRatio(instanceinternal->sourceVoice, settings.DopplerFactor, FAUDIO_COMMIT_NOW);
-			assert(res == 0);
-
-			res = FAudioVoice_SetOutputMatrix(
-				instanceinternal->sourceVoice, 
-				instanceinternal->audio->submixVoices[instance->type],
-				settings.SrcChannelCount, 
-				settings.DstChannelCount, 
-				settings.pMatrixCoefficients, 
-				FAUDIO_COMMIT_NOW);
-			assert(res == 0);
-
-			FAudioFilterParameters FilterParametersDirect = { FAudioLowPassFilter, 2.0f * sinf(F3DAUDIO_PI / 6.0f * settings.LPFDirectCoefficient), 1.0f };
-			res = FAudioVoice_SetOutputFilterParameters(instanceinternal->sourceVoice, instanceinternal->audio->submixVoices[instance->type], &FilterParametersDirect, FAUDIO_COMMIT_NOW);
-			assert(res == 0);
+			// The results are stored, because virtualized instances will only apply them when they get a real voice:
+			instanceinternal->has3D = true;
+			instanceinternal->frequencyRatio = settings.DopplerFactor;
+			instanceinternal->LPFDirectCoefficient = settings.LPFDirectCoefficient;
+			instanceinternal->LPFReverbCoefficient = settings.LPFReverbCoefficient;
+			std::fill(instanceinternal->reverbLevels.begin(), instanceinternal->reverbLevels.end(), settings.ReverbLevel);
+			instanceinternal->attenuation = *std::max_element(instanceinternal->outputMatrix.begin(), instanceinternal->outputMatrix.end());
 
-			if(instance->IsEnableReverb()){
-				res = FAudioVoice_SetOutputMatrix(instanceinternal->sourceVoice, instanceinternal->audio->reverbSubmix, settings.SrcChannelCount, 1, &settings.ReverbLevel, FAUDIO_COMMIT_NOW);
-				assert(res == 0);
-				FAudioFilterParameters FilterParametersReverb = { FAudioLowPassFilter, 2.0f * sinf(F3DAUDIO_PI / 6.0f * settings.LPFReverbCoefficient), 1.0f };
-				res = FAudioVoice_SetOutputFilterParameters(instanceinternal->sourceVoice, instanceinternal->audio->reverbSubmix, &FilterParametersReverb, FAUDIO_COMMIT_NOW);
-				assert(res == 0);
+			if (instanceinternal->sourceVoice != nullptr)
+			{
+				ApplyVoice3D(instanceinternal);
 			}
 		}
 	}
@@ -1317,6 +2717,8 @@ namespace wi::audio
 
 	bool CreateSound(const std::string& filename, Sound* sound) { return false; }
 	bool CreateSound(const uint8_t* data, size_t size, Sound* sound) { return false; }
+	bool CreateSoundStreaming(const std::string& filename, Sound* sound) { return false; }
+	bool CreateSoundStreaming(const uint8_t* data, size_t size, Sound* sound) { return false; }
 	bool CreateSoundInstance(const Sound* sound, SoundInstance* instance) { return false; }
 
 	void Play(SoundInstance* instance) {}
@@ -1330,6 +2732,10 @@ namespace wi::audio
 	SampleInfo GetSampleInfo(const Sound* sound) { return {}; }
 	uint64_t GetTotalSamplesPlayed(const SoundInstance* instance) { return 0; }
 
+	void UpdateVoices() {}
+	bool IsVirtual(const SoundInstance* instance) { return false; }
+	VoiceStatistics GetVoiceStatistics() { return {}; }
+
 	void SetSubmixVolume(SUBMIX_TYPE type, float volume) {}
 	float GetSubmixVolume(SUBMIX_TYPE type) { return 0; }
 
@@ -44,6 +44,7 @@ namespace wi::audio
 		float length = 0;		// length in seconds (0 = until end)
 		float loop_begin = 0;	// loop region begin in seconds, relative to the instance begin time (0 = from beginning)
 		float loop_length = 0;	// loop region length in seconds (0 = until the end)
+		float priority = 1;		// instances with higher priority are more likely to keep a real voice when the voice budget is exceeded
 
 		enum FLAGS
 		{
@@ -61,6 +62,11 @@ namespace wi::audio
 
 	bool CreateSound(const std::string& filename, Sound* sound);
 	bool CreateSound(const uint8_t* data, size_t size, Sound* sound);
+	// Creates a streaming sound: Ogg data is kept compressed in memory and decoded incrementally during playback
+	//	Use this for long sounds such as music to avoid the memory cost and load time of decoding the whole file up front
+	//	Wav data is not compressed, so it will be loaded the same way as with CreateSound()
+	bool CreateSoundStreaming(const std::string& filename, Sound* sound);
+	bool CreateSoundStreaming(const uint8_t* data, size_t size, Sound* sound);
 	bool CreateSoundInstance(const Sound* sound, SoundInstance* instance);
 
 	void Play(SoundInstance* instance);
@@ -78,10 +84,50 @@ namespace wi::audio
 		int sample_rate = 0;	// number of samples per second
 		uint32_t channel_count = 1;	// number of channels in the samples array (1: mono, 2:stereo, etc.)
 	};
+	// Returns information about the sound's samples
+	//	For streaming sounds, the samples array will be nullptr, because the decoded sound is not available in memory
 	SampleInfo GetSampleInfo(const Sound* sound);
 	// Returns the total number of samples that were played since the creation of the sound instance
 	uint64_t GetTotalSamplesPlayed(const SoundInstance* instance);
 
+	// StreamDecoder can decode compressed (Ogg Vorbis) sound data incrementally, without decoding the whole sound into memory
+	//	The data must be kept alive while the decoder is in use
+	struct StreamDecoder
+	{
+		std::shared_ptr<void> internal_state;
+		inline bool IsValid() const { return internal_state.get() != nullptr; }
+	};
+	bool CreateStreamDecoder(const uint8_t* data, size_t size, StreamDecoder* decoder);
+	// Returns information about the whole stream, the sample_count is the number of samples per channel, samples array will be nullptr
+	SampleInfo GetSampleInfo(const StreamDecoder* decoder);
+	// Decodes the next samples into the output array in interleaved channel format
+	//	output		: must be able to hold sample_count * channel_count elements
+	//	sample_count: maximum number of samples per channel to decode
+	//	returns the number of samples per channel that were written, 0 if the end of the stream is reached
+	size_t DecodeStream(StreamDecoder* decoder, short* output, size_t sample_count);
+	// Moves the decoding position to the specified sample (per channel) of the stream
+	bool SeekStream(StreamDecoder* decoder, size_t sample);
+
+	// Sound instances share a limited number of real voices. When more instances are playing than the voice budget,
+	//	the least audible ones (by priority, volume and 3D attenuation) are virtualized: their playback is only tracked in time,
+	//	and they continue from the right position when they get a real voice again
+	void SetVoiceBudget(uint32_t count);
+	uint32_t GetVoiceBudget();
+	// Call this once per frame to reassign the real voices between the sound instances (wi::Application calls it in Update)
+	//	Play() also reassigns the voices when the budget is full, so sounds can be heard without calling this too
+	void UpdateVoices();
+	// Returns true if the sound instance doesn't have a real voice currently
+	bool IsVirtual(const SoundInstance* instance);
+
+	struct VoiceStatistics
+	{
+		uint32_t real_voices = 0;		// number of sound instances that have a real voice (playing or paused)
+		uint32_t virtual_voices = 0;	// number of playing sound instances without a real voice
+		uint32_t pooled_voices = 0;		// number of real voices that are not used, but kept for reuse
+		uint64_t created_voices = 0;	// number of real voices created since initialization
+	};
+	VoiceStatistics GetVoiceStatistics();
+
 	void SetSubmixVolume(SUBMIX_TYPE type, float volume);
 	float GetSubmixVolume(SUBMIX_TYPE type);
 
@@ -248,10 +248,9 @@ namespace wi::lua
 
 	void Audio_BindLua::Bind()
 	{
-		static bool initialized = false;
-		if (!initialized)
+		static const char binding_key = 0;
+		if (wi::lua::BeginBinding(&binding_key))
 		{
-			initialized = true;
 			Luna<Audio_BindLua>::Register(wi::lua::GetLuaState());
 
 			wi::lua::RunText(R"(
@@ -328,10 +327,9 @@ REVERB_PRESET_PLATE = 29
 
 	void Sound_BindLua::Bind()
 	{
-		static bool initialized = false;
-		if (!initialized)
+		static const char binding_key = 0;
+		if (wi::lua::BeginBinding(&binding_key))
 		{
-			initialized = true;
 			Luna<Sound_BindLua>::Register(wi::lua::GetLuaState());
 		}
 	}
@@ -515,10 +513,9 @@ REVERB_PRESET_PLATE = 29
 
 	void SoundInstance_BindLua::Bind()
 	{
-		static bool initialized = false;
-		if (!initialized)
+		static const char binding_key = 0;
+		if (wi::lua::BeginBinding(&binding_key))
 		{
-			initialized = true;
 			Luna<SoundInstance_BindLua>::Register(wi::lua::GetLuaState());
 		}
 	}
@@ -677,10 +674,9 @@ REVERB_PRESET_PLATE = 29
 
 	void SoundInstance3D_BindLua::Bind()
 	{
-		static bool initialized = false;
-		if (!initialized)
+		static const char binding_key = 0;
+		if (wi::lua::BeginBinding(&binding_key))
 		{
-			initialized = true;
 			Luna<SoundInstance3D_BindLua>::Register(wi::lua::GetLuaState());
 		}
 	}
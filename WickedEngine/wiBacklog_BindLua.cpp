@@ -129,10 +129,9 @@ namespace wi::lua::backlog
 
 	void Bind()
 	{
-		static bool initialized = false;
-		if (!initialized)
+		static const char binding_key = 0;
+		if (wi::lua::BeginBinding(&binding_key))
 		{
-			initialized = true;
 			wi::lua::RegisterFunc("backlog_clear", backlog_clear);
 			wi::lua::RegisterFunc("backlog_post", backlog_post);
 			wi::lua::RegisterFunc("backlog_fontsize", backlog_fontsize);
@@ -12,6 +12,14 @@
 #include <atomic>
 #include <memory>
 #include <string>
+#include <algorithm>
+
+// Entity lookup table implementation used by the ComponentManager:
+//	0 : wi::unordered_map
+//	1 : paged sparse set (default)
+#ifndef WI_ECS_LOOKUP_TYPE
+#define WI_ECS_LOOKUP_TYPE 1
+#endif // WI_ECS_LOOKUP_TYPE
 
 // Entity-Component System
 namespace wi::ecs
@@ -111,6 +119,158 @@ namespace wi::ecs
 		}
 	}
 
+	// Entity -> component index lookup table using a hash map
+	class EntityLookup_HashMap
+	{
+	public:
+		inline void reserve(size_t count) { map.reserve(count); }
+		inline void clear() { map.clear(); }
+		inline size_t size() const { return map.size(); }
+		inline bool empty() const { return map.empty(); }
+		inline void set(Entity entity, size_t index) { map[entity] = index; }
+		inline void erase(Entity entity) { map.erase(entity); }
+
+		// Returns the component index of the entity, or ~0ull if it's not in the table
+		inline size_t find(Entity entity) const
+		{
+			if (map.empty())
+				return ~0ull;
+			auto it = map.find(entity);
+			if (it != map.end())
+			{
+				return it->second;
+			}
+			return ~0ull;
+		}
+
+	private:
+		wi::unordered_map<Entity, size_t> map;
+	};
+
+	// Entity -> component index lookup table using a paged sparse set
+	//	Entities are created sequentially, so the entity value is used to directly index into fixed size pages without hashing
+	//	Pages are allocated when the first entity is added to them and freed when the last one is removed
+	//	Entity values that are too large to be paged are stored in a fallback hash map
+	class EntityLookup_SparseSet
+	{
+	public:
+		inline void reserve(size_t count)
+		{
+			page_table.reserve((count + PAGE_SIZE - 1) / PAGE_SIZE);
+		}
+		inline void clear()
+		{
+			page_table.clear();
+			overflow.clear();
+			count = 0;
+		}
+		inline size_t size() const { return count; }
+		inline bool empty() const { return count == 0; }
+
+		inline void set(Entity entity, size_t index)
+		{
+			assert(index < EMPTY);
+			const Entity page_index = entity >> PAGE_SHIFT;
+			if (page_index >= MAX_PAGES)
+			{
+				count += overflow.count(entity) == 0 ? 1 : 0;
+				overflow[entity] = index;
+				return;
+			}
+			if (page_index >= page_table.size())
+			{
+				page_table.resize(page_index + 1);
+			}
+			Page& page = page_table[page_index];
+			if (page.indices == nullptr)
+			{
+				page.indices = std::make_unique<uint32_t[]>(PAGE_SIZE);
+				std::fill(page.indices.get(), page.indices.get() + PAGE_SIZE, EMPTY);
+			}
+			uint32_t& slot = page.indices[entity & PAGE_MASK];
+			if (slot == EMPTY)
+			{
+				page.count++;
+				count++;
+			}
+			slot = uint32_t(index);
+		}
+
+		inline void erase(Entity entity)
+		{
+			const Entity page_index = entity >> PAGE_SHIFT;
+			if (page_index >= MAX_PAGES)
+			{
+				count -= overflow.erase(entity);
+				return;
+			}
+			if (page_index >= page_table.size())
+				return;
+			Page& page = page_table[page_index];
+			if (page.indices == nullptr)
+				return;
+			uint32_t& slot = page.indices[entity & PAGE_MASK];
+			if (slot == EMPTY)
+				return;
+			slot = EMPTY;
+			count--;
+			if (--page.count == 0)
+			{
+				page.indices.reset();
+			}
+		}
+
+		// Returns the component index of the entity, or ~0ull if it's not in the table
+		inline size_t find(Entity entity) const
+		{
+			const Entity page_index = entity >> PAGE_SHIFT;
+			if (page_index < page_table.size())
+			{
+				const Page& page = page_table[page_index];
+				if (page.indices != nullptr)
+				{
+					const uint32_t slot = page.indices[entity & PAGE_MASK];
+					if (slot != EMPTY)
+					{
+						return slot;
+					}
+				}
+				return ~0ull;
+			}
+			if (page_index >= MAX_PAGES && !overflow.empty())
+			{
+				auto it = overflow.find(entity);
+				if (it != overflow.end())
+				{
+					return it->second;
+				}
+			}
+			return ~0ull;
+		}
+
+	private:
+		static constexpr uint32_t PAGE_SHIFT = 10;
+		static constexpr Entity PAGE_SIZE = Entity(1) << PAGE_SHIFT;
+		static constexpr Entity PAGE_MASK = PAGE_SIZE - 1;
+		static constexpr Entity MAX_PAGES = Entity(1) << 20; // entities above 2^30 will go to the overflow map
+		static constexpr uint32_t EMPTY = ~0u;
+
+		struct Page
+		{
+			std::unique_ptr<uint32_t[]> indices;
+			uint32_t count = 0;
+		};
+		wi::vector<Page> page_table;
+		wi::unordered_map<Entity, size_t> overflow;
+		size_t count = 0;
+	};
+
+#if WI_ECS_LOOKUP_TYPE == 1
+	using EntityLookup = EntityLookup_SparseSet;
+#else
+	using EntityLookup = EntityLookup_HashMap;
+#endif // WI_ECS_LOOKUP_TYPE
+
 	// This is an interface class to implement a ComponentManager,
 	// inherit this class if you want to work with ComponentLibrary
 	class ComponentManager_Interface
@@ -130,6 +290,8 @@ namespace wi::ecs
 		virtual size_t GetCount() const = 0;
 		virtual Entity GetEntity(size_t index) const = 0;
 		virtual const wi::vector<Entity>& GetEntityArray() const = 0;
+		virtual uint64_t GetVersion() const = 0;
+		virtual uint64_t GetVersion(size_t index) const = 0;
 	};
 
 	// The ComponentManager is a container that stores components and matches them with entities
@@ -150,6 +312,7 @@ namespace wi::ecs
 		{
 			components.reserve(count);
 			entities.reserve(count);
+			versions.reserve(count);
 			lookup.reserve(count);
 		}
 
@@ -158,7 +321,9 @@ namespace wi::ecs
 		{
 			components.clear();
 			entities.clear();
+			versions.clear();
 			lookup.clear();
+			removal_version = version;
 		}
 
 		// Perform deep copy of all the contents of "other" into this
@@ -166,13 +331,15 @@ namespace wi::ecs
 		{
 			components.reserve(GetCount() + other.GetCount());
 			entities.reserve(GetCount() + other.GetCount());
+			versions.reserve(GetCount() + other.GetCount());
 			lookup.reserve(GetCount() + other.GetCount());
 			for (size_t i = 0; i < other.GetCount(); ++i)
 			{
 				Entity entity = other.entities[i];
 				assert(!Contains(entity));
 				entities.push_back(entity);
-				lookup[entity] = components.size();
+				versions.push_back(version);
+				lookup.set(entity, components.size());
 				components.push_back(other.components[i]);
 			}
 		}
@@ -184,6 +351,7 @@ namespace wi::ecs
 		{
 			components.reserve(GetCount() + other.GetCount());
 			entities.reserve(GetCount() + other.GetCount());
+			versions.reserve(GetCount() + other.GetCount());
 			lookup.reserve(GetCount() + other.GetCount());
 
 			for (size_t i = 0; i < other.GetCount(); ++i)
@@ -191,7 +359,8 @@ namespace wi::ecs
 				Entity entity = other.entities[i];
 				assert(!Contains(entity));
 				entities.push_back(entity);
-				lookup[entity] = components.size();
+				versions.push_back(version);
+				lookup.set(entity, components.size());
 				components.push_back(std::move(other.components[i]));
 			}
 
@@ -225,12 +394,13 @@ namespace wi::ecs
 				}
 
 				entities.resize(prev_count + count);
+				versions.resize(prev_count + count, version);
 				for (size_t i = 0; i < count; ++i)
 				{
 					Entity entity;
 					SerializeEntity(archive, entity, seri);
 					entities[prev_count + i] = entity;
-					lookup[entity] = prev_count + i;
+					lookup.set(entity, prev_count + i);
 				}
 			}
 			else
@@ -256,8 +426,18 @@ namespace wi::ecs
 				archive >> component_exists;
 				if (component_exists)
 				{
-					auto& component = this->Create(entity);
-					component.Serialize(archive, seri);
+					// If the entity already has this component, it will be overwritten:
+					const size_t index = lookup.find(entity);
+					if (index != ~0ull)
+					{
+						components[index].Serialize(archive, seri);
+						SetChanged(index);
+					}
+					else
+					{
+						auto& component = this->Create(entity);
+						component.Serialize(archive, seri);
+					}
 				}
 			}
 			else
@@ -282,14 +462,14 @@ namespace wi::ecs
 			assert(entity != INVALID_ENTITY);
 
 			// Only one of this component type per entity is allowed!
-			assert(lookup.find(entity) == lookup.end());
+			assert(lookup.find(entity) == ~0ull);
 
 			// Entity count must always be the same as the number of coponents!
 			assert(entities.size() == components.size());
 			assert(lookup.size() == components.size());
 
 			// Update the entity lookup table:
-			lookup[entity] = components.size();
+			lookup.set(entity, components.size());
 
 			// New components are always pushed to the end:
 			components.emplace_back();
@@ -297,46 +477,44 @@ namespace wi::ecs
 			// Also push corresponding entity:
 			entities.push_back(entity);
 
+			// New components are considered to be changed:
+			versions.push_back(version);
+
 			return components.back();
 		}
 
 		// Remove a component of a certain entity if it exists
 		inline void Remove(Entity entity)
 		{
-			auto it = lookup.find(entity);
-			if (it != lookup.end())
+			const size_t index = lookup.find(entity);
+			if (index != ~0ull)
 			{
-				// Directly index into components and entities array:
-				const size_t index = it->second;
-				const Entity entity = entities[index];
-
 				if (index < components.size() - 1)
 				{
 					// Swap out the dead element with the last one:
 					components[index] = std::move(components.back()); // try to use move instead of copy
 					entities[index] = entities.back();
+					versions[index] = version;
 
 					// Update the lookup table:
-					lookup[entities[index]] = index;
+					lookup.set(entities[index], index);
 				}
 
 				// Shrink the container:
 				components.pop_back();
 				entities.pop_back();
+				versions.pop_back();
 				lookup.erase(entity);
+				removal_version = version;
 			}
 		}
 
 		// Remove a component of a certain entity if it exists while keeping the current ordering
 		inline void Remove_KeepSorted(Entity entity)
 		{
-			auto it = lookup.find(entity);
-			if (it != lookup.end())
+			const size_t index = lookup.find(entity);
+			if (index != ~0ull)
 			{
-				// Directly index into components and entities array:
-				const size_t index = it->second;
-				const Entity entity = entities[index];
-
 				if (index < components.size() - 1)
 				{
 					// Move every component left by one that is after this element:
@@ -348,14 +526,17 @@ namespace wi::ecs
 					for (size_t i = index + 1; i < entities.size(); ++i)
 					{
 						entities[i - 1] = entities[i];
-						lookup[entities[i - 1]] = i - 1;
+						versions[i - 1] = version;
+						lookup.set(entities[i - 1], i - 1);
 					}
 				}
 
 				// Shrink the container:
 				components.pop_back();
 				entities.pop_back();
+				versions.pop_back();
 				lookup.erase(entity);
+				removal_version = version;
 			}
 		}
 
@@ -380,32 +561,30 @@ namespace wi::ecs
 				const size_t next = i + direction;
 				components[i] = std::move(components[next]);
 				entities[i] = entities[next];
-				lookup[entities[i]] = i;
+				versions[i] = version;
+				lookup.set(entities[i], i);
 			}
 
 			// Saved entity-component moved to the required position:
 			components[index_to] = std::move(component);
 			entities[index_to] = entity;
-			lookup[entity] = index_to;
+			versions[index_to] = version;
+			lookup.set(entity, index_to);
 		}
 
 		// Check if a component exists for a given entity or not
 		inline bool Contains(Entity entity) const
 		{
-			if (lookup.empty())
-				return false;
-			return lookup.find(entity) != lookup.end();
+			return lookup.find(entity) != ~0ull;
 		}
 
 		// Retrieve a [read/write] component specified by an entity (if it exists, otherwise nullptr)
 		inline Component* GetComponent(Entity entity)
 		{
-			if (lookup.empty())
-				return nullptr;
-			auto it = lookup.find(entity);
-			if (it != lookup.end())
+			const size_t index = lookup.find(entity);
+			if (index != ~0ull)
 			{
-				return &components[it->second];
+				return &components[index];
 			}
 			return nullptr;
 		}
@@ -413,12 +592,10 @@ namespace wi::ecs
 		// Retrieve a [read only] component specified by an entity (if it exists, otherwise nullptr)
 		inline const Component* GetComponent(Entity entity) const
 		{
-			if (lookup.empty())
-				return nullptr;
-			const auto it = lookup.find(entity);
-			if (it != lookup.end())
+			const size_t index = lookup.find(entity);
+			if (index != ~0ull)
 			{
-				return &components[it->second];
+				return &components[index];
 			}
 			return nullptr;
 		}
@@ -426,14 +603,7 @@ namespace wi::ecs
 		// Retrieve component index by entity handle (if not exists, returns ~0ull value)
 		inline size_t GetIndex(Entity entity) const
 		{
-			if (lookup.empty())
-				return ~0ull;
-			const auto it = lookup.find(entity);
-			if (it != lookup.end())
-			{
-				return it->second;
-			}
-			return ~0ull;
+			return lookup.find(entity);
 		}
 
 		// Retrieve the number of existing entries
@@ -457,13 +627,47 @@ namespace wi::ecs
 		// Returns the tightly packed [read only] component array
 		inline const wi::vector<Component>& GetComponentArray() const { return components; }
 
+		// Change versioning:
+		//	Every component stores the version of the manager at the time when it was last changed
+		//	Creating, loading and reordering components will mark them as changed automatically,
+		//	but modifications of the component data must be reported with SetChanged()
+
+		// Starts a new version and returns the previous one
+		//	Every change that happened since the previous AdvanceVersion() call (and after this call) will be >= than the returned version
+		inline uint64_t AdvanceVersion() { return version++; }
+
+		// Returns the current version that is assigned to changes
+		inline uint64_t GetVersion() const { return version; }
+
+		// Returns the version of the last change of a specific component
+		//	0 <= index < GetCount()
+		inline uint64_t GetVersion(size_t index) const { return versions[index]; }
+
+		// Mark a specific component as changed with the current version
+		//	0 <= index < GetCount()
+		//	It is safe to call from multiple threads for different components
+		inline void SetChanged(size_t index) { versions[index] = version; }
+
+		// Check whether a specific component was changed at or after the specified version
+		//	0 <= index < GetCount()
+		inline bool IsChanged(size_t index, uint64_t since_version) const { return versions[index] >= since_version; }
+
+		// Check whether any component was removed at or after the specified version
+		//	Removed components can't be queried by IsChanged(), but references to them might need to be updated
+		inline bool IsRemoved(uint64_t since_version) const { return removal_version >= since_version; }
+
 	private:
 		// This is a linear array of alive components
 		wi::vector<Component> components;
 		// This is a linear array of entities corresponding to each alive component
 		wi::vector<Entity> entities;
+		// This is a linear array of versions corresponding to each alive component
+		wi::vector<uint64_t> versions;
 		// This is a lookup table for entities
-		wi::unordered_map<Entity, size_t> lookup;
+		EntityLookup lookup;
+		// The current version and the version of the last removal
+		uint64_t version = 1;
+		uint64_t removal_version = 0;
 
 		// Disallow this to be copied by mistake
 		ComponentManager(const ComponentManager&) = delete;
@@ -12,6 +12,7 @@
 #include "wiEventHandler.h"
 #include "wiTimer.h"
 #include "wiVector.h"
+#include "wiJobSystem.h"
 
 #include <algorithm>
 
@@ -302,10 +303,10 @@ namespace wi
 
 	uint64_t EmittedParticleSystem::GetMemorySizeInBytes() const
 	{
-		if (!particleBuffer.IsValid())
-			return 0;
+		uint64_t retVal = particles_cpu.GetMemorySizeInBytes();
 
-		uint64_t retVal = 0;
+		if (!particleBuffer.IsValid())
+			return retVal;
 
 		retVal += particleBuffer.GetDesc().size;
 		retVal += aliveList[0].GetDesc().size;
@@ -329,7 +330,10 @@ namespace wi
 	void EmittedParticleSystem::UpdateCPU(const TransformComponent& transform, float dt)
 	{
 		this->dt = dt;
-		CreateSelfBuffers();
+		if (!IsCPUSimulationEnabled())
+		{
+			CreateSelfBuffers();
+		}
 
 		if (IsPaused() || dt == 0)
 			return;
@@ -356,6 +360,16 @@ namespace wi
 
 		worldMatrix = transform.world;
 
+		if (IsCPUSimulationEnabled())
+		{
+			// Statistics are written directly by SimulateCPU():
+			if (particles_cpu.count > 0)
+			{
+				active_frames |= 1; // activate current frame
+			}
+			return;
+		}
+
 		// Swap CURRENT alivelist with NEW alivelist
 		std::swap(aliveList[0], aliveList[1]);
 
@@ -422,12 +436,513 @@ namespace wi
 	{
 		SetPaused(false);
 		counterBuffer = {}; // will be recreated
+		particles_cpu.count = 0;
+	}
+
+	void EmittedParticleSystem::ParticlesCPU::resize(uint32_t capacity)
+	{
+		capacity = AlignTo(capacity, 4u);
+		position_x.resize(capacity);
+		position_y.resize(capacity);
+		position_z.resize(capacity);
+		velocity_x.resize(capacity);
+		velocity_y.resize(capacity);
+		velocity_z.resize(capacity);
+		force_x.resize(capacity);
+		force_y.resize(capacity);
+		force_z.resize(capacity);
+		life.resize(capacity);
+		maxLife.resize(capacity);
+		sizeBegin.resize(capacity);
+		sizeEnd.resize(capacity);
+		size.resize(capacity);
+		mass.resize(capacity);
+		rotation.resize(capacity);
+		rotationVelocity.resize(capacity);
+		color.resize(capacity);
+		count = std::min(count, capacity);
+	}
+	uint64_t EmittedParticleSystem::ParticlesCPU::GetMemorySizeInBytes() const
+	{
+		return (uint64_t)position_x.size() * (17 * sizeof(float) + sizeof(uint32_t));
+	}
+
+	// 4 particles' 3D vectors in structure of arrays layout:
+	struct ParticleVector4
+	{
+		XMVECTOR x, y, z;
+	};
+	static inline ParticleVector4 LoadParticleVector4(const float* x, const float* y, const float* z)
+	{
+		return { XMLoadFloat4((const XMFLOAT4*)x), XMLoadFloat4((const XMFLOAT4*)y), XMLoadFloat4((const XMFLOAT4*)z) };
+	}
+	static inline void StoreParticleVector4(float* x, float* y, float* z, const ParticleVector4& v)
+	{
+		XMStoreFloat4((XMFLOAT4*)x, v.x);
+		XMStoreFloat4((XMFLOAT4*)y, v.y);
+		XMStoreFloat4((XMFLOAT4*)z, v.z);
+	}
+	static inline XMVECTOR Dot4(const ParticleVector4& a, const ParticleVector4& b)
+	{
+		return XMVectorMultiplyAdd(a.x, b.x, XMVectorMultiplyAdd(a.y, b.y, XMVectorMultiply(a.z, b.z)));
+	}
+	// Collision response of emittedparticle_simulateCS for particles where mask is set:
+	//	velocity is reflected by dir, then position and velocity are offset by dir * offset
+	static inline void CollideParticleVector4(
+		XMVECTOR mask,
+		const ParticleVector4& dir,
+		XMVECTOR offset,
+		ParticleVector4& position,
+		ParticleVector4& velocity
+	)
+	{
+		const XMVECTOR d = XMVectorScale(Dot4(velocity, dir), 2.0f);
+		const XMVECTOR ox = XMVectorMultiply(dir.x, offset);
+		const XMVECTOR oy = XMVectorMultiply(dir.y, offset);
+		const XMVECTOR oz = XMVectorMultiply(dir.z, offset);
+		velocity.x = XMVectorSelect(velocity.x, XMVectorAdd(XMVectorNegativeMultiplySubtract(d, dir.x, velocity.x), ox), mask);
+		velocity.y = XMVectorSelect(velocity.y, XMVectorAdd(XMVectorNegativeMultiplySubtract(d, dir.y, velocity.y), oy), mask);
+		velocity.z = XMVectorSelect(velocity.z, XMVectorAdd(XMVectorNegativeMultiplySubtract(d, dir.z, velocity.z), oz), mask);
+		position.x = XMVectorSelect(position.x, XMVectorAdd(position.x, ox), mask);
+		position.y = XMVectorSelect(position.y, XMVectorAdd(position.y, oy), mask);
+		position.z = XMVectorSelect(position.z, XMVectorAdd(position.z, oz), mask);
+	}
+	// Collision with a sphere of given center and radius, also used for capsules with the closest point on the segment as center:
+	static inline void CollideParticleVector4Sphere(
+		const ParticleVector4& center,
+		XMVECTOR radius,
+		XMVECTOR particleSize,
+		ParticleVector4& position,
+		ParticleVector4& velocity
+	)
+	{
+		ParticleVector4 dir = { XMVectorSubtract(center.x, position.x), XMVectorSubtract(center.y, position.y), XMVectorSubtract(center.z, position.z) };
+		XMVECTOR dist = XMVectorSqrt(Dot4(dir, dir));
+		const XMVECTOR dist_rcp = XMVectorReciprocal(dist);
+		dir.x = XMVectorMultiply(dir.x, dist_rcp);
+		dir.y = XMVectorMultiply(dir.y, dist_rcp);
+		dir.z = XMVectorMultiply(dir.z, dist_rcp);
+		dist = XMVectorSubtract(XMVectorSubtract(dist, radius), particleSize);
+		const XMVECTOR mask = XMVectorLess(dist, XMVectorZero());
+		CollideParticleVector4(mask, dir, dist, position, velocity);
+	}
+
+	void EmittedParticleSystem::SimulateCPU(const Scene& scene, const MeshComponent* mesh, const MaterialComponent* material)
+	{
+		if (!IsCPUSimulationEnabled() || IsPaused() || dt == 0)
+			return;
+
+		auto range = wi::profiler::BeginRangeCPU("EmittedParticleSystem::SimulateCPU");
+
+		// simulation can be either fixed or variable timestep:
+		const float timestep = FIXED_TIMESTEP >= 0 ? FIXED_TIMESTEP : dt;
+
+		ParticlesCPU& particles = particles_cpu;
+		if (particles.position_x.size() != AlignTo(MAX_PARTICLES, 4u))
+		{
+			particles.resize(MAX_PARTICLES);
+		}
+		particles.count = std::min(particles.count, MAX_PARTICLES);
+
+		// Emit: this is serial so that the random sequence stays deterministic
+		uint32_t first_subset = 0;
+		uint32_t last_subset = 0;
+		const bool emit_from_mesh =
+			mesh != nullptr &&
+			!mesh->vertex_positions.empty() &&
+			!mesh->indices.empty()
+			;
+		if (emit_from_mesh)
+		{
+			mesh->GetLODSubsetRange(0, first_subset, last_subset);
+		}
+		const XMMATRIX W = XMLoadFloat4x4(&worldMatrix);
+		XMFLOAT3 emitter_velocity;
+		XMStoreFloat3(&emitter_velocity, XMVector3TransformNormal(XMLoadFloat3(&velocity), W));
+		const XMFLOAT4 emitter_color = material == nullptr ? XMFLOAT4(1, 1, 1, 1) : material->baseColor;
+		uint32_t emit_count = 0;
+		for (auto& location : emit_locations)
+		{
+			XMFLOAT4X4 mat = location.transform.GetMatrix();
+			const XMMATRIX M = W * XMMatrixTranspose(XMLoadFloat4x4(&mat));
+			const XMFLOAT4 location_color = wi::Color(location.color).toFloat4();
+
+			for (uint32_t i = 0; i < location.count && particles.count < MAX_PARTICLES; ++i)
+			{
+				XMFLOAT3 emitPos = XMFLOAT3(0, 0, 0);
+				XMFLOAT3 nor = XMFLOAT3(0, 0, 0);
+				XMFLOAT4 baseColor = XMFLOAT4(
+					emitter_color.x * location_color.x,
+					emitter_color.y * location_color.y,
+					emitter_color.z * location_color.z,
+					emitter_color.w * location_color.w
+				);
+
+				if (emit_from_mesh && last_subset > first_subset)
+				{
+					// random subset of emitter mesh:
+					const MeshComponent::MeshSubset& subset = mesh->subsets[first_subset + rng_cpu.next_uint(0u, last_subset - first_subset - 1)];
+					const uint32_t triangleCount = subset.indexCount / 3;
+					if (triangleCount > 0)
+					{
+						// random triangle on emitter surface:
+						const uint32_t tri = rng_cpu.next_uint(0u, triangleCount - 1);
+						const uint32_t i0 = mesh->indices[subset.indexOffset + tri * 3 + 0];
+						const uint32_t i1 = mesh->indices[subset.indexOffset + tri * 3 + 1];
+						const uint32_t i2 = mesh->indices[subset.indexOffset + tri * 3 + 2];
+
+						// random barycentric coords:
+						float f = rng_cpu.next_float();
+						float g = rng_cpu.next_float();
+						if (f + g > 1)
+						{
+							f = 1 - f;
+							g = 1 - g;
+						}
+
+						const XMVECTOR P0 = XMLoadFloat3(&mesh->vertex_positions[i0]);
+						const XMVECTOR P1 = XMLoadFloat3(&mesh->vertex_positions[i1]);
+						const XMVECTOR P2 = XMLoadFloat3(&mesh->vertex_positions[i2]);
+						XMStoreFloat3(&emitPos, XMVectorBaryCentric(P0, P1, P2, f, g));
+
+						if (!mesh->vertex_normals.empty())
+						{
+							const XMVECTOR N0 = XMLoadFloat3(&mesh->vertex_normals[i0]);
+							const XMVECTOR N1 = XMLoadFloat3(&mesh->vertex_normals[i1]);
+							const XMVECTOR N2 = XMLoadFloat3(&mesh->vertex_normals[i2]);
+							XMVECTOR N = XMVector3Normalize(XMVectorBaryCentric(N0, N1, N2, f, g));
+							N = XMVector3Normalize(XMVector3TransformNormal(N, M));
+							XMStoreFloat3(&nor, N);
+						}
+
+						if (IsTakeColorFromMesh())
+						{
+							const MaterialComponent* subset_material = scene.materials.GetComponent(subset.materialID);
+							if (subset_material != nullptr)
+							{
+								XMVECTOR C = XMLoadFloat4(&baseColor) * XMLoadFloat4(&subset_material->baseColor);
+								if (subset_material->IsUsingVertexColors() && !mesh->vertex_colors.empty())
+								{
+									const XMFLOAT4 c0 = wi::Color(mesh->vertex_colors[i0]).toFloat4();
+									const XMFLOAT4 c1 = wi::Color(mesh->vertex_colors[i1]).toFloat4();
+									const XMFLOAT4 c2 = wi::Color(mesh->vertex_colors[i2]).toFloat4();
+									C *= XMVectorBaryCentric(XMLoadFloat4(&c0), XMLoadFloat4(&c1), XMLoadFloat4(&c2), f, g);
+								}
+								XMStoreFloat4(&baseColor, C);
+							}
+						}
+					}
+				}
+				else if (IsVolumeEnabled())
+				{
+					// Emit inside volume:
+					emitPos.x = rng_cpu.next_float() * 2 - 1;
+					emitPos.y = rng_cpu.next_float() * 2 - 1;
+					emitPos.z = rng_cpu.next_float() * 2 - 1;
+				}
+
+				XMFLOAT3 pos;
+				XMStoreFloat3(&pos, XMVector3Transform(XMLoadFloat3(&emitPos), M));
+
+				const float particleStartingSize = size + size * (rng_cpu.next_float() - 0.5f) * random_factor;
+
+				const uint32_t p = particles.count++;
+				particles.position_x[p] = pos.x;
+				particles.position_y[p] = pos.y;
+				particles.position_z[p] = pos.z;
+				particles.force_x[p] = 0;
+				particles.force_y[p] = 0;
+				particles.force_z[p] = 0;
+				particles.mass[p] = mass;
+				particles.velocity_x[p] = emitter_velocity.x + (nor.x + (rng_cpu.next_float() - 0.5f) * random_factor) * normal_factor;
+				particles.velocity_y[p] = emitter_velocity.y + (nor.y + (rng_cpu.next_float() - 0.5f) * random_factor) * normal_factor;
+				particles.velocity_z[p] = emitter_velocity.z + (nor.z + (rng_cpu.next_float() - 0.5f) * random_factor) * normal_factor;
+				particles.rotation[p] = (rng_cpu.next_float() - 0.5f) * random_factor * XM_2PI;
+				particles.rotationVelocity[p] = rotation * XM_PI * (rng_cpu.next_float() - 0.5f) * (1 + random_factor);
+				particles.maxLife[p] = life + life * (rng_cpu.next_float() - 0.5f) * random_life;
+				particles.life[p] = particles.maxLife[p];
+				particles.sizeBegin[p] = particleStartingSize;
+				particles.sizeEnd[p] = particleStartingSize * scaleX;
+				particles.size[p] = particleStartingSize;
+
+				baseColor.x *= wi::math::Lerp(1.0f, rng_cpu.next_float(), random_color);
+				baseColor.y *= wi::math::Lerp(1.0f, rng_cpu.next_float(), random_color);
+				baseColor.z *= wi::math::Lerp(1.0f, rng_cpu.next_float(), random_color);
+				particles.color[p] = wi::Color::fromFloat4(baseColor).rgba;
+
+				emit_count++;
+			}
+		}
+		emit_locations.clear();
+
+		// Gather forces and colliders that affect this emitter, in the same order as the GPU entity array:
+		struct ForceCPU
+		{
+			ForceFieldComponent::Type type;
+			XMFLOAT3 position;
+			XMFLOAT3 direction;
+			float gravity;
+			float range;
+		};
+		wi::vector<ForceCPU> forces;
+		wi::vector<const ColliderComponent*> colliders;
+		if (!IsCollidersDisabled())
+		{
+			for (uint32_t i = 0; i < scene.collider_count_gpu; ++i)
+			{
+				const ColliderComponent& collider = scene.colliders_gpu[i];
+				if (collider.layerMask & layerMask)
+				{
+					colliders.push_back(&collider);
+				}
+			}
+		}
+		for (size_t i = 0; i < scene.forces.GetCount(); ++i)
+		{
+			wi::ecs::Entity entity = scene.forces.GetEntity(i);
+			uint32_t force_layerMask = ~0u;
+			const LayerComponent* layer = scene.layers.GetComponent(entity);
+			if (layer != nullptr)
+			{
+				force_layerMask = layer->layerMask;
+			}
+			if ((force_layerMask & layerMask) == 0)
+				continue;
+			const TransformComponent* transform = scene.transforms.GetComponent(entity);
+			if (transform == nullptr)
+				continue;
+
+			// Placement is taken from the transform, because the force update system can run in parallel with the particle update:
+			const ForceFieldComponent& force = scene.forces[i];
+			const XMMATRIX FW = XMLoadFloat4x4(&transform->world);
+			ForceCPU& force_cpu = forces.emplace_back();
+			force_cpu.type = force.type;
+			force_cpu.position = transform->GetPosition();
+			XMStoreFloat3(&force_cpu.direction, XMVector3Normalize(XMVector3TransformNormal(XMVectorSet(0, -1, 0, 0), FW)));
+			force_cpu.gravity = force.gravity;
+			force_cpu.range = std::max(0.001f, force.GetRange());
+		}
+
+		// Simulate 4 particles per iteration:
+		const uint32_t packCount = (particles.count + 3) / 4;
+		wi::jobsystem::context ctx;
+		wi::jobsystem::Dispatch(ctx, packCount, 64, [&](wi::jobsystem::JobArgs args) {
+			const uint32_t offset = args.jobIndex * 4;
+			const XMVECTOR DT = XMVectorReplicate(timestep);
+			const XMVECTOR ZERO = XMVectorZero();
+			const XMVECTOR ONE = XMVectorSplatOne();
+
+			XMVECTOR particleLife = XMLoadFloat4((const XMFLOAT4*)(particles.life.data() + offset));
+			const XMVECTOR particleMaxLife = XMLoadFloat4((const XMFLOAT4*)(particles.maxLife.data() + offset));
+			const XMVECTOR sizeBegin = XMLoadFloat4((const XMFLOAT4*)(particles.sizeBegin.data() + offset));
+			const XMVECTOR sizeEnd = XMLoadFloat4((const XMFLOAT4*)(particles.sizeEnd.data() + offset));
+			ParticleVector4 position = LoadParticleVector4(particles.position_x.data() + offset, particles.position_y.data() + offset, particles.position_z.data() + offset);
+			ParticleVector4 velocity = LoadParticleVector4(particles.velocity_x.data() + offset, particles.velocity_y.data() + offset, particles.velocity_z.data() + offset);
+			ParticleVector4 force = LoadParticleVector4(particles.force_x.data() + offset, particles.force_y.data() + offset, particles.force_z.data() + offset);
+
+			particleLife = XMVectorSubtract(particleLife, DT);
+
+			const XMVECTOR lifeLerp = XMVectorSubtract(ONE, XMVectorDivide(particleLife, particleMaxLife));
+			const XMVECTOR particleSize = XMVectorLerpV(sizeBegin, sizeEnd, lifeLerp);
+
+			// integrate:
+			force.x = XMVectorAdd(force.x, XMVectorReplicate(gravity.x));
+			force.y = XMVectorAdd(force.y, XMVectorReplicate(gravity.y));
+			force.z = XMVectorAdd(force.z, XMVectorReplicate(gravity.z));
+			velocity.x = XMVectorMultiplyAdd(force.x, DT, velocity.x);
+			velocity.y = XMVectorMultiplyAdd(force.y, DT, velocity.y);
+			velocity.z = XMVectorMultiplyAdd(force.z, DT, velocity.z);
+			position.x = XMVectorMultiplyAdd(velocity.x, DT, position.x);
+			position.y = XMVectorMultiplyAdd(velocity.y, DT, position.y);
+			position.z = XMVectorMultiplyAdd(velocity.z, DT, position.z);
+
+			// reset force for next frame:
+			force = { ZERO, ZERO, ZERO };
+
+			// drag:
+			const XMVECTOR DRAG = XMVectorReplicate(drag);
+			velocity.x = XMVectorMultiply(velocity.x, DRAG);
+			velocity.y = XMVectorMultiply(velocity.y, DRAG);
+			velocity.z = XMVectorMultiply(velocity.z, DRAG);
+
+			// process colliders:
+			//	Dead particles are also processed, but they will be removed after simulation anyway
+			for (const ColliderComponent* collider : colliders)
+			{
+				switch (collider->shape)
+				{
+				default:
+				case ColliderComponent::Shape::Sphere:
+				{
+					const ParticleVector4 center = {
+						XMVectorReplicate(collider->sphere.center.x),
+						XMVectorReplicate(collider->sphere.center.y),
+						XMVectorReplicate(collider->sphere.center.z)
+					};
+					CollideParticleVector4Sphere(center, XMVectorReplicate(collider->sphere.radius), particleSize, position, velocity);
+				}
+				break;
+				case ColliderComponent::Shape::Capsule:
+				{
+					const float radius = collider->capsule.radius;
+					XMVECTOR A = XMLoadFloat3(&collider->capsule.base);
+					XMVECTOR B = XMLoadFloat3(&collider->capsule.tip);
+					const XMVECTOR N = XMVector3Normalize(A - B);
+					A -= N * radius;
+					B += N * radius;
+					XMFLOAT3 a, ab;
+					XMStoreFloat3(&a, A);
+					XMStoreFloat3(&ab, B - A);
+					const float ab_rcp = 1.0f / std::max(0.000001f, wi::math::Dot(ab, ab));
+
+					// closest point on segment:
+					const ParticleVector4 AB = { XMVectorReplicate(ab.x), XMVectorReplicate(ab.y), XMVectorReplicate(ab.z) };
+					const ParticleVector4 AP = {
+						XMVectorSubtract(position.x, XMVectorReplicate(a.x)),
+						XMVectorSubtract(position.y, XMVectorReplicate(a.y)),
+						XMVectorSubtract(position.z, XMVectorReplicate(a.z))
+					};
+					const XMVECTOR t = XMVectorSaturate(XMVectorScale(Dot4(AP, AB), ab_rcp));
+					const ParticleVector4 center = {
+						XMVectorMultiplyAdd(t, AB.x, XMVectorReplicate(a.x)),
+						XMVectorMultiplyAdd(t, AB.y, XMVectorReplicate(a.y)),
+						XMVectorMultiplyAdd(t, AB.z, XMVectorReplicate(a.z))
+					};
+					CollideParticleVector4Sphere(center, XMVectorReplicate(radius), particleSize, position, velocity);
+				}
+				break;
+				case ColliderComponent::Shape::Plane:
+				{
+					XMFLOAT3 n;
+					XMStoreFloat3(&n, XMVector3Normalize(XMLoadFloat3(&collider->plane.normal)));
+					ParticleVector4 dir = { XMVectorReplicate(n.x), XMVectorReplicate(n.y), XMVectorReplicate(n.z) };
+					const ParticleVector4 OP = {
+						XMVectorSubtract(position.x, XMVectorReplicate(collider->plane.origin.x)),
+						XMVectorSubtract(position.y, XMVectorReplicate(collider->plane.origin.y)),
+						XMVectorSubtract(position.z, XMVectorReplicate(collider->plane.origin.z))
+					};
+					XMVECTOR dist = Dot4(dir, OP);
+
+					// collide on both sides of the plane:
+					const XMVECTOR flip = XMVectorLess(dist, ZERO);
+					dir.x = XMVectorSelect(dir.x, XMVectorNegate(dir.x), flip);
+					dir.y = XMVectorSelect(dir.y, XMVectorNegate(dir.y), flip);
+					dir.z = XMVectorSelect(dir.z, XMVectorNegate(dir.z), flip);
+					dist = XMVectorSubtract(XMVectorAbs(dist), particleSize);
+
+					// projection to plane space, must be inside the plane extents:
+					const XMFLOAT4X4& P = collider->plane.projection;
+					const XMVECTOR px = XMVectorMultiplyAdd(position.x, XMVectorReplicate(P._11), XMVectorMultiplyAdd(position.y, XMVectorReplicate(P._21), XMVectorMultiplyAdd(position.z, XMVectorReplicate(P._31), XMVectorReplicate(P._41))));
+					const XMVECTOR py = XMVectorMultiplyAdd(position.x, XMVectorReplicate(P._12), XMVectorMultiplyAdd(position.y, XMVectorReplicate(P._22), XMVectorMultiplyAdd(position.z, XMVectorReplicate(P._32), XMVectorReplicate(P._42))));
+					const XMVECTOR pz = XMVectorMultiplyAdd(position.x, XMVectorReplicate(P._13), XMVectorMultiplyAdd(position.y, XMVectorReplicate(P._23), XMVectorMultiplyAdd(position.z, XMVectorReplicate(P._33), XMVectorReplicate(P._43))));
+					const XMVECTOR HALF = XMVectorReplicate(0.5f);
+					const XMVECTOR u = XMVectorMultiplyAdd(px, HALF, HALF);
+					const XMVECTOR v = XMVectorNegativeMultiplySubtract(py, HALF, HALF);
+					XMVECTOR mask = XMVectorLess(dist, ZERO);
+					mask = XMVectorAndInt(mask, XMVectorInBounds(XMVectorSubtract(u, HALF), HALF));
+					mask = XMVectorAndInt(mask, XMVectorInBounds(XMVectorSubtract(v, HALF), HALF));
+					mask = XMVectorAndInt(mask, XMVectorInBounds(XMVectorSubtract(pz, HALF), HALF));
+
+					CollideParticleVector4(mask, dir, XMVectorNegate(dist), position, velocity);
+				}
+				break;
+				}
+			}
+
+			// process forces:
+			for (const ForceCPU& force_cpu : forces)
+			{
+				ParticleVector4 dir = {
+					XMVectorSubtract(XMVectorReplicate(force_cpu.position.x), position.x),
+					XMVectorSubtract(XMVectorReplicate(force_cpu.position.y), position.y),
+					XMVectorSubtract(XMVectorReplicate(force_cpu.position.z), position.z)
+				};
+				const XMVECTOR dist = XMVectorSqrt(Dot4(dir, dir));
+				const XMVECTOR falloff = XMVectorScale(XMVectorSubtract(ONE, XMVectorSaturate(XMVectorScale(dist, 1.0f / force_cpu.range))), force_cpu.gravity);
+				switch (force_cpu.type)
+				{
+				default:
+				case ForceFieldComponent::Type::Point:
+				{
+					const XMVECTOR amount = XMVectorDivide(falloff, dist);
+					force.x = XMVectorMultiplyAdd(dir.x, amount, force.x);
+					force.y = XMVectorMultiplyAdd(dir.y, amount, force.y);
+					force.z = XMVectorMultiplyAdd(dir.z, amount, force.z);
+				}
+				break;
+				case ForceFieldComponent::Type::Plane:
+					force.x = XMVectorMultiplyAdd(XMVectorReplicate(force_cpu.direction.x), falloff, force.x);
+					force.y = XMVectorMultiplyAdd(XMVectorReplicate(force_cpu.direction.y), falloff, force.y);
+					force.z = XMVectorMultiplyAdd(XMVectorReplicate(force_cpu.direction.z), falloff, force.z);
+					break;
+				}
+			}
+
+			XMVECTOR particleRotation = XMLoadFloat4((const XMFLOAT4*)(particles.rotation.data() + offset));
+			const XMVECTOR particleRotationVelocity = XMLoadFloat4((const XMFLOAT4*)(particles.rotationVelocity.data() + offset));
+			particleRotation = XMVectorMultiplyAdd(particleRotationVelocity, DT, particleRotation);
+
+			// write back simulated particles:
+			XMStoreFloat4((XMFLOAT4*)(particles.life.data() + offset), particleLife);
+			XMStoreFloat4((XMFLOAT4*)(particles.size.data() + offset), particleSize);
+			XMStoreFloat4((XMFLOAT4*)(particles.rotation.data() + offset), particleRotation);
+			StoreParticleVector4(particles.position_x.data() + offset, particles.position_y.data() + offset, particles.position_z.data() + offset, position);
+			StoreParticleVector4(particles.velocity_x.data() + offset, particles.velocity_y.data() + offset, particles.velocity_z.data() + offset, velocity);
+			StoreParticleVector4(particles.force_x.data() + offset, particles.force_y.data() + offset, particles.force_z.data() + offset, force);
+		});
+		wi::jobsystem::Wait(ctx);
+
+		// Remove dead particles, keeping the order of alive particles:
+		const uint32_t aliveCount = particles.count;
+		uint32_t aliveCount_afterSimulation = 0;
+		for (uint32_t i = 0; i < aliveCount; ++i)
+		{
+			if (particles.life[i] <= 0)
+				continue;
+			const uint32_t j = aliveCount_afterSimulation++;
+			if (i == j)
+				continue;
+			particles.position_x[j] = particles.position_x[i];
+			particles.position_y[j] = particles.position_y[i];
+			particles.position_z[j] = particles.position_z[i];
+			particles.velocity_x[j] = particles.velocity_x[i];
+			particles.velocity_y[j] = particles.velocity_y[i];
+			particles.velocity_z[j] = particles.velocity_z[i];
+			particles.force_x[j] = particles.force_x[i];
+			particles.force_y[j] = particles.force_y[i];
+			particles.force_z[j] = particles.force_z[i];
+			particles.life[j] = particles.life[i];
+			particles.maxLife[j] = particles.maxLife[i];
+			particles.sizeBegin[j] = particles.sizeBegin[i];
+			particles.sizeEnd[j] = particles.sizeEnd[i];
+			particles.size[j] = particles.size[i];
+			particles.mass[j] = particles.mass[i];
+			particles.rotation[j] = particles.rotation[i];
+			particles.rotationVelocity[j] = particles.rotationVelocity[i];
+			particles.color[j] = particles.color[i];
+		}
+		particles.count = aliveCount_afterSimulation;
+
+		statistics = {};
+		statistics.aliveCount = aliveCount;
+		statistics.deadCount = MAX_PARTICLES - aliveCount_afterSimulation;
+		statistics.realEmitCount = emit_count;
+		statistics.aliveCount_afterSimulation = aliveCount_afterSimulation;
+
+		if (aliveCount_afterSimulation > 0)
+		{
+			active_frames |= 1; // activate current frame
+		}
+
+		wi::profiler::EndRange(range);
 	}
 
 	void EmittedParticleSystem::UpdateGPU(uint32_t instanceIndex, const MeshComponent* mesh, CommandList cmd) const
 	{
 		if (IsInactive())
 			return;
+		if (IsCPUSimulationEnabled())
+			return;
 		if (!particleBuffer.IsValid())
 			return;
 
@@ -841,6 +1356,8 @@ namespace wi
 	{
 		if (IsInactive())
 			return;
+		if (IsCPUSimulationEnabled())
+			return; // CPU simulated particles are not rendered
 		GraphicsDevice* device = wi::graphics::GetDevice();
 		device->EventBegin("EmittedParticle", cmd);
 
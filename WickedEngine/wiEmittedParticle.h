@@ -8,6 +8,7 @@
 #include "wiECS.h"
 #include "wiScene_Decl.h"
 #include "wiScene_Components.h"
+#include "wiRandom.h"
 
 namespace wi
 {
@@ -67,8 +68,47 @@ namespace wi
 
 		mutable wi::vector<EmitLocation> emit_locations;
 
+	public:
+		// Particle storage of the CPU simulation in structure of arrays layout
+		//	Array sizes are padded to multiple of 4 so that the simulation can process 4 particles at once
+		struct ParticlesCPU
+		{
+			uint32_t count = 0;
+			wi::vector<float> position_x;
+			wi::vector<float> position_y;
+			wi::vector<float> position_z;
+			wi::vector<float> velocity_x;
+			wi::vector<float> velocity_y;
+			wi::vector<float> velocity_z;
+			wi::vector<float> force_x;
+			wi::vector<float> force_y;
+			wi::vector<float> force_z;
+			wi::vector<float> life;
+			wi::vector<float> maxLife;
+			wi::vector<float> sizeBegin;
+			wi::vector<float> sizeEnd;
+			wi::vector<float> size; // current size, interpolated between sizeBegin and sizeEnd over lifetime
+			wi::vector<float> mass;
+			wi::vector<float> rotation;
+			wi::vector<float> rotationVelocity;
+			wi::vector<uint32_t> color;
+
+			void resize(uint32_t capacity);
+			uint64_t GetMemorySizeInBytes() const;
+		};
+
+	private:
+		ParticlesCPU particles_cpu;
+		wi::random::RNG rng_cpu = wi::random::RNG(0x7061727469636c65); // deterministic, so that CPU simulation is reproducible
+
 	public:
 		void UpdateCPU(const wi::scene::TransformComponent& transform, float dt);
+		// Emits and simulates particles on the CPU, when CPU simulation is enabled (call after UpdateCPU())
+		//	Supports forces, GPU-enabled colliders and lifetime. Not supported: SPH, depth collisions, rain blocker, mesh texture colors
+		//	mesh and material are optional
+		void SimulateCPU(const wi::scene::Scene& scene, const wi::scene::MeshComponent* mesh, const wi::scene::MaterialComponent* material);
+		// Returns the CPU simulated particles, only valid if CPU simulation is enabled
+		const ParticlesCPU& GetParticlesCPU() const { return particles_cpu; }
 		void Burst(int num);
 		void Burst(int num, const XMFLOAT3& position, const wi::Color& color = wi::Color::White());
 		void Burst(int num, const XMFLOAT4X4& transform, const wi::Color& color = wi::Color::White());
@@ -146,6 +186,7 @@ namespace wi
 		XMFLOAT3 center;
 		uint32_t layerMask = ~0u;
 		XMFLOAT4X4 worldMatrix = wi::math::IDENTITY_MATRIX;
+		bool cpu_simulation = false; // see SetCPUSimulationEnabled()
 
 		inline bool IsDebug() const { return _flags & FLAG_DEBUG; }
 		inline bool IsPaused() const { return _flags & FLAG_PAUSED; }
@@ -156,6 +197,7 @@ namespace wi
 		inline bool IsFrameBlendingEnabled() const { return _flags & FLAG_FRAME_BLENDING; }
 		inline bool IsCollidersDisabled() const { return _flags & FLAG_COLLIDERS_DISABLED; }
 		inline bool IsTakeColorFromMesh() const { return _flags & FLAG_TAKE_COLOR_FROM_MESH; }
+		inline bool IsCPUSimulationEnabled() const { return cpu_simulation; }
 
 		inline void SetDebug(bool value) { if (value) { _flags |= FLAG_DEBUG; } else { _flags &= ~FLAG_DEBUG; } }
 		inline void SetPaused(bool value) { if (value) { _flags |= FLAG_PAUSED; } else { _flags &= ~FLAG_PAUSED; } }
@@ -166,6 +208,9 @@ namespace wi
 		inline void SetFrameBlendingEnabled(bool value) { if (value) { _flags |= FLAG_FRAME_BLENDING; } else { _flags &= ~FLAG_FRAME_BLENDING; } }
 		inline void SetCollidersDisabled(bool value) { if (value) { _flags |= FLAG_COLLIDERS_DISABLED; } else { _flags &= ~FLAG_COLLIDERS_DISABLED; } }
 		inline void SetTakeColorFromMesh(bool value) { if (value) { _flags |= FLAG_TAKE_COLOR_FROM_MESH; } else { _flags &= ~FLAG_TAKE_COLOR_FROM_MESH; } }
+		// CPU simulation doesn't require a graphics device, but CPU simulated particles are not rendered
+		//	It is not serialized, it must be enabled at runtime, for example by a server that uses the particles for gameplay
+		inline void SetCPUSimulationEnabled(bool value) { cpu_simulation = value; }
 
 		// Set the opacity curve parameters
 		//	peak : start peak of the opacity relative to particle lifetime [0,1]
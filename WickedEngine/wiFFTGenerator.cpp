@@ -1,6 +1,8 @@
 #include "wiFFTGenerator.h"
 #include "wiResourceManager.h"
 #include "wiRenderer.h"
+#include "wiMath.h"
+#include "wiVector.h"
 #include "shaders/ShaderInterop_FFTGenerator.h"
 
 #include <stdio.h>
@@ -191,6 +193,92 @@ namespace wi::fftgenerator
 		radix008A(pUAV_Dst, fft_plan.pBuffer_Tmp, thread_count, istride, cmd);
 	}
 
+	void fft_c2c_cpu(uint32_t dim, float* real, float* imag)
+	{
+		assert(dim >= 4 && (dim & (dim - 1)) == 0);
+		uint32_t log2dim = 0;
+		while ((1u << log2dim) < dim)
+		{
+			log2dim++;
+		}
+
+		const uint32_t half_dim = dim / 2;
+		wi::vector<float> twiddle_real(half_dim);
+		wi::vector<float> twiddle_imag(half_dim);
+		for (uint32_t i = 0; i < half_dim; ++i)
+		{
+			const double phase = -TWO_PI * i / dim;
+			twiddle_real[i] = (float)std::cos(phase);
+			twiddle_imag[i] = (float)std::sin(phase);
+		}
+
+		// 1D FFT along the columns, this processes 4 columns at once with SIMD:
+		auto fft_columns = [&](float* re, float* im) {
+			// Bit reversal permutation of the rows:
+			for (uint32_t i = 0; i < dim; ++i)
+			{
+				uint32_t j = 0;
+				for (uint32_t bit = 0; bit < log2dim; ++bit)
+				{
+					j |= ((i >> bit) & 1u) << (log2dim - 1 - bit);
+				}
+				if (i < j)
+				{
+					std::swap_ranges(re + i * dim, re + (i + 1) * dim, re + j * dim);
+					std::swap_ranges(im + i * dim, im + (i + 1) * dim, im + j * dim);
+				}
+			}
+
+			// Radix-2 butterflies:
+			for (uint32_t len = 2; len <= dim; len <<= 1)
+			{
+				const uint32_t half_len = len / 2;
+				const uint32_t twiddle_step = dim / len;
+				for (uint32_t i = 0; i < dim; i += len)
+				{
+					for (uint32_t j = 0; j < half_len; ++j)
+					{
+						const XMVECTOR w_re = XMVectorReplicate(twiddle_real[j * twiddle_step]);
+						const XMVECTOR w_im = XMVectorReplicate(twiddle_imag[j * twiddle_step]);
+						float* a_re = re + (i + j) * dim;
+						float* a_im = im + (i + j) * dim;
+						float* b_re = re + (i + j + half_len) * dim;
+						float* b_im = im + (i + j + half_len) * dim;
+						for (uint32_t c = 0; c < dim; c += 4)
+						{
+							const XMVECTOR ar = XMLoadFloat4((const XMFLOAT4*)(a_re + c));
+							const XMVECTOR ai = XMLoadFloat4((const XMFLOAT4*)(a_im + c));
+							const XMVECTOR br = XMLoadFloat4((const XMFLOAT4*)(b_re + c));
+							const XMVECTOR bi = XMLoadFloat4((const XMFLOAT4*)(b_im + c));
+							const XMVECTOR tr = XMVectorNegativeMultiplySubtract(w_im, bi, XMVectorMultiply(w_re, br));
+							const XMVECTOR ti = XMVectorMultiplyAdd(w_im, br, XMVectorMultiply(w_re, bi));
+							XMStoreFloat4((XMFLOAT4*)(a_re + c), XMVectorAdd(ar, tr));
+							XMStoreFloat4((XMFLOAT4*)(a_im + c), XMVectorAdd(ai, ti));
+							XMStoreFloat4((XMFLOAT4*)(b_re + c), XMVectorSubtract(ar, tr));
+							XMStoreFloat4((XMFLOAT4*)(b_im + c), XMVectorSubtract(ai, ti));
+						}
+					}
+				}
+			}
+		};
+		auto transpose = [&](float* data) {
+			for (uint32_t y = 0; y < dim; ++y)
+			{
+				for (uint32_t x = y + 1; x < dim; ++x)
+				{
+					std::swap(data[y * dim + x], data[x * dim + y]);
+				}
+			}
+		};
+
+		fft_columns(real, imag);
+		transpose(real);
+		transpose(imag);
+		fft_columns(real, imag);
+		transpose(real);
+		transpose(imag);
+	}
+
 	void LoadShaders()
 	{
 		wi::renderer::LoadShader(ShaderStage::CS, radix008A_CS, "fft_512x512_c2c_CS.cso");
@@ -10,5 +10,10 @@ namespace wi::fftgenerator
 		const wi::graphics::GPUResource& pSRV_Src,
 		wi::graphics::CommandList cmd);
 
+	// CPU implementation of the 2D complex to complex forward FFT, the same transform as fft_512x512_c2c, but for any size
+	//	dim			: width and height of the data, must be power of two and at least 4
+	//	real, imag	: dim * dim values each in row major order, they will be transformed in place
+	void fft_c2c_cpu(uint32_t dim, float* real, float* imag);
+
 	void LoadShaders();
 }
@@ -14,12 +14,16 @@
 #include "wiUnorderedSet.h"
 #include "wiVector.h"
 #include "wiMath.h"
+#include "wiJobSystem.h"
+#include "wiImage.h"
 
 #include "Utility/liberation_sans.h"
 #include "Utility/stb_truetype.h"
 
 #include <fstream>
 #include <mutex>
+#include <atomic>
+#include <string_view>
 
 using namespace wi::enums;
 using namespace wi::graphics;
@@ -41,10 +45,15 @@ namespace wi::font
 		static Shader vertexShader;
 		static Shader pixelShader;
 		static PipelineState PSO[DEPTH_TEST_MODE_COUNT];
+		static Shader vertexShader_batched;
+		static Shader pixelShader_batched;
+		static PipelineState PSO_batched[DEPTH_TEST_MODE_COUNT];
 
 		static thread_local wi::Canvas canvas;
 
 		static Texture texture;
+		static Texture texture_upload; // new glyphs are written into this and only their rectangles are copied into the atlas texture
+		static wi::rectpacker::State packer; // keeps the free space of the atlas between updates
 
 		struct FontStyle
 		{
@@ -115,6 +124,108 @@ namespace wi::font
 		static_assert(sizeof(GlyphHash) == sizeof(uint32_t));
 		static wi::unordered_set<uint32_t> pendingGlyphs;
 		static std::mutex locker;
+		static AtlasStatistics statistics;
+
+		// Renders the glyph bitmap and computes the glyph placement, this is thread safe to be used for different glyphs in parallel
+		void RenderGlyph(uint32_t raw, float upscaling, Bitmap& bitmap, Glyph& glyph)
+		{
+			GlyphHash hash;
+			hash.raw = raw;
+			const int code = (int)hash.bits.code;
+			const float height = (float)hash.bits.height;
+			const bool is_sdf = hash.bits.sdf ? true : false;
+			uint32_t style = hash.bits.style;
+			const FontStyle* fontStyle = fontStyles[style].get();
+			int glyphIndex = stbtt_FindGlyphIndex(&fontStyle->fontInfo, code);
+			if (glyphIndex == 0)
+			{
+				// Try fallback to an other font style that has this character:
+				style = 0;
+				while (glyphIndex == 0 && style < fontStyles.size())
+				{
+					fontStyle = fontStyles[style].get();
+					glyphIndex = stbtt_FindGlyphIndex(&fontStyle->fontInfo, code);
+					style++;
+				}
+			}
+
+			const float upscaling_rcp = 1.0f / upscaling;
+			float fontScaling = stbtt_ScaleForPixelHeight(&fontStyle->fontInfo, height * upscaling);
+
+			bitmap.width = 0;
+			bitmap.height = 0;
+			bitmap.xoff = 0;
+			bitmap.yoff = 0;
+
+			if (is_sdf)
+			{
+				unsigned char* data = stbtt_GetGlyphSDF(
+					&fontStyle->fontInfo,
+					fontScaling,
+					glyphIndex,
+					(int)SDF::padding,
+					(unsigned char)SDF::onedge_value,
+					SDF::pixel_dist_scale,
+					&bitmap.width,
+					&bitmap.height,
+					&bitmap.xoff,
+					&bitmap.yoff
+				);
+				bitmap.data.resize(bitmap.width * bitmap.height);
+				std::memcpy(bitmap.data.data(), data, bitmap.data.size());
+				stbtt_FreeSDF(data, nullptr);
+			}
+			else
+			{
+				unsigned char* data = stbtt_GetGlyphBitmap(
+					&fontStyle->fontInfo,
+					fontScaling,
+					fontScaling,
+					glyphIndex,
+					&bitmap.width,
+					&bitmap.height,
+					&bitmap.xoff,
+					&bitmap.yoff
+				);
+				bitmap.data.resize(bitmap.width * bitmap.height);
+				std::memcpy(bitmap.data.data(), data, bitmap.data.size());
+				stbtt_FreeBitmap(data, nullptr);
+			}
+
+			glyph.x = float(bitmap.xoff) * upscaling_rcp;
+			glyph.y = (float(bitmap.yoff) + float(fontStyle->ascent) * fontScaling) * upscaling_rcp;
+			glyph.width = float(bitmap.width) * upscaling_rcp;
+			glyph.height = float(bitmap.height) * upscaling_rcp;
+			glyph.fontStyle = fontStyle;
+		}
+
+		// Computes the texture coordinates of the glyph from its packed rect (which includes 1 pixel padding on each side)
+		void PlaceGlyph(const wi::rectpacker::Rect& rect, Glyph& glyph, float inv_width, float inv_height)
+		{
+			glyph.tc_left = float(rect.x + 1);
+			glyph.tc_right = glyph.tc_left + float(rect.w - 2);
+			glyph.tc_top = float(rect.y + 1);
+			glyph.tc_bottom = glyph.tc_top + float(rect.h - 2);
+
+			glyph.tc_left *= inv_width;
+			glyph.tc_right *= inv_width;
+			glyph.tc_top *= inv_height;
+			glyph.tc_bottom *= inv_height;
+		}
+
+		// Copies the bitmap into the packed rect of the destination image, the padding is cleared
+		void WriteGlyph(const wi::rectpacker::Rect& rect, const Bitmap& bitmap, uint8_t* dst, size_t row_pitch)
+		{
+			for (int row = 0; row < rect.h; ++row)
+			{
+				uint8_t* dst_row = dst + rect.x + (rect.y + row) * row_pitch;
+				std::memset(dst_row, 0, rect.w);
+				if (row > 0 && row <= bitmap.height)
+				{
+					std::memcpy(dst_row + 1, bitmap.data.data() + (row - 1) * bitmap.width, bitmap.width);
+				}
+			}
+		}
 
 		struct ParseStatus
 		{
@@ -122,6 +233,7 @@ namespace wi::font
 			uint32_t quadCount = 0;
 			size_t last_word_begin = 0;
 			bool start_new_word = false;
+			bool missing_glyphs = false; // some glyphs are not in the atlas yet, so they were skipped
 		};
 
 		static thread_local wi::vector<FontVertex> vertexList;
@@ -169,6 +281,7 @@ namespace wi::font
 					// glyph not packed yet, so add to pending list:
 					std::scoped_lock lck(locker);
 					pendingGlyphs.insert(hash.raw);
+					status.missing_glyphs = true;
 					continue;
 				}
 
@@ -270,9 +383,189 @@ namespace wi::font
 			return ParseText(wchar_temp_buffer.c_str(), wchar_temp_buffer.length(), params);
 		}
 
-		void CommitText(void* vertexList_GPU)
+		// The text layouts are cached, so that static texts that are drawn every frame don't need to be parsed every frame:
+		static std::atomic_bool layout_cache_enabled{ true };
+		static std::atomic<uint32_t> atlas_version{ 0 }; // changes when the already placed glyphs are moved in the atlas
+		static std::atomic<uint64_t> layout_frame{ 0 }; // advanced by UpdateAtlas() every frame
+		static std::atomic<uint64_t> layout_cache_hits{ 0 };
+		static std::atomic<uint64_t> layout_cache_misses{ 0 };
+		static constexpr size_t layout_cache_max_text_length = 1024; // longer texts are not cached
+		static constexpr uint64_t layout_cache_max_age = 16; // layouts that were not used for this many frames are removed
+		struct LayoutKey
+		{
+			int size = 0;
+			int style = 0;
+			float spacingX = 0;
+			float spacingY = 0;
+			float h_wrap = 0;
+			Cursor cursor;
+			uint32_t flags = 0; // the params flags that affect the layout
+			bool wide = false;
+
+			bool operator==(const LayoutKey& other) const
+			{
+				return
+					size == other.size &&
+					style == other.style &&
+					spacingX == other.spacingX &&
+					spacingY == other.spacingY &&
+					h_wrap == other.h_wrap &&
+					cursor.position.x == other.cursor.position.x &&
+					cursor.position.y == other.cursor.position.y &&
+					cursor.size.x == other.cursor.size.x &&
+					cursor.size.y == other.cursor.size.y &&
+					flags == other.flags &&
+					wide == other.wide
+					;
+			}
+		};
+		struct TextLayout
 		{
-			std::memcpy(vertexList_GPU, vertexList.data(), sizeof(FontVertex) * vertexList.size());
+			LayoutKey key;
+			std::string text; // raw bytes of the text
+			ParseStatus status;
+			wi::vector<FontVertex> vertices;
+			uint32_t atlas_version = 0;
+			uint64_t last_used_frame = 0;
+		};
+		struct LayoutCache
+		{
+			wi::unordered_map<size_t, TextLayout> layouts;
+			wi::vector<size_t> expired;
+			uint64_t swept_frame = 0;
+		};
+		static thread_local LayoutCache layout_cache;
+
+		inline std::string_view TextBytes(const char* text, size_t text_length)
+		{
+			return std::string_view(text, text_length);
+		}
+		inline std::string_view TextBytes(const wchar_t* text, size_t text_length)
+		{
+			return std::string_view((const char*)text, text_length * sizeof(wchar_t));
+		}
+
+		// Returns the parsed text layout, either from the cache or by parsing the text
+		//	vertices : if not nullptr, it will receive the glyph quads of the layout (valid until the next layout on the current thread)
+		template<typename T>
+		ParseStatus LayoutText(const T* text, size_t text_length, const Params& params, const FontVertex** vertices = nullptr)
+		{
+			if (!layout_cache_enabled.load(std::memory_order_relaxed) || text_length > layout_cache_max_text_length)
+			{
+				ParseStatus status = ParseText(text, text_length, params);
+				if (vertices != nullptr)
+				{
+					*vertices = vertexList.data();
+				}
+				return status;
+			}
+
+			LayoutKey key;
+			key.size = params.size;
+			key.style = params.style;
+			key.spacingX = params.spacingX;
+			key.spacingY = params.spacingY;
+			key.h_wrap = params.h_wrap;
+			key.cursor = params.cursor;
+			key.flags = params._flags & (Params::SDF_RENDERING | Params::FLIP_HORIZONTAL | Params::FLIP_VERTICAL);
+			key.wide = sizeof(T) != sizeof(char);
+
+			const std::string_view bytes = TextBytes(text, text_length);
+			size_t hash = std::hash<std::string_view>{}(bytes);
+			wi::helper::hash_combine(hash, key.size);
+			wi::helper::hash_combine(hash, key.style);
+			wi::helper::hash_combine(hash, key.spacingX);
+			wi::helper::hash_combine(hash, key.spacingY);
+			wi::helper::hash_combine(hash, key.h_wrap);
+			wi::helper::hash_combine(hash, key.cursor.position.x);
+			wi::helper::hash_combine(hash, key.cursor.position.y);
+			wi::helper::hash_combine(hash, key.cursor.size.x);
+			wi::helper::hash_combine(hash, key.cursor.size.y);
+			wi::helper::hash_combine(hash, key.flags);
+			wi::helper::hash_combine(hash, key.wide);
+
+			const uint64_t frame = layout_frame.load(std::memory_order_relaxed);
+			const uint32_t version = atlas_version.load(std::memory_order_relaxed);
+
+			// Remove the layouts that were not used recently, for example texts that change every frame:
+			if (layout_cache.swept_frame + layout_cache_max_age < frame)
+			{
+				layout_cache.swept_frame = frame;
+				layout_cache.expired.clear();
+				for (auto& it : layout_cache.layouts)
+				{
+					if (it.second.last_used_frame + layout_cache_max_age < frame || it.second.atlas_version != version)
+					{
+						layout_cache.expired.push_back(it.first);
+					}
+				}
+				for (size_t expired : layout_cache.expired)
+				{
+					layout_cache.layouts.erase(expired);
+				}
+			}
+
+			TextLayout& layout = layout_cache.layouts[hash];
+			if (layout.atlas_version == version && layout.key == key && layout.text == bytes && !layout.vertices.empty())
+			{
+				layout_cache_hits.fetch_add(1, std::memory_order_relaxed);
+				layout.last_used_frame = frame;
+				if (vertices != nullptr)
+				{
+					*vertices = layout.vertices.data();
+				}
+				return layout.status;
+			}
+			layout_cache_misses.fetch_add(1, std::memory_order_relaxed);
+
+			ParseStatus status = ParseText(text, text_length, params);
+			if (vertices != nullptr)
+			{
+				*vertices = vertexList.data();
+			}
+			if (status.missing_glyphs || vertexList.empty())
+			{
+				// Incomplete layouts are not cached, they will change when the missing glyphs are added to the atlas:
+				layout_cache.layouts.erase(hash);
+				return status;
+			}
+			layout.key = key;
+			layout.text = bytes;
+			layout.status = status;
+			layout.vertices = vertexList;
+			layout.atlas_version = version;
+			layout.last_used_frame = frame;
+			return status;
+		}
+
+		// Computes the clip space bounds of the glyph quads for the 2D draw batching (min x, min y, max x, max y)
+		XMFLOAT4 ComputeBounds(const FontVertex* vertices, uint32_t vertex_count, const XMMATRIX& M)
+		{
+			float2 local_min = float2(std::numeric_limits<float>::max(), std::numeric_limits<float>::max());
+			float2 local_max = float2(std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest());
+			for (uint32_t i = 0; i < vertex_count; ++i)
+			{
+				local_min.x = std::min(local_min.x, vertices[i].pos.x);
+				local_min.y = std::min(local_min.y, vertices[i].pos.y);
+				local_max.x = std::max(local_max.x, vertices[i].pos.x);
+				local_max.y = std::max(local_max.y, vertices[i].pos.y);
+			}
+			const XMVECTOR corners[] = {
+				XMVectorSet(local_min.x, local_min.y, 0, 1),
+				XMVectorSet(local_max.x, local_min.y, 0, 1),
+				XMVectorSet(local_min.x, local_max.y, 0, 1),
+				XMVectorSet(local_max.x, local_max.y, 0, 1),
+			};
+			XMVECTOR _min = XMVectorReplicate(std::numeric_limits<float>::max());
+			XMVECTOR _max = XMVectorReplicate(std::numeric_limits<float>::lowest());
+			for (auto& corner : corners)
+			{
+				XMVECTOR P = XMVector4Transform(corner, M);
+				P = P / XMVectorSplatW(P);
+				_min = XMVectorMin(_min, P);
+				_max = XMVectorMax(_max, P);
+			}
+			return XMFLOAT4(XMVectorGetX(_min), XMVectorGetY(_min), XMVectorGetX(_max), XMVectorGetY(_max));
 		}
 
 	}
@@ -282,6 +575,8 @@ namespace wi::font
 	{
 		wi::renderer::LoadShader(ShaderStage::VS, vertexShader, "fontVS.cso");
 		wi::renderer::LoadShader(ShaderStage::PS, pixelShader, "fontPS.cso");
+		wi::renderer::LoadShader(ShaderStage::VS, vertexShader_batched, "fontVS_batched.cso");
+		wi::renderer::LoadShader(ShaderStage::PS, pixelShader_batched, "fontPS_batched.cso");
 
 		for (int d = 0; d < DEPTH_TEST_MODE_COUNT; ++d)
 		{
@@ -293,6 +588,10 @@ namespace wi::font
 			desc.rs = &rasterizerState;
 			desc.pt = PrimitiveTopology::TRIANGLESTRIP;
 			wi::graphics::GetDevice()->CreatePipelineState(&desc, &PSO[d]);
+
+			desc.vs = &vertexShader_batched;
+			desc.ps = &pixelShader_batched;
+			wi::graphics::GetDevice()->CreatePipelineState(&desc, &PSO_batched[d]);
 		}
 	}
 	void Initialize()
@@ -350,6 +649,9 @@ namespace wi::font
 	void InvalidateAtlas()
 	{
 		texture = {};
+		texture_upload = {};
+		packer = {};
+		atlas_version.fetch_add(1);
 		glyph_lookup.clear();
 		rect_lookup.clear();
 		bitmap_lookup.clear();
@@ -358,9 +660,10 @@ namespace wi::font
 	{
 		std::scoped_lock lck(locker);
 
+		layout_frame.fetch_add(1, std::memory_order_relaxed);
+
 		upscaling = std::max(1.5f, upscaling); // add some minimum upscaling, especially for SDF
 		static float upscaling_prev = 1;
-		const float upscaling_rcp = 1.0f / upscaling;
 
 		if (upscaling_prev != upscaling)
 		{
@@ -369,155 +672,183 @@ namespace wi::font
 			upscaling_prev = upscaling;
 		}
 
-		// If there are pending glyphs, render them and repack the atlas:
+		// If there are pending glyphs, render them and add them to the atlas:
 		if (!pendingGlyphs.empty())
 		{
-			for (int32_t raw : pendingGlyphs)
+			wi::Timer timer;
+
+			// The lookup entries are created before rendering, because the parallel rendering can't modify the lookups:
+			static wi::vector<uint32_t> new_glyphs;
+			static wi::vector<Bitmap*> new_bitmaps;
+			static wi::vector<Glyph*> new_glyphs_placement;
+			static wi::vector<wi::rectpacker::Rect> new_rects;
+			new_glyphs.clear();
+			for (uint32_t raw : pendingGlyphs)
 			{
-				GlyphHash hash;
-				hash.raw = raw;
-				const int code = (int)hash.bits.code;
-				const float height = (float)hash.bits.height;
-				const bool is_sdf = hash.bits.sdf ? true : false;
-				uint32_t style = hash.bits.style;
-				FontStyle* fontStyle = fontStyles[style].get();
-				int glyphIndex = stbtt_FindGlyphIndex(&fontStyle->fontInfo, code);
-				if (glyphIndex == 0)
-				{
-					// Try fallback to an other font style that has this character:
-					style = 0;
-					while (glyphIndex == 0 && style < fontStyles.size())
-					{
-						fontStyle = fontStyles[style].get();
-						glyphIndex = stbtt_FindGlyphIndex(&fontStyle->fontInfo, code);
-						style++;
-					}
-				}
-
-				float fontScaling = stbtt_ScaleForPixelHeight(&fontStyle->fontInfo, height * upscaling);
-
-				Bitmap& bitmap = bitmap_lookup[hash.raw];
-				bitmap.width = 0;
-				bitmap.height = 0;
-				bitmap.xoff = 0;
-				bitmap.yoff = 0;
+				new_glyphs.push_back(raw);
+				bitmap_lookup[raw];
+				glyph_lookup[raw];
+			}
+			pendingGlyphs.clear();
+			new_bitmaps.resize(new_glyphs.size());
+			new_glyphs_placement.resize(new_glyphs.size());
+			for (size_t i = 0; i < new_glyphs.size(); ++i)
+			{
+				new_bitmaps[i] = &bitmap_lookup[new_glyphs[i]];
+				new_glyphs_placement[i] = &glyph_lookup[new_glyphs[i]];
+			}
 
-				if (is_sdf)
-				{
-					unsigned char* data = stbtt_GetGlyphSDF(
-						&fontStyle->fontInfo,
-						fontScaling,
-						glyphIndex,
-						(int)SDF::padding,
-						(unsigned char)SDF::onedge_value,
-						SDF::pixel_dist_scale,
-						&bitmap.width,
-						&bitmap.height,
-						&bitmap.xoff,
-						&bitmap.yoff
-					);
-					bitmap.data.resize(bitmap.width * bitmap.height);
-					std::memcpy(bitmap.data.data(), data, bitmap.data.size());
-					stbtt_FreeSDF(data, nullptr);
-				}
-				else
-				{
-					unsigned char* data = stbtt_GetGlyphBitmap(
-						&fontStyle->fontInfo,
-						fontScaling,
-						fontScaling,
-						glyphIndex,
-						&bitmap.width,
-						&bitmap.height,
-						&bitmap.xoff,
-						&bitmap.yoff
-					);
-					bitmap.data.resize(bitmap.width * bitmap.height);
-					std::memcpy(bitmap.data.data(), data, bitmap.data.size());
-					stbtt_FreeBitmap(data, nullptr);
-				}
+			// Render the glyphs in parallel (SDF generation is especially slow):
+			wi::jobsystem::context ctx;
+			wi::jobsystem::Dispatch(ctx, (uint32_t)new_glyphs.size(), 1, [&](wi::jobsystem::JobArgs args) {
+				RenderGlyph(new_glyphs[args.jobIndex], upscaling, *new_bitmaps[args.jobIndex], *new_glyphs_placement[args.jobIndex]);
+			});
+			wi::jobsystem::Wait(ctx);
 
+			new_rects.resize(new_glyphs.size());
+			for (size_t i = 0; i < new_glyphs.size(); ++i)
+			{
 				wi::rectpacker::Rect rect = {};
-				rect.w = bitmap.width + 2;
-				rect.h = bitmap.height + 2;
-				rect.id = hash.raw;
-				rect_lookup[hash.raw] = rect;
-
-				Glyph& glyph = glyph_lookup[hash.raw];
-				glyph.x = float(bitmap.xoff) * upscaling_rcp;
-				glyph.y = (float(bitmap.yoff) + float(fontStyle->ascent) * fontScaling) * upscaling_rcp;
-				glyph.width = float(bitmap.width) * upscaling_rcp;
-				glyph.height = float(bitmap.height) * upscaling_rcp;
-				glyph.fontStyle = fontStyle;
+				rect.w = new_bitmaps[i]->width + 2;
+				rect.h = new_bitmaps[i]->height + 2;
+				rect.id = new_glyphs[i];
+				rect_lookup[rect.id] = rect;
+				new_rects[i] = rect;
 			}
-			pendingGlyphs.clear();
+			statistics.rendered_glyphs = (uint32_t)new_glyphs.size();
+			statistics.uploaded_rects = 0;
+			statistics.uploaded_bytes = 0;
+			statistics.repacked = false;
+
+			GraphicsDevice* device = GetDevice();
 
-			// Setup packer, this will allocate memory if needed:
-			static thread_local wi::rectpacker::State packer;
-			packer.clear();
-			for (auto& it : rect_lookup)
+			// Try to pack the new glyphs into the free space of the atlas, and only copy their rectangles into the atlas texture:
+			if (texture.IsValid() && texture_upload.mapped_subresources != nullptr && packer.pack_more(new_rects.data(), (int)new_rects.size()))
 			{
-				packer.add_rect(it.second);
+				const float inv_width = 1.0f / packer.width;
+				const float inv_height = 1.0f / packer.height;
+				const SubresourceData& upload = texture_upload.mapped_subresources[0];
+				uint8_t* upload_data = (uint8_t*)upload.data_ptr;
+
+				CommandList cmd = device->BeginCommandList();
+				device->EventBegin("wi::font::UpdateAtlas", cmd);
+				device->Barrier(GPUBarrier::Image(&texture, texture.desc.layout, ResourceState::COPY_DST), cmd);
+				for (size_t i = 0; i < new_rects.size(); ++i)
+				{
+					const wi::rectpacker::Rect& rect = new_rects[i];
+					rect_lookup[rect.id] = rect;
+					WriteGlyph(rect, *new_bitmaps[i], upload_data, upload.row_pitch);
+					PlaceGlyph(rect, *new_glyphs_placement[i], inv_width, inv_height);
+
+					Box box;
+					box.left = uint32_t(rect.x);
+					box.top = uint32_t(rect.y);
+					box.front = 0;
+					box.right = uint32_t(rect.x + rect.w);
+					box.bottom = uint32_t(rect.y + rect.h);
+					box.back = 1;
+					device->CopyTexture(&texture, box.left, box.top, 0, 0, 0, &texture_upload, 0, 0, cmd, &box);
+					statistics.uploaded_rects++;
+					statistics.uploaded_bytes += size_t(rect.w) * size_t(rect.h);
+				}
+				device->Barrier(GPUBarrier::Image(&texture, ResourceState::COPY_DST, texture.desc.layout), cmd);
+				device->EventEnd(cmd);
 			}
-
-			// Perform packing and process the result if successful:
-			if (packer.pack(4096))
+			else
 			{
-				// Retrieve texture atlas dimensions:
-				const int atlasWidth = packer.width;
-				const int atlasHeight = packer.height;
-				const float inv_width = 1.0f / atlasWidth;
-				const float inv_height = 1.0f / atlasHeight;
-
-				// Create the CPU-side texture atlas and fill with transparency (0):
-				wi::vector<uint8_t> atlas(size_t(atlasWidth) * size_t(atlasHeight));
-				std::fill(atlas.begin(), atlas.end(), 0);
+				// The atlas is full (or doesn't exist yet), repack all glyphs:
+				packer.clear();
+				for (auto& it : rect_lookup)
+				{
+					packer.add_rect(it.second);
+				}
 
-				// Iterate all packed glyph rectangles:
-				for (auto& rect : packer.rects)
+				// Perform packing and process the result if successful:
+				if (packer.pack(4096))
 				{
-					rect.x += 1;
-					rect.y += 1;
-					rect.w -= 2;
-					rect.h -= 2;
-
-					const int32_t hash = rect.id;
-					//const wchar_t code = codefromhash(hash);
-					//const int style = stylefromhash(hash);
-					//const float height = (float)heightfromhash(hash);
-					Glyph& glyph = glyph_lookup[hash];
-					Bitmap& bitmap = bitmap_lookup[hash];
-
-					for (int row = 0; row < bitmap.height; ++row)
+					// Leave free space for the glyphs that will be added later, so they can be packed without repacking everything:
+					if (packer.width < 4096 || packer.height < 4096)
 					{
-						uint8_t* dst = atlas.data() + rect.x + (rect.y + row) * atlasWidth;
-						uint8_t* src = bitmap.data.data() + row * bitmap.width;
-						std::memcpy(dst, src, bitmap.width);
+						if (packer.height < packer.width)
+						{
+							packer.height *= 2;
+						}
+						else
+						{
+							packer.width *= 2;
+						}
+						packer.pack(4096);
 					}
 
-					// Compute texture coordinates for the glyph:
-					glyph.tc_left = float(rect.x);
-					glyph.tc_right = glyph.tc_left + float(rect.w);
-					glyph.tc_top = float(rect.y);
-					glyph.tc_bottom = glyph.tc_top + float(rect.h);
+					// Retrieve texture atlas dimensions:
+					const int atlasWidth = packer.width;
+					const int atlasHeight = packer.height;
+					const float inv_width = 1.0f / atlasWidth;
+					const float inv_height = 1.0f / atlasHeight;
 
-					glyph.tc_left *= inv_width;
-					glyph.tc_right *= inv_width;
-					glyph.tc_top *= inv_height;
-					glyph.tc_bottom *= inv_height;
-				}
+					// Create the CPU-side texture atlas and fill with transparency (0):
+					wi::vector<uint8_t> atlas(size_t(atlasWidth) * size_t(atlasHeight));
+					std::fill(atlas.begin(), atlas.end(), 0);
 
-				// Upload the CPU-side texture atlas bitmap to the GPU:
-				wi::texturehelper::CreateTexture(texture, atlas.data(), atlasWidth, atlasHeight, Format::R8_UNORM);
-				GetDevice()->SetName(&texture, "wi::font::texture");
-			}
-			else
-			{
-				assert(0); // rect packing failure
+					// Iterate all packed glyph rectangles:
+					for (auto& rect : packer.rects)
+					{
+						const int32_t hash = rect.id;
+						rect_lookup[hash] = rect;
+						WriteGlyph(rect, bitmap_lookup[hash], atlas.data(), size_t(atlasWidth));
+						PlaceGlyph(rect, glyph_lookup[hash], inv_width, inv_height);
+					}
+
+					// Upload the CPU-side texture atlas bitmap to the GPU:
+					wi::texturehelper::CreateTexture(texture, atlas.data(), atlasWidth, atlasHeight, Format::R8_UNORM);
+					device->SetName(&texture, "wi::font::texture");
+
+					TextureDesc desc = texture.desc;
+					desc.usage = Usage::UPLOAD;
+					desc.bind_flags = BindFlag::NONE;
+					desc.layout = ResourceState::COPY_SRC;
+					device->CreateTexture(&desc, nullptr, &texture_upload);
+					device->SetName(&texture_upload, "wi::font::texture_upload");
+
+					statistics.uploaded_rects = (uint32_t)packer.rects.size();
+					statistics.uploaded_bytes = atlas.size();
+					statistics.repacked = true;
+					statistics.repack_count++;
+					atlas_version.fetch_add(1); // the cached text layouts refer to the old glyph placements
+				}
+				else
+				{
+					assert(0); // rect packing failure
+				}
 			}
+
+			statistics.glyph_count = (uint32_t)glyph_lookup.size();
+			statistics.atlas_width = (uint32_t)packer.width;
+			statistics.atlas_height = (uint32_t)packer.height;
+			statistics.update_time = (float)timer.elapsed_milliseconds();
 		}
 
 	}
+	AtlasStatistics GetAtlasStatistics()
+	{
+		std::scoped_lock lck(locker);
+		return statistics;
+	}
+	void SetLayoutCacheEnabled(bool value)
+	{
+		layout_cache_enabled.store(value);
+	}
+	bool IsLayoutCacheEnabled()
+	{
+		return layout_cache_enabled.load();
+	}
+	LayoutCacheStatistics GetLayoutCacheStatistics()
+	{
+		LayoutCacheStatistics result;
+		result.hits = layout_cache_hits.load(std::memory_order_relaxed);
+		result.misses = layout_cache_misses.load(std::memory_order_relaxed);
+		return result;
+	}
 	const Texture* GetAtlas()
 	{
 		return &texture;
@@ -568,30 +899,74 @@ namespace wi::font
 		{
 			return Cursor();
 		}
-		ParseStatus status = ParseText(text, text_length, params);
+		const FontVertex* vertices = nullptr;
+		ParseStatus status = LayoutText(text, text_length, params, &vertices);
 
 		if (status.quadCount > 0)
 		{
 			GraphicsDevice* device = wi::graphics::GetDevice();
-			GraphicsDevice::GPUAllocation mem = device->AllocateGPU(sizeof(FontVertex) * status.quadCount * 4, cmd);
-			if (!mem.IsValid())
-			{
-				return status.cursor;
-			}
-			CommitText(mem.data);
 
+			// Inside a wi::image batch the font is drawn together with the batched images, except with custom projection:
+			const bool batched = wi::image::IsBatching(cmd) && params.customProjection == nullptr && PSO_batched[params.isDepthTestEnabled()].IsValid();
+
+			wi::image::DrawStatistics draw_statistics;
 			FontConstants font = {};
-			font.buffer_index = device->GetDescriptorIndex(&mem.buffer, SubresourceType::SRV);
-			font.buffer_offset = (uint32_t)mem.offset;
 			font.texture_index = device->GetDescriptorIndex(&texture, SubresourceType::SRV);
-			if (font.buffer_index < 0 || font.texture_index < 0)
+			if (font.texture_index < 0)
 			{
 				return status.cursor;
 			}
+			if (!batched)
+			{
+				GraphicsDevice::GPUAllocation mem = device->AllocateGPU(sizeof(FontVertex) * status.quadCount * 4, cmd);
+				if (!mem.IsValid())
+				{
+					return status.cursor;
+				}
+				std::memcpy(mem.data, vertices, sizeof(FontVertex) * status.quadCount * 4);
+				draw_statistics.gpu_allocations++;
 
-			device->EventBegin("Font", cmd);
+				font.buffer_index = device->GetDescriptorIndex(&mem.buffer, SubresourceType::SRV);
+				font.buffer_offset = (uint32_t)mem.offset;
+				if (font.buffer_index < 0)
+				{
+					return status.cursor;
+				}
+
+				wi::image::FlushBatch(cmd);
+				device->EventBegin("Font", cmd);
+				device->BindPipelineState(&PSO[params.isDepthTestEnabled()], cmd);
+				draw_statistics.pipeline_binds++;
+			}
 
-			device->BindPipelineState(&PSO[params.isDepthTestEnabled()], cmd);
+			// Draws the glyphs with the current font constants:
+			auto draw = [&](const XMMATRIX& transform) {
+				if (batched)
+				{
+					FontBatchInstance instance = {};
+					XMFLOAT4X4 rows;
+					XMStoreFloat4x4(&rows, transform);
+					instance.transform0 = XMFLOAT4(rows._11, rows._12, rows._13, rows._14);
+					instance.transform1 = XMFLOAT4(rows._21, rows._22, rows._23, rows._24);
+					instance.transform2 = XMFLOAT4(rows._31, rows._32, rows._33, rows._34);
+					instance.transform3 = XMFLOAT4(rows._41, rows._42, rows._43, rows._44);
+					instance.color = font.color;
+					instance.softness_bolden_hdrscaling = font.softness_bolden_hdrscaling;
+					instance.texture_index = font.texture_index;
+					const XMFLOAT4 bounds = ComputeBounds(vertices, status.quadCount * 4, transform);
+					wi::image::DrawTextBatched(&PSO_batched[params.isDepthTestEnabled()], instance, vertices, status.quadCount, bounds, cmd);
+				}
+				else
+				{
+					XMStoreFloat4x4(&font.transform, transform);
+					device->BindDynamicConstantBuffer(font, CBSLOT_FONT, cmd);
+					device->DrawInstanced(4, status.quadCount, 0, 0, cmd);
+					draw_statistics.texts++;
+					draw_statistics.constant_buffer_binds++;
+					draw_statistics.gpu_allocations++;
+					draw_statistics.draw_calls++;
+				}
+			};
 
 			using namespace wi::math;
 			XMFLOAT4 color = XMFLOAT4(1, 1, 1, 1);
@@ -654,7 +1029,6 @@ namespace wi::font
 			if (params.shadowColor.getA() > 0)
 			{
 				// font shadow render:
-				XMStoreFloat4x4(&font.transform, XMMatrixTranslation(params.shadow_offset_x, params.shadow_offset_y, 0) * M);
 				color = params.shadowColor;
 				color.x *= params.shadow_intensity;
 				color.y *= params.shadow_intensity;
@@ -664,13 +1038,10 @@ namespace wi::font
 				softness = params.shadow_softness * 0.5f;
 				font.softness_bolden_hdrscaling = pack_half3(softness, bolden, hdr_scaling);
 				font.softness_bolden_hdrscaling.y |= flags << 16u;
-				device->BindDynamicConstantBuffer(font, CBSLOT_FONT, cmd);
-
-				device->DrawInstanced(4, status.quadCount, 0, 0, cmd);
+				draw(XMMatrixTranslation(params.shadow_offset_x, params.shadow_offset_y, 0) * M);
 			}
 
 			// font base render:
-			XMStoreFloat4x4(&font.transform, M);
 			color = params.color;
 			color.x *= params.intensity;
 			color.y *= params.intensity;
@@ -680,11 +1051,13 @@ namespace wi::font
 			softness = params.softness * 0.5f;
 			font.softness_bolden_hdrscaling = pack_half3(softness, bolden, hdr_scaling);
 			font.softness_bolden_hdrscaling.y |= flags << 16u;
-			device->BindDynamicConstantBuffer(font, CBSLOT_FONT, cmd);
-
-			device->DrawInstanced(4, status.quadCount, 0, 0, cmd);
+			draw(M);
 
-			device->EventEnd(cmd);
+			if (!batched)
+			{
+				device->EventEnd(cmd);
+			}
+			wi::image::AddDrawStatistics(draw_statistics);
 		}
 
 		return status.cursor;
@@ -726,7 +1099,7 @@ namespace wi::font
 		{
 			return XMFLOAT2(0, 0);
 		}
-		return ParseText(text, text_length, params).cursor.size;
+		return LayoutText(text, text_length, params).cursor.size;
 	}
 	XMFLOAT2 TextSize(const wchar_t* text, size_t text_length, const Params& params)
 	{
@@ -734,7 +1107,7 @@ namespace wi::font
 		{
 			return XMFLOAT2(0, 0);
 		}
-		return ParseText(text, text_length, params).cursor.size;
+		return LayoutText(text, text_length, params).cursor.size;
 	}
 	XMFLOAT2 TextSize(const char* text, const Params& params)
 	{
@@ -743,7 +1116,7 @@ namespace wi::font
 		{
 			return XMFLOAT2(0, 0);
 		}
-		return ParseText(text, text_length, params).cursor.size;
+		return LayoutText(text, text_length, params).cursor.size;
 	}
 	XMFLOAT2 TextSize(const wchar_t* text, const Params& params)
 	{
@@ -752,7 +1125,7 @@ namespace wi::font
 		{
 			return XMFLOAT2(0, 0);
 		}
-		return ParseText(text, text_length, params).cursor.size;
+		return LayoutText(text, text_length, params).cursor.size;
 	}
 	XMFLOAT2 TextSize(const std::string& text, const Params& params)
 	{
@@ -760,7 +1133,7 @@ namespace wi::font
 		{
 			return XMFLOAT2(0, 0);
 		}
-		return ParseText(text.c_str(), text.length(), params).cursor.size;
+		return LayoutText(text.c_str(), text.length(), params).cursor.size;
 	}
 	XMFLOAT2 TextSize(const std::wstring& text, const Params& params)
 	{
@@ -768,7 +1141,7 @@ namespace wi::font
 		{
 			return XMFLOAT2(0, 0);
 		}
-		return ParseText(text.c_str(), text.length(), params).cursor.size;
+		return LayoutText(text.c_str(), text.length(), params).cursor.size;
 	}
 
 	Cursor TextCursor(const char* text, size_t text_length, const Params& params)
@@ -777,7 +1150,7 @@ namespace wi::font
 		{
 			return {};
 		}
-		return ParseText(text, text_length, params).cursor;
+		return LayoutText(text, text_length, params).cursor;
 	}
 	Cursor TextCursor(const wchar_t* text, size_t text_length, const Params& params)
 	{
@@ -785,7 +1158,7 @@ namespace wi::font
 		{
 			return {};
 		}
-		return ParseText(text, text_length, params).cursor;
+		return LayoutText(text, text_length, params).cursor;
 	}
 	Cursor TextCursor(const char* text, const Params& params)
 	{
@@ -794,7 +1167,7 @@ namespace wi::font
 		{
 			return {};
 		}
-		return ParseText(text, text_length, params).cursor;
+		return LayoutText(text, text_length, params).cursor;
 	}
 	Cursor TextCursor(const wchar_t* text, const Params& params)
 	{
@@ -803,7 +1176,7 @@ namespace wi::font
 		{
 			return {};
 		}
-		return ParseText(text, text_length, params).cursor;
+		return LayoutText(text, text_length, params).cursor;
 	}
 	Cursor TextCursor(const std::string& text, const Params& params)
 	{
@@ -811,7 +1184,7 @@ namespace wi::font
 		{
 			return {};
 		}
-		return ParseText(text.c_str(), text.length(), params).cursor;
+		return LayoutText(text.c_str(), text.length(), params).cursor;
 	}
 	Cursor TextCursor(const std::wstring& text, const Params& params)
 	{
@@ -819,7 +1192,7 @@ namespace wi::font
 		{
 			return {};
 		}
-		return ParseText(text.c_str(), text.length(), params).cursor;
+		return LayoutText(text.c_str(), text.length(), params).cursor;
 	}
 
 	float TextWidth(const char* text, size_t text_length, const Params& params)
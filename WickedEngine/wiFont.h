@@ -160,8 +160,40 @@ namespace wi::font
 	void SetCanvas(const wi::Canvas& current_canvas);
 	// Call once per frame to update font atlas texture
 	//	upscaling : this should be the DPI upscaling factor, otherwise there will be no upscaling. Upscaling will cause glyphs to be cached at higher resolution.
+	//	The new glyphs are rendered in parallel with the job system and packed into the free space of the atlas, so only their rectangles are uploaded.
+	//	The whole atlas is only repacked and uploaded when it is full.
 	void UpdateAtlas(float upscaling = 1.0f);
 
+	struct AtlasStatistics
+	{
+		uint32_t glyph_count = 0; // number of glyphs in the atlas
+		uint32_t atlas_width = 0;
+		uint32_t atlas_height = 0;
+		uint32_t rendered_glyphs = 0; // number of new glyphs rendered by the last update
+		uint32_t uploaded_rects = 0; // number of glyph rectangles uploaded by the last update
+		size_t uploaded_bytes = 0; // size of the texture data uploaded by the last update
+		bool repacked = false; // whether the last update had to repack and upload the whole atlas
+		uint32_t repack_count = 0; // total number of whole atlas repacks
+		float update_time = 0; // time of the last update in milliseconds
+	};
+	// Returns the statistics of the last UpdateAtlas() that had new glyphs
+	AtlasStatistics GetAtlasStatistics();
+
+	// Enable/disable the text layout cache (enabled by default)
+	//	When enabled, the glyph quads of a text are reused by Draw(), TextSize(), etc. while the text and its layout parameters don't change,
+	//	so static texts that are drawn every frame don't need to be laid out every frame. Position, alignment, color and such are not part of the layout.
+	//	The layouts are cached per thread and are removed when they were not used for a few frames.
+	void SetLayoutCacheEnabled(bool value);
+	bool IsLayoutCacheEnabled();
+
+	struct LayoutCacheStatistics
+	{
+		uint64_t hits = 0; // number of texts that reused a cached layout
+		uint64_t misses = 0; // number of texts that had to be laid out
+	};
+	// Returns the total layout cache hits and misses since startup
+	LayoutCacheStatistics GetLayoutCacheStatistics();
+
 	// Draw text with specified parameters and return cursor for last word
 	//	The next Draw() can continue from where this left off by using the return value of this function
 	//	in wi::font::Params::cursor
@@ -139,20 +139,28 @@ namespace wi::gui
 		GraphicsDevice* device = wi::graphics::GetDevice();
 
 		device->EventBegin("GUI", cmd);
+		if (batching)
+		{
+			wi::image::BeginBatch(cmd);
+		}
 		// Rendering is back to front:
 		for (size_t i = 0; i < widgets.size(); ++i)
 		{
 			const Widget* widget = widgets[widgets.size() - i - 1];
-			device->BindScissorRects(1, &scissorRect, cmd);
+			wi::image::BindScissorRect(scissorRect, cmd);
 			widget->Render(canvas, cmd);
 		}
 
-		device->BindScissorRects(1, &scissorRect, cmd);
+		wi::image::BindScissorRect(scissorRect, cmd);
 		for (auto& x : widgets)
 		{
 			x->RenderTooltip(canvas, cmd);
 		}
 
+		if (batching)
+		{
+			wi::image::EndBatch(cmd);
+		}
 		device->EventEnd(cmd);
 
 		wi::profiler::EndRange(range_cpu);
@@ -769,13 +777,12 @@ namespace wi::gui
 			scissor.top = scissor.bottom;
 		}
 
-		GraphicsDevice* device = wi::graphics::GetDevice();
 		float scale = canvas.GetDPIScaling();
 		scissor.bottom = int32_t((float)scissor.bottom * scale);
 		scissor.top = int32_t((float)scissor.top * scale);
 		scissor.left = int32_t((float)scissor.left * scale);
 		scissor.right = int32_t((float)scissor.right * scale);
-		device->BindScissorRects(1, &scissor, cmd);
+		wi::image::BindScissorRect(scissor, cmd);
 	}
 	Hitbox2D Widget::GetPointerHitbox(bool constrained) const
 	{
@@ -2946,6 +2953,7 @@ namespace wi::gui
 
 			// control-arrow-triangle
 			{
+				wi::image::FlushBatch(cmd); // custom draws can't be batched
 				device->BindPipelineState(&gui_internal().PSO_colored, cmd);
 
 				MiscCB cb;
@@ -4987,6 +4995,7 @@ namespace wi::gui
 
 		const XMMATRIX Projection = canvas.GetProjection();
 
+		wi::image::FlushBatch(cmd); // custom draws can't be batched
 		device->BindPipelineState(&gui_internal().PSO_colored, cmd);
 
 		ApplyScissor(canvas, scissorRect, cmd);
@@ -5744,6 +5753,7 @@ namespace wi::gui
 			// opened flag triangle:
 			if(DoesItemHaveChildren(i))
 			{
+				wi::image::FlushBatch(cmd); // custom draws can't be batched
 				device->BindPipelineState(&gui_internal().PSO_colored, cmd);
 
 				MiscCB cb;
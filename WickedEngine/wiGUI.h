@@ -234,6 +234,7 @@ namespace wi::gui
 		wi::vector<Widget*> widgets;
 		bool focus = false;
 		bool visible = true;
+		bool batching = false;
 	public:
 
 		void Update(const wi::Canvas& canvas, float dt);
@@ -251,6 +252,11 @@ namespace wi::gui
 		void SetVisible(bool value) { visible = value; }
 		bool IsVisible() const { return visible; }
 
+		// Batching merges the widget draws into fewer draw calls with wi::image::BeginBatch()/EndBatch() (default: disabled)
+		//	Widgets that record their own rendering commands must call wi::image::FlushBatch() before them
+		void SetBatchingEnabled(bool value) { batching = value; }
+		bool IsBatchingEnabled() const { return batching; }
+
 		void SetColor(wi::Color color, int id = -1);
 		void SetImage(wi::Resource resource, int id = -1);
 		void SetShadowColor(wi::Color color);
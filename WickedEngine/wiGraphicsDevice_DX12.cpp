@@ -6922,6 +6922,11 @@ std::mutex queue_locker;
 		UINT dstPlane = dst_aspect == ImageAspect::STENCIL ? 1 : 0;
 		CD3DX12_TEXTURE_COPY_LOCATION src_location(src_internal->resource.Get(), D3D12CalcSubresource(srcMip, srcSlice, srcPlane, src->desc.mip_levels, src->desc.array_size));
 		CD3DX12_TEXTURE_COPY_LOCATION dst_location(dst_internal->resource.Get(), D3D12CalcSubresource(dstMip, dstSlice, dstPlane, dst->desc.mip_levels, dst->desc.array_size));
+		if (src->desc.usage == Usage::UPLOAD)
+		{
+			// Upload textures are buffers, the source is addressed by its placed footprint:
+			src_location = CD3DX12_TEXTURE_COPY_LOCATION(src_internal->resource.Get(), src_internal->footprints[srcSlice * src->desc.mip_levels + srcMip]);
+		}
 		if (srcbox == nullptr)
 		{
 			commandlist.GetGraphicsCommandList()->CopyTextureRegion(
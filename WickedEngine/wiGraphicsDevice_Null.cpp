@@ -0,0 +1,444 @@
+#include "wiGraphicsDevice_Null.h"
+#include "wiBacklog.h"
+
+#include <cstring>
+
+namespace wi::graphics
+{
+
+namespace null_internal
+{
+	struct Resource_Null
+	{
+		std::shared_ptr<std::atomic<uint64_t>> allocated_memory;
+		uint64_t allocated_size = 0;
+		int descriptor = -1;
+		int subresource_count = 0;
+		wi::vector<uint8_t> mapped_memory; // only for CPU accessible resources
+		wi::vector<SubresourceData> mapped_subresources; // only for CPU accessible textures
+
+		~Resource_Null()
+		{
+			if (allocated_memory != nullptr)
+			{
+				allocated_memory->fetch_sub(allocated_size);
+			}
+		}
+	};
+	struct Sampler_Null
+	{
+		int descriptor = -1;
+	};
+	struct SwapChain_Null
+	{
+		Texture backbuffer;
+	};
+
+	Resource_Null* to_internal(const GPUResource* param)
+	{
+		return static_cast<Resource_Null*>(param->internal_state.get());
+	}
+	Sampler_Null* to_internal(const Sampler* param)
+	{
+		return static_cast<Sampler_Null*>(param->internal_state.get());
+	}
+	SwapChain_Null* to_internal(const SwapChain* param)
+	{
+		return static_cast<SwapChain_Null*>(param->internal_state.get());
+	}
+}
+using namespace null_internal;
+
+	GraphicsDevice_Null::GraphicsDevice_Null(ValidationMode validationMode_)
+	{
+		validationMode = validationMode_;
+		adapterName = "Null";
+		driverDescription = "Null graphics device, no GPU work is performed";
+		adapterType = AdapterType::Cpu;
+		TIMESTAMP_FREQUENCY = 1;
+		allocated_memory = std::make_shared<std::atomic<uint64_t>>(0ull);
+
+		wilog("Created GraphicsDevice_Null");
+	}
+
+	bool GraphicsDevice_Null::CreateSwapChain(const SwapChainDesc* desc, wi::platform::window_type window, SwapChain* swapchain) const
+	{
+		auto internal_state = std::static_pointer_cast<SwapChain_Null>(swapchain->internal_state);
+		if (swapchain->internal_state == nullptr)
+		{
+			internal_state = std::make_shared<SwapChain_Null>();
+		}
+		swapchain->internal_state = internal_state;
+		swapchain->desc = *desc;
+
+		TextureDesc texturedesc;
+		texturedesc.width = desc->width;
+		texturedesc.height = desc->height;
+		texturedesc.format = desc->format;
+		texturedesc.bind_flags = BindFlag::RENDER_TARGET;
+		texturedesc.layout = ResourceState::RENDERTARGET;
+		return CreateTexture(&texturedesc, nullptr, &internal_state->backbuffer);
+	}
+	bool GraphicsDevice_Null::CreateBuffer2(const GPUBufferDesc* desc, const std::function<void(void*)>& init_callback, GPUBuffer* buffer, const GPUResource* alias, uint64_t alias_offset) const
+	{
+		auto internal_state = std::make_shared<Resource_Null>();
+		internal_state->descriptor = descriptor_allocator.fetch_add(1);
+		buffer->internal_state = internal_state;
+		buffer->type = GPUResource::Type::BUFFER;
+		buffer->mapped_data = nullptr;
+		buffer->mapped_size = 0;
+		buffer->desc = *desc;
+
+		if (alias == nullptr)
+		{
+			internal_state->allocated_memory = allocated_memory;
+			internal_state->allocated_size = desc->size;
+			allocated_memory->fetch_add(desc->size);
+		}
+
+		if (desc->usage == Usage::UPLOAD || desc->usage == Usage::READBACK)
+		{
+			internal_state->mapped_memory.resize(desc->size);
+			buffer->mapped_data = internal_state->mapped_memory.data();
+			buffer->mapped_size = internal_state->mapped_memory.size();
+		}
+
+		if (init_callback != nullptr)
+		{
+			if (buffer->mapped_data != nullptr)
+			{
+				init_callback(buffer->mapped_data);
+			}
+			else
+			{
+				// The data is not kept for GPU-only buffers, but the callback is still performed like on a real device:
+				wi::vector<uint8_t> staging(desc->size);
+				init_callback(staging.data());
+			}
+		}
+
+		return true;
+	}
+	bool GraphicsDevice_Null::CreateTexture(const TextureDesc* desc, const SubresourceData* initial_data, Texture* texture, const GPUResource* alias, uint64_t alias_offset) const
+	{
+		auto internal_state = std::make_shared<Resource_Null>();
+		internal_state->descriptor = descriptor_allocator.fetch_add(1);
+		texture->internal_state = internal_state;
+		texture->type = GPUResource::Type::TEXTURE;
+		texture->mapped_data = nullptr;
+		texture->mapped_size = 0;
+		texture->mapped_subresources = nullptr;
+		texture->mapped_subresource_count = 0;
+		texture->sparse_properties = nullptr;
+		texture->desc = *desc;
+
+		if (texture->desc.mip_levels == 0)
+		{
+			texture->desc.mip_levels = GetMipCount(texture->desc.width, texture->desc.height, texture->desc.depth);
+		}
+
+		const size_t size = ComputeTextureMemorySizeInBytes(texture->desc);
+		if (alias == nullptr)
+		{
+			internal_state->allocated_memory = allocated_memory;
+			internal_state->allocated_size = size;
+			allocated_memory->fetch_add(size);
+		}
+
+		if (desc->usage == Usage::UPLOAD || desc->usage == Usage::READBACK)
+		{
+			internal_state->mapped_memory.resize(size);
+			texture->mapped_data = internal_state->mapped_memory.data();
+			texture->mapped_size = internal_state->mapped_memory.size();
+
+			// Linear tiling layout, in the order of slice0|mip0, slice0|mip1, ... sliceN|mipN:
+			const uint32_t bytes_per_block = GetFormatStride(texture->desc.format);
+			const uint32_t pixels_per_block = GetFormatBlockSize(texture->desc.format);
+			size_t offset = 0;
+			for (uint32_t layer = 0; layer < texture->desc.array_size; ++layer)
+			{
+				for (uint32_t mip = 0; mip < texture->desc.mip_levels; ++mip)
+				{
+					const uint32_t mip_width = std::max(1u, texture->desc.width >> mip);
+					const uint32_t mip_height = std::max(1u, texture->desc.height >> mip);
+					const uint32_t mip_depth = std::max(1u, texture->desc.depth >> mip);
+					const uint32_t num_blocks_x = (mip_width + pixels_per_block - 1) / pixels_per_block;
+					const uint32_t num_blocks_y = (mip_height + pixels_per_block - 1) / pixels_per_block;
+					SubresourceData& subresource = internal_state->mapped_subresources.emplace_back();
+					subresource.data_ptr = internal_state->mapped_memory.data() + offset;
+					subresource.row_pitch = num_blocks_x * bytes_per_block;
+					subresource.slice_pitch = subresource.row_pitch * num_blocks_y;
+					offset += size_t(subresource.slice_pitch) * mip_depth * texture->desc.sample_count;
+				}
+			}
+			texture->mapped_subresources = internal_state->mapped_subresources.data();
+			texture->mapped_subresource_count = internal_state->mapped_subresources.size();
+		}
+
+		return true;
+	}
+	bool GraphicsDevice_Null::CreateShader(ShaderStage stage, const void* shadercode, size_t shadercode_size, Shader* shader) const
+	{
+		shader->internal_state = std::make_shared<int>(0);
+		shader->stage = stage;
+		return true;
+	}
+	bool GraphicsDevice_Null::CreateSampler(const SamplerDesc* desc, Sampler* sampler) const
+	{
+		auto internal_state = std::make_shared<Sampler_Null>();
+		internal_state->descriptor = descriptor_allocator.fetch_add(1);
+		sampler->internal_state = internal_state;
+		sampler->desc = *desc;
+		return true;
+	}
+	bool GraphicsDevice_Null::CreateQueryHeap(const GPUQueryHeapDesc* desc, GPUQueryHeap* queryheap) const
+	{
+		queryheap->internal_state = std::make_shared<int>(0);
+		queryheap->desc = *desc;
+		return true;
+	}
+	bool GraphicsDevice_Null::CreatePipelineState(const PipelineStateDesc* desc, PipelineState* pso, const RenderPassInfo* renderpass_info) const
+	{
+		pso->internal_state = std::make_shared<int>(0);
+		pso->desc = *desc;
+		return true;
+	}
+	bool GraphicsDevice_Null::CreateRaytracingAccelerationStructure(const RaytracingAccelerationStructureDesc* desc, RaytracingAccelerationStructure* bvh) const
+	{
+		auto internal_state = std::make_shared<Resource_Null>();
+		internal_state->descriptor = descriptor_allocator.fetch_add(1);
+		bvh->internal_state = internal_state;
+		bvh->type = GPUResource::Type::RAYTRACING_ACCELERATION_STRUCTURE;
+		bvh->desc = *desc;
+		return true;
+	}
+	bool GraphicsDevice_Null::CreateRaytracingPipelineState(const RaytracingPipelineStateDesc* desc, RaytracingPipelineState* rtpso) const
+	{
+		rtpso->internal_state = std::make_shared<int>(0);
+		rtpso->desc = *desc;
+		return true;
+	}
+
+	int GraphicsDevice_Null::CreateSubresource(Texture* texture, SubresourceType type, uint32_t firstSlice, uint32_t sliceCount, uint32_t firstMip, uint32_t mipCount, const Format* format_change, const ImageAspect* aspect, const Swizzle* swizzle, float min_lod_clamp) const
+	{
+		if (!texture->IsValid())
+			return -1;
+		return to_internal(texture)->subresource_count++;
+	}
+	int GraphicsDevice_Null::CreateSubresource(GPUBuffer* buffer, SubresourceType type, uint64_t offset, uint64_t size, const Format* format_change, const uint32_t* structuredbuffer_stride_change) const
+	{
+		if (!buffer->IsValid())
+			return -1;
+		return to_internal(buffer)->subresource_count++;
+	}
+
+	void GraphicsDevice_Null::DeleteSubresources(GPUResource* resource)
+	{
+		if (!resource->IsValid())
+			return;
+		to_internal(resource)->subresource_count = 0;
+	}
+
+	int GraphicsDevice_Null::GetDescriptorIndex(const GPUResource* resource, SubresourceType type, int subresource) const
+	{
+		if (resource == nullptr || !resource->IsValid())
+			return -1;
+		return to_internal(resource)->descriptor;
+	}
+	int GraphicsDevice_Null::GetDescriptorIndex(const Sampler* sampler) const
+	{
+		if (sampler == nullptr || !sampler->IsValid())
+			return -1;
+		return to_internal(sampler)->descriptor;
+	}
+
+	CommandList GraphicsDevice_Null::BeginCommandList(QUEUE_TYPE queue)
+	{
+		cmd_locker.lock();
+		uint32_t cmd_current = cmd_count++;
+		if (cmd_current >= commandlists.size())
+		{
+			commandlists.push_back(std::make_unique<CommandList_Null>());
+		}
+		CommandList cmd;
+		cmd.internal_state = commandlists[cmd_current].get();
+		cmd_locker.unlock();
+
+		CommandList_Null& commandlist = GetCommandList(cmd);
+		commandlist.reset(GetBufferIndex());
+		commandlist.queue = queue;
+		commandlist.id = cmd_current;
+
+		return cmd;
+	}
+	void GraphicsDevice_Null::SubmitCommandLists()
+	{
+		frame_statistics = {};
+		for (uint32_t cmd = 0; cmd < cmd_count; ++cmd)
+		{
+			frame_statistics.add(commandlists[cmd]->statistics);
+		}
+		cmd_count = 0;
+		FRAMECOUNT++;
+	}
+
+	Texture GraphicsDevice_Null::GetBackBuffer(const SwapChain* swapchain) const
+	{
+		return to_internal(swapchain)->backbuffer;
+	}
+
+	void GraphicsDevice_Null::RenderPassBegin(const SwapChain* swapchain, CommandList cmd)
+	{
+		CommandList_Null& commandlist = GetCommandList(cmd);
+		commandlist.renderpass_info = RenderPassInfo::from(swapchain->desc);
+		commandlist.statistics.renderpasses++;
+	}
+	void GraphicsDevice_Null::RenderPassBegin(const RenderPassImage* images, uint32_t image_count, CommandList cmd, RenderPassFlags flags)
+	{
+		CommandList_Null& commandlist = GetCommandList(cmd);
+		commandlist.renderpass_info = RenderPassInfo::from(images, image_count);
+		commandlist.statistics.renderpasses++;
+	}
+	void GraphicsDevice_Null::RenderPassEnd(CommandList cmd)
+	{
+		GetCommandList(cmd).renderpass_info = {};
+	}
+	void GraphicsDevice_Null::BindResource(const GPUResource* resource, uint32_t slot, CommandList cmd, int subresource)
+	{
+		GetCommandList(cmd).statistics.resource_binds++;
+	}
+	void GraphicsDevice_Null::BindResources(const GPUResource* const* resources, uint32_t slot, uint32_t count, CommandList cmd)
+	{
+		GetCommandList(cmd).statistics.resource_binds += count;
+	}
+	void GraphicsDevice_Null::BindUAV(const GPUResource* resource, uint32_t slot, CommandList cmd, int subresource)
+	{
+		GetCommandList(cmd).statistics.resource_binds++;
+	}
+	void GraphicsDevice_Null::BindUAVs(const GPUResource* const* resources, uint32_t slot, uint32_t count, CommandList cmd)
+	{
+		GetCommandList(cmd).statistics.resource_binds += count;
+	}
+	void GraphicsDevice_Null::BindSampler(const Sampler* sampler, uint32_t slot, CommandList cmd)
+	{
+		GetCommandList(cmd).statistics.resource_binds++;
+	}
+	void GraphicsDevice_Null::BindConstantBuffer(const GPUBuffer* buffer, uint32_t slot, CommandList cmd, uint64_t offset)
+	{
+		GetCommandList(cmd).statistics.resource_binds++;
+	}
+	void GraphicsDevice_Null::BindVertexBuffers(const GPUBuffer* const* vertexBuffers, uint32_t slot, uint32_t count, const uint32_t* strides, const uint64_t* offsets, CommandList cmd)
+	{
+		GetCommandList(cmd).statistics.resource_binds += count;
+	}
+	void GraphicsDevice_Null::BindIndexBuffer(const GPUBuffer* indexBuffer, const IndexBufferFormat format, uint64_t offset, CommandList cmd)
+	{
+		GetCommandList(cmd).statistics.resource_binds++;
+	}
+	void GraphicsDevice_Null::BindPipelineState(const PipelineState* pso, CommandList cmd)
+	{
+		GetCommandList(cmd).statistics.pipeline_binds++;
+	}
+	void GraphicsDevice_Null::BindComputeShader(const Shader* cs, CommandList cmd)
+	{
+		GetCommandList(cmd).statistics.pipeline_binds++;
+	}
+	void GraphicsDevice_Null::Draw(uint32_t vertexCount, uint32_t startVertexLocation, CommandList cmd)
+	{
+		DrawInstanced(vertexCount, 1, startVertexLocation, 0, cmd);
+	}
+	void GraphicsDevice_Null::DrawIndexed(uint32_t indexCount, uint32_t startIndexLocation, int32_t baseVertexLocation, CommandList cmd)
+	{
+		DrawIndexedInstanced(indexCount, 1, startIndexLocation, baseVertexLocation, 0, cmd);
+	}
+	void GraphicsDevice_Null::DrawInstanced(uint32_t vertexCount, uint32_t instanceCount, uint32_t startVertexLocation, uint32_t startInstanceLocation, CommandList cmd)
+	{
+		Statistics& statistics = GetCommandList(cmd).statistics;
+		statistics.draws++;
+		statistics.vertices += uint64_t(vertexCount) * uint64_t(instanceCount);
+		statistics.instances += instanceCount;
+	}
+	void GraphicsDevice_Null::DrawIndexedInstanced(uint32_t indexCount, uint32_t instanceCount, uint32_t startIndexLocation, int32_t baseVertexLocation, uint32_t startInstanceLocation, CommandList cmd)
+	{
+		Statistics& statistics = GetCommandList(cmd).statistics;
+		statistics.draws++;
+		statistics.vertices += uint64_t(indexCount) * uint64_t(instanceCount);
+		statistics.instances += instanceCount;
+	}
+	void GraphicsDevice_Null::DrawInstancedIndirect(const GPUBuffer* args, uint64_t args_offset, CommandList cmd)
+	{
+		GetCommandList(cmd).statistics.draws++;
+	}
+	void GraphicsDevice_Null::DrawIndexedInstancedIndirect(const GPUBuffer* args, uint64_t args_offset, CommandList cmd)
+	{
+		GetCommandList(cmd).statistics.draws++;
+	}
+	void GraphicsDevice_Null::DrawInstancedIndirectCount(const GPUBuffer* args, uint64_t args_offset, const GPUBuffer* count, uint64_t count_offset, uint32_t max_count, CommandList cmd)
+	{
+		GetCommandList(cmd).statistics.draws++;
+	}
+	void GraphicsDevice_Null::DrawIndexedInstancedIndirectCount(const GPUBuffer* args, uint64_t args_offset, const GPUBuffer* count, uint64_t count_offset, uint32_t max_count, CommandList cmd)
+	{
+		GetCommandList(cmd).statistics.draws++;
+	}
+	void GraphicsDevice_Null::Dispatch(uint32_t threadGroupCountX, uint32_t threadGroupCountY, uint32_t threadGroupCountZ, CommandList cmd)
+	{
+		GetCommandList(cmd).statistics.dispatches++;
+	}
+	void GraphicsDevice_Null::DispatchIndirect(const GPUBuffer* args, uint64_t args_offset, CommandList cmd)
+	{
+		GetCommandList(cmd).statistics.dispatches++;
+	}
+	void GraphicsDevice_Null::DispatchMesh(uint32_t threadGroupCountX, uint32_t threadGroupCountY, uint32_t threadGroupCountZ, CommandList cmd)
+	{
+		GetCommandList(cmd).statistics.draws++;
+	}
+	void GraphicsDevice_Null::DispatchMeshIndirect(const GPUBuffer* args, uint64_t args_offset, CommandList cmd)
+	{
+		GetCommandList(cmd).statistics.draws++;
+	}
+	void GraphicsDevice_Null::DispatchMeshIndirectCount(const GPUBuffer* args, uint64_t args_offset, const GPUBuffer* count, uint64_t count_offset, uint32_t max_count, CommandList cmd)
+	{
+		GetCommandList(cmd).statistics.draws++;
+	}
+	void GraphicsDevice_Null::CopyResource(const GPUResource* pDst, const GPUResource* pSrc, CommandList cmd)
+	{
+		GetCommandList(cmd).statistics.copies++;
+
+		// CPU accessible resources are kept in memory, so copies between them are performed:
+		if (pDst->mapped_data != nullptr && pSrc->mapped_data != nullptr)
+		{
+			std::memcpy(pDst->mapped_data, pSrc->mapped_data, std::min(pDst->mapped_size, pSrc->mapped_size));
+		}
+	}
+	void GraphicsDevice_Null::CopyBuffer(const GPUBuffer* pDst, uint64_t dst_offset, const GPUBuffer* pSrc, uint64_t src_offset, uint64_t size, CommandList cmd)
+	{
+		GetCommandList(cmd).statistics.copies++;
+
+		if (pDst->mapped_data != nullptr && pSrc->mapped_data != nullptr)
+		{
+			std::memcpy((uint8_t*)pDst->mapped_data + dst_offset, (const uint8_t*)pSrc->mapped_data + src_offset, size);
+		}
+	}
+	void GraphicsDevice_Null::CopyTexture(const Texture* dst, uint32_t dstX, uint32_t dstY, uint32_t dstZ, uint32_t dstMip, uint32_t dstSlice, const Texture* src, uint32_t srcMip, uint32_t srcSlice, CommandList cmd, const Box* srcbox, ImageAspect dst_aspect, ImageAspect src_aspect)
+	{
+		GetCommandList(cmd).statistics.copies++;
+	}
+	void GraphicsDevice_Null::Barrier(const GPUBarrier* barriers, uint32_t numBarriers, CommandList cmd)
+	{
+		GetCommandList(cmd).statistics.barriers += numBarriers;
+	}
+	void GraphicsDevice_Null::BindRaytracingPipelineState(const RaytracingPipelineState* rtpso, CommandList cmd)
+	{
+		GetCommandList(cmd).statistics.pipeline_binds++;
+	}
+	void GraphicsDevice_Null::DispatchRays(const DispatchRaysDesc* desc, CommandList cmd)
+	{
+		GetCommandList(cmd).statistics.dispatches++;
+	}
+	void GraphicsDevice_Null::PushConstants(const void* data, uint32_t size, CommandList cmd, uint32_t offset)
+	{
+		GetCommandList(cmd).statistics.push_constants++;
+	}
+
+}
@@ -8818,6 +8818,51 @@ using namespace vulkan_internal;
 		auto src_internal = to_internal(src);
 		auto dst_internal = to_internal(dst);
 
+		if (src->desc.usage == Usage::UPLOAD)
+		{
+			// Upload textures are tightly packed buffers, the source region is copied from the buffer:
+			const SubresourceData& subresource = src_internal->mapped_subresources[srcSlice * src->desc.mip_levels + srcMip];
+			const uint32_t data_stride = GetFormatStride(src->desc.format);
+			const uint32_t block_size = GetFormatBlockSize(src->desc.format);
+
+			VkBufferImageCopy copy = {};
+			copy.bufferOffset = VkDeviceSize((const uint8_t*)subresource.data_ptr - (const uint8_t*)src->mapped_data);
+			copy.bufferRowLength = subresource.row_pitch / data_stride * block_size;
+			copy.bufferImageHeight = 0;
+			copy.imageSubresource.aspectMask = _ConvertImageAspect(dst_aspect);
+			copy.imageSubresource.baseArrayLayer = dstSlice;
+			copy.imageSubresource.layerCount = 1;
+			copy.imageSubresource.mipLevel = dstMip;
+			copy.imageOffset.x = dstX;
+			copy.imageOffset.y = dstY;
+			copy.imageOffset.z = dstZ;
+			if (srcbox == nullptr)
+			{
+				copy.imageExtent.width = std::max(1u, std::min(dst->desc.width, src->desc.width) >> srcMip);
+				copy.imageExtent.height = std::max(1u, std::min(dst->desc.height, src->desc.height) >> srcMip);
+				copy.imageExtent.depth = std::max(1u, std::min(dst->desc.depth, src->desc.depth) >> srcMip);
+			}
+			else
+			{
+				copy.bufferOffset += srcbox->front * subresource.slice_pitch;
+				copy.bufferOffset += srcbox->top / block_size * subresource.row_pitch;
+				copy.bufferOffset += srcbox->left / block_size * data_stride;
+				copy.imageExtent.width = srcbox->right - srcbox->left;
+				copy.imageExtent.height = srcbox->bottom - srcbox->top;
+				copy.imageExtent.depth = srcbox->back - srcbox->front;
+			}
+
+			vkCmdCopyBufferToImage(
+				commandlist.GetCommandBuffer(),
+				src_internal->staging_resource,
+				dst_internal->resource,
+				_ConvertImageLayout(ResourceState::COPY_DST),
+				1,
+				&copy
+			);
+			return;
+		}
+
 		VkImageCopy copy = {};
 		copy.dstSubresource.aspectMask = _ConvertImageAspect(dst_aspect);
 		copy.dstSubresource.baseArrayLayer = dstSlice;
@@ -11,6 +11,7 @@
 #include "wiBacklog.h"
 #include "wiEventHandler.h"
 #include "wiTimer.h"
+#include "wiJobSystem.h"
 
 using namespace wi::primitive;
 using namespace wi::graphics;
@@ -65,26 +66,71 @@ namespace wi
 			std::fill(vertex_lengths.begin(), vertex_lengths.end(), 1.0f);
 		}
 
-		indices.clear();
+		// The triangles are culled in parallel groups. Each group writes its triangles after the ones of the previous groups,
+		//	so the result is exactly the same as if the triangles were processed in order on one thread:
+		struct TriangleGroup
+		{
+			uint32_t indexOffset = 0;
+			uint32_t indexCount = 0;
+			uint32_t outputOffset = 0;
+			uint32_t outputCount = 0;
+		};
+		constexpr uint32_t group_index_count = 3 * 4096;
+		wi::vector<TriangleGroup> groups;
 		uint32_t first_subset = 0;
 		uint32_t last_subset = 0;
 		mesh.GetLODSubsetRange(0, first_subset, last_subset);
 		for (uint32_t subsetIndex = first_subset; subsetIndex < last_subset; ++subsetIndex)
 		{
 			const MeshComponent::MeshSubset& subset = mesh.subsets[subsetIndex];
-			for (size_t i = 0; i < subset.indexCount; i += 3)
+			for (uint32_t offset = 0; offset < subset.indexCount; offset += group_index_count)
 			{
-				const uint32_t i0 = mesh.indices[subset.indexOffset + i + 0];
-				const uint32_t i1 = mesh.indices[subset.indexOffset + i + 1];
-				const uint32_t i2 = mesh.indices[subset.indexOffset + i + 2];
-				if (vertex_lengths[i0] > 0 || vertex_lengths[i1] > 0 || vertex_lengths[i2] > 0)
+				TriangleGroup& group = groups.emplace_back();
+				group.indexOffset = subset.indexOffset + offset;
+				group.indexCount = std::min(group_index_count, subset.indexCount - offset);
+			}
+		}
+
+		auto is_triangle_used = [&](const uint32_t* tri) {
+			return vertex_lengths[tri[0]] > 0 || vertex_lengths[tri[1]] > 0 || vertex_lengths[tri[2]] > 0;
+		};
+
+		wi::jobsystem::context ctx;
+		wi::jobsystem::Dispatch(ctx, (uint32_t)groups.size(), 1, [&](wi::jobsystem::JobArgs args) {
+			TriangleGroup& group = groups[args.jobIndex];
+			for (uint32_t i = 0; i < group.indexCount; i += 3)
+			{
+				if (is_triangle_used(&mesh.indices[group.indexOffset + i]))
 				{
-					indices.push_back(i0);
-					indices.push_back(i1);
-					indices.push_back(i2);
+					group.outputCount += 3;
 				}
 			}
+		});
+		wi::jobsystem::Wait(ctx);
+
+		uint32_t index_count = 0;
+		for (auto& group : groups)
+		{
+			group.outputOffset = index_count;
+			index_count += group.outputCount;
 		}
+		indices.resize(index_count);
+
+		wi::jobsystem::Dispatch(ctx, (uint32_t)groups.size(), 1, [&](wi::jobsystem::JobArgs args) {
+			const TriangleGroup& group = groups[args.jobIndex];
+			uint32_t* dest = indices.data() + group.outputOffset;
+			for (uint32_t i = 0; i < group.indexCount; i += 3)
+			{
+				const uint32_t* tri = &mesh.indices[group.indexOffset + i];
+				if (is_triangle_used(tri))
+				{
+					*dest++ = tri[0];
+					*dest++ = tri[1];
+					*dest++ = tri[2];
+				}
+			}
+		});
+		wi::jobsystem::Wait(ctx);
 
 		_flags |= REBUILD_BUFFERS;
 	}
@@ -3,10 +3,14 @@
 #include "wiRenderer.h"
 #include "wiHelper.h"
 #include "shaders/ShaderInterop_Image.h"
+#include "shaders/ShaderInterop_Font.h"
 #include "wiBacklog.h"
 #include "wiEventHandler.h"
 #include "wiTimer.h"
 #include "wiInput.h"
+#include "wiVector.h"
+
+#include <algorithm>
 
 using namespace wi::enums;
 using namespace wi::graphics;
@@ -32,9 +36,391 @@ namespace wi::image
 		STRIP_MODE_COUNT,
 	};
 	static PipelineState imagePSO[BLENDMODE_COUNT][STENCILMODE_COUNT][STENCILREFMODE_COUNT][DEPTH_TEST_MODE_COUNT][STRIP_MODE_COUNT];
+	static Shader vertexShader_batched;
+	static Shader pixelShader_batched;
+	static PipelineState imagePSO_batched[BLENDMODE_COUNT][STENCILMODE_COUNT][STENCILREFMODE_COUNT][DEPTH_TEST_MODE_COUNT];
 	static thread_local Texture backgroundTexture;
 	static thread_local wi::Canvas canvas;
 
+	// The draws that are collected between BeginBatch() and EndBatch() on the current thread:
+	struct Batch
+	{
+		struct Image
+		{
+			ImageConstants constants;
+			const PipelineState* pso = nullptr;
+			uint32_t stencilRef = 0;
+			uint32_t vertex_offset = 0; // into vertices
+			uint32_t vertex_count = 0;
+			uint32_t index_offset = 0; // into indices
+			uint32_t index_count = 0;
+			Rect scissor;
+		};
+		struct Text
+		{
+			FontBatchInstance instance;
+			const PipelineState* pso = nullptr;
+			uint32_t glyph_offset = 0; // into text_vertices, in quads
+			uint32_t glyph_count = 0;
+			Rect scissor;
+		};
+		// The items are sorted into layers, the items of a layer don't overlap each other, so they can be drawn in any order
+		struct Item
+		{
+			XMFLOAT4 bounds = {}; // clip space min x, min y, max x, max y
+			uint32_t layer = 0;
+			uint32_t index = 0; // into images or texts
+			bool text = false;
+		};
+		struct MergedDraw
+		{
+			uint32_t item = 0; // the first item of the draw
+			uint32_t start = 0; // first index of images or first glyph of texts
+			uint32_t count = 0; // index count of images or glyph count of texts
+		};
+
+		CommandList cmd;
+		bool active = false;
+		bool scissor_valid = false; // whether the scissor was set with BindScissorRect()
+		Rect scissor;
+		wi::vector<Image> images;
+		wi::vector<Text> texts;
+		wi::vector<Item> items;
+		uint32_t layer_count = 0;
+		// Screen space grid of the items, to only test overlap with the items that are nearby:
+		struct Cell
+		{
+			XMFLOAT4 bounds;
+			uint32_t layer;
+		};
+		static constexpr int grid_size = 32;
+		wi::vector<Cell> grid[grid_size * grid_size];
+		wi::vector<float4> vertices;
+		wi::vector<uint16_t> indices;
+		wi::vector<FontVertex> text_vertices;
+		wi::vector<uint32_t> order;
+		wi::vector<MergedDraw> draws;
+	};
+	static thread_local Batch batch;
+	static thread_local DrawStatistics statistics;
+
+	inline bool IsBatchActive(CommandList cmd)
+	{
+		return batch.active && batch.cmd.internal_state == cmd.internal_state;
+	}
+
+	constexpr bool BoundsOverlap(const XMFLOAT4& a, const XMFLOAT4& b)
+	{
+		return a.x < b.z && b.x < a.z && a.y < b.w && b.y < a.w;
+	}
+
+	// Packs the scissor rect for the clipping in the batched shaders
+	void PackScissor(const Rect& scissor, uint32_t& clip_lefttop, uint32_t& clip_rightbottom)
+	{
+		if (!batch.scissor_valid)
+		{
+			clip_lefttop = 0;
+			clip_rightbottom = 0xFFFFFFFF;
+			return;
+		}
+		clip_lefttop = uint32_t(std::clamp(scissor.left, 0, 0xFFFF)) | (uint32_t(std::clamp(scissor.top, 0, 0xFFFF)) << 16u);
+		clip_rightbottom = uint32_t(std::clamp(scissor.right, 0, 0xFFFF)) | (uint32_t(std::clamp(scissor.bottom, 0, 0xFFFF)) << 16u);
+	}
+
+	// Adds a draw to the batch, into the layer above the highest layer that it overlaps
+	void AddBatchItem(const XMFLOAT4& bounds, uint32_t index, bool text)
+	{
+		Batch::Item item;
+		item.bounds = bounds;
+		item.index = index;
+		item.text = text;
+		item.layer = 0;
+
+		auto cell = [](float x) {
+			return std::clamp(int((x * 0.5f + 0.5f) * Batch::grid_size), 0, Batch::grid_size - 1);
+		};
+		const int cell_min_x = cell(bounds.x);
+		const int cell_min_y = cell(bounds.y);
+		const int cell_max_x = cell(bounds.z);
+		const int cell_max_y = cell(bounds.w);
+		for (int y = cell_min_y; y <= cell_max_y; ++y)
+		{
+			for (int x = cell_min_x; x <= cell_max_x; ++x)
+			{
+				for (const Batch::Cell& other : batch.grid[x + y * Batch::grid_size])
+				{
+					if (other.layer >= item.layer && BoundsOverlap(other.bounds, bounds))
+					{
+						item.layer = other.layer + 1;
+					}
+				}
+			}
+		}
+
+		for (int y = cell_min_y; y <= cell_max_y; ++y)
+		{
+			for (int x = cell_min_x; x <= cell_max_x; ++x)
+			{
+				batch.grid[x + y * Batch::grid_size].push_back({ bounds, item.layer });
+			}
+		}
+		batch.layer_count = std::max(batch.layer_count, item.layer + 1);
+		batch.items.push_back(item);
+	}
+
+	// Removes the collected draws of the batch
+	void ClearBatch()
+	{
+		batch.images.clear();
+		batch.texts.clear();
+		batch.items.clear();
+		batch.vertices.clear();
+		batch.indices.clear();
+		batch.text_vertices.clear();
+		batch.layer_count = 0;
+		for (auto& cell : batch.grid)
+		{
+			cell.clear();
+		}
+	}
+
+	// Draws all the collected draws of the batch
+	void DrawBatch(CommandList cmd)
+	{
+		if (batch.items.empty())
+			return;
+
+		GraphicsDevice* device = wi::graphics::GetDevice();
+
+		// Order the items by layer, and inside the layers the items with the same pipeline and texture are next to each other:
+		batch.order.resize(batch.items.size());
+		for (uint32_t i = 0; i < (uint32_t)batch.order.size(); ++i)
+		{
+			batch.order[i] = i;
+		}
+		std::sort(batch.order.begin(), batch.order.end(), [](uint32_t a, uint32_t b) {
+			const Batch::Item& item_a = batch.items[a];
+			const Batch::Item& item_b = batch.items[b];
+			if (item_a.layer != item_b.layer)
+				return item_a.layer < item_b.layer;
+			if (item_a.text != item_b.text)
+				return item_a.text < item_b.text;
+			if (item_a.text)
+			{
+				const Batch::Text& text_a = batch.texts[item_a.index];
+				const Batch::Text& text_b = batch.texts[item_b.index];
+				if (text_a.pso != text_b.pso)
+					return text_a.pso < text_b.pso;
+				if (text_a.instance.texture_index != text_b.instance.texture_index)
+					return text_a.instance.texture_index < text_b.instance.texture_index;
+				return a < b;
+			}
+			const Batch::Image& image_a = batch.images[item_a.index];
+			const Batch::Image& image_b = batch.images[item_b.index];
+			if (image_a.pso != image_b.pso)
+				return image_a.pso < image_b.pso;
+			if (image_a.stencilRef != image_b.stencilRef)
+				return image_a.stencilRef < image_b.stencilRef;
+			if (image_a.constants.texture_base_index != image_b.constants.texture_base_index)
+				return image_a.constants.texture_base_index < image_b.constants.texture_base_index;
+			return a < b;
+		});
+
+		// All batched draws are written into one allocation:
+		//	images: ImageConstants[images] | ImageBatchVertex[vertices] | uint32_t[indices]
+		//	texts: FontBatchInstance[texts] | uint32_t[glyphs] (glyph -> text) | FontVertex[glyphs * 4]
+		uint32_t vertex_count = 0;
+		uint32_t index_count = 0;
+		for (auto& image : batch.images)
+		{
+			vertex_count += image.vertex_count;
+			index_count += image.index_count;
+		}
+		const uint32_t glyph_count = uint32_t(batch.text_vertices.size() / 4);
+		const uint64_t instances_size = sizeof(ImageConstants) * batch.images.size();
+		const uint64_t vertices_size = sizeof(ImageBatchVertex) * vertex_count;
+		const uint64_t indices_size = sizeof(uint32_t) * index_count;
+		const uint64_t images_size = AlignTo(instances_size + vertices_size + indices_size, uint64_t(16));
+		const uint64_t text_instances_size = sizeof(FontBatchInstance) * batch.texts.size();
+		const uint64_t glyphs_size = sizeof(uint32_t) * glyph_count;
+		const uint64_t text_vertices_size = sizeof(FontVertex) * glyph_count * 4;
+		GraphicsDevice::GPUAllocation mem = device->AllocateGPU(images_size + text_instances_size + glyphs_size + text_vertices_size, cmd);
+		statistics.gpu_allocations++;
+		if (!mem.IsValid())
+		{
+			ClearBatch();
+			return;
+		}
+		ImageBatchConstants image_cb = {};
+		FontBatchConstants text_cb = {};
+		image_cb.buffer_index = device->GetDescriptorIndex(&mem.buffer, SubresourceType::SRV);
+		image_cb.instance_offset = (uint)mem.offset;
+		image_cb.vertex_offset = (uint)(mem.offset + instances_size);
+		text_cb.buffer_index = image_cb.buffer_index;
+		text_cb.instance_offset = (uint)(mem.offset + images_size);
+		text_cb.glyph_offset = (uint)(text_cb.instance_offset + text_instances_size);
+		text_cb.vertex_offset = (uint)(text_cb.glyph_offset + glyphs_size);
+		ImageConstants* dst_instances = (ImageConstants*)mem.data;
+		ImageBatchVertex* dst_vertices = (ImageBatchVertex*)((uint8_t*)mem.data + instances_size);
+		uint32_t* dst_indices = (uint32_t*)((uint8_t*)mem.data + instances_size + vertices_size);
+		FontBatchInstance* dst_text_instances = (FontBatchInstance*)((uint8_t*)mem.data + images_size);
+		uint32_t* dst_glyphs = (uint32_t*)((uint8_t*)dst_text_instances + text_instances_size);
+		FontVertex* dst_text_vertices = (FontVertex*)((uint8_t*)dst_glyphs + glyphs_size);
+
+		// The consecutive draws with the same pipeline state are merged into one draw:
+		batch.draws.clear();
+		uint32_t instance = 0;
+		uint32_t vertex = 0;
+		uint32_t index = 0;
+		uint32_t text_instance = 0;
+		uint32_t glyph = 0;
+		for (uint32_t item_index : batch.order)
+		{
+			const Batch::Item& item = batch.items[item_index];
+			bool merge = false;
+			if (!batch.draws.empty())
+			{
+				const Batch::Item& prev = batch.items[batch.draws.back().item];
+				if (prev.text != item.text)
+				{
+					merge = false;
+				}
+				else if (item.text)
+				{
+					merge = batch.texts[prev.index].pso == batch.texts[item.index].pso;
+				}
+				else
+				{
+					merge = batch.images[prev.index].pso == batch.images[item.index].pso && batch.images[prev.index].stencilRef == batch.images[item.index].stencilRef;
+				}
+			}
+			if (!merge)
+			{
+				Batch::MergedDraw& draw = batch.draws.emplace_back();
+				draw.item = item_index;
+				draw.start = item.text ? glyph : index;
+			}
+
+			if (item.text)
+			{
+				const Batch::Text& text = batch.texts[item.index];
+				batch.draws.back().count += text.glyph_count;
+
+				FontBatchInstance text_constants = text.instance;
+				PackScissor(text.scissor, text_constants.clip_lefttop, text_constants.clip_rightbottom);
+				std::memcpy(dst_text_instances + text_instance, &text_constants, sizeof(FontBatchInstance));
+				for (uint32_t i = 0; i < text.glyph_count; ++i)
+				{
+					dst_glyphs[glyph + i] = text_instance;
+				}
+				std::memcpy(dst_text_vertices + glyph * 4, batch.text_vertices.data() + text.glyph_offset * 4, sizeof(FontVertex) * text.glyph_count * 4);
+				text_instance++;
+				glyph += text.glyph_count;
+				continue;
+			}
+
+			const Batch::Image& image = batch.images[item.index];
+			batch.draws.back().count += image.index_count;
+
+			uint32_t clip_lefttop = 0;
+			uint32_t clip_rightbottom = 0;
+			PackScissor(image.scissor, clip_lefttop, clip_rightbottom);
+
+			std::memcpy(dst_instances + instance, &image.constants, sizeof(ImageConstants));
+			for (uint32_t i = 0; i < image.vertex_count; ++i)
+			{
+				ImageBatchVertex v;
+				v.pos = batch.vertices[image.vertex_offset + i];
+				v.instance = instance;
+				v.corner = i;
+				v.clip_lefttop = clip_lefttop;
+				v.clip_rightbottom = clip_rightbottom;
+				std::memcpy(dst_vertices + vertex + i, &v, sizeof(v));
+			}
+			for (uint32_t i = 0; i < image.index_count; ++i)
+			{
+				dst_indices[index + i] = vertex + batch.indices[image.index_offset + i];
+			}
+			instance++;
+			vertex += image.vertex_count;
+			index += image.index_count;
+		}
+
+		device->EventBegin("Image Batch", cmd);
+
+		// The batched draws apply their scissor in the shader:
+		if (batch.scissor_valid)
+		{
+			Rect full_scissor;
+			full_scissor.left = 0;
+			full_scissor.top = 0;
+			full_scissor.right = 0xFFFF;
+			full_scissor.bottom = 0xFFFF;
+			device->BindScissorRects(1, &full_scissor, cmd);
+		}
+		if (index_count > 0)
+		{
+			device->BindIndexBuffer(&mem.buffer, IndexBufferFormat::UINT32, mem.offset + instances_size + vertices_size, cmd);
+		}
+		const PipelineState* bound_pso = nullptr;
+		uint32_t bound_stencilRef = ~0u;
+		bool image_cb_bound = false; // the image and font constants use the same slot
+		for (auto& draw : batch.draws)
+		{
+			const Batch::Item& item = batch.items[draw.item];
+			if (item.text)
+			{
+				const Batch::Text& text = batch.texts[item.index];
+				if (bound_pso != text.pso)
+				{
+					device->BindPipelineState(text.pso, cmd);
+					bound_pso = text.pso;
+					statistics.pipeline_binds++;
+				}
+				text_cb.first_glyph = draw.start;
+				device->BindDynamicConstantBuffer(text_cb, CBSLOT_FONT, cmd);
+				statistics.constant_buffer_binds++;
+				statistics.gpu_allocations++;
+				image_cb_bound = false;
+				device->DrawInstanced(4, draw.count, 0, 0, cmd);
+			}
+			else
+			{
+				const Batch::Image& image = batch.images[item.index];
+				if (bound_pso != image.pso)
+				{
+					device->BindPipelineState(image.pso, cmd);
+					bound_pso = image.pso;
+					statistics.pipeline_binds++;
+				}
+				if (bound_stencilRef != image.stencilRef)
+				{
+					device->BindStencilRef(image.stencilRef, cmd);
+					bound_stencilRef = image.stencilRef;
+				}
+				if (!image_cb_bound)
+				{
+					device->BindDynamicConstantBuffer(image_cb, CBSLOT_IMAGE, cmd);
+					statistics.constant_buffer_binds++;
+					statistics.gpu_allocations++;
+					image_cb_bound = true;
+				}
+				device->DrawIndexed(draw.count, draw.start, 0, cmd);
+			}
+			statistics.draw_calls++;
+		}
+		if (batch.scissor_valid)
+		{
+			device->BindScissorRects(1, &batch.scissor, cmd);
+		}
+
+		device->EventEnd(cmd);
+
+		statistics.batch_layers += batch.layer_count;
+		statistics.batch_flushes++;
+		ClearBatch();
+	}
+
 	void SetBackground(const Texture& texture)
 	{
 		backgroundTexture = texture;
@@ -49,6 +435,13 @@ namespace wi::image
 	{
 		GraphicsDevice* device = wi::graphics::GetDevice();
 
+		const bool batched = IsBatchActive(cmd) && !params.isFullScreenEnabled() && params.customProjection == nullptr;
+		if (!batched && IsBatchActive(cmd))
+		{
+			// The unbatched image must be drawn after the collected draws:
+			DrawBatch(cmd);
+		}
+
 		const Sampler* sampler = &samplers[SAMPLER_LINEAR_CLAMP];
 
 		if (params.quality == QUALITY_NEAREST)
@@ -178,6 +571,9 @@ namespace wi::image
 
 		STRIP_MODE strip_mode = STRIP_ON;
 		uint32_t index_count = 0;
+		const uint32_t batch_vertex_offset = (uint32_t)batch.vertices.size();
+		const uint32_t batch_index_offset = (uint32_t)batch.indices.size();
+		XMFLOAT4 bounds = {};
 
 		if (params.isFullScreenEnabled())
 		{
@@ -222,6 +618,11 @@ namespace wi::image
 				XMStoreFloat4(corners + i, XMVector2Transform(V[i], M)); // division by w will happen on GPU
 			}
 
+			bounds.x = std::min(std::min(corners[0].x, corners[1].x), std::min(corners[2].x, corners[3].x));
+			bounds.y = std::min(std::min(corners[0].y, corners[1].y), std::min(corners[2].y, corners[3].y));
+			bounds.z = std::max(std::max(corners[0].x, corners[1].x), std::max(corners[2].x, corners[3].x));
+			bounds.w = std::max(std::max(corners[0].y, corners[1].y), std::max(corners[2].y, corners[3].y));
+
 			image.b0 = float2(corners[0].x, corners[0].y);
 			image.b1 = float2(corners[1].x - corners[0].x, corners[1].y - corners[0].y);
 			image.b2 = float2(corners[2].x - corners[0].x, corners[2].y - corners[0].y);
@@ -241,14 +642,28 @@ namespace wi::image
 					index_count += segments * 3;
 				}
 				index_count += 3; // closing triangle
-				const size_t vb_size = sizeof(float4) * vertex_count;
-				const size_t ib_size = sizeof(uint16_t) * index_count;
-				GraphicsDevice::GPUAllocation mem = device->AllocateGPU(vb_size + ib_size, cmd);
-				image.buffer_index = device->GetDescriptorIndex(&mem.buffer, SubresourceType::SRV);
-				image.buffer_offset = (uint)mem.offset;
-				device->BindIndexBuffer(&mem.buffer, IndexBufferFormat::UINT16, mem.offset + vb_size, cmd);
-				float4* vertices = (float4*)mem.data;
-				uint16_t* indices = (uint16_t*)((uint8_t*)mem.data + vb_size);
+				float4* vertices = nullptr;
+				uint16_t* indices = nullptr;
+				if (batched)
+				{
+					// The batch geometry is written to the GPU when the batch is drawn:
+					batch.vertices.resize(batch_vertex_offset + vertex_count);
+					batch.indices.resize(batch_index_offset + index_count);
+					vertices = batch.vertices.data() + batch_vertex_offset;
+					indices = batch.indices.data() + batch_index_offset;
+				}
+				else
+				{
+					const size_t vb_size = sizeof(float4) * vertex_count;
+					const size_t ib_size = sizeof(uint16_t) * index_count;
+					GraphicsDevice::GPUAllocation mem = device->AllocateGPU(vb_size + ib_size, cmd);
+					statistics.gpu_allocations++;
+					image.buffer_index = device->GetDescriptorIndex(&mem.buffer, SubresourceType::SRV);
+					image.buffer_offset = (uint)mem.offset;
+					device->BindIndexBuffer(&mem.buffer, IndexBufferFormat::UINT16, mem.offset + vb_size, cmd);
+					vertices = (float4*)mem.data;
+					indices = (uint16_t*)((uint8_t*)mem.data + vb_size);
+				}
 				uint32_t vi = 0;
 				uint32_t ii = 0;
 				XMStoreFloat4(vertices + vi, XMVector2Transform((V[0] + V[1] + V[2] + V[3]) * 0.25f, M)); // center vertex
@@ -312,6 +727,14 @@ namespace wi::image
 				indices[ii++] = vi - 1;
 				indices[ii++] = 1;
 			}
+			else if (batched)
+			{
+				// Non rounded image in a batch is a quad of two triangles in the batch's triangle list:
+				batch.vertices.insert(batch.vertices.end(), corners, corners + arraysize(corners));
+				const uint16_t quad_indices[] = { 0, 1, 2, 2, 1, 3 };
+				batch.indices.insert(batch.indices.end(), quad_indices, quad_indices + arraysize(quad_indices));
+				index_count = arraysize(quad_indices);
+			}
 			else
 			{
 				// Non rounded image will simply use a 4 vertex triangle strip (simple quad)
@@ -392,19 +815,43 @@ namespace wi::image
 			image.gradient_uv_end = wi::math::pack_half2(params.gradient_uv_end);
 		}
 
-		device->EventBegin("Image", cmd);
-
 		uint32_t stencilRef = params.stencilRef;
 		if (params.stencilRefMode == STENCILREFMODE_USER)
 		{
 			stencilRef = wi::renderer::CombineStencilrefs(STENCILREF_EMPTY, (uint8_t)stencilRef);
 		}
+
+		if (batched)
+		{
+			Batch::Image& batched_image = batch.images.emplace_back();
+			batched_image.constants = image;
+			batched_image.pso = &imagePSO_batched[params.blendFlag][params.stencilComp][params.stencilRefMode][params.isDepthTestEnabled()];
+			batched_image.stencilRef = stencilRef;
+			batched_image.vertex_offset = batch_vertex_offset;
+			batched_image.vertex_count = (uint32_t)batch.vertices.size() - batch_vertex_offset;
+			batched_image.index_offset = batch_index_offset;
+			batched_image.index_count = index_count;
+			batched_image.scissor = batch.scissor;
+			AddBatchItem(bounds, uint32_t(batch.images.size() - 1), false);
+			statistics.images++;
+			statistics.batched_images++;
+			return;
+		}
+
+		device->EventBegin("Image", cmd);
+
 		device->BindStencilRef(stencilRef, cmd);
 
 		device->BindPipelineState(&imagePSO[params.blendFlag][params.stencilComp][params.stencilRefMode][params.isDepthTestEnabled()][strip_mode], cmd);
 
 		device->BindDynamicConstantBuffer(image, CBSLOT_IMAGE, cmd);
 
+		statistics.images++;
+		statistics.draw_calls++;
+		statistics.pipeline_binds++;
+		statistics.constant_buffer_binds++;
+		statistics.gpu_allocations++; // the dynamic constant buffer
+
 		if (params.isFullScreenEnabled())
 		{
 			device->Draw(3, 0, cmd); // full screen triangle
@@ -426,11 +873,101 @@ namespace wi::image
 		device->EventEnd(cmd);
 	}
 
+	void BeginBatch(CommandList cmd)
+	{
+		assert(!batch.active); // batches can't be nested
+		if (!imagePSO_batched[0][0][0][0].IsValid())
+		{
+			// The batched shaders are not available, everything will be drawn immediately:
+			return;
+		}
+		batch.active = true;
+		batch.cmd = cmd;
+		batch.scissor_valid = false;
+	}
+	void EndBatch(CommandList cmd)
+	{
+		if (!IsBatchActive(cmd))
+			return;
+		DrawBatch(cmd);
+		batch.active = false;
+		batch.cmd = {};
+	}
+	void FlushBatch(CommandList cmd)
+	{
+		if (!IsBatchActive(cmd))
+			return;
+		DrawBatch(cmd);
+	}
+	bool IsBatching(CommandList cmd)
+	{
+		return IsBatchActive(cmd);
+	}
+	void BindScissorRect(const Rect& rect, CommandList cmd)
+	{
+		GraphicsDevice* device = wi::graphics::GetDevice();
+		if (!IsBatchActive(cmd))
+		{
+			device->BindScissorRects(1, &rect, cmd);
+			return;
+		}
+		if (!batch.scissor_valid)
+		{
+			// The draws that were collected before the first scissor change use the previously bound scissor rect:
+			DrawBatch(cmd);
+			batch.scissor_valid = true;
+		}
+		batch.scissor = rect;
+		if (batch.items.empty())
+		{
+			device->BindScissorRects(1, &rect, cmd);
+		}
+	}
+	bool DrawTextBatched(const PipelineState* pso, const FontBatchInstance& instance, const FontVertex* vertices, uint32_t quad_count, const XMFLOAT4& bounds, CommandList cmd)
+	{
+		if (!IsBatchActive(cmd))
+			return false;
+		Batch::Text& text = batch.texts.emplace_back();
+		text.instance = instance;
+		text.pso = pso;
+		text.glyph_offset = uint32_t(batch.text_vertices.size() / 4);
+		text.glyph_count = quad_count;
+		text.scissor = batch.scissor;
+		batch.text_vertices.insert(batch.text_vertices.end(), vertices, vertices + quad_count * 4);
+		AddBatchItem(bounds, uint32_t(batch.texts.size() - 1), true);
+		statistics.texts++;
+		statistics.batched_texts++;
+		return true;
+	}
+
+	DrawStatistics GetDrawStatistics()
+	{
+		return statistics;
+	}
+	void ResetDrawStatistics()
+	{
+		statistics = {};
+	}
+	void AddDrawStatistics(const DrawStatistics& other)
+	{
+		statistics.images += other.images;
+		statistics.texts += other.texts;
+		statistics.draw_calls += other.draw_calls;
+		statistics.pipeline_binds += other.pipeline_binds;
+		statistics.constant_buffer_binds += other.constant_buffer_binds;
+		statistics.gpu_allocations += other.gpu_allocations;
+		statistics.batched_images += other.batched_images;
+		statistics.batched_texts += other.batched_texts;
+		statistics.batch_layers += other.batch_layers;
+		statistics.batch_flushes += other.batch_flushes;
+	}
 
 	void LoadShaders()
 	{
 		wi::renderer::LoadShader(ShaderStage::VS, vertexShader, "imageVS.cso");
 		wi::renderer::LoadShader(ShaderStage::PS, pixelShader, "imagePS.cso");
+		wi::renderer::LoadShader(ShaderStage::VS, vertexShader_batched, "imageVS_batched.cso");
+		wi::renderer::LoadShader(ShaderStage::PS, pixelShader_batched, "imagePS_batched.cso");
 
 		GraphicsDevice* device = wi::graphics::GetDevice();
 
@@ -468,6 +1005,25 @@ namespace wi::image
 				}
 			}
 		}
+
+		desc.vs = &vertexShader_batched;
+		desc.ps = &pixelShader_batched;
+		desc.pt = PrimitiveTopology::TRIANGLELIST;
+		for (int j = 0; j < BLENDMODE_COUNT; ++j)
+		{
+			desc.bs = &blendStates[j];
+			for (int k = 0; k < STENCILMODE_COUNT; ++k)
+			{
+				for (int m = 0; m < STENCILREFMODE_COUNT; ++m)
+				{
+					for (int d = 0; d < DEPTH_TEST_MODE_COUNT; ++d)
+					{
+						desc.dss = &depthStencilStates[k][m][d];
+						device->CreatePipelineState(&desc, &imagePSO_batched[j][k][m][d]);
+					}
+				}
+			}
+		}
 	}
 
 	void Initialize()
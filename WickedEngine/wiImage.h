@@ -6,6 +6,9 @@
 #include "wiCanvas.h"
 #include "wiPrimitive.h"
 
+struct FontBatchInstance;
+struct FontVertex;
+
 namespace wi::image
 {
 	// Do not alter order or value because it is bound to lua manually!
@@ -250,6 +253,53 @@ namespace wi::image
 	// Draw the specified texture with the specified parameters
 	void Draw(const wi::graphics::Texture* texture, const Params& params, wi::graphics::CommandList cmd);
 
+	// 2D draw batching:
+	//	Between BeginBatch() and EndBatch(), the images (and fonts) drawn on the command list are collected instead of being drawn immediately.
+	//	The collected draws are reordered where they don't overlap on the screen, and the images (and texts) with the same pipeline state
+	//	are merged into one draw call, so drawing a lot of GUI elements needs only a few draw calls.
+	//	If the batched shaders are not available, BeginBatch() does nothing and everything is drawn immediately.
+	//	The scissor rect must be changed with BindScissorRect() inside a batch, because the collected draws can have different scissor rects.
+	//	Images with customProjection and full screen images are not batched, they draw the previously collected draws and themselves immediately.
+	//	Other rendering commands (like custom draws, render pass changes) must not be recorded while there are collected draws, use FlushBatch() before them.
+	void BeginBatch(wi::graphics::CommandList cmd);
+	// Draws the collected draws and ends the batch
+	void EndBatch(wi::graphics::CommandList cmd);
+	// Draws the collected draws, but the batch continues
+	void FlushBatch(wi::graphics::CommandList cmd);
+	// Returns true if the command list is inside BeginBatch() and EndBatch() (on the current thread)
+	bool IsBatching(wi::graphics::CommandList cmd);
+	// Binds the scissor rect (in physical pixels) on the command list
+	//	Inside a batch, this must be used instead of GraphicsDevice::BindScissorRects(), because the scissor rect will be applied to the collected draws when they are drawn
+	void BindScissorRect(const wi::graphics::Rect& rect, wi::graphics::CommandList cmd);
+	// Adds the glyph quads of a text to the batch (wi::font uses this), it will be ordered correctly with the batched images
+	//	pso				:	batched font pipeline state, the consecutive texts with the same pso are drawn with one draw call
+	//	instance		:	constants of the text, the scissor rect is filled by the batch
+	//	vertices		:	4 vertices for every glyph quad, they are copied
+	//	bounds			:	screen area that the text covers in clip space (min x, min y, max x, max y)
+	//	returns false if the command list is not batching, in which case the caller must draw immediately
+	bool DrawTextBatched(const wi::graphics::PipelineState* pso, const FontBatchInstance& instance, const FontVertex* vertices, uint32_t quad_count, const XMFLOAT4& bounds, wi::graphics::CommandList cmd);
+
+	// CPU side counters of the 2D rendering commands (images and fonts), they can be checked without GPU
+	struct DrawStatistics
+	{
+		uint32_t images = 0; // number of images that were drawn
+		uint32_t texts = 0; // number of texts that were drawn (a text with shadow counts as two)
+		uint32_t draw_calls = 0; // number of draw calls that were recorded
+		uint32_t pipeline_binds = 0; // number of pipeline state binds
+		uint32_t constant_buffer_binds = 0; // number of constant buffer binds
+		uint32_t gpu_allocations = 0; // number of GPU memory allocations (including dynamic constant buffers)
+		uint32_t batched_images = 0; // number of images that were drawn by a batch
+		uint32_t batched_texts = 0; // number of texts that were drawn by a batch
+		uint32_t batch_layers = 0; // number of overlapping layers that the batched draws were sorted into
+		uint32_t batch_flushes = 0; // number of times the collected draws of a batch were drawn
+	};
+	// Returns the counters accumulated on the current thread since the last ResetDrawStatistics()
+	DrawStatistics GetDrawStatistics();
+	// Resets the counters of the current thread
+	void ResetDrawStatistics();
+	// Adds the counters of an other 2D renderer (wi::font uses this)
+	void AddDrawStatistics(const DrawStatistics& statistics);
+
 	// Initializes the image renderer
 	void Initialize();
 
@@ -540,10 +540,9 @@ namespace wi::lua
 
 	void ImageParams_BindLua::Bind()
 	{
-		static bool initialized = false;
-		if (!initialized)
+		static const char binding_key = 0;
+		if (wi::lua::BeginBinding(&binding_key))
 		{
-			initialized = true;
 			Luna<ImageParams_BindLua>::Register(wi::lua::GetLuaState());
 
 			wi::lua::RunText(R"(
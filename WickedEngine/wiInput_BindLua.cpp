@@ -296,10 +296,9 @@ namespace wi::lua
 
 	void Input_BindLua::Bind()
 	{
-		static bool initialized = false;
-		if (!initialized)
+		static const char binding_key = 0;
+		if (wi::lua::BeginBinding(&binding_key))
 		{
-			initialized = true;
 			Luna<Input_BindLua>::Register(wi::lua::GetLuaState());
 
 			wi::lua::RunText(R"(
@@ -482,10 +481,9 @@ CURSOR_CROSS = 9
 
 	void Touch_BindLua::Bind()
 	{
-		static bool initialized = false;
-		if (!initialized)
+		static const char binding_key = 0;
+		if (wi::lua::BeginBinding(&binding_key))
 		{
-			initialized = true;
 			Luna<Touch_BindLua>::Register(wi::lua::GetLuaState());
 		}
 	}
@@ -556,10 +554,9 @@ CURSOR_CROSS = 9
 
 	void ControllerFeedback_BindLua::Bind()
 	{
-		static bool initialized = false;
-		if (!initialized)
+		static const char binding_key = 0;
+		if (wi::lua::BeginBinding(&binding_key))
 		{
-			initialized = true;
 			Luna<ControllerFeedback_BindLua>::Register(wi::lua::GetLuaState());
 		}
 	}
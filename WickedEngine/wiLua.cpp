@@ -29,18 +29,201 @@
 #include "wiTimer.h"
 #include "wiVector.h"
 #include "wiVersion.h"
+#include "wiJobSystem.h"
+#include "wiSpinLock.h"
+#include "wiProfiler.h"
 
 #include <memory>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
 
 namespace wi::lua
 {
 	static constexpr const char* WILUA_ERROR_PREFIX = "[Lua Error] ";
+
+	// Memory allocator of a lua state, small allocations (strings, tables, closures, math userdata) are served from size class pools
+	//	instead of the heap, so creating and collecting many short lived objects is cheap
+	//	Every lua state has its own allocator, so it doesn't need locking
+	struct LuaAllocator
+	{
+		// Pool of fixed size slots, unlike BlockAllocator this hands out raw memory without constructing or clearing it, lua initializes what it uses
+		template<size_t size, size_t block_size = 256>
+		struct Pool
+		{
+			struct alignas(16) Slot
+			{
+				uint8_t data[size];
+			};
+			wi::vector<std::unique_ptr<Slot[]>> blocks;
+			wi::vector<void*> free_list;
+
+			void* allocate()
+			{
+				if (free_list.empty())
+				{
+					Slot* slots = blocks.emplace_back(new Slot[block_size]).get(); // default initialized, the memory is not cleared
+					free_list.reserve(block_size);
+					for (size_t i = 0; i < block_size; ++i)
+					{
+						free_list.push_back(slots + i);
+					}
+				}
+				void* ptr = free_list.back();
+				free_list.pop_back();
+				return ptr;
+			}
+			void free(void* ptr)
+			{
+				free_list.push_back(ptr);
+			}
+		};
+		static constexpr size_t size_classes[] = { 16, 32, 48, 64, 96, 128, 192, 256 };
+		static constexpr int size_class_count = arraysize(size_classes);
+
+		Pool<16> pool16;
+		Pool<32> pool32;
+		Pool<48> pool48;
+		Pool<64> pool64;
+		Pool<96> pool96;
+		Pool<128> pool128;
+		Pool<192> pool192;
+		Pool<256> pool256;
+		std::atomic<size_t> allocated_bytes{ 0 }; // written by the owning state's thread, read by GetAllocatedMemory() on the main thread
+
+		// returns the size class index, or size_class_count for allocations that don't fit into a pool
+		static constexpr int get_size_class(size_t size)
+		{
+			for (int i = 0; i < size_class_count; ++i)
+			{
+				if (size <= size_classes[i])
+					return i;
+			}
+			return size_class_count;
+		}
+		void* allocate(int size_class, size_t size)
+		{
+			switch (size_class)
+			{
+			case 0: return pool16.allocate();
+			case 1: return pool32.allocate();
+			case 2: return pool48.allocate();
+			case 3: return pool64.allocate();
+			case 4: return pool96.allocate();
+			case 5: return pool128.allocate();
+			case 6: return pool192.allocate();
+			case 7: return pool256.allocate();
+			default: return malloc(size);
+			}
+		}
+		void free(int size_class, void* ptr)
+		{
+			switch (size_class)
+			{
+			case 0: pool16.free(ptr); break;
+			case 1: pool32.free(ptr); break;
+			case 2: pool48.free(ptr); break;
+			case 3: pool64.free(ptr); break;
+			case 4: pool96.free(ptr); break;
+			case 5: pool128.free(ptr); break;
+			case 6: pool192.free(ptr); break;
+			case 7: pool256.free(ptr); break;
+			default: ::free(ptr); break;
+			}
+		}
+
+		// lua_Alloc implementation, ud is the LuaAllocator
+		static void* Alloc(void* ud, void* ptr, size_t osize, size_t nsize)
+		{
+			LuaAllocator& allocator = *(LuaAllocator*)ud;
+			if (ptr == nullptr)
+			{
+				osize = 0; // when ptr is null, osize is the type of the object that is being allocated
+			}
+			if (nsize == 0)
+			{
+				if (ptr != nullptr)
+				{
+					allocator.free(get_size_class(osize), ptr);
+					allocator.allocated_bytes.fetch_sub(osize, std::memory_order_relaxed);
+				}
+				return nullptr;
+			}
+			const int old_class = ptr == nullptr ? -1 : get_size_class(osize);
+			const int new_class = get_size_class(nsize);
+			void* ret = nullptr;
+			if (old_class == new_class)
+			{
+				if (new_class < size_class_count)
+				{
+					ret = ptr; // the chunk is large enough for the new size
+				}
+				else
+				{
+					ret = realloc(ptr, nsize);
+					if (ret == nullptr)
+						return nullptr; // lua keeps the old block when the allocation fails
+				}
+			}
+			else
+			{
+				ret = allocator.allocate(new_class, nsize);
+				if (ret == nullptr)
+					return nullptr;
+				if (ptr != nullptr)
+				{
+					std::memcpy(ret, ptr, std::min(osize, nsize));
+					allocator.free(old_class, ptr);
+				}
+			}
+			allocator.allocated_bytes.fetch_add(nsize - osize, std::memory_order_relaxed); // wraps around correctly when shrinking
+			return ret;
+		}
+	};
+
+	static int Panic(lua_State* L)
+	{
+		const char* str = lua_tostring(L, -1);
+		std::string ss;
+		ss += WILUA_ERROR_PREFIX;
+		ss += "Unprotected error: ";
+		ss += str == nullptr ? "unknown" : str;
+		wi::backlog::post(ss, wi::backlog::LogLevel::Error);
+		return 0; // lua will abort
+	}
+
 	struct LuaInternal
 	{
 		lua_State* m_luaState = NULL;
 
+		// The allocators of all lua states, they are destroyed after the lua states were closed:
+		wi::vector<std::unique_ptr<LuaAllocator>> allocators;
+
+		// Worker states for isolated scripts:
+		wi::vector<lua_State*> worker_states;
+		wi::SpinLock deferred_locker;
+		wi::vector<std::string> deferred_scripts; // scripts that worker states requested to run on the main state
+		std::atomic_bool return_to_editor_requested{ false };
+
+		// Budgeted garbage collection:
+		GarbageCollectionMode gc_mode = GarbageCollectionMode::Automatic;
+		float gc_budget = 1;
+		struct GCState
+		{
+			size_t memory_after_cycle = 0;
+			bool in_cycle = false;
+			bool finished = false; // finished for the current CollectGarbage()
+		};
+		wi::vector<GCState> gc_states; // main state, then worker states
+		uint32_t gc_next_state = 0; // the states take turns, continuing where the previous CollectGarbage() stopped
+		GarbageCollectionStatistics gc_statistics;
+
 		~LuaInternal()
 		{
+			for (lua_State* L : worker_states)
+			{
+				lua_close(L);
+			}
 			if (m_luaState != NULL)
 			{
 				lua_close(m_luaState);
@@ -53,6 +236,14 @@ namespace wi::lua
 		return luainternal;
 	}
 
+	// The lua state that is used by the wi::lua functions on the current thread, nullptr means the main lua state
+	//	This is set while a worker state is running a script or being initialized
+	static thread_local lua_State* current_state = nullptr;
+	inline lua_State* CurrentState()
+	{
+		return current_state != nullptr ? current_state : lua_internal().m_luaState;
+	}
+
 	wi::Application* editorApplication = nullptr;
 	wi::RenderPath* editorRenderPath = nullptr;
 	int IsThisEditor(lua_State* L)
@@ -63,6 +254,12 @@ namespace wi::lua
 	}
 	int ReturnToEditor(lua_State* L)
 	{
+		if (current_state != nullptr)
+		{
+			// Worker states can't modify the application, it will be done by RunDeferred() on the main thread
+			lua_internal().return_to_editor_requested.store(true);
+			return 0;
+		}
 		if (editorApplication != nullptr && editorRenderPath != nullptr)
 		{
 			KillProcesses();
@@ -89,7 +286,7 @@ namespace wi::lua
 
 	void PostErrorMsg()
 	{
-		PostErrorMsg(lua_internal().m_luaState);
+		PostErrorMsg(CurrentState());
 	}
 
 	uint32_t GeneratePID()
@@ -222,6 +419,31 @@ namespace wi::lua
 		return 0;
 	}
 
+	int RunOnMainThread(lua_State* L)
+	{
+		int argc = SGetArgCount(L);
+		if (argc > 0)
+		{
+			std::string script = SGetString(L, 1);
+			if (current_state == nullptr)
+			{
+				RunText(script);
+			}
+			else
+			{
+				LuaInternal& internal = lua_internal();
+				internal.deferred_locker.lock();
+				internal.deferred_scripts.push_back(std::move(script));
+				internal.deferred_locker.unlock();
+			}
+		}
+		else
+		{
+			SError(L, "RunOnMainThread(string script) not enough arguments!");
+		}
+		return 0;
+	}
+
 	int IsThisDebugBuild(lua_State* L)
 	{
 #ifdef _DEBUG
@@ -263,15 +485,26 @@ namespace wi::lua
 		return 1;
 	}
 
-	void Initialize()
+	// Creates a lua state that uses its own pooled allocator
+	static lua_State* NewState()
 	{
-		if (lua_internal().m_luaState != nullptr)
-			return; // already initialized
+		LuaAllocator* allocator = lua_internal().allocators.emplace_back(std::make_unique<LuaAllocator>()).get();
+		lua_State* L = lua_newstate(LuaAllocator::Alloc, allocator);
+		lua_atpanic(L, Panic);
+		if (lua_internal().gc_mode == GarbageCollectionMode::Budgeted)
+		{
+			lua_gc(L, LUA_GCSTOP);
+		}
+		return L;
+	}
 
-		wi::Timer timer;
+	// Registers the engine functionality into a newly created lua state
+	static void BindState(lua_State* L)
+	{
+		lua_State* prev_state = current_state;
+		current_state = L;
 
-		lua_internal().m_luaState = luaL_newstate();
-		luaL_openlibs(lua_internal().m_luaState);
+		luaL_openlibs(L);
 		RegisterFunc("dofile", Internal_DoFile);
 		RegisterFunc("dobinaryfile", Internal_DoBinaryFile);
 		RegisterFunc("compilebinaryfile", Internal_CompileBinaryFile);
@@ -280,6 +513,7 @@ namespace wi::lua
 		RegisterFunc("IsThisEditor", IsThisEditor);
 		RegisterFunc("ReturnToEditor", ReturnToEditor);
 		RegisterFunc("IsThisDebugBuild", IsThisDebugBuild);
+		RegisterFunc("RunOnMainThread", RunOnMainThread);
 
 		RegisterFunc("GetVersionMajor", GetVersionMajor);
 		RegisterFunc("GetVersionMinor", GetVersionMinor);
@@ -316,17 +550,114 @@ namespace wi::lua
 		TrailRenderer_BindLua::Bind();
 		Async_BindLua::Bind();
 
+		current_state = prev_state;
+	}
+
+	void Initialize()
+	{
+		if (lua_internal().m_luaState != nullptr)
+			return; // already initialized
+
+		wi::Timer timer;
+
+		lua_internal().m_luaState = NewState();
+		BindState(lua_internal().m_luaState);
+
 		wilog("wi::lua Initialized [Lua %s.%s.%s] (%d ms)", LUA_VERSION_MAJOR, LUA_VERSION_MINOR, LUA_VERSION_RELEASE, (int)std::round(timer.elapsed()));
 	}
 
 	lua_State* GetLuaState()
 	{
-		return lua_internal().m_luaState;
+		return CurrentState();
+	}
+
+	size_t GetAllocatedMemory()
+	{
+		size_t bytes = 0;
+		for (auto& allocator : lua_internal().allocators)
+		{
+			bytes += allocator->allocated_bytes.load(std::memory_order_relaxed);
+		}
+		return bytes;
+	}
+
+	bool BeginBinding(const void* key)
+	{
+		lua_State* L = CurrentState();
+		const bool bound = lua_rawgetp(L, LUA_REGISTRYINDEX, key) != LUA_TNIL;
+		lua_pop(L, 1);
+		if (bound)
+			return false;
+		lua_pushboolean(L, 1);
+		lua_rawsetp(L, LUA_REGISTRYINDEX, key);
+		return true;
+	}
+
+	uint32_t GetWorkerStateCount()
+	{
+		LuaInternal& internal = lua_internal();
+		if (internal.worker_states.empty() && internal.m_luaState != nullptr)
+		{
+			wi::Timer timer;
+			const uint32_t count = std::max(1u, wi::jobsystem::GetThreadCount());
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				lua_State* L = NewState();
+				BindState(L);
+				internal.worker_states.push_back(L);
+			}
+			wilog("wi::lua created %d worker states (%d ms)", count, (int)std::round(timer.elapsed()));
+		}
+		return (uint32_t)internal.worker_states.size();
+	}
+
+	bool RunBinaryDataOnWorker(uint32_t worker, const void* data, size_t size, const char* debugname)
+	{
+		LuaInternal& internal = lua_internal();
+		assert(worker < internal.worker_states.size());
+		lua_State* prev_state = current_state;
+		current_state = internal.worker_states[worker];
+		const bool success = RunBinaryData(data, size, debugname);
+		current_state = prev_state;
+		return success;
+	}
+
+	void RunDeferred()
+	{
+		LuaInternal& internal = lua_internal();
+		internal.deferred_locker.lock();
+		wi::vector<std::string> scripts = std::move(internal.deferred_scripts);
+		internal.deferred_scripts.clear();
+		internal.deferred_locker.unlock();
+		for (auto& script : scripts)
+		{
+			RunText(script);
+		}
+
+		if (internal.return_to_editor_requested.exchange(false))
+		{
+			ReturnToEditor(internal.m_luaState);
+		}
+	}
+
+	// Calls the function for the main state and every worker state, with the worker state set as the current state
+	template<typename F>
+	inline void ForEachState(F func)
+	{
+		LuaInternal& internal = lua_internal();
+		func(internal.m_luaState);
+		for (lua_State* L : internal.worker_states)
+		{
+			lua_State* prev_state = current_state;
+			current_state = L;
+			func(L);
+			current_state = prev_state;
+		}
 	}
 
 	bool RunScript()
 	{
-		if(lua_pcall(lua_internal().m_luaState, 0, LUA_MULTRET, 0) != LUA_OK)
+		if(lua_pcall(CurrentState(), 0, LUA_MULTRET, 0) != LUA_OK)
 		{
 			PostErrorMsg();
 			return false;
@@ -355,7 +686,7 @@ namespace wi::lua
 	}
 	bool RunText(const char* script)
 	{
-		if(luaL_loadstring(lua_internal().m_luaState, script) == LUA_OK)
+		if(luaL_loadstring(CurrentState(), script) == LUA_OK)
 		{
 			return RunScript();
 		}
@@ -365,7 +696,7 @@ namespace wi::lua
 	}
 	bool RunBinaryData(const void* data, size_t size, const char* debugname)
 	{
-		if(luaL_loadbuffer(lua_internal().m_luaState, (const char*)data, size, debugname) == LUA_OK)
+		if(luaL_loadbuffer(CurrentState(), (const char*)data, size, debugname) == LUA_OK)
 		{
 			return RunScript();
 		}
@@ -375,17 +706,19 @@ namespace wi::lua
 	}
 	void RegisterFunc(const char* name, lua_CFunction function)
 	{
-		lua_register(lua_internal().m_luaState, name, function);
+		lua_register(CurrentState(), name, function);
 	}
 
 	void SetDeltaTime(double dt)
 	{
-		lua_getglobal(lua_internal().m_luaState, "setDeltaTime");
-		SSetDouble(lua_internal().m_luaState, dt);
-		if(lua_pcall(lua_internal().m_luaState, 1, LUA_MULTRET, 0) != LUA_OK)
-		{
-			PostErrorMsg();
-		}
+		ForEachState([dt](lua_State* L) {
+			lua_getglobal(L, "setDeltaTime");
+			SSetDouble(L, dt);
+			if (lua_pcall(L, 1, LUA_MULTRET, 0) != LUA_OK)
+			{
+				PostErrorMsg();
+			}
+		});
 	}
 
 	inline void SignalHelper(lua_State* L, const char* str)
@@ -399,24 +732,145 @@ namespace wi::lua
 	}
 	void FixedUpdate()
 	{
-		SignalHelper(lua_internal().m_luaState, "wickedengine_fixed_update_tick");
+		ForEachState([](lua_State* L) { SignalHelper(L, "wickedengine_fixed_update_tick"); });
 	}
 	void Update()
 	{
-		SignalHelper(lua_internal().m_luaState, "wickedengine_update_tick");
+		ForEachState([](lua_State* L) { SignalHelper(L, "wickedengine_update_tick"); });
+
+		// The deferred queue is drained every frame, even if no isolated scripts were run by the scene this frame:
+		RunDeferred();
 	}
 	void Render()
 	{
-		SignalHelper(lua_internal().m_luaState, "wickedengine_render_tick");
+		ForEachState([](lua_State* L) { SignalHelper(L, "wickedengine_render_tick"); });
 	}
 	void Signal(const char* name)
 	{
-		SignalHelper(lua_internal().m_luaState, name);
+		ForEachState([name](lua_State* L) { SignalHelper(L, name); });
 	}
 
 	void KillProcesses()
 	{
-		RunText("killProcesses();");
+		ForEachState([](lua_State* L) { RunText("killProcesses();"); });
+	}
+
+	void SetGarbageCollectionMode(GarbageCollectionMode mode)
+	{
+		LuaInternal& internal = lua_internal();
+		internal.gc_mode = mode;
+		if (internal.m_luaState == nullptr)
+			return;
+		ForEachState([mode](lua_State* L) {
+			if (mode == GarbageCollectionMode::Budgeted)
+			{
+				lua_gc(L, LUA_GCINC, 0, 0, 0); // incremental mode, with the current parameters
+				lua_gc(L, LUA_GCSTOP);
+			}
+			else
+			{
+				lua_gc(L, LUA_GCRESTART);
+			}
+		});
+	}
+	GarbageCollectionMode GetGarbageCollectionMode()
+	{
+		return lua_internal().gc_mode;
+	}
+	void SetGarbageCollectionBudget(float milliseconds)
+	{
+		lua_internal().gc_budget = std::max(0.0f, milliseconds);
+	}
+	float GetGarbageCollectionBudget()
+	{
+		return lua_internal().gc_budget;
+	}
+	void CollectGarbage()
+	{
+		LuaInternal& internal = lua_internal();
+		if (internal.m_luaState == nullptr)
+			return;
+
+		GarbageCollectionStatistics& statistics = internal.gc_statistics;
+		if (internal.gc_mode == GarbageCollectionMode::Budgeted)
+		{
+			auto range = wi::profiler::BeginRangeCPU("Lua GC");
+			wi::Timer timer;
+
+			const uint32_t state_count = 1 + (uint32_t)internal.worker_states.size();
+			internal.gc_states.resize(state_count);
+			for (auto& gc_state : internal.gc_states)
+			{
+				gc_state.finished = false;
+			}
+			statistics.steps = 0;
+			statistics.forced_steps = 0;
+
+			uint32_t active_count = state_count;
+			while (active_count > 0)
+			{
+				const uint32_t index = internal.gc_next_state++ % state_count;
+				LuaInternal::GCState& gc_state = internal.gc_states[index];
+				if (gc_state.finished)
+					continue;
+				lua_State* L = index == 0 ? internal.m_luaState : internal.worker_states[index - 1];
+				const size_t memory = size_t(lua_gc(L, LUA_GCCOUNT)) * 1024 + size_t(lua_gc(L, LUA_GCCOUNTB));
+
+				// A new cycle is only started when the memory grew since the last cycle, otherwise the budget would be spent on collecting nothing:
+				if (!gc_state.in_cycle && memory < gc_state.memory_after_cycle + gc_state.memory_after_cycle / 2)
+				{
+					gc_state.finished = true;
+					active_count--;
+					continue;
+				}
+
+				// If the memory doubled since the last cycle, the budget is exceeded until the cycle completes:
+				const bool pressure = memory > gc_state.memory_after_cycle * 2 + 1024 * 1024;
+				if (timer.elapsed_milliseconds() >= internal.gc_budget)
+				{
+					if (!pressure)
+					{
+						gc_state.finished = true;
+						active_count--;
+						continue;
+					}
+					statistics.forced_steps++;
+				}
+
+				// Finalizers can run while collecting, so the state must be current:
+				lua_State* prev_state = current_state;
+				current_state = index == 0 ? nullptr : L;
+				gc_state.in_cycle = true;
+				statistics.steps++;
+				if (lua_gc(L, LUA_GCSTEP, 0))
+				{
+					gc_state.in_cycle = false;
+					gc_state.finished = true;
+					gc_state.memory_after_cycle = size_t(lua_gc(L, LUA_GCCOUNT)) * 1024 + size_t(lua_gc(L, LUA_GCCOUNTB));
+					statistics.cycles++;
+					active_count--;
+				}
+				current_state = prev_state;
+			}
+			internal.gc_next_state %= state_count;
+
+			statistics.time = float(timer.elapsed_milliseconds());
+			wi::profiler::EndRange(range);
+		}
+		statistics.memory = GetAllocatedMemory();
+
+		// The profiler counters are only reported in budgeted mode, the automatic mode keeps the previous behavior:
+		if (internal.gc_mode == GarbageCollectionMode::Budgeted)
+		{
+			wi::profiler::SetCounter("Lua memory", double(statistics.memory) / 1024.0, "KB");
+			wi::profiler::SetCounter("Lua GC steps", double(statistics.steps));
+			wi::profiler::SetCounter("Lua GC forced steps", double(statistics.forced_steps));
+			wi::profiler::SetCounter("Lua GC cycles", double(statistics.cycles));
+		}
+	}
+	GarbageCollectionStatistics GetGarbageCollectionStatistics()
+	{
+		return lua_internal().gc_statistics;
 	}
 
 	const char* SGetString(lua_State* L, int stackpos)
@@ -667,19 +1121,20 @@ namespace wi::lua
 	}
 	bool CompileText(const char* script, wi::vector<uint8_t>& dst)
 	{
-		if(luaL_loadstring(lua_internal().m_luaState, script) != LUA_OK)
+		lua_State* L = CurrentState();
+		if(luaL_loadstring(L, script) != LUA_OK)
 		{
 			PostErrorMsg();
 			return false;
 		}
 		dst.clear();
-		if(lua_dump(lua_internal().m_luaState, writer, &dst, 0) != LUA_OK)
+		if(lua_dump(L, writer, &dst, 0) != LUA_OK)
 		{
 			PostErrorMsg();
-			lua_pop(lua_internal().m_luaState, 1); // lua_dump does not pop the dumped function from stack
+			lua_pop(L, 1); // lua_dump does not pop the dumped function from stack
 			return false;
 		}
-		lua_pop(lua_internal().m_luaState, 1); // lua_dump does not pop the dumped function from stack
+		lua_pop(L, 1); // lua_dump does not pop the dumped function from stack
 		return true;
 	}
 
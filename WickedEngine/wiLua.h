@@ -20,8 +20,29 @@ namespace wi::lua
 {
 	void Initialize();
 
+	// Returns the lua state that is used on the current thread (the main state, or a worker state while it is running an isolated script)
 	lua_State* GetLuaState();
 
+	// Worker lua states can run isolated scripts in parallel on the job system threads, but each of them must be used by only one thread at a time
+	//	Every worker state has the same bindings as the main state, but they don't share any lua data (globals, processes) with each other or with the main state
+	//	Isolated scripts can use RunOnMainThread(string script) in lua to defer work to the main state, for example creating or removing entities
+	//	The worker states are created when this is first called, it must be called from the main thread
+	uint32_t GetWorkerStateCount();
+	// Runs a binary script on the specified worker state [0, GetWorkerStateCount() - 1]
+	//	It is safe to call from multiple threads for different worker states
+	bool RunBinaryDataOnWorker(uint32_t worker, const void* data, size_t size, const char* debugname = "");
+	// Runs the scripts that the worker states deferred with RunOnMainThread(), it must be called from the main thread after the worker states finished
+	//	Update() and the scene script system call this every frame, so deferred work is not lost when no isolated scripts remain
+	void RunDeferred();
+
+	// Returns the number of bytes that are currently allocated by all lua states
+	//	It must be called from the main thread, while the worker states are running scripts the result is only approximate
+	size_t GetAllocatedMemory();
+
+	// Returns true if the binding identified by the key is not yet registered into the current lua state and marks it as registered
+	//	Bind() functions use this to register into every lua state exactly once, the key is usually the address of a static variable
+	bool BeginBinding(const void* key);
+
 	//run a script from file
 	bool RunFile(const char* filename);
 	inline bool RunFile(const std::string& filename) { return RunFile(filename.c_str()); }
@@ -53,6 +74,32 @@ namespace wi::lua
 	//kill every running background task (coroutine)
 	void KillProcesses();
 
+	enum class GarbageCollectionMode
+	{
+		Automatic,	// lua collects garbage incrementally while it allocates memory, so the collection can happen at any point of the frame (default)
+		Budgeted,	// the automatic collector is stopped, and garbage is only collected by CollectGarbage() within a time budget
+	};
+	// Sets the garbage collection mode of all lua states (main and worker states)
+	void SetGarbageCollectionMode(GarbageCollectionMode mode);
+	GarbageCollectionMode GetGarbageCollectionMode();
+	// Sets the time in milliseconds that one CollectGarbage() can spend in budgeted mode (default: 1 ms)
+	void SetGarbageCollectionBudget(float milliseconds);
+	float GetGarbageCollectionBudget();
+	// Runs incremental garbage collection steps on the lua states until the time budget is spent or there is nothing more to collect
+	//	It only collects garbage in budgeted mode. The wi::Application calls it once per frame after Render(), it must be called from the main thread
+	//	If the scripts create garbage faster than it can be collected within the budget, the budget is exceeded to keep the memory usage bounded
+	void CollectGarbage();
+
+	struct GarbageCollectionStatistics
+	{
+		size_t memory = 0; // bytes allocated by all lua states
+		float time = 0; // milliseconds spent by the last CollectGarbage()
+		uint32_t steps = 0; // incremental steps performed by the last CollectGarbage()
+		uint32_t forced_steps = 0; // steps of the last CollectGarbage() that exceeded the budget because of memory growth
+		uint64_t cycles = 0; // number of collection cycles completed by CollectGarbage()
+	};
+	GarbageCollectionStatistics GetGarbageCollectionStatistics();
+
 	// Generates a unique identifier for a script instance:
 	uint32_t GeneratePID();
 
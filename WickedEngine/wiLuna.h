@@ -1,11 +1,12 @@
 #pragma once
 
 //Luna : Official C++ to Lua binder project, 5th version
-// modified for Wicked Engine to use custom memory allocator and removed warnings
-
-#include "wiAllocator.h"
+// modified for Wicked Engine to store objects inside the userdata and removed warnings
 
 #include <string.h> // strlen
+#include <stdint.h> // uintptr_t
+#include <new> // placement new
+#include <type_traits>
 
 #define lunamethod(class, name) {#name, &class::name}
 #define lunaproperty(class, name) {#name, &class::Get##name, &class::Set##name}
@@ -17,8 +18,6 @@ int Set##property (lua_State* L) { return property.Set(L); }
 template < class T > class Luna {
 public:
 
-	inline static wi::allocator::BlockAllocator<T> allocator;
-
 	struct PropertyType {
 		const char     *name;
 		int             (T::*getter) (lua_State *);
@@ -141,9 +140,24 @@ public:
 	*/
 	static int constructor(lua_State * L)
 	{
-		T*  ap = allocator.allocate(L);
-		T** a = static_cast<T**>(lua_newuserdata(L, sizeof(T *))); // Push value = userdata
-		*a = ap;
+		// The constructor reads the arguments from the stack, so it must run before the userdata is pushed
+		if constexpr (std::is_trivially_copyable_v<T> && std::is_copy_constructible_v<T>)
+		{
+			// Simple value types (like math types) are constructed on the C stack and copied into the userdata:
+			T ap(L);
+			T** a = new_userdata(L); // Push value = userdata
+			new (*a) T(ap);
+		}
+		else
+		{
+			// Other types can reference themselves, so they are constructed in place and the userdata is anchored in the registry while it is removed from the stack:
+			T** a = new_userdata(L); // Push value = userdata
+			lua_rawsetp(L, LUA_REGISTRYINDEX, a);
+			new (*a) T(L);
+			lua_rawgetp(L, LUA_REGISTRYINDEX, a);
+			lua_pushnil(L);
+			lua_rawsetp(L, LUA_REGISTRYINDEX, a);
+		}
 
 		luaL_getmetatable(L, T::className); 		// Fetch global metatable T::classname
 		lua_setmetatable(L, -2);
@@ -162,8 +176,8 @@ public:
 	template<typename... ARG>
 	static T* push(lua_State * L, ARG&&... args)
 	{
-		T **a = (T **)lua_newuserdata(L, sizeof(T *)); // Create userdata
-		*a = allocator.allocate(std::forward<ARG>(args)...);
+		T** a = new_userdata(L); // Create userdata
+		new (*a) T(std::forward<ARG>(args)...);
 
 		luaL_getmetatable(L, T::className);
 
@@ -201,9 +215,22 @@ public:
 
 			if (_index & (1 << 8)) // A func
 			{
+				// The last accessed func is cached in the user values of the object, so calling the same method repeatedly doesn't allocate
+				if (lua_getiuservalue(L, 1, 2) == LUA_TNUMBER && lua_tointeger(L, -1) == _index)
+				{
+					lua_getiuservalue(L, 1, 1);
+					return 1; // Return the cached func
+				}
+				lua_pop(L, 1);
+
 				lua_pushnumber(L, _index ^ (1 << 8)); // Push the right func index
-				lua_pushlightuserdata(L, obj);
+				lua_pushvalue(L, 1); // The object is an upvalue, so it is kept alive while the func is referenced
 				lua_pushcclosure(L, &Luna < T >::function_dispatch, 2);
+
+				lua_pushvalue(L, -1);
+				lua_setiuservalue(L, 1, 1); // Cache the func
+				lua_pushinteger(L, _index);
+				lua_setiuservalue(L, 1, 2); // Cache the index of the func
 				return 1; // Return a func
 			}
 
@@ -282,12 +309,34 @@ public:
 	{
 		T** obj = static_cast < T ** >(lua_touserdata(L, -1));
 
-		if (obj)
-			allocator.free(*obj);
+		if (obj && *obj)
+		{
+			(*obj)->~T();
+			*obj = nullptr;
+		}
 
 		return 0;
 	}
 
+	/*
+	@ new_userdata (internal)
+	Arguments:
+	* L - Lua State
+
+	Description:
+	Pushes a userdata that contains the object pointer followed by the storage of the object, so an object is only one allocation from the Lua allocator.
+	The two user values are used to cache the last accessed func and its index.
+	The object is not constructed yet.
+	*/
+	static T** new_userdata(lua_State* L)
+	{
+		T** a = static_cast<T**>(lua_newuserdatauv(L, sizeof(T*) + sizeof(T) + alignof(T) - 1, 2));
+		uintptr_t storage = reinterpret_cast<uintptr_t>(a + 1);
+		storage = (storage + alignof(T) - 1) & ~uintptr_t(alignof(T) - 1);
+		*a = reinterpret_cast<T*>(storage);
+		return a;
+	}
+
 	static int to_string(lua_State* L)
 	{
 		T** obj = static_cast<T**>(lua_touserdata(L, -1));
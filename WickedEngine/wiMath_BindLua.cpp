@@ -40,6 +40,16 @@ namespace wi::lua
 		lunamethod(Vector_BindLua, PlaneFromPoints),
 		lunamethod(Vector_BindLua, GetAngle),
 		lunamethod(Vector_BindLua, GetAngleSigned),
+		lunamethod(Vector_BindLua, CopyFrom),
+		lunamethod(Vector_BindLua, SetValues),
+		lunamethod(Vector_BindLua, AddInPlace),
+		lunamethod(Vector_BindLua, SubtractInPlace),
+		lunamethod(Vector_BindLua, MultiplyInPlace),
+		lunamethod(Vector_BindLua, LerpInPlace),
+		lunamethod(Vector_BindLua, NormalizeInPlace),
+		lunamethod(Vector_BindLua, TransformInPlace),
+		lunamethod(Vector_BindLua, TransformNormalInPlace),
+		lunamethod(Vector_BindLua, TransformCoordInPlace),
 		{ NULL, NULL }
 	};
 	Luna<Vector_BindLua>::PropertyType Vector_BindLua::properties[] = {
@@ -680,12 +690,169 @@ namespace wi::lua
 	}
 
 
+	// In-place operations modify the vector itself instead of returning a new vector, so they don't allocate lua memory
+	//	They take the operands from the last arguments, so they work both with v:AddInPlace(other) and v.AddInPlace(other) syntax
+	int Vector_BindLua::CopyFrom(lua_State* L)
+	{
+		int argc = wi::lua::SGetArgCount(L);
+		if (argc > 0)
+		{
+			Vector_BindLua* v = Luna<Vector_BindLua>::lightcheck(L, argc);
+			if (v)
+			{
+				data = v->data;
+				return 0;
+			}
+			wi::lua::SError(L, "CopyFrom(Vector v) argument is not a Vector!");
+			return 0;
+		}
+		wi::lua::SError(L, "CopyFrom(Vector v) not enough arguments!");
+		return 0;
+	}
+	int Vector_BindLua::SetValues(lua_State* L)
+	{
+		int argc = wi::lua::SGetArgCount(L);
+		// Skip the self argument of v:SetValues(x,y,z,w) syntax:
+		int first = (argc > 0 && Luna<Vector_BindLua>::lightcheck(L, 1) == this) ? 2 : 1;
+		data.x = first <= argc ? wi::lua::SGetFloat(L, first) : 0;
+		data.y = first + 1 <= argc ? wi::lua::SGetFloat(L, first + 1) : 0;
+		data.z = first + 2 <= argc ? wi::lua::SGetFloat(L, first + 2) : 0;
+		data.w = first + 3 <= argc ? wi::lua::SGetFloat(L, first + 3) : 0;
+		return 0;
+	}
+	int Vector_BindLua::AddInPlace(lua_State* L)
+	{
+		int argc = wi::lua::SGetArgCount(L);
+		if (argc > 0)
+		{
+			Vector_BindLua* v = Luna<Vector_BindLua>::lightcheck(L, argc);
+			if (v)
+			{
+				XMStoreFloat4(&data, XMVectorAdd(XMLoadFloat4(&data), XMLoadFloat4(&v->data)));
+				return 0;
+			}
+			wi::lua::SError(L, "AddInPlace(Vector v) argument is not a Vector!");
+			return 0;
+		}
+		wi::lua::SError(L, "AddInPlace(Vector v) not enough arguments!");
+		return 0;
+	}
+	int Vector_BindLua::SubtractInPlace(lua_State* L)
+	{
+		int argc = wi::lua::SGetArgCount(L);
+		if (argc > 0)
+		{
+			Vector_BindLua* v = Luna<Vector_BindLua>::lightcheck(L, argc);
+			if (v)
+			{
+				XMStoreFloat4(&data, XMVectorSubtract(XMLoadFloat4(&data), XMLoadFloat4(&v->data)));
+				return 0;
+			}
+			wi::lua::SError(L, "SubtractInPlace(Vector v) argument is not a Vector!");
+			return 0;
+		}
+		wi::lua::SError(L, "SubtractInPlace(Vector v) not enough arguments!");
+		return 0;
+	}
+	int Vector_BindLua::MultiplyInPlace(lua_State* L)
+	{
+		int argc = wi::lua::SGetArgCount(L);
+		if (argc > 0)
+		{
+			Vector_BindLua* v = Luna<Vector_BindLua>::lightcheck(L, argc);
+			if (v)
+			{
+				XMStoreFloat4(&data, XMVectorMultiply(XMLoadFloat4(&data), XMLoadFloat4(&v->data)));
+			}
+			else
+			{
+				XMStoreFloat4(&data, XMLoadFloat4(&data) * wi::lua::SGetFloat(L, argc));
+			}
+			return 0;
+		}
+		wi::lua::SError(L, "MultiplyInPlace(Vector v or float f) not enough arguments!");
+		return 0;
+	}
+	int Vector_BindLua::LerpInPlace(lua_State* L)
+	{
+		int argc = wi::lua::SGetArgCount(L);
+		if (argc > 1)
+		{
+			Vector_BindLua* v = Luna<Vector_BindLua>::lightcheck(L, argc - 1);
+			float t = wi::lua::SGetFloat(L, argc);
+			if (v)
+			{
+				XMStoreFloat4(&data, XMVectorLerp(XMLoadFloat4(&data), XMLoadFloat4(&v->data), t));
+				return 0;
+			}
+			wi::lua::SError(L, "LerpInPlace(Vector v, float t) argument types mismatch!");
+			return 0;
+		}
+		wi::lua::SError(L, "LerpInPlace(Vector v, float t) not enough arguments!");
+		return 0;
+	}
+	int Vector_BindLua::NormalizeInPlace(lua_State* L)
+	{
+		XMStoreFloat4(&data, XMVector3Normalize(XMLoadFloat4(&data)));
+		return 0;
+	}
+	int Vector_BindLua::TransformInPlace(lua_State* L)
+	{
+		int argc = wi::lua::SGetArgCount(L);
+		if (argc > 0)
+		{
+			Matrix_BindLua* mat = Luna<Matrix_BindLua>::lightcheck(L, argc);
+			if (mat)
+			{
+				XMStoreFloat4(&data, XMVector4Transform(XMLoadFloat4(&data), XMLoadFloat4x4(&mat->data)));
+				return 0;
+			}
+			wi::lua::SError(L, "TransformInPlace(Matrix matrix) argument is not a Matrix!");
+			return 0;
+		}
+		wi::lua::SError(L, "TransformInPlace(Matrix matrix) not enough arguments!");
+		return 0;
+	}
+	int Vector_BindLua::TransformNormalInPlace(lua_State* L)
+	{
+		int argc = wi::lua::SGetArgCount(L);
+		if (argc > 0)
+		{
+			Matrix_BindLua* mat = Luna<Matrix_BindLua>::lightcheck(L, argc);
+			if (mat)
+			{
+				XMStoreFloat4(&data, XMVector3TransformNormal(XMLoadFloat4(&data), XMLoadFloat4x4(&mat->data)));
+				return 0;
+			}
+			wi::lua::SError(L, "TransformNormalInPlace(Matrix matrix) argument is not a Matrix!");
+			return 0;
+		}
+		wi::lua::SError(L, "TransformNormalInPlace(Matrix matrix) not enough arguments!");
+		return 0;
+	}
+	int Vector_BindLua::TransformCoordInPlace(lua_State* L)
+	{
+		int argc = wi::lua::SGetArgCount(L);
+		if (argc > 0)
+		{
+			Matrix_BindLua* mat = Luna<Matrix_BindLua>::lightcheck(L, argc);
+			if (mat)
+			{
+				XMStoreFloat4(&data, XMVector3TransformCoord(XMLoadFloat4(&data), XMLoadFloat4x4(&mat->data)));
+				return 0;
+			}
+			wi::lua::SError(L, "TransformCoordInPlace(Matrix matrix) argument is not a Matrix!");
+			return 0;
+		}
+		wi::lua::SError(L, "TransformCoordInPlace(Matrix matrix) not enough arguments!");
+		return 0;
+	}
+
 	void Vector_BindLua::Bind()
 	{
-		static bool initialized = false;
-		if (!initialized)
+		static const char binding_key = 0;
+		if (wi::lua::BeginBinding(&binding_key))
 		{
-			initialized = true;
 			Luna<Vector_BindLua>::Register(wi::lua::GetLuaState());
 			Luna<Vector_BindLua>::push_global(wi::lua::GetLuaState(), "vector");
 		}
@@ -751,6 +918,8 @@ namespace wi::lua
 		lunamethod(Matrix_BindLua, Multiply),
 		lunamethod(Matrix_BindLua, Transpose),
 		lunamethod(Matrix_BindLua, Inverse),
+		lunamethod(Matrix_BindLua, CopyFrom),
+		lunamethod(Matrix_BindLua, MultiplyInPlace),
 
 		lunamethod(Matrix_BindLua, GetForward),
 		lunamethod(Matrix_BindLua, GetUp),
@@ -1089,12 +1258,46 @@ namespace wi::lua
 		return 1;
 	}
 
+	int Matrix_BindLua::CopyFrom(lua_State* L)
+	{
+		int argc = wi::lua::SGetArgCount(L);
+		if (argc > 0)
+		{
+			Matrix_BindLua* m = Luna<Matrix_BindLua>::lightcheck(L, argc);
+			if (m)
+			{
+				data = m->data;
+				return 0;
+			}
+			wi::lua::SError(L, "CopyFrom(Matrix m) argument is not a Matrix!");
+			return 0;
+		}
+		wi::lua::SError(L, "CopyFrom(Matrix m) not enough arguments!");
+		return 0;
+	}
+	int Matrix_BindLua::MultiplyInPlace(lua_State* L)
+	{
+		int argc = wi::lua::SGetArgCount(L);
+		if (argc > 0)
+		{
+			Matrix_BindLua* m = Luna<Matrix_BindLua>::lightcheck(L, argc);
+			if (m)
+			{
+				XMStoreFloat4x4(&data, XMMatrixMultiply(XMLoadFloat4x4(&data), XMLoadFloat4x4(&m->data)));
+				return 0;
+			}
+			wi::lua::SError(L, "MultiplyInPlace(Matrix m) argument is not a Matrix!");
+			return 0;
+		}
+		wi::lua::SError(L, "MultiplyInPlace(Matrix m) not enough arguments!");
+		return 0;
+	}
+
 	void Matrix_BindLua::Bind()
 	{
-		static bool initialized = false;
-		if (!initialized)
+		static const char binding_key = 0;
+		if (wi::lua::BeginBinding(&binding_key))
 		{
-			initialized = true;
 			Luna<Matrix_BindLua>::Register(wi::lua::GetLuaState());
 			Luna<Matrix_BindLua>::push_global(wi::lua::GetLuaState(), "matrix");
 		}
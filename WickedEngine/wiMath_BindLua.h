@@ -68,6 +68,18 @@ namespace wi::lua
 		int GetAngle(lua_State* L);
 		int GetAngleSigned(lua_State* L);
 
+		// In-place operations, these modify this vector instead of returning a new one:
+		int CopyFrom(lua_State* L);
+		int SetValues(lua_State* L);
+		int AddInPlace(lua_State* L);
+		int SubtractInPlace(lua_State* L);
+		int MultiplyInPlace(lua_State* L);
+		int LerpInPlace(lua_State* L);
+		int NormalizeInPlace(lua_State* L);
+		int TransformInPlace(lua_State* L);
+		int TransformNormalInPlace(lua_State* L);
+		int TransformCoordInPlace(lua_State* L);
+
 		static void Bind();
 	};
 	struct VectorProperty
@@ -120,6 +132,10 @@ namespace wi::lua
 		int GetUp(lua_State* L);
 		int GetRight(lua_State* L);
 
+		// In-place operations, these modify this matrix instead of returning a new one:
+		int CopyFrom(lua_State* L);
+		int MultiplyInPlace(lua_State* L);
+
 		static void Bind();
 	};
 	struct MatrixProperty
@@ -41,9 +41,41 @@ namespace wi::network
 	bool CanReceive(const Socket* sock, long timeout_microseconds = 1);
 
 	// Receive data. This function will block until a packet has been received. Use CanReceive() function to check if this function will block or not.
+	//	If the socket is non-blocking, this returns false immediately when there is no packet to receive
 	//	sock		:	socket that receives packet
 	//	connection	:	sender's connection data will be written to it when the function returns
 	//	data		:	buffer to hold received data, must be already allocated to a sufficient size
 	//	dataSize	:	expected data size in bytes
 	bool Receive(const Socket* sock, Connection* connection, void* data, size_t dataSize);
+
+	// Enables or disables non-blocking mode for the socket. In non-blocking mode, the receive functions return immediately
+	//	when there is no data, and the send functions return when the send buffer of the socket is full
+	//	sock		:	socket to modify
+	//	value		:	true to enable non-blocking mode, false to enable blocking mode (default for new sockets)
+	bool SetNonBlocking(const Socket* sock, bool value = true);
+
+	// Describes one packet for batched sending and receiving, the data buffer is always provided by the caller
+	struct Datagram
+	{
+		Connection connection;	// receiver when sending, sender will be written here when receiving
+		void* data = nullptr;	// buffer that contains data to send, or buffer to hold received data
+		size_t capacity = 0;	// size of the data buffer in bytes when receiving
+		size_t dataSize = 0;	// size of the data to send, or size of the received data in bytes
+	};
+
+	// Sends multiple data packets with as few system calls as possible
+	//	sock		:	socket that sends the packets
+	//	datagrams	:	array of packets to send
+	//	count		:	number of packets in the array
+	//	returns the number of packets that were sent, which can be less than count if the socket is non-blocking and its send buffer is full, or an error occurred
+	size_t SendBatch(const Socket* sock, const Datagram* datagrams, size_t count);
+
+	// Receives multiple data packets with as few system calls as possible
+	//	If the socket is blocking, this waits until at least one packet is received, then returns with the packets that are already available
+	//	If the socket is non-blocking, this returns immediately with the packets that are available (can be zero)
+	//	sock		:	socket that receives packets
+	//	datagrams	:	array of packets, the data and capacity members must be filled by the caller, the rest will be written by the function
+	//	count		:	maximum number of packets to receive
+	//	returns the number of received packets
+	size_t ReceiveBatch(const Socket* sock, Datagram* datagrams, size_t count);
 }
@@ -0,0 +1,627 @@
+#include "wiNetworkChannel.h"
+#include "wiRandom.h"
+#include "wiMath.h"
+
+#include <cstring>
+#include <algorithm>
+
+namespace wi::network
+{
+	// Packet layout:
+	//	header:		protocol_id (u32), sequence (u16), ack (u16), ack_bits (u32), flags (u8)
+	//	messages:	flags (u8), size (u16), [message_id (u16)], [fragment_index (u16), fragment_count (u16)], data
+	static constexpr size_t max_packet_size = 1472; // Ethernet MTU - IP header - UDP header
+	static constexpr size_t packet_header_size = 4 + 2 + 2 + 4 + 1;
+	static constexpr size_t unreliable_header_size = 1 + 2;
+	static constexpr size_t reliable_header_size = 1 + 2 + 2;
+	static constexpr size_t fragment_header_size = reliable_header_size + 2 + 2;
+	static constexpr uint32_t window_size = 1024; // number of tracked packets and messages in flight
+	static constexpr uint32_t max_messages_per_packet = 64; // reliable messages
+	static constexpr uint32_t max_fragment_count = 256;
+
+	enum PACKET_FLAGS
+	{
+		PACKET_FLAG_HAS_ACK = 1 << 0,
+	};
+	enum MESSAGE_FLAGS
+	{
+		MESSAGE_FLAG_RELIABLE = 1 << 0,
+		MESSAGE_FLAG_FRAGMENT = 1 << 1,
+	};
+
+	// Sequence numbers wrap around, so they are compared within half of the range:
+	static constexpr bool sequence_greater_than(uint16_t a, uint16_t b)
+	{
+		return ((a > b) && (a - b <= 32768)) || ((a < b) && (b - a > 32768));
+	}
+	static constexpr bool sequence_less_than(uint16_t a, uint16_t b)
+	{
+		return sequence_greater_than(b, a);
+	}
+
+	template<typename T>
+	inline void write_value(uint8_t*& dst, T value)
+	{
+		std::memcpy(dst, &value, sizeof(T));
+		dst += sizeof(T);
+	}
+	template<typename T>
+	inline bool read_value(const uint8_t*& src, const uint8_t* end, T& value)
+	{
+		if (src + sizeof(T) > end)
+			return false;
+		std::memcpy(&value, src, sizeof(T));
+		src += sizeof(T);
+		return true;
+	}
+
+	struct SentPacket
+	{
+		uint32_t sequence = ~0u; // ~0u: empty
+		bool acked = false;
+		double time = 0;
+		uint32_t message_count = 0;
+		uint16_t message_ids[max_messages_per_packet] = {};
+	};
+	struct SendSlot
+	{
+		bool used = false;
+		bool acked = false;
+		uint16_t message_id = 0;
+		uint16_t fragment_index = 0;
+		uint16_t fragment_count = 0;
+		uint32_t send_count = 0;
+		double last_sent_time = 0;
+		wi::vector<uint8_t> data; // capacity is kept when the slot is reused
+	};
+	struct ReceiveSlot
+	{
+		bool used = false;
+		uint16_t message_id = 0;
+		uint16_t fragment_index = 0;
+		uint16_t fragment_count = 0;
+		wi::vector<uint8_t> data; // capacity is kept when the slot is reused
+	};
+	struct DelayedPacket
+	{
+		double release_time = 0;
+		uint32_t size = 0;
+		uint8_t data[max_packet_size];
+	};
+
+	struct ChannelInternal
+	{
+		Socket socket;
+		Connection remote;
+		ChannelDesc desc;
+		wi::random::RNG rng;
+		double time = 0;
+		double last_send_time = 0;
+		double last_receive_time = 0;
+		ChannelStatistics stats;
+
+		// Sending:
+		uint16_t next_packet_sequence = 0;
+		uint16_t next_message_id = 0;
+		uint16_t oldest_message_id = 0; // oldest reliable message that is not acknowledged yet
+		wi::vector<SentPacket> sent_packets;
+		wi::vector<SendSlot> send_slots;
+		wi::vector<uint8_t> unreliable_queue; // [size (u16), data] for each message
+		wi::vector<uint8_t> packet_memory; // max_packet_size for each outgoing packet
+		wi::vector<uint32_t> packet_sizes;
+		wi::vector<Datagram> datagrams;
+		wi::vector<DelayedPacket> delayed_packets;
+
+		// Receiving:
+		bool has_received = false;
+		bool ack_pending = false;
+		uint16_t remote_sequence = 0; // most recent received packet sequence
+		uint16_t next_receive_message_id = 0;
+		wi::vector<uint32_t> received_packets;
+		wi::vector<ReceiveSlot> receive_slots;
+		wi::vector<uint8_t> unreliable_received; // [size (u16), data] for each message
+		size_t unreliable_read_offset = 0;
+
+		void ProcessAck(uint16_t sequence)
+		{
+			SentPacket& packet = sent_packets[sequence % window_size];
+			if (packet.sequence != sequence || packet.acked)
+				return;
+			packet.acked = true;
+			stats.packets_acked++;
+
+			const float rtt = float(time - packet.time);
+			stats.rtt = stats.rtt == 0 ? rtt : wi::math::Lerp(stats.rtt, rtt, 0.1f);
+
+			for (uint32_t i = 0; i < packet.message_count; ++i)
+			{
+				const uint16_t message_id = packet.message_ids[i];
+				SendSlot& slot = send_slots[message_id % window_size];
+				if (slot.used && slot.message_id == message_id)
+				{
+					slot.acked = true;
+				}
+			}
+		}
+	};
+	ChannelInternal* to_internal(const Channel* param)
+	{
+		return static_cast<ChannelInternal*>(param->internal_state.get());
+	}
+
+	bool CreateChannel(const Socket* sock, const Connection* remote, const ChannelDesc* desc, Channel* channel)
+	{
+		if (sock == nullptr || !sock->IsValid() || remote == nullptr || desc == nullptr)
+			return false;
+
+		std::shared_ptr<ChannelInternal> channelinternal = std::make_shared<ChannelInternal>();
+		channelinternal->socket = *sock;
+		channelinternal->remote = *remote;
+		channelinternal->desc = *desc;
+		channelinternal->desc.mtu = std::max(uint32_t(fragment_header_size + packet_header_size + 1), std::min(uint32_t(max_packet_size), desc->mtu));
+		channelinternal->rng.seed(std::max(uint64_t(1), desc->simulation_seed));
+		channelinternal->sent_packets.resize(window_size);
+		channelinternal->send_slots.resize(window_size);
+		channelinternal->received_packets.resize(window_size, ~0u);
+		channelinternal->receive_slots.resize(window_size);
+		channel->internal_state = channelinternal;
+		return true;
+	}
+
+	bool SendChannelMessage(Channel* channel, const void* data, size_t dataSize, bool reliable)
+	{
+		if (channel == nullptr || !channel->IsValid() || (data == nullptr && dataSize > 0))
+			return false;
+		ChannelInternal& channelinternal = *to_internal(channel);
+		const uint8_t* src = (const uint8_t*)data;
+
+		if (!reliable)
+		{
+			if (dataSize > channelinternal.desc.mtu - packet_header_size - unreliable_header_size)
+				return false;
+			const size_t offset = channelinternal.unreliable_queue.size();
+			channelinternal.unreliable_queue.resize(offset + sizeof(uint16_t) + dataSize);
+			uint8_t* dst = channelinternal.unreliable_queue.data() + offset;
+			write_value(dst, uint16_t(dataSize));
+			if (dataSize > 0)
+			{
+				std::memcpy(dst, src, dataSize);
+			}
+			channelinternal.stats.messages_sent++;
+			return true;
+		}
+
+		// Large messages are split into fragments that each fit into a packet:
+		const size_t fragment_size = channelinternal.desc.mtu - packet_header_size - fragment_header_size;
+		const size_t fragment_count = std::max(size_t(1), (dataSize + fragment_size - 1) / fragment_size);
+		if (fragment_count > max_fragment_count)
+			return false;
+		const uint16_t in_flight = channelinternal.next_message_id - channelinternal.oldest_message_id;
+		if (in_flight + fragment_count > window_size)
+			return false; // the remote endpoint needs to acknowledge the older messages first
+
+		for (size_t i = 0; i < fragment_count; ++i)
+		{
+			const uint16_t message_id = channelinternal.next_message_id++;
+			SendSlot& slot = channelinternal.send_slots[message_id % window_size];
+			slot.used = true;
+			slot.acked = false;
+			slot.message_id = message_id;
+			slot.fragment_index = (uint16_t)i;
+			slot.fragment_count = (uint16_t)fragment_count;
+			slot.send_count = 0;
+			slot.last_sent_time = 0;
+			const size_t offset = i * fragment_size;
+			const size_t size = std::min(fragment_size, dataSize - std::min(dataSize, offset));
+			slot.data.resize(size);
+			if (size > 0)
+			{
+				std::memcpy(slot.data.data(), src + offset, size);
+			}
+		}
+		channelinternal.stats.messages_sent++;
+		return true;
+	}
+
+	void UpdateChannel(Channel* channel, float dt)
+	{
+		if (channel == nullptr || !channel->IsValid())
+			return;
+		ChannelInternal& channelinternal = *to_internal(channel);
+		channelinternal.time += dt;
+		const double time = channelinternal.time;
+
+		// Delayed packets of the latency simulation are sent when their time comes:
+		if (!channelinternal.delayed_packets.empty())
+		{
+			channelinternal.datagrams.clear();
+			for (DelayedPacket& packet : channelinternal.delayed_packets)
+			{
+				if (packet.release_time <= time)
+				{
+					Datagram& datagram = channelinternal.datagrams.emplace_back();
+					datagram.connection = channelinternal.remote;
+					datagram.data = packet.data;
+					datagram.dataSize = packet.size;
+				}
+			}
+			if (!channelinternal.datagrams.empty())
+			{
+				SendBatch(&channelinternal.socket, channelinternal.datagrams.data(), channelinternal.datagrams.size());
+				for (size_t i = 0; i < channelinternal.delayed_packets.size();)
+				{
+					if (channelinternal.delayed_packets[i].release_time <= time)
+					{
+						channelinternal.delayed_packets[i] = channelinternal.delayed_packets.back();
+						channelinternal.delayed_packets.pop_back();
+					}
+					else
+					{
+						i++;
+					}
+				}
+			}
+		}
+
+		// The acknowledgement of the last 33 received packets is included in all outgoing packets:
+		uint32_t ack_bits = 0;
+		for (uint32_t i = 0; i < 32; ++i)
+		{
+			const uint16_t sequence = channelinternal.remote_sequence - 1 - i;
+			if (channelinternal.received_packets[sequence % window_size] == sequence)
+			{
+				ack_bits |= 1u << i;
+			}
+		}
+		const uint8_t packet_flags = channelinternal.has_received ? PACKET_FLAG_HAS_ACK : 0;
+
+		// Messages are coalesced into as few packets as possible:
+		channelinternal.packet_sizes.clear();
+		size_t packet_size = 0; // 0: no open packet
+		SentPacket* sent_packet = nullptr;
+		auto begin_packet = [&]() {
+			const size_t packet_index = channelinternal.packet_sizes.size();
+			if (channelinternal.packet_memory.size() < (packet_index + 1) * max_packet_size)
+			{
+				channelinternal.packet_memory.resize((packet_index + 1) * max_packet_size);
+			}
+			const uint16_t sequence = channelinternal.next_packet_sequence++;
+			uint8_t* dst = channelinternal.packet_memory.data() + packet_index * max_packet_size;
+			write_value(dst, channelinternal.desc.protocol_id);
+			write_value(dst, sequence);
+			write_value(dst, channelinternal.remote_sequence);
+			write_value(dst, ack_bits);
+			write_value(dst, packet_flags);
+			packet_size = packet_header_size;
+
+			sent_packet = &channelinternal.sent_packets[sequence % window_size];
+			sent_packet->sequence = sequence;
+			sent_packet->acked = false;
+			sent_packet->time = time;
+			sent_packet->message_count = 0;
+		};
+		auto end_packet = [&]() {
+			channelinternal.packet_sizes.push_back((uint32_t)packet_size);
+			packet_size = 0;
+		};
+		auto allocate = [&](size_t size, bool reliable) {
+			if (packet_size > 0 && (packet_size + size > channelinternal.desc.mtu || (reliable && sent_packet->message_count >= max_messages_per_packet)))
+			{
+				end_packet();
+			}
+			if (packet_size == 0)
+			{
+				begin_packet();
+			}
+			uint8_t* dst = channelinternal.packet_memory.data() + channelinternal.packet_sizes.size() * max_packet_size + packet_size;
+			packet_size += size;
+			return dst;
+		};
+
+		for (size_t offset = 0; offset < channelinternal.unreliable_queue.size();)
+		{
+			uint16_t size;
+			std::memcpy(&size, channelinternal.unreliable_queue.data() + offset, sizeof(size));
+			offset += sizeof(size);
+			uint8_t* dst = allocate(unreliable_header_size + size, false);
+			write_value(dst, uint8_t(0));
+			write_value(dst, size);
+			std::memcpy(dst, channelinternal.unreliable_queue.data() + offset, size);
+			offset += size;
+		}
+		channelinternal.unreliable_queue.clear();
+
+		// Reliable messages are sent when they were not sent yet, or they were not acknowledged in time:
+		const double resend_time = std::max(double(channelinternal.desc.resend_time), double(channelinternal.stats.rtt) * 1.5);
+		for (uint16_t message_id = channelinternal.oldest_message_id; message_id != channelinternal.next_message_id; ++message_id)
+		{
+			SendSlot& slot = channelinternal.send_slots[message_id % window_size];
+			if (!slot.used || slot.acked)
+				continue;
+			if (slot.send_count > 0 && time - slot.last_sent_time < resend_time)
+				continue;
+			const bool fragment = slot.fragment_count > 1;
+			uint8_t* dst = allocate((fragment ? fragment_header_size : reliable_header_size) + slot.data.size(), true);
+			write_value(dst, uint8_t(MESSAGE_FLAG_RELIABLE | (fragment ? MESSAGE_FLAG_FRAGMENT : 0)));
+			write_value(dst, uint16_t(slot.data.size()));
+			write_value(dst, slot.message_id);
+			if (fragment)
+			{
+				write_value(dst, slot.fragment_index);
+				write_value(dst, slot.fragment_count);
+			}
+			if (!slot.data.empty())
+			{
+				std::memcpy(dst, slot.data.data(), slot.data.size());
+			}
+			sent_packet->message_ids[sent_packet->message_count++] = slot.message_id;
+			if (slot.send_count > 0)
+			{
+				channelinternal.stats.messages_resent++;
+			}
+			slot.send_count++;
+			slot.last_sent_time = time;
+		}
+
+		// If there is nothing to send, an empty packet still carries the acknowledgements:
+		if (packet_size == 0 && channelinternal.packet_sizes.empty() && (channelinternal.ack_pending || time - channelinternal.last_send_time >= channelinternal.desc.keepalive_time))
+		{
+			begin_packet();
+		}
+		if (packet_size > 0)
+		{
+			end_packet();
+		}
+		if (channelinternal.packet_sizes.empty())
+			return;
+		channelinternal.ack_pending = false;
+		channelinternal.last_send_time = time;
+
+		channelinternal.datagrams.clear();
+		for (size_t i = 0; i < channelinternal.packet_sizes.size(); ++i)
+		{
+			const uint32_t size = channelinternal.packet_sizes[i];
+			uint8_t* data = channelinternal.packet_memory.data() + i * max_packet_size;
+			channelinternal.stats.packets_sent++;
+			channelinternal.stats.bytes_sent += size;
+
+			const ChannelDesc& desc = channelinternal.desc;
+			if (desc.simulated_packet_loss > 0 && channelinternal.rng.next_float() < desc.simulated_packet_loss)
+			{
+				channelinternal.stats.packets_dropped_by_simulation++;
+				continue;
+			}
+			const double delay = desc.simulated_latency + (desc.simulated_jitter > 0 ? desc.simulated_jitter * channelinternal.rng.next_float() : 0);
+			if (delay > 0)
+			{
+				DelayedPacket& packet = channelinternal.delayed_packets.emplace_back();
+				packet.release_time = time + delay;
+				packet.size = size;
+				std::memcpy(packet.data, data, size);
+				continue;
+			}
+
+			Datagram& datagram = channelinternal.datagrams.emplace_back();
+			datagram.connection = channelinternal.remote;
+			datagram.data = data;
+			datagram.dataSize = size;
+		}
+		if (!channelinternal.datagrams.empty())
+		{
+			SendBatch(&channelinternal.socket, channelinternal.datagrams.data(), channelinternal.datagrams.size());
+		}
+	}
+
+	bool ProcessChannelPacket(Channel* channel, const void* data, size_t dataSize)
+	{
+		if (channel == nullptr || !channel->IsValid() || data == nullptr)
+			return false;
+		if (dataSize < packet_header_size || dataSize > max_packet_size)
+			return false;
+		ChannelInternal& channelinternal = *to_internal(channel);
+
+		const uint8_t* src = (const uint8_t*)data;
+		const uint8_t* end = src + dataSize;
+		uint32_t protocol_id;
+		uint16_t sequence;
+		uint16_t ack;
+		uint32_t ack_bits;
+		uint8_t packet_flags;
+		read_value(src, end, protocol_id);
+		read_value(src, end, sequence);
+		read_value(src, end, ack);
+		read_value(src, end, ack_bits);
+		read_value(src, end, packet_flags);
+		if (protocol_id != channelinternal.desc.protocol_id)
+			return false;
+
+		// The whole packet is validated before processing, so that a malformed packet doesn't modify the channel:
+		const uint8_t* messages_begin = src;
+		while (src < end)
+		{
+			uint8_t flags;
+			uint16_t size;
+			uint16_t message_id;
+			uint16_t fragment_index;
+			uint16_t fragment_count;
+			read_value(src, end, flags);
+			if (!read_value(src, end, size))
+				return false;
+			if ((flags & MESSAGE_FLAG_RELIABLE) && !read_value(src, end, message_id))
+				return false;
+			if (flags & MESSAGE_FLAG_FRAGMENT)
+			{
+				if (!(flags & MESSAGE_FLAG_RELIABLE) || !read_value(src, end, fragment_index) || !read_value(src, end, fragment_count))
+					return false;
+				if (fragment_count > max_fragment_count || fragment_index >= fragment_count)
+					return false;
+			}
+			if (src + size > end)
+				return false;
+			src += size;
+		}
+
+		channelinternal.stats.packets_received++;
+		channelinternal.stats.bytes_received += dataSize;
+		channelinternal.last_receive_time = channelinternal.time;
+		channelinternal.ack_pending = true;
+
+		if (packet_flags & PACKET_FLAG_HAS_ACK)
+		{
+			channelinternal.ProcessAck(ack);
+			for (uint32_t i = 0; i < 32; ++i)
+			{
+				if (ack_bits & (1u << i))
+				{
+					channelinternal.ProcessAck(ack - 1 - i);
+				}
+			}
+			while (channelinternal.oldest_message_id != channelinternal.next_message_id)
+			{
+				SendSlot& slot = channelinternal.send_slots[channelinternal.oldest_message_id % window_size];
+				if (slot.used && !slot.acked)
+					break;
+				slot.used = false;
+				channelinternal.oldest_message_id++;
+			}
+		}
+
+		if (channelinternal.received_packets[sequence % window_size] == sequence)
+			return true; // duplicate packet, the messages were already processed
+
+		// If a reliable message can't be stored, the packet is not acknowledged, so the sender will resend its messages:
+		bool rejected = false;
+		src = messages_begin;
+		while (src < end)
+		{
+			uint8_t flags = 0;
+			uint16_t size = 0;
+			uint16_t message_id = 0;
+			uint16_t fragment_index = 0;
+			uint16_t fragment_count = 1;
+			read_value(src, end, flags);
+			read_value(src, end, size);
+			if (flags & MESSAGE_FLAG_RELIABLE)
+			{
+				read_value(src, end, message_id);
+			}
+			if (flags & MESSAGE_FLAG_FRAGMENT)
+			{
+				read_value(src, end, fragment_index);
+				read_value(src, end, fragment_count);
+			}
+			const uint8_t* message_data = src;
+			src += size;
+
+			if (!(flags & MESSAGE_FLAG_RELIABLE))
+			{
+				const size_t offset = channelinternal.unreliable_received.size();
+				channelinternal.unreliable_received.resize(offset + sizeof(uint16_t) + size);
+				uint8_t* dst = channelinternal.unreliable_received.data() + offset;
+				write_value(dst, size);
+				std::memcpy(dst, message_data, size);
+				continue;
+			}
+
+			if (sequence_less_than(message_id, channelinternal.next_receive_message_id))
+				continue; // already received
+			ReceiveSlot& slot = channelinternal.receive_slots[message_id % window_size];
+			if (uint16_t(message_id - channelinternal.next_receive_message_id) >= window_size || (slot.used && slot.message_id != message_id))
+			{
+				rejected = true; // the application didn't receive older messages yet
+				continue;
+			}
+			if (slot.used)
+				continue; // already received
+			slot.used = true;
+			slot.message_id = message_id;
+			slot.fragment_index = fragment_index;
+			slot.fragment_count = fragment_count;
+			slot.data.resize(size);
+			if (size > 0)
+			{
+				std::memcpy(slot.data.data(), message_data, size);
+			}
+		}
+
+		if (!rejected)
+		{
+			channelinternal.received_packets[sequence % window_size] = sequence;
+			if (!channelinternal.has_received || sequence_greater_than(sequence, channelinternal.remote_sequence))
+			{
+				channelinternal.remote_sequence = sequence;
+				channelinternal.has_received = true;
+			}
+		}
+		return true;
+	}
+
+	bool ReceiveChannelMessage(Channel* channel, wi::vector<uint8_t>& message)
+	{
+		if (channel == nullptr || !channel->IsValid())
+			return false;
+		ChannelInternal& channelinternal = *to_internal(channel);
+
+		// Unreliable messages are returned as soon as they arrive:
+		if (channelinternal.unreliable_read_offset < channelinternal.unreliable_received.size())
+		{
+			const uint8_t* src = channelinternal.unreliable_received.data() + channelinternal.unreliable_read_offset;
+			uint16_t size;
+			std::memcpy(&size, src, sizeof(size));
+			src += sizeof(size);
+			message.resize(size);
+			if (size > 0)
+			{
+				std::memcpy(message.data(), src, size);
+			}
+			channelinternal.unreliable_read_offset += sizeof(size) + size;
+			if (channelinternal.unreliable_read_offset >= channelinternal.unreliable_received.size())
+			{
+				channelinternal.unreliable_received.clear();
+				channelinternal.unreliable_read_offset = 0;
+			}
+			channelinternal.stats.messages_received++;
+			return true;
+		}
+
+		// Reliable messages are returned in order, fragmented messages only when all of their fragments arrived:
+		const uint16_t message_id = channelinternal.next_receive_message_id;
+		const ReceiveSlot& first = channelinternal.receive_slots[message_id % window_size];
+		if (!first.used || first.message_id != message_id)
+			return false;
+		const uint16_t fragment_count = std::max(uint16_t(1), first.fragment_count);
+		size_t size = 0;
+		for (uint16_t i = 0; i < fragment_count; ++i)
+		{
+			const ReceiveSlot& slot = channelinternal.receive_slots[uint16_t(message_id + i) % window_size];
+			if (!slot.used || slot.message_id != uint16_t(message_id + i))
+				return false;
+			size += slot.data.size();
+		}
+		message.resize(size);
+		size_t offset = 0;
+		for (uint16_t i = 0; i < fragment_count; ++i)
+		{
+			ReceiveSlot& slot = channelinternal.receive_slots[uint16_t(message_id + i) % window_size];
+			if (!slot.data.empty())
+			{
+				std::memcpy(message.data() + offset, slot.data.data(), slot.data.size());
+			}
+			offset += slot.data.size();
+			slot.used = false;
+		}
+		channelinternal.next_receive_message_id += fragment_count;
+		channelinternal.stats.messages_received++;
+		return true;
+	}
+
+	ChannelStatistics GetChannelStatistics(const Channel* channel)
+	{
+		if (channel == nullptr || !channel->IsValid())
+			return {};
+		const ChannelInternal& channelinternal = *to_internal(channel);
+		ChannelStatistics stats = channelinternal.stats;
+		stats.time_since_last_receive = channelinternal.time - channelinternal.last_receive_time;
+		return stats;
+	}
+}
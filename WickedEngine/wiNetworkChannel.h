@@ -0,0 +1,78 @@
+#pragma once
+#include "CommonInclude.h"
+#include "wiNetwork.h"
+#include "wiVector.h"
+
+#include <memory>
+
+namespace wi::network
+{
+	// Message channel between two endpoints on top of UDP sockets. It provides:
+	//	- reliable messages that are delivered exactly once and in the order they were sent
+	//	- unreliable messages that are delivered at most once, as soon as they arrive
+	//	The queued messages are coalesced into packets that fit into the MTU, large reliable messages are fragmented and reassembled
+	//	Packets are acknowledged with sequence numbers and ack bitfields, and only the unacknowledged reliable messages are resent
+	struct Channel
+	{
+		std::shared_ptr<void> internal_state;
+		inline bool IsValid() const { return internal_state.get() != nullptr; }
+	};
+
+	struct ChannelDesc
+	{
+		uint32_t protocol_id = 0x57494E43; // packets with a different protocol id are ignored
+		uint32_t mtu = 1200; // maximum packet size in bytes, including the channel headers
+		float resend_time = 0.1f; // minimum time in seconds before an unacknowledged reliable message is sent again
+		float keepalive_time = 0.1f; // if nothing was sent for this long in seconds, an empty packet is sent to keep the acknowledgements flowing
+
+		// Network condition simulation, applied to outgoing packets, for testing without a real network:
+		float simulated_packet_loss = 0; // probability of dropping a packet [0, 1]
+		float simulated_latency = 0; // delay of packets in seconds
+		float simulated_jitter = 0; // random additional delay of packets in seconds [0, jitter], this can also reorder the packets
+		uint64_t simulation_seed = 1; // seed of the deterministic random generator used for the simulation
+	};
+
+	struct ChannelStatistics
+	{
+		float rtt = 0; // smoothed round trip time in seconds
+		uint64_t packets_sent = 0;
+		uint64_t packets_received = 0;
+		uint64_t packets_acked = 0;
+		uint64_t packets_dropped_by_simulation = 0;
+		uint64_t messages_sent = 0; // number of reliable and unreliable messages queued with SendChannelMessage()
+		uint64_t messages_received = 0; // number of messages returned by ReceiveChannelMessage()
+		uint64_t messages_resent = 0; // number of times a reliable message or fragment was sent again
+		uint64_t bytes_sent = 0;
+		uint64_t bytes_received = 0;
+		double time_since_last_receive = 0; // seconds since a valid packet was processed, can be used to detect timeout
+	};
+
+	// Creates a channel that sends packets to the remote connection through the socket
+	//	sock		:	socket that sends packets, it can be shared by multiple channels
+	//	remote		:	connection of the remote endpoint
+	//	desc		:	parameters of the channel
+	bool CreateChannel(const Socket* sock, const Connection* remote, const ChannelDesc* desc, Channel* channel);
+
+	// Queues a message for sending, it will be sent with the next UpdateChannel()
+	//	data		:	message data, it is copied so it doesn't need to be kept alive
+	//	dataSize	:	size of the message data in bytes
+	//	reliable	:	reliable messages are resent until acknowledged and are received in order, unreliable messages must fit into one packet
+	//	returns false if the message can't be sent, for example too many reliable messages are waiting for acknowledgement
+	bool SendChannelMessage(Channel* channel, const void* data, size_t dataSize, bool reliable = true);
+
+	// Sends the queued messages and resends unacknowledged messages
+	//	dt			:	elapsed time in seconds since the last update
+	void UpdateChannel(Channel* channel, float dt);
+
+	// Processes a packet that was received from the remote connection of the channel (for example with ReceiveBatch())
+	//	The application is responsible for receiving packets and dispatching them to the correct channel, so that multiple channels can share a socket
+	//	returns false if the packet is not a valid packet of this channel
+	bool ProcessChannelPacket(Channel* channel, const void* data, size_t dataSize);
+
+	// Returns the next received message, reliable messages are returned in the order they were sent
+	//	message		:	the message data will be copied here, the vector can be reused to avoid allocations
+	//	returns false if there are no messages to receive
+	bool ReceiveChannelMessage(Channel* channel, wi::vector<uint8_t>& message);
+
+	ChannelStatistics GetChannelStatistics(const Channel* channel);
+}
@@ -14,10 +14,9 @@ namespace wi::lua
 
 	void Network_BindLua::Bind()
 	{
-		static bool initialized = false;
-		if (!initialized)
+		static const char binding_key = 0;
+		if (wi::lua::BeginBinding(&binding_key))
 		{
-			initialized = true;
 			Luna<Network_BindLua>::Register(wi::lua::GetLuaState());
 			Luna<Network_BindLua>::push_global(wi::lua::GetLuaState(), "network");
 		}
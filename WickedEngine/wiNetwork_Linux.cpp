@@ -6,10 +6,14 @@
 #include "wiTimer.h"
 
 #include <string>
+#include <cstring>
+#include <algorithm>
 #include <unistd.h>
 #include <errno.h>
+#include <fcntl.h>
 
 #include <sys/socket.h>
+#include <sys/select.h>
 #include <netinet/in.h>
 
 namespace wi::network
@@ -114,7 +118,7 @@ namespace wi::network
 			timeout.tv_sec = 0;
 			timeout.tv_usec = timeout_microseconds;
 
-			int result = select(0, &readfds, NULL, NULL, &timeout);
+			int result = select(socketinternal->handle + 1, &readfds, NULL, NULL, &timeout);
 			if (result < 0)
 			{
 				wi::backlog::post("wi::network_Linux error in Send: (Error Code: " + std::to_string(result) + ") " + std::string(strerror(result)));
@@ -135,6 +139,10 @@ namespace wi::network
 			sockaddr_in sender;
 			int targetsize = sizeof(sender);
 			int result = recvfrom(socketinternal->handle, (char*)data, (int)dataSize, 0, (sockaddr*)& sender, (socklen_t*)&targetsize);
+			if (result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			{
+				return false; // non-blocking socket, nothing to receive
+			}
 			if (result < 0)
 			{
 				wi::backlog::post("wi::network_Linux error in Send: (Error Code: " + std::to_string(result) + ") " + std::string(strerror(result)));
@@ -154,6 +162,147 @@ namespace wi::network
 		}
 		return false;
 	}
+
+	bool SetNonBlocking(const Socket* sock, bool value)
+	{
+		if (sock->IsValid()){
+			auto socketinternal = to_internal(sock);
+
+			int flags = fcntl(socketinternal->handle, F_GETFL, 0);
+			if (flags >= 0)
+			{
+				flags = value ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK);
+				flags = fcntl(socketinternal->handle, F_SETFL, flags);
+			}
+			if (flags < 0)
+			{
+				wi::backlog::post("wi::network_Linux error in SetNonBlocking: (Error Code: " + std::to_string(errno) + ") " + std::string(strerror(errno)));
+				return false;
+			}
+
+			return true;
+		}
+		return false;
+	}
+
+	// The batches are processed in chunks, so that the system call parameters can be kept on the stack
+	static constexpr size_t batch_chunk_size = 64;
+
+	size_t SendBatch(const Socket* sock, const Datagram* datagrams, size_t count)
+	{
+		if (sock->IsValid()){
+			auto socketinternal = to_internal(sock);
+
+			mmsghdr messages[batch_chunk_size];
+			iovec buffers[batch_chunk_size];
+			sockaddr_in targets[batch_chunk_size];
+
+			size_t sent = 0;
+			while (sent < count)
+			{
+				const size_t batch = std::min(count - sent, batch_chunk_size);
+				for (size_t i = 0; i < batch; ++i)
+				{
+					const Datagram& datagram = datagrams[sent + i];
+
+					sockaddr_in& target = targets[i];
+					target = {};
+					target.sin_family = AF_INET;
+					target.sin_port = htons(datagram.connection.port);
+					in_addr_union address;
+					address.S_un_b.s_b1 = datagram.connection.ipaddress[0];
+					address.S_un_b.s_b2 = datagram.connection.ipaddress[1];
+					address.S_un_b.s_b3 = datagram.connection.ipaddress[2];
+					address.S_un_b.s_b4 = datagram.connection.ipaddress[3];
+					target.sin_addr.s_addr = address.S_addr;
+
+					buffers[i].iov_base = datagram.data;
+					buffers[i].iov_len = datagram.dataSize;
+
+					messages[i] = {};
+					messages[i].msg_hdr.msg_name = &target;
+					messages[i].msg_hdr.msg_namelen = sizeof(target);
+					messages[i].msg_hdr.msg_iov = &buffers[i];
+					messages[i].msg_hdr.msg_iovlen = 1;
+				}
+
+				int result = sendmmsg(socketinternal->handle, messages, (unsigned int)batch, 0);
+				if (result < 0)
+				{
+					if (errno != EAGAIN && errno != EWOULDBLOCK)
+					{
+						wi::backlog::post("wi::network_Linux error in SendBatch: (Error Code: " + std::to_string(errno) + ") " + std::string(strerror(errno)));
+					}
+					break;
+				}
+				sent += (size_t)result;
+				if ((size_t)result < batch)
+					break; // send buffer is full
+			}
+			return sent;
+		}
+		return 0;
+	}
+
+	size_t ReceiveBatch(const Socket* sock, Datagram* datagrams, size_t count)
+	{
+		if (sock->IsValid()){
+			auto socketinternal = to_internal(sock);
+
+			mmsghdr messages[batch_chunk_size];
+			iovec buffers[batch_chunk_size];
+			sockaddr_in senders[batch_chunk_size];
+
+			size_t received = 0;
+			while (received < count)
+			{
+				const size_t batch = std::min(count - received, batch_chunk_size);
+				for (size_t i = 0; i < batch; ++i)
+				{
+					Datagram& datagram = datagrams[received + i];
+
+					buffers[i].iov_base = datagram.data;
+					buffers[i].iov_len = datagram.capacity;
+
+					messages[i] = {};
+					messages[i].msg_hdr.msg_name = &senders[i];
+					messages[i].msg_hdr.msg_namelen = sizeof(senders[i]);
+					messages[i].msg_hdr.msg_iov = &buffers[i];
+					messages[i].msg_hdr.msg_iovlen = 1;
+				}
+
+				// Only the first chunk is allowed to wait (if the socket is blocking), after that only the already available packets are received:
+				const int flags = received == 0 ? MSG_WAITFORONE : MSG_DONTWAIT;
+				int result = recvmmsg(socketinternal->handle, messages, (unsigned int)batch, flags, nullptr);
+				if (result < 0)
+				{
+					if (errno != EAGAIN && errno != EWOULDBLOCK)
+					{
+						wi::backlog::post("wi::network_Linux error in ReceiveBatch: (Error Code: " + std::to_string(errno) + ") " + std::string(strerror(errno)));
+					}
+					break;
+				}
+
+				for (int i = 0; i < result; ++i)
+				{
+					Datagram& datagram = datagrams[received + i];
+					datagram.dataSize = messages[i].msg_len;
+					datagram.connection.port = htons(senders[i].sin_port); // reverse byte order from network to host
+					in_addr_union address;
+					address.S_addr = senders[i].sin_addr.s_addr;
+					datagram.connection.ipaddress[0] = address.S_un_b.s_b1;
+					datagram.connection.ipaddress[1] = address.S_un_b.s_b2;
+					datagram.connection.ipaddress[2] = address.S_un_b.s_b3;
+					datagram.connection.ipaddress[3] = address.S_un_b.s_b4;
+				}
+				received += (size_t)result;
+				if ((size_t)result < batch)
+					break; // no more packets available
+			}
+			return received;
+		}
+		return 0;
+	}
 }
 
 #endif // LINUX
@@ -47,6 +47,7 @@ namespace wi::network
 	{
 		std::shared_ptr<NetworkInternal> networkinternal;
 		SOCKET handle = NULL;
+		bool nonblocking = false;
 
 		~SocketInternal()
 		{
@@ -169,6 +170,10 @@ namespace wi::network
 			if (result == SOCKET_ERROR)
 			{
 				int error = WSAGetLastError();
+				if (error == WSAEWOULDBLOCK)
+				{
+					return false; // non-blocking socket, nothing to receive
+				}
 				wi::backlog::post("wi::network error in Receive: " + std::to_string(error));
 				return false;
 			}
@@ -184,6 +189,104 @@ namespace wi::network
 		return false;
 	}
 
+	bool SetNonBlocking(const Socket* sock, bool value)
+	{
+		if (socket != nullptr && sock->IsValid())
+		{
+			auto socketinternal = to_internal(sock);
+
+			u_long mode = value ? 1 : 0;
+			int result = ioctlsocket(socketinternal->handle, FIONBIO, &mode);
+			if (result == SOCKET_ERROR)
+			{
+				int error = WSAGetLastError();
+				wi::backlog::post("wi::network error in SetNonBlocking: " + std::to_string(error));
+				return false;
+			}
+			socketinternal->nonblocking = value;
+
+			return true;
+		}
+		return false;
+	}
+
+	// Winsock doesn't have batched send and receive for UDP, so these are processed one by one
+	size_t SendBatch(const Socket* sock, const Datagram* datagrams, size_t count)
+	{
+		if (socket != nullptr && sock->IsValid())
+		{
+			auto socketinternal = to_internal(sock);
+
+			size_t sent = 0;
+			for (; sent < count; ++sent)
+			{
+				const Datagram& datagram = datagrams[sent];
+
+				sockaddr_in target;
+				target.sin_family = AF_INET;
+				target.sin_port = htons(datagram.connection.port); // reverse byte order from host to network
+				target.sin_addr.S_un.S_un_b.s_b1 = datagram.connection.ipaddress[0];
+				target.sin_addr.S_un.S_un_b.s_b2 = datagram.connection.ipaddress[1];
+				target.sin_addr.S_un.S_un_b.s_b3 = datagram.connection.ipaddress[2];
+				target.sin_addr.S_un.S_un_b.s_b4 = datagram.connection.ipaddress[3];
+
+				int result = sendto(socketinternal->handle, (const char*)datagram.data, (int)datagram.dataSize, 0, (const sockaddr*)&target, sizeof(target));
+				if (result == SOCKET_ERROR)
+				{
+					int error = WSAGetLastError();
+					if (error != WSAEWOULDBLOCK)
+					{
+						wi::backlog::post("wi::network error in SendBatch: " + std::to_string(error));
+					}
+					break;
+				}
+			}
+			return sent;
+		}
+		return 0;
+	}
+
+	size_t ReceiveBatch(const Socket* sock, Datagram* datagrams, size_t count)
+	{
+		if (socket != nullptr && sock->IsValid())
+		{
+			auto socketinternal = to_internal(sock);
+
+			size_t received = 0;
+			while (received < count)
+			{
+				// Only the first packet is allowed to wait (if the socket is blocking), after that only the already available packets are received:
+				if (received > 0 && !socketinternal->nonblocking && !CanReceive(sock, 0))
+					break;
+
+				Datagram& datagram = datagrams[received];
+
+				sockaddr_in sender;
+				int targetsize = sizeof(sender);
+				int result = recvfrom(socketinternal->handle, (char*)datagram.data, (int)datagram.capacity, 0, (sockaddr*)&sender, &targetsize);
+				if (result == SOCKET_ERROR)
+				{
+					int error = WSAGetLastError();
+					if (error != WSAEWOULDBLOCK)
+					{
+						wi::backlog::post("wi::network error in ReceiveBatch: " + std::to_string(error));
+					}
+					break;
+				}
+
+				datagram.dataSize = (size_t)result;
+				datagram.connection.port = htons(sender.sin_port); // reverse byte order from network to host
+				datagram.connection.ipaddress[0] = sender.sin_addr.S_un.S_un_b.s_b1;
+				datagram.connection.ipaddress[1] = sender.sin_addr.S_un.S_un_b.s_b2;
+				datagram.connection.ipaddress[2] = sender.sin_addr.S_un.S_un_b.s_b3;
+				datagram.connection.ipaddress[3] = sender.sin_addr.S_un.S_un_b.s_b4;
+				received++;
+			}
+			return received;
+		}
+		return 0;
+	}
+
 }
 
 #endif // PLATFORM_WINDOWS_DESKTOP
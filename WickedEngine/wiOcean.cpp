@@ -7,6 +7,7 @@
 #include "wiEventHandler.h"
 #include "wiTimer.h"
 #include "wiVector.h"
+#include "wiRandom.h"
 
 #include <algorithm>
 #include <mutex>
@@ -75,10 +76,10 @@ namespace wi
 #define GRAV_ACCEL	981.0f	// The acceleration of gravity, cm/s^2
 
 	// Generating gaussian random number with mean 0 and standard deviation 1.
-	float Gauss()
+	float Gauss(wi::random::RNG& rng)
 	{
-		float u1 = rand() / (float)RAND_MAX;
-		float u2 = rand() / (float)RAND_MAX;
+		float u1 = rng.next_float();
+		float u2 = rng.next_float();
 		if (u1 < 1e-6f)
 			u1 = 1e-6f;
 		return std::sqrt(-2 * logf(u1)) * cosf(2 * XM_PI * u2);
@@ -119,10 +120,17 @@ namespace wi
 
 		// Height map H(0)
 		int height_map_size = (params.dmap_dim + 4) * (params.dmap_dim + 1);
-		wi::vector<XMFLOAT2> h0_data(height_map_size);
-		wi::vector<float> omega_data(height_map_size);
+		h0_data.resize(height_map_size);
+		omega_data.resize(height_map_size);
 		initHeightMap(h0_data.data(), omega_data.data());
 
+		spectrum_cpu.clear();
+		displacementMap_cpu.clear();
+		displacementMap_cpu_dim = 0;
+
+		if (device == nullptr)
+			return; // without graphics device, only the CPU simulation is available
+
 		int hmap_dim = params.dmap_dim;
 		int input_full_size = (hmap_dim + 4) * (hmap_dim + 1);
 		// This value should be (hmap_dim / 2 + 1) * hmap_dim, but we use full sized buffer here for simplicity.
@@ -210,10 +218,123 @@ namespace wi
 		device->CreateBuffer(&cb_desc, nullptr, &constantBuffer);
 	}
 
+	void Ocean::UpdateDisplacementMapCPU(float time, uint32_t dim)
+	{
+		const uint32_t actual_dim = (uint32_t)params.dmap_dim;
+		const uint32_t input_width = actual_dim + 4;
+		if (h0_data.size() != size_t(input_width * (actual_dim + 1)))
+			return;
+		dim = clamp(dim, 4u, actual_dim);
+		assert((dim & (dim - 1)) == 0);
+
+		// The reduced map takes the center of the spectrum, which contains the lowest frequencies:
+		const uint32_t offset = (actual_dim - dim) / 2;
+		const uint32_t size = dim * dim;
+		const float t = time * params.time_scale;
+
+		spectrum_cpu.resize(size * 6);
+		float* ht_real = spectrum_cpu.data();
+		float* ht_imag = ht_real + size;
+		float* dtx_real = ht_imag + size;
+		float* dtx_imag = dtx_real + size;
+		float* dty_real = dtx_imag + size;
+		float* dty_imag = dty_real + size;
+
+		// H(0) -> H(t), same as oceanSimulatorCS:
+		for (uint32_t y = 0; y < dim; ++y)
+		{
+			for (uint32_t x = 0; x < dim; ++x)
+			{
+				const uint32_t kx_index = x + offset;
+				const uint32_t ky_index = y + offset;
+				const uint32_t in_index = ky_index * input_width + kx_index;
+				const uint32_t in_mindex = (actual_dim - ky_index) * input_width + (actual_dim - kx_index);
+				const uint32_t out_index = y * dim + x;
+
+				const XMFLOAT2 h0_k = h0_data[in_index];
+				const XMFLOAT2 h0_mk = h0_data[in_mindex];
+				float sin_v, cos_v;
+				XMScalarSinCos(&sin_v, &cos_v, omega_data[in_index] * t);
+
+				const float ht_x = (h0_k.x + h0_mk.x) * cos_v - (h0_k.y + h0_mk.y) * sin_v;
+				const float ht_y = (h0_k.x - h0_mk.x) * sin_v + (h0_k.y - h0_mk.y) * cos_v;
+
+				// H(t) -> Dx(t), Dy(t)
+				float kx = float(kx_index) - actual_dim * 0.5f;
+				float ky = float(ky_index) - actual_dim * 0.5f;
+				const float sqr_k = kx * kx + ky * ky;
+				const float rsqr_k = sqr_k > 1e-12f ? 1.0f / std::sqrt(sqr_k) : 0.0f;
+				kx *= rsqr_k;
+				ky *= rsqr_k;
+
+				ht_real[out_index] = ht_x;
+				ht_imag[out_index] = ht_y;
+				dtx_real[out_index] = ht_y * kx;
+				dtx_imag[out_index] = -ht_x * kx;
+				dty_real[out_index] = ht_y * ky;
+				dty_imag[out_index] = -ht_x * ky;
+			}
+		}
+
+		wi::fftgenerator::fft_c2c_cpu(dim, ht_real, ht_imag);
+		wi::fftgenerator::fft_c2c_cpu(dim, dtx_real, dtx_imag);
+		wi::fftgenerator::fft_c2c_cpu(dim, dty_real, dty_imag);
+
+		// Same as oceanUpdateDisplacementMapCS:
+		displacementMap_cpu.resize(size);
+		displacementMap_cpu_dim = dim;
+		for (uint32_t y = 0; y < dim; ++y)
+		{
+			for (uint32_t x = 0; x < dim; ++x)
+			{
+				const uint32_t index = y * dim + x;
+				// cos(pi * (m1 + m2))
+				const float sign_correction = ((x + y) & 1) ? -1.0f : 1.0f;
+				displacementMap_cpu[index] = XMFLOAT4(
+					dtx_real[index] * sign_correction * params.choppy_scale,
+					dty_real[index] * sign_correction * params.choppy_scale,
+					ht_real[index] * sign_correction,
+					1
+				);
+			}
+		}
+	}
+
+	void Ocean::ClearDisplacementMapCPU()
+	{
+		spectrum_cpu.clear();
+		displacementMap_cpu.clear();
+		displacementMap_cpu_dim = 0;
+	}
+
 	XMFLOAT3 Ocean::GetDisplacedPosition(const XMFLOAT3& worldPosition) const
 	{
 		XMFLOAT3 ocean_pos = XMFLOAT3(worldPosition.x, params.waterHeight, worldPosition.z);
-		if (displacement_readback_valid[displacement_readback_index])
+		if (!displacementMap_cpu.empty())
+		{
+			// The CPU displacement map is periodic, texel (m) corresponds to position (m * patch_length / dim):
+			const float patch_size_rcp = 1.0f / params.patch_length;
+			const XMFLOAT2 uv = XMFLOAT2(frac(ocean_pos.x * patch_size_rcp), frac(ocean_pos.z * patch_size_rcp));
+			const XMFLOAT2 fpixel = XMFLOAT2(uv.x * displacementMap_cpu_dim, uv.y * displacementMap_cpu_dim);
+			const XMFLOAT2 pixel_frac = XMFLOAT2(frac(fpixel.x), frac(fpixel.y));
+			const uint32_t x0 = std::min((uint32_t)fpixel.x, displacementMap_cpu_dim - 1);
+			const uint32_t y0 = std::min((uint32_t)fpixel.y, displacementMap_cpu_dim - 1);
+			const uint32_t x1 = (x0 + 1) % displacementMap_cpu_dim;
+			const uint32_t y1 = (y0 + 1) % displacementMap_cpu_dim;
+			const XMVECTOR displacement_tl = XMLoadFloat4(&displacementMap_cpu[y0 * displacementMap_cpu_dim + x0]);
+			const XMVECTOR displacement_tr = XMLoadFloat4(&displacementMap_cpu[y0 * displacementMap_cpu_dim + x1]);
+			const XMVECTOR displacement_bl = XMLoadFloat4(&displacementMap_cpu[y1 * displacementMap_cpu_dim + x0]);
+			const XMVECTOR displacement_br = XMLoadFloat4(&displacementMap_cpu[y1 * displacementMap_cpu_dim + x1]);
+			const XMVECTOR displacement_t = XMVectorLerp(displacement_tl, displacement_tr, pixel_frac.x);
+			const XMVECTOR displacement_b = XMVectorLerp(displacement_bl, displacement_br, pixel_frac.x);
+			XMFLOAT4 displacement;
+			XMStoreFloat4(&displacement, XMVectorLerp(displacement_t, displacement_b, pixel_frac.y));
+			// xzy swizzle is on purpose, that's how the data is generated:
+			ocean_pos.x += displacement.x;
+			ocean_pos.y += displacement.z;
+			ocean_pos.z += displacement.y;
+		}
+		else if (displacement_readback_valid[displacement_readback_index])
 		{
 			const Texture& tex = displacementMap_readback[displacement_readback_index];
 			const uint8_t* bytedata = (const uint8_t*)tex.mapped_data;
@@ -267,6 +388,9 @@ namespace wi
 		int height_map_dim = params.dmap_dim;
 		float patch_length = params.patch_length;
 
+		// Fixed seed, so the same parameters always generate the same waves on every machine:
+		wi::random::RNG rng(0x6f6365616e);
+
 
 		for (i = 0; i <= height_map_dim; i++)
 		{
@@ -279,8 +403,8 @@ namespace wi
 
 				float phil = (K.x == 0 && K.y == 0) ? 0 : std::sqrt(Phillips(K, wind_dir, v, a, dir_depend));
 
-				out_h0[i * (height_map_dim + 4) + j].x = float(phil * Gauss() * HALF_SQRT_2);
-				out_h0[i * (height_map_dim + 4) + j].y = float(phil * Gauss() * HALF_SQRT_2);
+				out_h0[i * (height_map_dim + 4) + j].x = float(phil * Gauss(rng) * HALF_SQRT_2);
+				out_h0[i * (height_map_dim + 4) + j].y = float(phil * Gauss(rng) * HALF_SQRT_2);
 
 				// The angular frequency is following the dispersion relation:
 				//            out_omega^2 = g*k
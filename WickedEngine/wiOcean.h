@@ -4,6 +4,7 @@
 #include "wiFFTGenerator.h"
 #include "wiScene_Decl.h"
 #include "wiMath.h"
+#include "wiVector.h"
 
 namespace wi
 {
@@ -51,7 +52,7 @@ namespace wi
 
 		static void Initialize();
 
-		bool IsValid() const { return displacementMap.IsValid(); }
+		bool IsValid() const { return !h0_data.empty(); }
 
 		// occlusion result history bitfield (32 bit->32 frame history)
 		mutable uint32_t occlusionHistory = ~0u;
@@ -65,7 +66,16 @@ namespace wi
 			return occlusionHistory == 0;
 		}
 
+		// Evaluate the ocean simulation on the CPU into a reduced resolution displacement map
+		//	This doesn't require a graphics device and the result only depends on the parameters and time, so servers can use it for gameplay queries
+		//	time	: simulation time in seconds
+		//	dim		: resolution of the displacement map, must be power of two. Only the lowest frequency waves will be evaluated if it's lower than dmap_dim
+		void UpdateDisplacementMapCPU(float time, uint32_t dim = 64);
+		// Release the CPU displacement map, so that GetDisplacedPosition() uses the GPU readback again
+		void ClearDisplacementMapCPU();
+
 		// Return the position at world space modified by the ocean displacement map
+		//	If UpdateDisplacementMapCPU() was used (and not cleared since), then the CPU displacement map is sampled, otherwise the GPU readback
 		XMFLOAT3 GetDisplacedPosition(const XMFLOAT3& worldPosition) const;
 
 		OceanParameters params;
@@ -80,6 +90,14 @@ namespace wi
 
 		void initHeightMap(XMFLOAT2* out_h0, float* out_omega);
 
+		// Initial height field and angular frequency, kept on the CPU for the CPU simulation:
+		wi::vector<XMFLOAT2> h0_data;
+		wi::vector<float> omega_data;
+
+		// CPU simulation:
+		wi::vector<float> spectrum_cpu; // real and imaginary parts of H(t), Dx(t) and Dy(t)
+		wi::vector<XMFLOAT4> displacementMap_cpu;
+		uint32_t displacementMap_cpu_dim = 0;
 
 		// Initial height field H(0) generated by Phillips spectrum & Gauss distribution.
 		wi::graphics::GPUBuffer buffer_Float2_H0;
@@ -3,6 +3,9 @@
 #include "wiEventHandler.h"
 #include "wiProfiler.h"
 #include "wiPrimitive.h"
+#include "wiJobSystem.h"
+
+#include <algorithm>
 
 using namespace wi::graphics;
 using namespace wi::primitive;
@@ -15,6 +18,59 @@ namespace wi
 		const XMFLOAT3& goalpos,
 		const wi::VoxelGrid& voxelgrid
 	)
+	{
+		XMUINT3 start;
+		XMUINT3 goal;
+		if (!begin_process(startpos, goalpos, voxelgrid, start, goal))
+			return;
+		search_voxels(start, goal, voxelgrid);
+		simplify_path(voxelgrid);
+	}
+
+	void PathQuery::process(
+		const XMFLOAT3& startpos,
+		const XMFLOAT3& goalpos,
+		const wi::VoxelGrid& voxelgrid,
+		const wi::PathHierarchy& hierarchy
+	)
+	{
+		XMUINT3 start;
+		XMUINT3 goal;
+		if (!begin_process(startpos, goalpos, voxelgrid, start, goal))
+			return;
+		if (!hierarchy.is_compatible(*this, voxelgrid) || !search_hierarchy(start, goal, voxelgrid, hierarchy, scratch))
+		{
+			search_voxels(start, goal, voxelgrid);
+		}
+		simplify_path(voxelgrid);
+	}
+
+	void PathQuery::process(
+		const XMFLOAT3& startpos,
+		const XMFLOAT3& goalpos,
+		const wi::VoxelGrid& voxelgrid,
+		const wi::PathHierarchy* hierarchy,
+		Scratch& scratch
+	)
+	{
+		XMUINT3 start;
+		XMUINT3 goal;
+		if (!begin_process(startpos, goalpos, voxelgrid, start, goal))
+			return;
+		if (hierarchy == nullptr || !hierarchy->is_compatible(*this, voxelgrid) || !search_hierarchy(start, goal, voxelgrid, *hierarchy, scratch))
+		{
+			search_voxels(start, goal, voxelgrid, scratch);
+		}
+		simplify_path(voxelgrid);
+	}
+
+	bool PathQuery::begin_process(
+		const XMFLOAT3& startpos,
+		const XMFLOAT3& goalpos,
+		const wi::VoxelGrid& voxelgrid,
+		XMUINT3& start,
+		XMUINT3& goal
+	)
 	{
 		frontier = {};
 		came_from.clear();
@@ -22,45 +78,13 @@ namespace wi
 		result_path_goal_to_start.clear();
 		result_path_goal_to_start_simplified.clear();
 		process_startpos = startpos;
-		Node start = Node::create(voxelgrid.world_to_coord(startpos));
-		Node goal = Node::create(voxelgrid.world_to_coord(goalpos));
-		debugstartnode = voxelgrid.coord_to_world(start.coord());
-		debuggoalnode = voxelgrid.coord_to_world(goal.coord());
+		start = Node::create(voxelgrid.world_to_coord(startpos)).coord();
+		goal = Node::create(voxelgrid.world_to_coord(goalpos)).coord();
+		debugstartnode = voxelgrid.coord_to_world(start);
+		debuggoalnode = voxelgrid.coord_to_world(goal);
 		debugvoxelsize = voxelgrid.voxelSize;
 
-		auto cost_to_goal = [&](XMUINT3 coord, XMUINT3 goal) {
-			// manhattan distance:
-			return std::abs(int(coord.x) - int(goal.x)) + std::abs(int(coord.y) - int(goal.y)) + std::abs(int(coord.z) - int(goal.z));
-		};
-		auto dda = [&](const XMUINT3& start, const XMUINT3& goal)
-		{
-			const int dx = int(goal.x) - int(start.x);
-			const int dy = int(goal.y) - int(start.y);
-			const int dz = int(goal.z) - int(start.z);
-
-			const int step = std::max(std::abs(dx), std::max(std::abs(dy), std::abs(dz)));
-
-			const float x_incr = float(dx) / step;
-			const float y_incr = float(dy) / step;
-			const float z_incr = float(dz) / step;
-
-			float x = float(start.x);
-			float y = float(start.y);
-			float z = float(start.z);
-
-			for (int i = 0; i < step; i++)
-			{
-				XMUINT3 coord = XMUINT3(uint32_t(std::round(x)), uint32_t(std::round(y)), uint32_t(std::round(z)));
-				if (!is_voxel_valid(voxelgrid, coord))
-					return false;
-				x += x_incr;
-				y += y_incr;
-				z += z_incr;
-			}
-			return true;
-		};
-
-		if (!is_voxel_valid(voxelgrid, goal.coord()))
+		if (!is_voxel_valid(voxelgrid, goal))
 		{
 			// If goal is unreachable because it is not a valid voxel, check immediate neighborhood:
 			//	This works better than abandoning when goal happens to be in an invalid voxel because
@@ -81,7 +105,7 @@ namespace wi
 						XMUINT3 neighbor_coord = XMUINT3(uint32_t(goal.x + x), uint32_t(goal.y + y), uint32_t(goal.z + z));
 						if (is_voxel_valid(voxelgrid, neighbor_coord))
 						{
-							goal = Node::create(neighbor_coord);
+							goal = neighbor_coord;
 							found = true;
 							break;
 						}
@@ -91,9 +115,21 @@ namespace wi
 			if (!found)
 			{
 				// if neighborhood was not valid at all, then abandon the search:
-				return;
+				return false;
 			}
 		}
+		return true;
+	}
+
+	void PathQuery::search_voxels(XMUINT3 start_coord, XMUINT3 goal_coord, const wi::VoxelGrid& voxelgrid)
+	{
+		const Node start = Node::create(start_coord);
+		const Node goal = Node::create(goal_coord);
+
+		auto cost_to_goal = [&](XMUINT3 coord, XMUINT3 goal) {
+			// manhattan distance:
+			return std::abs(int(coord.x) - int(goal.x)) + std::abs(int(coord.y) - int(goal.y)) + std::abs(int(coord.z) - int(goal.z));
+		};
 
 		// A* explanation at: https://www.redblobgames.com/pathfinding/a-star/introduction.html
 		frontier.emplace(start);
@@ -193,6 +229,423 @@ namespace wi
 			result_path_goal_to_start.push_back(voxelgrid.coord_to_world(node.coord()));
 			current = node;
 		}
+	}
+
+	namespace PathHierarchy_internal
+	{
+		// The 26 neighbor directions, in the same order as the neighbors of the voxel search
+		struct Directions
+		{
+			XMINT3 offsets[26];
+			uint32_t costs[26]; // manhattan length of the step, same as the step cost of the voxel search
+			Directions()
+			{
+				uint32_t count = 0;
+				for (int x = -1; x <= 1; ++x)
+				{
+					for (int y = -1; y <= 1; ++y)
+					{
+						for (int z = -1; z <= 1; ++z)
+						{
+							if (x == 0 && y == 0 && z == 0)
+							{
+								continue;
+							}
+							offsets[count] = XMINT3(x, y, z);
+							costs[count] = uint32_t(std::abs(x) + std::abs(y) + std::abs(z));
+							count++;
+						}
+					}
+				}
+			}
+		};
+		static const Directions directions;
+		static constexpr uint8_t invalid_direction = 0xFF;
+		static constexpr uint32_t invalid_cost = ~0u;
+		static constexpr uint32_t invalid_node = ~0u;
+
+		inline uint32_t& axis_of(XMUINT3& v, int axis) { return (&v.x)[axis]; }
+		inline uint32_t axis_of(const XMUINT3& v, int axis) { return (&v.x)[axis]; }
+		inline XMUINT3 step(const XMUINT3& coord, uint8_t direction, int sign = 1)
+		{
+			const XMINT3& offset = directions.offsets[direction];
+			return XMUINT3(uint32_t(int(coord.x) + offset.x * sign), uint32_t(int(coord.y) + offset.y * sign), uint32_t(int(coord.z) + offset.z * sign));
+		}
+		inline uint32_t manhattan(const XMUINT3& a, const XMUINT3& b)
+		{
+			return uint32_t(std::abs(int(a.x) - int(b.x)) + std::abs(int(a.y) - int(b.y)) + std::abs(int(a.z) - int(b.z)));
+		}
+		inline uint32_t local_index(const PathHierarchy::Cluster& cluster, const XMUINT3& coord)
+		{
+			return (coord.x - cluster.origin.x) + (coord.y - cluster.origin.y) * cluster.size.x + (coord.z - cluster.origin.z) * cluster.size.x * cluster.size.y;
+		}
+		inline bool is_inside(const PathHierarchy::Cluster& cluster, const XMUINT3& coord)
+		{
+			// the unsigned subtraction also handles the wrapped around negative coordinates:
+			return
+				(coord.x - cluster.origin.x) < cluster.size.x &&
+				(coord.y - cluster.origin.y) < cluster.size.y &&
+				(coord.z - cluster.origin.z) < cluster.size.z;
+		}
+
+		inline void heap_push(wi::vector<uint64_t>& heap, uint32_t cost, uint32_t index)
+		{
+			heap.push_back((uint64_t(cost) << 32ull) | uint64_t(index));
+			std::push_heap(heap.begin(), heap.end(), std::greater<uint64_t>());
+		}
+		inline uint64_t heap_pop(wi::vector<uint64_t>& heap)
+		{
+			std::pop_heap(heap.begin(), heap.end(), std::greater<uint64_t>());
+			const uint64_t item = heap.back();
+			heap.pop_back();
+			return item;
+		}
+
+		// Dijkstra search from the source voxel to the walkable voxels of the cluster
+		//	cost	: cost of reaching each voxel of the cluster from the source, invalid_cost if not reachable
+		//	parent	: direction of the step that reached each voxel, invalid_direction for the source and unreached voxels
+		//	The source itself doesn't need to be walkable
+		static void search_cluster(
+			const PathHierarchy::Cluster& cluster,
+			const XMUINT3& source,
+			wi::vector<uint32_t>& cost,
+			wi::vector<uint8_t>& parent,
+			wi::vector<uint64_t>& heap
+		)
+		{
+			const uint32_t voxel_count = cluster.size.x * cluster.size.y * cluster.size.z;
+			cost.assign(voxel_count, invalid_cost);
+			parent.assign(voxel_count, invalid_direction);
+			heap.clear();
+
+			const uint32_t source_index = local_index(cluster, source);
+			cost[source_index] = 0;
+			heap_push(heap, 0, source_index);
+
+			while (!heap.empty())
+			{
+				const uint64_t item = heap_pop(heap);
+				const uint32_t current_cost = uint32_t(item >> 32ull);
+				const uint32_t current_index = uint32_t(item & 0xFFFFFFFF);
+				if (current_cost > cost[current_index])
+					continue; // outdated heap entry
+
+				const XMUINT3 coord = XMUINT3(
+					cluster.origin.x + current_index % cluster.size.x,
+					cluster.origin.y + (current_index / cluster.size.x) % cluster.size.y,
+					cluster.origin.z + current_index / (cluster.size.x * cluster.size.y)
+				);
+				for (uint8_t direction = 0; direction < arraysize(directions.offsets); ++direction)
+				{
+					const XMUINT3 neighbor = step(coord, direction);
+					if (!is_inside(cluster, neighbor))
+						continue;
+					const uint32_t neighbor_index = local_index(cluster, neighbor);
+					if (!cluster.is_walkable(neighbor_index))
+						continue;
+					const uint32_t new_cost = current_cost + directions.costs[direction];
+					if (new_cost < cost[neighbor_index])
+					{
+						cost[neighbor_index] = new_cost;
+						parent[neighbor_index] = direction;
+						heap_push(heap, new_cost, neighbor_index);
+					}
+				}
+			}
+		}
+	}
+	using namespace PathHierarchy_internal;
+
+	void PathQuery::search_voxels(XMUINT3 start, XMUINT3 goal, const wi::VoxelGrid& voxelgrid, Scratch& scratch)
+	{
+		if (!voxelgrid.is_coord_valid(start) || !voxelgrid.is_coord_valid(goal))
+			return;
+
+		// The arrays are stamped with the search generation, so they only need to be cleared when the voxel grid resolution changes:
+		const XMUINT3 resolution = voxelgrid.resolution;
+		const uint32_t voxel_count = resolution.x * resolution.y * resolution.z;
+		if (scratch.voxel_generation.size() != voxel_count)
+		{
+			scratch.voxel_cost.resize(voxel_count);
+			scratch.voxel_parent.resize(voxel_count);
+			scratch.voxel_generation.clear();
+			scratch.voxel_generation.resize(voxel_count, 0);
+			scratch.voxel_current_generation = 0;
+		}
+		scratch.voxel_current_generation++;
+		if (scratch.voxel_current_generation == 0)
+		{
+			std::fill(scratch.voxel_generation.begin(), scratch.voxel_generation.end(), 0u);
+			scratch.voxel_current_generation = 1;
+		}
+		const uint32_t generation = scratch.voxel_current_generation;
+
+		auto flatten = [&](const XMUINT3& coord) {
+			return coord.x + coord.y * resolution.x + coord.z * resolution.x * resolution.y;
+		};
+		const uint32_t start_index = flatten(start);
+		const uint32_t goal_index = flatten(goal);
+
+		// Same A* as the search without scratch, but with the heap and dense arrays instead of the priority queue and hash maps:
+		scratch.heap.clear();
+		scratch.voxel_generation[start_index] = generation;
+		scratch.voxel_cost[start_index] = 0;
+		scratch.voxel_parent[start_index] = invalid_node;
+		heap_push(scratch.heap, manhattan(start, goal), start_index);
+
+		while (!scratch.heap.empty())
+		{
+			const uint64_t item = heap_pop(scratch.heap);
+			const uint32_t index = uint32_t(item & 0xFFFFFFFF);
+			if (index == goal_index)
+				break;
+			const XMUINT3 coord = XMUINT3(index % resolution.x, (index / resolution.x) % resolution.y, index / (resolution.x * resolution.y));
+			const uint32_t cost = scratch.voxel_cost[index];
+			if (uint32_t(item >> 32ull) > cost + manhattan(coord, goal))
+				continue; // outdated heap entry
+
+			for (uint8_t direction = 0; direction < arraysize(directions.offsets); ++direction)
+			{
+				const XMUINT3 neighbor = step(coord, direction);
+				if (!is_voxel_valid(voxelgrid, neighbor))
+					continue;
+				const uint32_t neighbor_index = flatten(neighbor);
+				const uint32_t new_cost = cost + directions.costs[direction];
+				if (scratch.voxel_generation[neighbor_index] != generation || new_cost < scratch.voxel_cost[neighbor_index])
+				{
+					scratch.voxel_generation[neighbor_index] = generation;
+					scratch.voxel_cost[neighbor_index] = new_cost;
+					scratch.voxel_parent[neighbor_index] = index;
+					heap_push(scratch.heap, new_cost + manhattan(neighbor, goal), neighbor_index);
+				}
+			}
+		}
+
+		if (scratch.voxel_generation[goal_index] != generation || scratch.voxel_parent[goal_index] == invalid_node)
+			return; // goal is not reachable
+
+		for (uint32_t index = goal_index; index != invalid_node; index = scratch.voxel_parent[index])
+		{
+			const XMUINT3 coord = XMUINT3(index % resolution.x, (index / resolution.x) % resolution.y, index / (resolution.x * resolution.y));
+			result_path_goal_to_start.push_back(voxelgrid.coord_to_world(coord));
+		}
+	}
+
+	bool PathQuery::search_hierarchy(XMUINT3 start, XMUINT3 goal, const wi::VoxelGrid& voxelgrid, const wi::PathHierarchy& hierarchy, Scratch& scratch)
+	{
+		if (hierarchy.nodes.empty() || !voxelgrid.is_coord_valid(start))
+			return false;
+		const uint32_t start_cluster_index = hierarchy.get_cluster_index(start);
+		const uint32_t goal_cluster_index = hierarchy.get_cluster_index(goal);
+		if (start_cluster_index == goal_cluster_index)
+			return false; // short distance, the voxel search is faster and finds the optimal path
+		const PathHierarchy::Cluster& start_cluster = hierarchy.clusters[start_cluster_index];
+		const PathHierarchy::Cluster& goal_cluster = hierarchy.clusters[goal_cluster_index];
+
+		Scratch& search = scratch;
+
+		// Local searches connect the start and goal to the entrances of their clusters:
+		search_cluster(start_cluster, start, search.start_cost, search.start_parent, search.heap);
+		search_cluster(goal_cluster, goal, search.goal_cost, search.goal_parent, search.heap);
+
+		// Abstract A* on the entrance graph, the start and goal are added as two extra nodes after the entrance nodes:
+		//	The per node arrays are stamped with the search generation, so they don't need to be cleared for every query
+		const uint32_t node_count = uint32_t(hierarchy.nodes.size());
+		const uint32_t start_node = node_count;
+		const uint32_t goal_node = node_count + 1;
+		if (search.generation.size() < node_count + 2)
+		{
+			search.cost.resize(node_count + 2);
+			search.parent.resize(node_count + 2);
+			search.parent_edge.resize(node_count + 2);
+			search.generation.resize(node_count + 2, 0);
+		}
+		search.current_generation++;
+		if (search.current_generation == 0)
+		{
+			std::fill(search.generation.begin(), search.generation.end(), 0u);
+			search.current_generation = 1;
+		}
+		const uint32_t generation = search.current_generation;
+
+		auto node_coord = [&](uint32_t node) {
+			return node == start_node ? start : (node == goal_node ? goal : hierarchy.nodes[node].coord);
+		};
+		auto relax = [&](uint32_t from, uint32_t node, uint32_t new_cost, uint32_t edge) {
+			if (search.generation[node] != generation)
+			{
+				search.generation[node] = generation;
+				search.cost[node] = invalid_cost;
+			}
+			if (new_cost < search.cost[node])
+			{
+				search.cost[node] = new_cost;
+				search.parent[node] = from;
+				search.parent_edge[node] = edge;
+				heap_push(search.heap, new_cost + manhattan(node_coord(node), goal), node);
+			}
+		};
+
+		search.heap.clear();
+		search.generation[start_node] = generation;
+		search.cost[start_node] = 0;
+		search.parent[start_node] = invalid_node;
+		heap_push(search.heap, manhattan(start, goal), start_node);
+		bool found = false;
+
+		while (!search.heap.empty())
+		{
+			const uint64_t item = heap_pop(search.heap);
+			const uint32_t node = uint32_t(item & 0xFFFFFFFF);
+			if (node == goal_node)
+			{
+				found = true;
+				break;
+			}
+			const uint32_t node_cost = search.cost[node];
+			if (uint32_t(item >> 32ull) > node_cost + manhattan(node_coord(node), goal))
+				continue; // outdated heap entry
+
+			if (node == start_node)
+			{
+				for (uint32_t entrance = 0; entrance < uint32_t(start_cluster.entrances.size()); ++entrance)
+				{
+					const uint32_t cost = search.start_cost[local_index(start_cluster, start_cluster.entrances[entrance])];
+					if (cost != invalid_cost)
+					{
+						relax(node, start_cluster.first_node + entrance, cost, invalid_node);
+					}
+				}
+				continue;
+			}
+
+			for (uint32_t i = hierarchy.node_edge_offsets[node]; i < hierarchy.node_edge_offsets[node + 1]; ++i)
+			{
+				const PathHierarchy::Edge& edge = hierarchy.edges[i];
+				relax(node, edge.target, node_cost + edge.cost, edge.path);
+			}
+			if (hierarchy.nodes[node].cluster == goal_cluster_index)
+			{
+				const uint32_t cost = search.goal_cost[local_index(goal_cluster, hierarchy.nodes[node].coord)];
+				if (cost != invalid_cost)
+				{
+					relax(node, goal_node, node_cost + cost, invalid_node);
+				}
+			}
+		}
+
+		if (!found)
+			return false;
+
+		// Abstract path from start to goal:
+		search.chain.clear();
+		for (uint32_t node = goal_node; node != invalid_node; node = search.parent[node])
+		{
+			search.chain.push_back(node);
+		}
+		std::reverse(search.chain.begin(), search.chain.end());
+
+		// Refine the abstract path into voxels:
+		search.path.clear();
+		search.path.push_back(start);
+		for (size_t i = 1; i < search.chain.size(); ++i)
+		{
+			const uint32_t from = search.chain[i - 1];
+			const uint32_t to = search.chain[i];
+			if (from == start_node)
+			{
+				// walk back from the entrance to the start, then append it in reverse:
+				const size_t first = search.path.size();
+				XMUINT3 coord = node_coord(to);
+				uint8_t direction = search.start_parent[local_index(start_cluster, coord)];
+				while (direction != invalid_direction)
+				{
+					search.path.push_back(coord);
+					coord = step(coord, direction, -1);
+					direction = search.start_parent[local_index(start_cluster, coord)];
+				}
+				std::reverse(search.path.begin() + first, search.path.end());
+			}
+			else if (to == goal_node)
+			{
+				// the goal search tree leads from the entrance to the goal:
+				XMUINT3 coord = node_coord(from);
+				uint8_t direction = search.goal_parent[local_index(goal_cluster, coord)];
+				while (direction != invalid_direction)
+				{
+					coord = step(coord, direction, -1);
+					search.path.push_back(coord);
+					direction = search.goal_parent[local_index(goal_cluster, coord)];
+				}
+			}
+			else if (search.parent_edge[to] == invalid_node)
+			{
+				// transition between neighbor clusters:
+				search.path.push_back(node_coord(to));
+			}
+			else
+			{
+				// precomputed path inside a cluster:
+				const uint32_t path = search.parent_edge[to];
+				const PathHierarchy::Cluster& cluster = hierarchy.clusters[hierarchy.nodes[from].cluster];
+				const PathHierarchy::Cluster::Edge& edge = cluster.edges[path >> 1];
+				const uint8_t* steps = cluster.paths.data() + edge.path_offset;
+				XMUINT3 coord = node_coord(from);
+				if ((path & 1) == 0)
+				{
+					for (uint32_t j = 0; j < edge.path_length; ++j)
+					{
+						coord = step(coord, steps[j]);
+						search.path.push_back(coord);
+					}
+				}
+				else
+				{
+					for (uint32_t j = edge.path_length; j > 0; --j)
+					{
+						coord = step(coord, steps[j - 1], -1);
+						search.path.push_back(coord);
+					}
+				}
+			}
+		}
+
+		for (size_t i = search.path.size(); i > 0; --i)
+		{
+			result_path_goal_to_start.push_back(voxelgrid.coord_to_world(search.path[i - 1]));
+		}
+		return true;
+	}
+
+	void PathQuery::simplify_path(const wi::VoxelGrid& voxelgrid)
+	{
+		auto dda = [&](const XMUINT3& start, const XMUINT3& goal)
+		{
+			const int dx = int(goal.x) - int(start.x);
+			const int dy = int(goal.y) - int(start.y);
+			const int dz = int(goal.z) - int(start.z);
+
+			const int step = std::max(std::abs(dx), std::max(std::abs(dy), std::abs(dz)));
+
+			const float x_incr = float(dx) / step;
+			const float y_incr = float(dy) / step;
+			const float z_incr = float(dz) / step;
+
+			float x = float(start.x);
+			float y = float(start.y);
+			float z = float(start.z);
+
+			for (int i = 0; i < step; i++)
+			{
+				XMUINT3 coord = XMUINT3(uint32_t(std::round(x)), uint32_t(std::round(y)), uint32_t(std::round(z)));
+				if (!is_voxel_valid(voxelgrid, coord))
+					return false;
+				x += x_incr;
+				y += y_incr;
+				z += z_incr;
+			}
+			return true;
+		};
 
 		// Simplification:
 		if (!result_path_goal_to_start.empty())
@@ -344,6 +797,11 @@ namespace wi
 	}
 
 	bool PathQuery::is_voxel_valid(const VoxelGrid& voxelgrid, XMUINT3 coord) const
+	{
+		return is_voxel_valid(voxelgrid, coord, flying, agent_width, agent_height);
+	}
+
+	bool PathQuery::is_voxel_valid(const VoxelGrid& voxelgrid, XMUINT3 coord, bool flying, int agent_width, int agent_height)
 	{
 		if (flying)
 		{
@@ -393,6 +851,490 @@ namespace wi
 		return true;
 	}
 
+	uint32_t PathHierarchy::get_cluster_index(const XMUINT3& coord) const
+	{
+		const uint32_t x = coord.x / built_cluster_size;
+		const uint32_t y = coord.y / built_cluster_size;
+		const uint32_t z = coord.z / built_cluster_size;
+		return x + y * cluster_count.x + z * cluster_count.x * cluster_count.y;
+	}
+
+	void PathHierarchy::build_cluster(const wi::VoxelGrid& voxelgrid, uint32_t cluster_index)
+	{
+		Cluster& cluster = clusters[cluster_index];
+		const XMUINT3 cluster_coord = XMUINT3(
+			cluster_index % cluster_count.x,
+			(cluster_index / cluster_count.x) % cluster_count.y,
+			cluster_index / (cluster_count.x * cluster_count.y)
+		);
+		cluster.origin = XMUINT3(cluster_coord.x * built_cluster_size, cluster_coord.y * built_cluster_size, cluster_coord.z * built_cluster_size);
+		cluster.size = XMUINT3(
+			std::min(built_cluster_size, resolution.x - cluster.origin.x),
+			std::min(built_cluster_size, resolution.y - cluster.origin.y),
+			std::min(built_cluster_size, resolution.z - cluster.origin.z)
+		);
+		cluster.entrances.clear();
+		cluster.transitions.clear();
+		cluster.edges.clear();
+		cluster.paths.clear();
+
+		const uint32_t voxel_count = cluster.size.x * cluster.size.y * cluster.size.z;
+		cluster.walkable.clear();
+		cluster.walkable.resize((voxel_count + 63) / 64);
+		uint32_t local = 0;
+		for (uint32_t z = 0; z < cluster.size.z; ++z)
+		{
+			for (uint32_t y = 0; y < cluster.size.y; ++y)
+			{
+				for (uint32_t x = 0; x < cluster.size.x; ++x)
+				{
+					const XMUINT3 coord = XMUINT3(cluster.origin.x + x, cluster.origin.y + y, cluster.origin.z + z);
+					if (PathQuery::is_voxel_valid(voxelgrid, coord, built_flying, built_agent_width, built_agent_height))
+					{
+						cluster.walkable[local / 64] |= 1ull << (local % 64);
+					}
+					local++;
+				}
+			}
+		}
+
+		// Entrances on the six faces that have a neighbor cluster:
+		//	The walkable cells of a face are grouped into 4-connected regions, and the cell nearest to the center of each region becomes an entrance
+		//	Both clusters of the face find the same regions and cells, so the neighbor cluster will have the matching entrance on its side
+		wi::vector<uint8_t> face;
+		wi::vector<uint32_t> region;
+		wi::vector<uint32_t> stack;
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			const int axis_u = (axis + 1) % 3;
+			const int axis_v = (axis + 2) % 3;
+			const uint32_t size_u = axis_of(cluster.size, axis_u);
+			const uint32_t size_v = axis_of(cluster.size, axis_v);
+			for (int side = -1; side <= 1; side += 2)
+			{
+				if (side < 0 && axis_of(cluster_coord, axis) == 0)
+					continue;
+				if (side > 0 && axis_of(cluster_coord, axis) + 1 >= axis_of(cluster_count, axis))
+					continue;
+
+				auto face_coord = [&](uint32_t u, uint32_t v) {
+					XMUINT3 coord = cluster.origin;
+					axis_of(coord, axis) += side < 0 ? 0 : axis_of(cluster.size, axis) - 1;
+					axis_of(coord, axis_u) += u;
+					axis_of(coord, axis_v) += v;
+					return coord;
+				};
+
+				face.resize(size_u * size_v);
+				for (uint32_t v = 0; v < size_v; ++v)
+				{
+					for (uint32_t u = 0; u < size_u; ++u)
+					{
+						const XMUINT3 inner = face_coord(u, v);
+						XMUINT3 outer = inner;
+						axis_of(outer, axis) += side;
+						face[u + v * size_u] =
+							cluster.is_walkable(local_index(cluster, inner)) &&
+							PathQuery::is_voxel_valid(voxelgrid, outer, built_flying, built_agent_width, built_agent_height);
+					}
+				}
+
+				region.assign(face.size(), ~0u);
+				for (uint32_t seed = 0; seed < uint32_t(face.size()); ++seed)
+				{
+					if (!face[seed] || region[seed] != ~0u)
+						continue;
+
+					// flood fill the region, summing the cell positions for the center:
+					wi::vector<uint32_t>& cells = stack;
+					cells.clear();
+					cells.push_back(seed);
+					region[seed] = seed;
+					uint32_t sum_u = 0;
+					uint32_t sum_v = 0;
+					for (size_t i = 0; i < cells.size(); ++i)
+					{
+						const uint32_t cell = cells[i];
+						const uint32_t u = cell % size_u;
+						const uint32_t v = cell / size_u;
+						sum_u += u;
+						sum_v += v;
+						auto visit = [&](uint32_t neighbor) {
+							if (face[neighbor] && region[neighbor] == ~0u)
+							{
+								region[neighbor] = seed;
+								cells.push_back(neighbor);
+							}
+						};
+						if (u > 0) visit(cell - 1);
+						if (u + 1 < size_u) visit(cell + 1);
+						if (v > 0) visit(cell - size_u);
+						if (v + 1 < size_v) visit(cell + size_u);
+					}
+
+					const float center_u = float(sum_u) / float(cells.size());
+					const float center_v = float(sum_v) / float(cells.size());
+					uint32_t best = seed;
+					float best_distance = std::numeric_limits<float>::max();
+					for (uint32_t cell : cells)
+					{
+						const float du = float(cell % size_u) - center_u;
+						const float dv = float(cell / size_u) - center_v;
+						const float distance = du * du + dv * dv;
+						if (distance < best_distance || (distance == best_distance && cell < best))
+						{
+							best_distance = distance;
+							best = cell;
+						}
+					}
+
+					const XMUINT3 inner = face_coord(best % size_u, best / size_u);
+					XMUINT3 outer = inner;
+					axis_of(outer, axis) += side;
+
+					// an edge or corner voxel can be the entrance of multiple faces:
+					uint32_t entrance = 0;
+					while (entrance < uint32_t(cluster.entrances.size()))
+					{
+						const XMUINT3& existing = cluster.entrances[entrance];
+						if (existing.x == inner.x && existing.y == inner.y && existing.z == inner.z)
+							break;
+						entrance++;
+					}
+					if (entrance == uint32_t(cluster.entrances.size()))
+					{
+						cluster.entrances.push_back(inner);
+					}
+					Cluster::Transition& transition = cluster.transitions.emplace_back();
+					transition.entrance = entrance;
+					transition.partner = outer;
+				}
+			}
+		}
+
+		// Paths between the entrances inside the cluster:
+		wi::vector<uint32_t> cost;
+		wi::vector<uint8_t> parent;
+		wi::vector<uint64_t> heap;
+		wi::vector<uint8_t>& steps = face;
+		for (uint32_t i = 0; i < uint32_t(cluster.entrances.size()); ++i)
+		{
+			search_cluster(cluster, cluster.entrances[i], cost, parent, heap);
+			for (uint32_t j = i + 1; j < uint32_t(cluster.entrances.size()); ++j)
+			{
+				uint32_t index = local_index(cluster, cluster.entrances[j]);
+				if (cost[index] == invalid_cost)
+					continue;
+				Cluster::Edge& edge = cluster.edges.emplace_back();
+				edge.from = i;
+				edge.to = j;
+				edge.cost = cost[index];
+				edge.path_offset = uint32_t(cluster.paths.size());
+
+				// the search tree leads from j back to i, the steps are stored in reverse:
+				steps.clear();
+				XMUINT3 coord = cluster.entrances[j];
+				while (parent[index] != invalid_direction)
+				{
+					steps.push_back(parent[index]);
+					coord = step(coord, parent[index], -1);
+					index = local_index(cluster, coord);
+				}
+				edge.path_length = uint32_t(steps.size());
+				cluster.paths.insert(cluster.paths.end(), steps.rbegin(), steps.rend());
+			}
+		}
+	}
+
+	void PathHierarchy::build_clusters(const wi::VoxelGrid& voxelgrid, const wi::vector<uint32_t>& cluster_indices)
+	{
+		wi::jobsystem::context ctx;
+		wi::jobsystem::Dispatch(ctx, (uint32_t)cluster_indices.size(), 1, [&](wi::jobsystem::JobArgs args) {
+			build_cluster(voxelgrid, cluster_indices[args.jobIndex]);
+		});
+		wi::jobsystem::Wait(ctx);
+	}
+
+	void PathHierarchy::build_graph()
+	{
+		auto pack = [](const XMUINT3& coord) {
+			return uint64_t(coord.x) | (uint64_t(coord.y) << 21ull) | (uint64_t(coord.z) << 42ull);
+		};
+
+		nodes.clear();
+		wi::unordered_map<uint64_t, uint32_t> lookup;
+		for (uint32_t cluster_index = 0; cluster_index < uint32_t(clusters.size()); ++cluster_index)
+		{
+			Cluster& cluster = clusters[cluster_index];
+			cluster.first_node = uint32_t(nodes.size());
+			for (const XMUINT3& entrance : cluster.entrances)
+			{
+				lookup[pack(entrance)] = uint32_t(nodes.size());
+				Node& node = nodes.emplace_back();
+				node.coord = entrance;
+				node.cluster = cluster_index;
+			}
+		}
+
+		// Count the edges of each node, then fill them in compressed rows:
+		node_edge_offsets.clear();
+		node_edge_offsets.resize(nodes.size() + 1);
+		for (const Cluster& cluster : clusters)
+		{
+			for (const Cluster::Edge& edge : cluster.edges)
+			{
+				node_edge_offsets[cluster.first_node + edge.from + 1]++;
+				node_edge_offsets[cluster.first_node + edge.to + 1]++;
+			}
+			for (const Cluster::Transition& transition : cluster.transitions)
+			{
+				if (lookup.count(pack(transition.partner)) > 0)
+				{
+					node_edge_offsets[cluster.first_node + transition.entrance + 1]++;
+				}
+			}
+		}
+		for (size_t i = 1; i < node_edge_offsets.size(); ++i)
+		{
+			node_edge_offsets[i] += node_edge_offsets[i - 1];
+		}
+
+		edges.resize(node_edge_offsets.back());
+		wi::vector<uint32_t> cursor(node_edge_offsets.begin(), node_edge_offsets.end() - 1);
+		for (const Cluster& cluster : clusters)
+		{
+			for (uint32_t i = 0; i < uint32_t(cluster.edges.size()); ++i)
+			{
+				const Cluster::Edge& cluster_edge = cluster.edges[i];
+				const uint32_t from = cluster.first_node + cluster_edge.from;
+				const uint32_t to = cluster.first_node + cluster_edge.to;
+				Edge& forward = edges[cursor[from]++];
+				forward.target = to;
+				forward.cost = cluster_edge.cost;
+				forward.path = i << 1u;
+				Edge& backward = edges[cursor[to]++];
+				backward.target = from;
+				backward.cost = cluster_edge.cost;
+				backward.path = (i << 1u) | 1u;
+			}
+			for (const Cluster::Transition& transition : cluster.transitions)
+			{
+				auto it = lookup.find(pack(transition.partner));
+				if (it == lookup.end())
+					continue;
+				const uint32_t from = cluster.first_node + transition.entrance;
+				Edge& edge = edges[cursor[from]++];
+				edge.target = it->second;
+				edge.cost = 1;
+				edge.path = ~0u;
+			}
+		}
+	}
+
+	void PathHierarchy::build(const wi::VoxelGrid& voxelgrid)
+	{
+		built_flying = flying;
+		built_agent_height = agent_height;
+		built_agent_width = agent_width;
+		built_cluster_size = std::min(std::max(cluster_size, 4u), 64u);
+		resolution = voxelgrid.resolution;
+		cluster_count = XMUINT3(
+			(resolution.x + built_cluster_size - 1) / built_cluster_size,
+			(resolution.y + built_cluster_size - 1) / built_cluster_size,
+			(resolution.z + built_cluster_size - 1) / built_cluster_size
+		);
+		clusters.clear();
+		clusters.resize(cluster_count.x * cluster_count.y * cluster_count.z);
+
+		wi::vector<uint32_t> cluster_indices(clusters.size());
+		for (uint32_t i = 0; i < uint32_t(cluster_indices.size()); ++i)
+		{
+			cluster_indices[i] = i;
+		}
+		build_clusters(voxelgrid, cluster_indices);
+		build_graph();
+
+		voxels = voxelgrid.voxels;
+		version = voxelgrid.version;
+		voxelgrid_id = voxelgrid.instance_id.value;
+		built = true;
+		rebuilt_cluster_count = uint32_t(clusters.size());
+	}
+
+	void PathHierarchy::update(const wi::VoxelGrid& voxelgrid)
+	{
+		if (
+			!built ||
+			resolution.x != voxelgrid.resolution.x ||
+			resolution.y != voxelgrid.resolution.y ||
+			resolution.z != voxelgrid.resolution.z ||
+			voxels.size() != voxelgrid.voxels.size() ||
+			built_flying != flying ||
+			built_agent_height != agent_height ||
+			built_agent_width != agent_width ||
+			built_cluster_size != std::min(std::max(cluster_size, 4u), 64u)
+			)
+		{
+			build(voxelgrid);
+			return;
+		}
+		rebuilt_cluster_count = 0;
+		if (version == voxelgrid.version && voxelgrid_id == voxelgrid.instance_id.value)
+			return;
+
+		// Find the clusters whose walkable voxels can be affected by the changed 4x4x4 voxel blocks:
+		//	A voxel's walkability depends on the voxels around it within the agent size
+		wi::vector<uint8_t> dirty(clusters.size(), 0);
+		const int margin_xz = built_agent_width + 1;
+		const int margin_y = built_agent_height + 1;
+		const XMUINT3 div4 = voxelgrid.resolution_div4;
+		for (uint32_t i = 0; i < uint32_t(voxels.size()); ++i)
+		{
+			if (voxels[i] == voxelgrid.voxels[i])
+				continue;
+			const XMINT3 block = XMINT3(int(i % div4.x) * 4, int((i / div4.x) % div4.y) * 4, int(i / (div4.x * div4.y)) * 4);
+			const XMUINT3 range_min = XMUINT3(
+				uint32_t(std::max(0, block.x - margin_xz)) / built_cluster_size,
+				uint32_t(std::max(0, block.y - margin_y)) / built_cluster_size,
+				uint32_t(std::max(0, block.z - margin_xz)) / built_cluster_size
+			);
+			const XMUINT3 range_max = XMUINT3(
+				std::min(uint32_t(block.x + 3 + margin_xz), resolution.x - 1) / built_cluster_size,
+				std::min(uint32_t(block.y + 3 + margin_y), resolution.y - 1) / built_cluster_size,
+				std::min(uint32_t(block.z + 3 + margin_xz), resolution.z - 1) / built_cluster_size
+			);
+			for (uint32_t z = range_min.z; z <= range_max.z; ++z)
+			{
+				for (uint32_t y = range_min.y; y <= range_max.y; ++y)
+				{
+					for (uint32_t x = range_min.x; x <= range_max.x; ++x)
+					{
+						dirty[x + y * cluster_count.x + z * cluster_count.x * cluster_count.y] = 1;
+					}
+				}
+			}
+		}
+
+		// The face neighbors are also rebuilt, because their entrances depend on the walkable voxels of the changed clusters:
+		wi::vector<uint32_t> cluster_indices;
+		for (uint32_t i = 0; i < uint32_t(clusters.size()); ++i)
+		{
+			if (dirty[i] != 1)
+				continue;
+			const XMUINT3 coord = XMUINT3(i % cluster_count.x, (i / cluster_count.x) % cluster_count.y, i / (cluster_count.x * cluster_count.y));
+			const uint32_t stride[] = { 1, cluster_count.x, cluster_count.x * cluster_count.y };
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				if (axis_of(coord, axis) > 0 && dirty[i - stride[axis]] == 0)
+				{
+					dirty[i - stride[axis]] = 2;
+				}
+				if (axis_of(coord, axis) + 1 < axis_of(cluster_count, axis) && dirty[i + stride[axis]] == 0)
+				{
+					dirty[i + stride[axis]] = 2;
+				}
+			}
+		}
+		for (uint32_t i = 0; i < uint32_t(clusters.size()); ++i)
+		{
+			if (dirty[i] != 0)
+			{
+				cluster_indices.push_back(i);
+			}
+		}
+
+		build_clusters(voxelgrid, cluster_indices);
+		build_graph();
+
+		voxels = voxelgrid.voxels;
+		version = voxelgrid.version;
+		voxelgrid_id = voxelgrid.instance_id.value;
+		rebuilt_cluster_count = uint32_t(cluster_indices.size());
+	}
+
+	bool PathHierarchy::is_compatible(const PathQuery& query, const wi::VoxelGrid& voxelgrid) const
+	{
+		return
+			built &&
+			version == voxelgrid.version &&
+			voxelgrid_id == voxelgrid.instance_id.value &&
+			resolution.x == voxelgrid.resolution.x &&
+			resolution.y == voxelgrid.resolution.y &&
+			resolution.z == voxelgrid.resolution.z &&
+			built_flying == query.flying &&
+			built_agent_height == query.agent_height &&
+			built_agent_width == query.agent_width;
+	}
+
+	size_t PathHierarchy::get_memory_size() const
+	{
+		size_t size = sizeof(*this);
+		size += voxels.size() * sizeof(uint64_t);
+		size += clusters.size() * sizeof(Cluster);
+		for (const Cluster& cluster : clusters)
+		{
+			size += cluster.walkable.size() * sizeof(uint64_t);
+			size += cluster.entrances.size() * sizeof(XMUINT3);
+			size += cluster.transitions.size() * sizeof(Cluster::Transition);
+			size += cluster.edges.size() * sizeof(Cluster::Edge);
+			size += cluster.paths.size() * sizeof(uint8_t);
+		}
+		size += nodes.size() * sizeof(Node);
+		size += node_edge_offsets.size() * sizeof(uint32_t);
+		size += edges.size() * sizeof(Edge);
+		return size;
+	}
+
+	void PathQueryBatch::process(wi::jobsystem::context& ctx, const wi::VoxelGrid& voxelgrid, const wi::PathHierarchy* hierarchy)
+	{
+		if (requests.empty())
+			return;
+
+		// One job per worker thread (+1 for the thread that waits), and the jobs take the next unprocessed request until all are taken:
+		//	This way every job can use its own scratch storage and the uneven query costs are balanced between the workers
+		const uint32_t request_count = uint32_t(requests.size());
+		const uint32_t worker_count = std::min(request_count, wi::jobsystem::GetThreadCount(ctx.priority) + 1);
+		if (scratches.size() < worker_count)
+		{
+			scratches.resize(worker_count);
+		}
+		next_request.store(0);
+
+		wi::jobsystem::Dispatch(ctx, worker_count, 1, [this, &voxelgrid, hierarchy, request_count](wi::jobsystem::JobArgs args) {
+			PathQuery::Scratch& scratch = scratches[args.jobIndex];
+			for (uint32_t index = next_request.fetch_add(1); index < request_count; index = next_request.fetch_add(1))
+			{
+				const Request& request = requests[index];
+				if (request.query == nullptr)
+					continue;
+				request.query->process(request.startpos, request.goalpos, voxelgrid, hierarchy, scratch);
+			}
+		});
+	}
+
+	size_t PathQueryBatch::get_memory_size() const
+	{
+		size_t size = 0;
+		for (const PathQuery::Scratch& scratch : scratches)
+		{
+			size += scratch.voxel_cost.capacity() * sizeof(uint32_t);
+			size += scratch.voxel_parent.capacity() * sizeof(uint32_t);
+			size += scratch.voxel_generation.capacity() * sizeof(uint32_t);
+			size += scratch.cost.capacity() * sizeof(uint32_t);
+			size += scratch.parent.capacity() * sizeof(uint32_t);
+			size += scratch.parent_edge.capacity() * sizeof(uint32_t);
+			size += scratch.generation.capacity() * sizeof(uint32_t);
+			size += scratch.start_cost.capacity() * sizeof(uint32_t);
+			size += scratch.start_parent.capacity() * sizeof(uint8_t);
+			size += scratch.goal_cost.capacity() * sizeof(uint32_t);
+			size += scratch.goal_parent.capacity() * sizeof(uint8_t);
+			size += scratch.chain.capacity() * sizeof(uint32_t);
+			size += scratch.path.capacity() * sizeof(XMUINT3);
+			size += scratch.heap.capacity() * sizeof(uint64_t);
+		}
+		return size;
+	}
+
 	namespace PathQuery_internal
 	{
 		PipelineState pso_curve;
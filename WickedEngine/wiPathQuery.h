@@ -5,11 +5,108 @@
 #include "wiVoxelGrid.h"
 #include "wiGraphicsDevice.h"
 #include "wiPrimitive.h"
+#include "wiJobSystem.h"
 
 #include <queue>
 
 namespace wi
 {
+	struct PathQuery;
+
+	// Hierarchical pathfinding abstraction (HPA*) over a voxel grid, for one type of agent
+	//	The voxel grid is divided into clusters. The walkable voxels on the boundaries of neighboring clusters form entrances,
+	//	and the entrances inside each cluster are connected with precomputed paths and costs.
+	//	PathQuery::process() can use it to search the path on the graph of entrances, so it only needs to search voxel by voxel
+	//	inside the clusters of the start and goal
+	struct PathHierarchy
+	{
+		// The agent parameters must match the PathQuery that uses the hierarchy (see PathQuery for their meaning):
+		bool flying = false;
+		int agent_height = 1;
+		int agent_width = 0;
+		uint32_t cluster_size = 16; // number of voxels along each axis of a cluster, in range [4, 64]
+
+		// Builds the whole hierarchy for the voxel grid, the clusters are processed in parallel with the job system
+		void build(const wi::VoxelGrid& voxelgrid);
+
+		// Updates the hierarchy after the voxel grid was modified, only the clusters affected by the modified voxels are rebuilt
+		//	The changes are detected with the version and instance id of the voxel grid, it does nothing if the same voxel grid wasn't modified
+		//	It builds the whole hierarchy if it wasn't built yet, or the resolution or the parameters changed
+		void update(const wi::VoxelGrid& voxelgrid);
+
+		// Returns true if the hierarchy is up to date with the voxel grid and it was built for the same agent parameters as the query
+		bool is_compatible(const PathQuery& query, const wi::VoxelGrid& voxelgrid) const;
+
+		size_t get_cluster_count() const { return clusters.size(); }
+		size_t get_node_count() const { return nodes.size(); }
+		size_t get_edge_count() const { return edges.size(); }
+		size_t get_memory_size() const;
+		uint32_t get_rebuilt_cluster_count() const { return rebuilt_cluster_count; } // number of clusters that were rebuilt by the last build() or update()
+
+		struct Cluster
+		{
+			XMUINT3 origin = XMUINT3(0, 0, 0); // first voxel of the cluster
+			XMUINT3 size = XMUINT3(0, 0, 0); // number of voxels (smaller than cluster_size at the end of the voxel grid)
+			wi::vector<uint64_t> walkable; // one bit for each voxel of the cluster
+			wi::vector<XMUINT3> entrances; // walkable voxels on the boundary that are connected to neighbor clusters
+			struct Transition
+			{
+				uint32_t entrance = 0; // index into entrances
+				XMUINT3 partner = XMUINT3(0, 0, 0); // entrance voxel of the neighbor cluster
+			};
+			wi::vector<Transition> transitions;
+			struct Edge
+			{
+				uint32_t from = 0; // index into entrances
+				uint32_t to = 0; // index into entrances
+				uint32_t cost = 0;
+				uint32_t path_offset = 0; // start of the path in paths
+				uint32_t path_length = 0;
+			};
+			wi::vector<Edge> edges; // paths between the entrances inside the cluster
+			wi::vector<uint8_t> paths; // steps of the edge paths as neighbor direction indices, from -> to
+			uint32_t first_node = 0; // index of the first entrance in the nodes of the hierarchy
+
+			inline bool is_walkable(uint32_t local_index) const { return (walkable[local_index / 64] & (1ull << (local_index % 64))) != 0; }
+		};
+
+		struct Node
+		{
+			XMUINT3 coord = XMUINT3(0, 0, 0);
+			uint32_t cluster = 0;
+		};
+		struct Edge
+		{
+			uint32_t target = 0; // node index
+			uint32_t cost = 0;
+			uint32_t path = ~0u; // cluster edge index << 1 | reversed, or ~0u for a transition between clusters
+		};
+
+		XMUINT3 resolution = XMUINT3(0, 0, 0);
+		XMUINT3 cluster_count = XMUINT3(0, 0, 0);
+		wi::vector<Cluster> clusters;
+		wi::vector<Node> nodes;
+		wi::vector<uint32_t> node_edge_offsets; // edges of node i are in range [node_edge_offsets[i], node_edge_offsets[i + 1])
+		wi::vector<Edge> edges;
+
+		uint32_t get_cluster_index(const XMUINT3& coord) const;
+
+	private:
+		void build_cluster(const wi::VoxelGrid& voxelgrid, uint32_t cluster_index);
+		void build_clusters(const wi::VoxelGrid& voxelgrid, const wi::vector<uint32_t>& cluster_indices);
+		void build_graph();
+
+		wi::vector<uint64_t> voxels; // copy of the voxels that the hierarchy was built from, to find the changes
+		uint64_t version = 0;
+		uint64_t voxelgrid_id = 0; // instance id of the voxel grid that the hierarchy was built from
+		bool built = false;
+		bool built_flying = false;
+		int built_agent_height = 0;
+		int built_agent_width = 0;
+		uint32_t built_cluster_size = 0;
+		uint32_t rebuilt_cluster_count = 0;
+	};
+
 	struct PathQuery
 	{
 		struct Node
@@ -49,6 +146,31 @@ namespace wi
 		int agent_height = 1; // keep away from vertical obstacles by this many voxels
 		int agent_width = 0; // keep away from horizontal obstacles by this many voxels
 
+		// Reusable storage of the search, which can be shared by queries that are not processed at the same time
+		struct Scratch
+		{
+			// Voxel search with dense arrays over the whole voxel grid (only used when the scratch is given to process()):
+			wi::vector<uint32_t> voxel_cost;
+			wi::vector<uint32_t> voxel_parent;
+			wi::vector<uint32_t> voxel_generation;
+			uint32_t voxel_current_generation = 0;
+
+			// Hierarchical search:
+			wi::vector<uint32_t> cost;
+			wi::vector<uint32_t> parent;
+			wi::vector<uint32_t> parent_edge;
+			wi::vector<uint32_t> generation;
+			uint32_t current_generation = 0;
+			wi::vector<uint32_t> start_cost; // voxel costs from the start inside the start cluster
+			wi::vector<uint8_t> start_parent; // voxel directions towards the start inside the start cluster
+			wi::vector<uint32_t> goal_cost; // voxel costs from the goal inside the goal cluster
+			wi::vector<uint8_t> goal_parent; // voxel directions towards the goal inside the goal cluster
+			wi::vector<uint32_t> chain;
+			wi::vector<XMUINT3> path;
+
+			wi::vector<uint64_t> heap;
+		} scratch; // used by the hierarchical search when the query is processed without a scratch
+
 		// Find the path between startpos and goalpos in the voxel grid:
 		void process(
 			const XMFLOAT3& startpos,
@@ -56,6 +178,27 @@ namespace wi
 			const wi::VoxelGrid& voxelgrid
 		);
 
+		// Find the path between startpos and goalpos in the voxel grid, using the path hierarchy of the voxel grid for long distances
+		//	If the hierarchy is not compatible (see PathHierarchy::is_compatible()) or it doesn't find a path, the voxel grid is searched without it
+		void process(
+			const XMFLOAT3& startpos,
+			const XMFLOAT3& goalpos,
+			const wi::VoxelGrid& voxelgrid,
+			const wi::PathHierarchy& hierarchy
+		);
+
+		// Find the path between startpos and goalpos using the given scratch storage instead of the storage of the query
+		//	The voxel search uses dense arrays over the whole voxel grid instead of hash maps, so it doesn't allocate when the scratch was already used with the same voxel grid
+		//	hierarchy	: the path hierarchy of the voxel grid, can be nullptr
+		//	scratch		: it can be reused for any number of queries, but it must not be used by multiple threads at the same time (see PathQueryBatch)
+		void process(
+			const XMFLOAT3& startpos,
+			const XMFLOAT3& goalpos,
+			const wi::VoxelGrid& voxelgrid,
+			const wi::PathHierarchy* hierarchy,
+			Scratch& scratch
+		);
+
 		bool is_succesful() const;
 
 		// Search for a cover location that can hide the subject from observer.
@@ -85,6 +228,7 @@ namespace wi
 		XMFLOAT3 get_goal() const;
 
 		bool is_voxel_valid(const VoxelGrid& voxelgrid, XMUINT3 coord) const;
+		static bool is_voxel_valid(const VoxelGrid& voxelgrid, XMUINT3 coord, bool flying, int agent_width, int agent_height);
 
 		bool debug_voxels = true;
 		mutable float debugtimer = 0;
@@ -93,5 +237,37 @@ namespace wi
 		XMFLOAT3 debuggoalnode = XMFLOAT3(0, 0, 0);
 		bool debug_waypoints = false; // if true, waypoint voxels will be drawn. Blue = waypoint, Pink = simplified waypoint
 		void debugdraw(const XMFLOAT4X4& ViewProjection, wi::graphics::CommandList cmd) const;
+
+	private:
+		bool begin_process(const XMFLOAT3& startpos, const XMFLOAT3& goalpos, const wi::VoxelGrid& voxelgrid, XMUINT3& start, XMUINT3& goal);
+		void search_voxels(XMUINT3 start, XMUINT3 goal, const wi::VoxelGrid& voxelgrid);
+		void search_voxels(XMUINT3 start, XMUINT3 goal, const wi::VoxelGrid& voxelgrid, Scratch& scratch);
+		bool search_hierarchy(XMUINT3 start, XMUINT3 goal, const wi::VoxelGrid& voxelgrid, const wi::PathHierarchy& hierarchy, Scratch& scratch);
+		void simplify_path(const wi::VoxelGrid& voxelgrid);
+	};
+
+	// Processes many path queries against one voxel grid asynchronously with the job system
+	//	The requests are distributed between the worker threads, and every worker uses its own scratch storage, which is kept between batches.
+	//	Reuse the same batch (for example every frame) to avoid allocations
+	struct PathQueryBatch
+	{
+		struct Request
+		{
+			PathQuery* query = nullptr; // the parameters of the query are used (flying, agent_width, agent_height), and it receives the results
+			XMFLOAT3 startpos = XMFLOAT3(0, 0, 0);
+			XMFLOAT3 goalpos = XMFLOAT3(0, 0, 0);
+		};
+		wi::vector<Request> requests;
+
+		// Starts processing all the requests, the ctx will be finished when all of them are processed
+		//	The batch, the voxel grid, the hierarchy and the queries must not be modified until the ctx is finished
+		//	hierarchy	: the path hierarchy of the voxel grid, can be nullptr
+		void process(wi::jobsystem::context& ctx, const wi::VoxelGrid& voxelgrid, const wi::PathHierarchy* hierarchy = nullptr);
+
+		size_t get_memory_size() const; // size of the scratch storage of the workers
+
+	private:
+		wi::vector<PathQuery::Scratch> scratches;
+		std::atomic<uint32_t> next_request{ 0 };
 	};
 }
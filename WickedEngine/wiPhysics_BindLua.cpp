@@ -949,10 +949,9 @@ namespace wi::lua
 
 	void Physics_BindLua::Bind()
 	{
-		static bool initialized = false;
-		if (!initialized)
+		static const char binding_key = 0;
+		if (wi::lua::BeginBinding(&binding_key))
 		{
-			initialized = true;
 			Luna<PickDragOperation_BindLua>::Register(wi::lua::GetLuaState());
 			Luna<Physics_BindLua>::Register(wi::lua::GetLuaState());
 			Luna<Physics_BindLua>::push_global(wi::lua::GetLuaState(), "physics");
@@ -7,10 +7,9 @@ namespace wi::lua::primitive
 {
 	void Bind()
 	{
-		static bool initialized = false;
-		if (!initialized)
+		static const char binding_key = 0;
+		if (wi::lua::BeginBinding(&binding_key))
 		{
-			initialized = true;
 
 			lua_State* L = wi::lua::GetLuaState();
 
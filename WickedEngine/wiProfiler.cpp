@@ -62,11 +62,20 @@ namespace wi::profiler
 	};
 	wi::unordered_map<size_t, Range> ranges;
 
+	struct Counter
+	{
+		std::string name;
+		std::string unit;
+		double value = 0;
+	};
+	wi::vector<Counter> counters; // kept in the order they were first set, so that the displayed list is stable
+
 	void BeginFrame()
 	{
 		if (ENABLED_REQUEST != ENABLED)
 		{
 			ranges.clear();
+			counters.clear();
 			ENABLED = ENABLED_REQUEST;
 		}
 
@@ -306,6 +315,27 @@ namespace wi::profiler
 		assert(success);
 	}
 
+	void SetCounter(const char* name, double value, const char* unit)
+	{
+		if (!ENABLED || !initialized)
+			return;
+
+		std::scoped_lock lck(lock);
+		for (auto& counter : counters)
+		{
+			if (counter.name == name)
+			{
+				counter.value = value;
+				counter.unit = unit;
+				return;
+			}
+		}
+		Counter& counter = counters.emplace_back();
+		counter.name = name;
+		counter.unit = unit;
+		counter.value = value;
+	}
+
 	struct Hits
 	{
 		uint32_t num_hits = 0;
@@ -388,6 +418,18 @@ namespace wi::profiler
 			x.second.total_time = 0;
 		}
 
+		// Print counters:
+		lock.lock();
+		if (!counters.empty())
+		{
+			ss << std::endl << "Counters:" << std::endl;
+			for (auto& counter : counters)
+			{
+				ss << "\t" << counter.name << ": " << std::fixed << counter.value << " " << counter.unit << std::endl;
+			}
+		}
+		lock.unlock();
+
 		wi::font::Params params = wi::font::Params(x, y + (graph_size.y + graph_padding_y) * 2, wi::font::WIFONTSIZE_DEFAULT - 6, wi::font::WIFALIGN_LEFT, wi::font::WIFALIGN_TOP, text_color);
 
 		// Background:
@@ -52,6 +52,12 @@ namespace wi::profiler
 		inline ~ScopedRangeGPU() { EndRange(id); }
 	};
 
+	// Sets the value of a named counter, the counters are displayed with the profiling results
+	//	This can be used to display statistics of engine systems, the value is kept until it is set again
+	//	name	:	name of the counter, it is copied
+	//	unit	:	unit of the value that is displayed after it, it is copied
+	void SetCounter(const char* name, double value, const char* unit = "");
+
 	// Renders a basic text of the Profiling results to the (x,y) screen coordinate
 	void DrawData(
 		const wi::Canvas& canvas,
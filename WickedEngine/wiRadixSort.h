@@ -0,0 +1,84 @@
+#pragma once
+#include "CommonInclude.h"
+#include "wiVector.h"
+
+#include <cstring>
+#include <utility>
+
+namespace wi::radixsort
+{
+	// Stable LSD radix sort of an element array by a 64-bit key, in ascending key order
+	//	data		: the elements to be sorted, the result will be written here
+	//	scratch		: temporary storage, must be able to hold count elements
+	//	count		: number of elements in data
+	//	get_key		: function that returns the uint64_t sort key of an element
+	//
+	//	The key is processed in 8-bit digits, but digits that are the same for all elements are skipped,
+	//	so keys that only use a part of their bits (for example the upper bits are zero) will be sorted with less passes
+	//	The element type should be trivially copyable, because elements are moved with memcpy
+	template<typename T, typename KeyFunc>
+	inline void sort(T* data, T* scratch, size_t count, KeyFunc get_key)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "wi::radixsort::sort requires trivially copyable elements!");
+		if (count < 2)
+			return;
+
+		constexpr int digit_count = sizeof(uint64_t);
+		uint32_t histograms[digit_count][256] = {};
+
+		// Building all histograms at once requires only a single read pass:
+		for (size_t i = 0; i < count; ++i)
+		{
+			const uint64_t key = get_key(data[i]);
+			for (int digit = 0; digit < digit_count; ++digit)
+			{
+				histograms[digit][(key >> (digit * 8)) & 0xFF]++;
+			}
+		}
+
+		T* src = data;
+		T* dst = scratch;
+		for (int digit = 0; digit < digit_count; ++digit)
+		{
+			uint32_t* histogram = histograms[digit];
+
+			// If every element falls into the same bucket, this pass wouldn't change anything:
+			const uint64_t first_key = get_key(src[0]);
+			if (histogram[(first_key >> (digit * 8)) & 0xFF] == count)
+				continue;
+
+			// Exclusive prefix sum to get the bucket offsets:
+			uint32_t offset = 0;
+			for (int bucket = 0; bucket < 256; ++bucket)
+			{
+				const uint32_t bucket_count = histogram[bucket];
+				histogram[bucket] = offset;
+				offset += bucket_count;
+			}
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				const uint64_t key = get_key(src[i]);
+				dst[histogram[(key >> (digit * 8)) & 0xFF]++] = src[i];
+			}
+			std::swap(src, dst);
+		}
+
+		// After odd number of passes, the result ends up in the scratch memory:
+		if (src != data)
+		{
+			std::memcpy(data, src, sizeof(T) * count);
+		}
+	}
+
+	// Radix sort of a vector, the scratch vector will be resized as needed, so it can be reused between sorts to avoid allocations
+	template<typename T, typename KeyFunc>
+	inline void sort(wi::vector<T>& items, wi::vector<T>& scratch, KeyFunc get_key)
+	{
+		if (scratch.size() < items.size())
+		{
+			scratch.resize(items.size());
+		}
+		sort(items.data(), scratch.data(), items.size(), get_key);
+	}
+}
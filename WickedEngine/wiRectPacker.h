@@ -62,5 +62,23 @@ namespace wi::rectpacker
 			height = 0;
 			return false;
 		}
+
+		// Packs more rects into the free space that remained after the last successful pack(), without moving the already packed rects
+		//	The containing width/height is not modified, the packed new rects are added to the rect array
+		//	returns true if all new rects were packed, false if they didn't fit (the was_packed member of the rects tells which ones were packed)
+		bool pack_more(Rect* new_rects, int count)
+		{
+			if (width == 0 || height == 0)
+				return false;
+			const bool success = stbrp_pack_rects(&context, new_rects, count) != 0;
+			for (int i = 0; i < count; ++i)
+			{
+				if (new_rects[i].was_packed)
+				{
+					rects.push_back(new_rects[i]);
+				}
+			}
+			return success;
+		}
 	};
 }
@@ -497,10 +497,9 @@ namespace wi::lua
 
 	void RenderPath2D_BindLua::Bind()
 	{
-		static bool initialized = false;
-		if (!initialized)
+		static const char binding_key = 0;
+		if (wi::lua::BeginBinding(&binding_key))
 		{
-			initialized = true;
 			Luna<RenderPath2D_BindLua>::Register(wi::lua::GetLuaState());
 		}
 	}
@@ -763,10 +763,9 @@ Tonemap = {
 
 	void RenderPath3D_BindLua::Bind()
 	{
-		static bool initialized = false;
-		if (!initialized)
+		static const char binding_key = 0;
+		if (wi::lua::BeginBinding(&binding_key))
 		{
-			initialized = true;
 			Luna<RenderPath3D_BindLua>::Register(wi::lua::GetLuaState());
 
 			wi::lua::RunText(value_bindings);
@@ -35,10 +35,9 @@ namespace wi::lua
 	void RenderPath_BindLua::Bind()
 	{
 
-		static bool initialized = false;
-		if (!initialized)
+		static const char binding_key = 0;
+		if (wi::lua::BeginBinding(&binding_key))
 		{
-			initialized = true;
 			Luna<RenderPath_BindLua>::Register(wi::lua::GetLuaState());
 		}
 	}
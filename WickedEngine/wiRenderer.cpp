@@ -13,6 +13,7 @@
 #include "wiGPUBVH.h"
 #include "wiJobSystem.h"
 #include "wiSpinLock.h"
+#include "wiRadixSort.h"
 #include "wiEventHandler.h"
 #include "wiPlatform.h"
 #include "wiSheenLUT.h"
@@ -229,7 +230,7 @@ struct alignas(16) RenderBatch
 	// opaque sorting
 	//	Priority is set to mesh index to have more instancing
 	//	distance is second priority (front to back Z-buffering)
-	constexpr bool operator<(const RenderBatch& other) const
+	constexpr uint64_t GetOpaqueSortKey() const
 	{
 		union SortKey
 		{
@@ -243,20 +244,16 @@ struct alignas(16) RenderBatch
 			uint64_t value;
 		};
 		static_assert(sizeof(SortKey) == sizeof(uint64_t));
-		SortKey a = {};
-		a.bits.distance = distance;
-		a.bits.meshIndex = meshIndex;
-		a.bits.sort_bits = sort_bits;
-		SortKey b = {};
-		b.bits.distance = other.distance;
-		b.bits.meshIndex = other.meshIndex;
-		b.bits.sort_bits = other.sort_bits;
-		return a.value < b.value;
+		SortKey key = {};
+		key.bits.distance = distance;
+		key.bits.meshIndex = meshIndex;
+		key.bits.sort_bits = sort_bits;
+		return key.value;
 	}
 	// transparent sorting
 	//	Priority is distance for correct alpha blending (back to front rendering)
 	//	mesh index is second priority for instancing
-	constexpr bool operator>(const RenderBatch& other) const
+	constexpr uint64_t GetTransparentSortKey() const
 	{
 		union SortKey
 		{
@@ -270,15 +267,19 @@ struct alignas(16) RenderBatch
 			uint64_t value;
 		};
 		static_assert(sizeof(SortKey) == sizeof(uint64_t));
-		SortKey a = {};
-		a.bits.distance = distance;
-		a.bits.sort_bits = sort_bits;
-		a.bits.meshIndex = meshIndex;
-		SortKey b = {};
-		b.bits.distance = other.distance;
-		b.bits.sort_bits = other.sort_bits;
-		b.bits.meshIndex = other.meshIndex;
-		return a.value > b.value;
+		SortKey key = {};
+		key.bits.distance = distance;
+		key.bits.sort_bits = sort_bits;
+		key.bits.meshIndex = meshIndex;
+		return key.value;
+	}
+	constexpr bool operator<(const RenderBatch& other) const
+	{
+		return GetOpaqueSortKey() < other.GetOpaqueSortKey();
+	}
+	constexpr bool operator>(const RenderBatch& other) const
+	{
+		return GetTransparentSortKey() > other.GetTransparentSortKey();
 	}
 };
 static_assert(sizeof(RenderBatch) == 16ull);
@@ -287,6 +288,10 @@ static_assert(sizeof(RenderBatch) == 16ull);
 struct RenderQueue
 {
 	wi::vector<RenderBatch> batches;
+	wi::vector<RenderBatch> batches_scratch; // temporary storage for radix sort, kept to avoid reallocation
+
+	// Below this count, comparison sort is faster than the radix sort passes:
+	static constexpr size_t radix_sort_threshold = 256;
 
 	inline void init()
 	{
@@ -302,11 +307,26 @@ struct RenderQueue
 	}
 	inline void sort_transparent()
 	{
-		std::sort(batches.begin(), batches.end(), std::greater<RenderBatch>());
+		if (batches.size() < radix_sort_threshold)
+		{
+			std::sort(batches.begin(), batches.end(), std::greater<RenderBatch>());
+			return;
+		}
+		// Radix sort is ascending, so the inverted key gives the descending order:
+		wi::radixsort::sort(batches, batches_scratch, [](const RenderBatch& batch) {
+			return ~batch.GetTransparentSortKey();
+		});
 	}
 	inline void sort_opaque()
 	{
-		std::sort(batches.begin(), batches.end(), std::less<RenderBatch>());
+		if (batches.size() < radix_sort_threshold)
+		{
+			std::sort(batches.begin(), batches.end(), std::less<RenderBatch>());
+			return;
+		}
+		wi::radixsort::sort(batches, batches_scratch, [](const RenderBatch& batch) {
+			return batch.GetOpaqueSortKey();
+		});
 	}
 	inline bool empty() const
 	{
@@ -738,6 +758,12 @@ bool LoadShader(
 	const wi::vector<std::string>& permutation_defines
 )
 {
+	if (device != nullptr && device->GetShaderFormat() == ShaderFormat::NONE)
+	{
+		// The device doesn't consume shader binaries (null device), so shader dump lookup, compilation and file loading are skipped:
+		return device->CreateShader(stage, nullptr, 0, &shader);
+	}
+
 	std::string shaderbinaryfilename = SHADERPATH + filename;
 
 	if (!permutation_defines.empty())
@@ -6493,6 +6519,43 @@ void SetShadowPropsCube(int resolution)
 	max_shadow_resolution_cube = resolution;
 }
 
+// Shadow cameras of all shadow casting lights, these are culled together against the scene objects in a single pass:
+struct ShadowCasterCulling
+{
+	struct Camera
+	{
+		XMFLOAT4X4 view_projection;
+		Frustum frustum;
+		uint32_t output_index = 0; // viewport index of the camera
+		bool culling = true; // if false, objects are not tested against this camera (eg. cubemap face not visible from main camera)
+	};
+	struct Light
+	{
+		uint32_t lightIndex = 0;
+		uint32_t camera_offset = 0; // first camera of the light in the cameras array
+		uint32_t camera_count = 0;
+	};
+	wi::vector<Camera> cameras;
+	wi::vector<Light> lights;
+	wi::vector<uint8_t> camera_masks; // [light][object] mask of the culling cameras that the object is visible in
+	wi::vector<uint8_t> shadow_lods; // [light][object] lod override, only valid where the camera mask is not zero
+
+	inline void init()
+	{
+		cameras.clear();
+		lights.clear();
+	}
+	inline void add_camera(const SHCAM& shcam, uint32_t output_index, bool culling = true)
+	{
+		Camera& camera = cameras.emplace_back();
+		XMStoreFloat4x4(&camera.view_projection, shcam.view_projection);
+		camera.frustum = shcam.frustum;
+		camera.output_index = output_index;
+		camera.culling = culling;
+	}
+};
+static thread_local ShadowCasterCulling shadowCasterCulling;
+
 void DrawShadowmaps(
 	const Visibility& vis,
 	CommandList cmd
@@ -6530,25 +6593,9 @@ void DrawShadowmaps(
 
 	const uint32_t max_viewport_count = device->GetMaxViewportCount();
 
-	const RenderPassImage rp[] = {
-		RenderPassImage::DepthStencil(
-			&shadowMapAtlas,
-			RenderPassImage::LoadOp::CLEAR,
-			RenderPassImage::StoreOp::STORE,
-			ResourceState::SHADER_RESOURCE,
-			ResourceState::DEPTHSTENCIL,
-			ResourceState::SHADER_RESOURCE
-		),
-		RenderPassImage::RenderTarget(
-			&shadowMapAtlas_Transparent,
-			RenderPassImage::LoadOp::CLEAR,
-			RenderPassImage::StoreOp::STORE,
-			ResourceState::SHADER_RESOURCE,
-			ResourceState::SHADER_RESOURCE
-		),
-	};
-	device->RenderPassBegin(rp, arraysize(rp), cmd);
-
+	// Gather the shadow cameras of all shadow casting lights, so they can be culled together in one pass over the objects:
+	ShadowCasterCulling& culling = shadowCasterCulling;
+	culling.init();
 	for (uint32_t lightIndex : vis.visibleLights)
 	{
 		const LightComponent& light = vis.scene->lights[lightIndex];
@@ -6560,79 +6607,217 @@ void DrawShadowmaps(
 			continue;
 		const wi::rectpacker::Rect& shadow_rect = vis.visibleLightShadowRects[lightIndex];
 
-		renderQueue.init();
-		renderQueue_transparent.init();
+		ShadowCasterCulling::Light caster_light;
+		caster_light.lightIndex = lightIndex;
+		caster_light.camera_offset = (uint32_t)culling.cameras.size();
 
 		switch (light.GetType())
 		{
 		case LightComponent::DIRECTIONAL:
 		{
 			if (max_shadow_resolution_2D == 0 && light.forced_shadow_resolution < 0)
-				break;
+				continue;
 			if (light.cascade_distances.empty())
-				break;
+				continue;
 
 			const uint32_t cascade_count = std::min((uint32_t)light.cascade_distances.size(), max_viewport_count);
-			Viewport* viewports = (Viewport*)alloca(sizeof(Viewport) * cascade_count);
-			Rect* scissors = (Rect*)alloca(sizeof(Rect) * cascade_count);
 			SHCAM* shcams = (SHCAM*)alloca(sizeof(SHCAM) * cascade_count);
 			CreateDirLightShadowCams(light, *vis.camera, shcams, cascade_count, shadow_rect);
+			for (uint32_t cascade = 0; cascade < cascade_count; ++cascade)
+			{
+				culling.add_camera(shcams[cascade], cascade);
+			}
+		}
+		break;
+		case LightComponent::SPOT:
+		case LightComponent::RECTANGLE:
+		{
+			if (max_shadow_resolution_2D == 0 && light.forced_shadow_resolution < 0)
+				continue;
 
-			for (size_t i = 0; i < vis.scene->aabb_objects.size(); ++i)
+			SHCAM shcam;
+			CreateSpotLightShadowCam(light, shcam);
+			if (!cam_frustum.Intersects(shcam.boundingfrustum))
+				continue;
+			culling.add_camera(shcam, 0);
+		}
+		break;
+		case LightComponent::POINT:
+		{
+			if (max_shadow_resolution_cube == 0 && light.forced_shadow_resolution < 0)
+				continue;
+
+			const float zNearP = 0.1f;
+			const float zFarP = std::max(1.0f, light.GetRange());
+			SHCAM cameras[6];
+			CreateCubemapCameras(light.position, zNearP, zFarP, cameras, arraysize(cameras));
+			for (uint32_t shcam = 0; shcam < arraysize(cameras); ++shcam)
 			{
-				const AABB& aabb = vis.scene->aabb_objects[i];
-				if (aabb.layerMask & vis.layerMask)
-				{
-					const ObjectComponent& object = vis.scene->objects[i];
-					if (object.IsRenderable() && object.IsCastingShadow())
-					{
-						const float distanceSq = wi::math::DistanceSquared(EYE, object.center);
-						if (distanceSq > sqr(object.draw_distance + object.radius)) // Note: here I use draw_distance instead of fadeDeistance because this doesn't account for impostor switch fade
-							continue;
+				// Check if cubemap face frustum is visible from main camera, otherwise, it will be skipped:
+				//	The culling bits will be only assigned to visible faces, but all faces are kept because hair particles are rendered into all of them
+				const bool visible = cam_frustum.Intersects(cameras[shcam].boundingfrustum);
+				culling.add_camera(cameras[shcam], shcam, visible);
+			}
+		}
+		break;
+		default:
+			continue;
+		}
 
-						// Determine which cascades the object is contained in:
-						uint8_t camera_mask = 0;
-						uint8_t shadow_lod = 0xFF;
-						for (uint32_t cascade = 0; cascade < cascade_count; ++cascade)
-						{
-							if ((cascade < (cascade_count - object.cascadeMask)) && shcams[cascade].frustum.CheckBoxFast(aabb))
-							{
-								camera_mask |= 1 << cascade;
-								if (shadow_lod_override)
-								{
-									const uint8_t candidate_lod = (uint8_t)vis.scene->ComputeObjectLODForView(object, aabb, vis.scene->meshes[object.mesh_index], shcams[cascade].view_projection);
-									shadow_lod = std::min(shadow_lod, candidate_lod);
-								}
-							}
-						}
-						if (camera_mask == 0)
-							continue;
+		caster_light.camera_count = (uint32_t)culling.cameras.size() - caster_light.camera_offset;
+		culling.lights.push_back(caster_light);
+	}
 
-						RenderBatch batch;
-						batch.Create(object.mesh_index, uint32_t(i), 0, object.sort_bits, camera_mask, shadow_lod);
+	// Test every object against every shadow camera at once:
+	//	The result is a camera mask per light and object, it will be zero for objects that don't cast shadow for that light
+	const uint32_t object_count = (uint32_t)vis.scene->aabb_objects.size();
+	if (!culling.lights.empty() && object_count > 0)
+	{
+		const size_t caster_count = culling.lights.size() * object_count;
+		culling.camera_masks.resize(caster_count);
+		culling.shadow_lods.resize(caster_count);
 
-						const uint32_t filterMask = object.GetFilterMask();
-						if (filterMask & FILTER_OPAQUE)
-						{
-							renderQueue.add(batch);
-						}
-						if ((filterMask & FILTER_TRANSPARENT) || (filterMask & FILTER_WATER))
+		wi::jobsystem::context ctx;
+		wi::jobsystem::Dispatch(ctx, object_count, 64, [&](wi::jobsystem::JobArgs args) {
+			const uint32_t i = args.jobIndex;
+			for (size_t light_slot = 0; light_slot < culling.lights.size(); ++light_slot)
+			{
+				culling.camera_masks[light_slot * object_count + i] = 0;
+			}
+
+			const AABB& aabb = vis.scene->aabb_objects[i];
+			if ((aabb.layerMask & vis.layerMask) == 0)
+				return;
+
+			const ObjectComponent& object = vis.scene->objects[i];
+			if (!object.IsRenderable() || !object.IsCastingShadow())
+				return;
+
+			const float distanceSq = wi::math::DistanceSquared(EYE, object.center);
+			if (distanceSq > sqr(object.draw_distance + object.radius)) // Note: here I use draw_distance instead of fadeDeistance because this doesn't account for impostor switch fade
+				return;
+
+			for (size_t light_slot = 0; light_slot < culling.lights.size(); ++light_slot)
+			{
+				const ShadowCasterCulling::Light& caster_light = culling.lights[light_slot];
+				const LightComponent& light = vis.scene->lights[caster_light.lightIndex];
+
+				uint32_t camera_limit = caster_light.camera_count;
+				if (light.GetType() == LightComponent::DIRECTIONAL)
+				{
+					// Skip the cascades that the object doesn't want to be rendered into:
+					camera_limit = caster_light.camera_count - object.cascadeMask;
+				}
+				else if (light.GetType() == LightComponent::POINT)
+				{
+					Sphere boundingsphere(light.position, light.GetRange());
+					if (!boundingsphere.intersects(aabb))
+						continue;
+				}
+
+				// Check for each shadow camera, if object is visible from it:
+				uint8_t camera_mask = 0;
+				uint8_t shadow_lod = 0xFF;
+				uint32_t camera_index = 0;
+				for (uint32_t camera = 0; camera < caster_light.camera_count; ++camera)
+				{
+					const ShadowCasterCulling::Camera& shadow_camera = culling.cameras[caster_light.camera_offset + camera];
+					if (!shadow_camera.culling)
+						continue;
+					if (camera_index < camera_limit && shadow_camera.frustum.CheckBoxFast(aabb))
+					{
+						camera_mask |= 1 << camera_index;
+						if (shadow_lod_override)
 						{
-							renderQueue_transparent.add(batch);
+							const uint8_t candidate_lod = (uint8_t)vis.scene->ComputeObjectLODForView(object, aabb, vis.scene->meshes[object.mesh_index], XMLoadFloat4x4(&shadow_camera.view_projection));
+							shadow_lod = std::min(shadow_lod, candidate_lod);
 						}
 					}
+					camera_index++;
 				}
+
+				culling.camera_masks[light_slot * object_count + i] = camera_mask;
+				culling.shadow_lods[light_slot * object_count + i] = shadow_lod;
+			}
+		});
+		wi::jobsystem::Wait(ctx);
+	}
+
+	// Fills the render queues from the culling results of a light:
+	auto add_shadow_casters = [&](size_t light_slot) {
+		renderQueue.init();
+		renderQueue_transparent.init();
+
+		const uint8_t* camera_masks = culling.camera_masks.data() + light_slot * object_count;
+		const uint8_t* shadow_lods = culling.shadow_lods.data() + light_slot * object_count;
+		for (uint32_t i = 0; i < object_count; ++i)
+		{
+			const uint8_t camera_mask = camera_masks[i];
+			if (camera_mask == 0)
+				continue;
+
+			const ObjectComponent& object = vis.scene->objects[i];
+
+			RenderBatch batch;
+			batch.Create(object.mesh_index, i, 0, object.sort_bits, camera_mask, shadow_lods[i]);
+
+			const uint32_t filterMask = object.GetFilterMask();
+			if (filterMask & FILTER_OPAQUE)
+			{
+				renderQueue.add(batch);
+			}
+			if ((filterMask & FILTER_TRANSPARENT) || (filterMask & FILTER_WATER))
+			{
+				renderQueue_transparent.add(batch);
 			}
+		}
+	};
+
+	const RenderPassImage rp[] = {
+		RenderPassImage::DepthStencil(
+			&shadowMapAtlas,
+			RenderPassImage::LoadOp::CLEAR,
+			RenderPassImage::StoreOp::STORE,
+			ResourceState::SHADER_RESOURCE,
+			ResourceState::DEPTHSTENCIL,
+			ResourceState::SHADER_RESOURCE
+		),
+		RenderPassImage::RenderTarget(
+			&shadowMapAtlas_Transparent,
+			RenderPassImage::LoadOp::CLEAR,
+			RenderPassImage::StoreOp::STORE,
+			ResourceState::SHADER_RESOURCE,
+			ResourceState::SHADER_RESOURCE
+		),
+	};
+	device->RenderPassBegin(rp, arraysize(rp), cmd);
+
+	for (size_t light_slot = 0; light_slot < culling.lights.size(); ++light_slot)
+	{
+		const ShadowCasterCulling::Light& caster_light = culling.lights[light_slot];
+		const ShadowCasterCulling::Camera* shadow_cameras = culling.cameras.data() + caster_light.camera_offset;
+		const LightComponent& light = vis.scene->lights[caster_light.lightIndex];
+		const wi::rectpacker::Rect& shadow_rect = vis.visibleLightShadowRects[caster_light.lightIndex];
+
+		add_shadow_casters(light_slot);
+
+		switch (light.GetType())
+		{
+		case LightComponent::DIRECTIONAL:
+		{
+			const uint32_t cascade_count = caster_light.camera_count;
+			Viewport* viewports = (Viewport*)alloca(sizeof(Viewport) * cascade_count);
+			Rect* scissors = (Rect*)alloca(sizeof(Rect) * cascade_count);
 
 			if (!renderQueue.empty() || !renderQueue_transparent.empty())
 			{
 				for (uint32_t cascade = 0; cascade < cascade_count; ++cascade)
 				{
-					XMStoreFloat4x4(&cb.cameras[cascade].view_projection, shcams[cascade].view_projection);
+					cb.cameras[cascade].view_projection = shadow_cameras[cascade].view_projection;
 					cb.cameras[cascade].output_index = cascade;
 					for (int i = 0; i < arraysize(cb.cameras[cascade].frustum.planes); ++i)
 					{
-						cb.cameras[cascade].frustum.planes[i] = shcams[cascade].frustum.planes[i];
+						cb.cameras[cascade].frustum.planes[i] = shadow_cameras[cascade].frustum.planes[i];
 					}
 					cb.cameras[cascade].options = SHADERCAMERA_OPTION_ORTHO;
 					cb.cameras[cascade].forward.x = -light.direction.x;
@@ -6663,7 +6848,7 @@ void DrawShadowmaps(
 				cb.cameras[0].position = vis.camera->Eye;
 				for (uint32_t cascade = 0; cascade < std::min(2u, cascade_count); ++cascade)
 				{
-					XMStoreFloat4x4(&cb.cameras[0].view_projection, shcams[cascade].view_projection);
+					cb.cameras[0].view_projection = shadow_cameras[cascade].view_projection;
 					device->BindDynamicConstantBuffer(cb, CBSLOT_RENDERER_CAMERA, cmd);
 
 					Viewport vp;
@@ -6680,7 +6865,7 @@ void DrawShadowmaps(
 					for (uint32_t hairIndex : vis.visibleHairs)
 					{
 						const HairParticleSystem& hair = vis.scene->hairs[hairIndex];
-						if (!shcams[cascade].frustum.CheckBoxFast(hair.aabb))
+						if (!shadow_cameras[cascade].frustum.CheckBoxFast(hair.aabb))
 							continue;
 						Entity entity = vis.scene->hairs.GetEntity(hairIndex);
 						const MaterialComponent* material = vis.scene->materials.GetComponent(entity);
@@ -6696,48 +6881,7 @@ void DrawShadowmaps(
 		case LightComponent::SPOT:
 		case LightComponent::RECTANGLE:
 		{
-			if (max_shadow_resolution_2D == 0 && light.forced_shadow_resolution < 0)
-				break;
-
-			SHCAM shcam;
-			CreateSpotLightShadowCam(light, shcam);
-			if (!cam_frustum.Intersects(shcam.boundingfrustum))
-				break;
-
-			for (size_t i = 0; i < vis.scene->aabb_objects.size(); ++i)
-			{
-				const AABB& aabb = vis.scene->aabb_objects[i];
-				if ((aabb.layerMask & vis.layerMask) && shcam.frustum.CheckBoxFast(aabb))
-				{
-					const ObjectComponent& object = vis.scene->objects[i];
-					if (object.IsRenderable() && object.IsCastingShadow())
-					{
-						const float distanceSq = wi::math::DistanceSquared(EYE, object.center);
-						if (distanceSq > sqr(object.draw_distance + object.radius)) // Note: here I use draw_distance instead of fadeDeistance because this doesn't account for impostor switch fade
-							continue;
-
-						uint8_t shadow_lod = 0xFF;
-						if (shadow_lod_override)
-						{
-							const uint8_t candidate_lod = (uint8_t)vis.scene->ComputeObjectLODForView(object, aabb, vis.scene->meshes[object.mesh_index], shcam.view_projection);
-							shadow_lod = std::min(shadow_lod, candidate_lod);
-						}
-
-						RenderBatch batch;
-						batch.Create(object.mesh_index, uint32_t(i), 0, object.sort_bits, 0xFF, shadow_lod);
-
-						const uint32_t filterMask = object.GetFilterMask();
-						if (filterMask & FILTER_OPAQUE)
-						{
-							renderQueue.add(batch);
-						}
-						if ((filterMask & FILTER_TRANSPARENT) || (filterMask & FILTER_WATER))
-						{
-							renderQueue_transparent.add(batch);
-						}
-					}
-				}
-			}
+			const ShadowCasterCulling::Camera& shcam = shadow_cameras[0];
 
 			if (predicationRequest && light.occlusionquery >= 0)
 			{
@@ -6751,7 +6895,7 @@ void DrawShadowmaps(
 
 			if (!renderQueue.empty() || !renderQueue_transparent.empty())
 			{
-				XMStoreFloat4x4(&cb.cameras[0].view_projection, shcam.view_projection);
+				cb.cameras[0].view_projection = shcam.view_projection;
 				cb.cameras[0].output_index = 0;
 				for (int i = 0; i < arraysize(cb.cameras[0].frustum.planes); ++i)
 				{
@@ -6780,7 +6924,7 @@ void DrawShadowmaps(
 			{
 				cb.cameras[0].position = vis.camera->Eye;
 				cb.cameras[0].options = SHADERCAMERA_OPTION_NONE;
-				XMStoreFloat4x4(&cb.cameras[0].view_projection, shcam.view_projection);
+				cb.cameras[0].view_projection = shcam.view_projection;
 				device->BindDynamicConstantBuffer(cb, CBSLOT_RENDERER_CAMERA, cmd);
 
 				Viewport vp;
@@ -6816,21 +6960,12 @@ void DrawShadowmaps(
 		break;
 		case LightComponent::POINT:
 		{
-			if (max_shadow_resolution_cube == 0 && light.forced_shadow_resolution < 0)
-				break;
-
-			Sphere boundingsphere(light.position, light.GetRange());
-
-			const float zNearP = 0.1f;
-			const float zFarP = std::max(1.0f, light.GetRange());
-			SHCAM cameras[6];
-			CreateCubemapCameras(light.position, zNearP, zFarP, cameras, arraysize(cameras));
-			Viewport vp[arraysize(cameras)];
-			Rect scissors[arraysize(cameras)];
-			Frustum frusta[arraysize(cameras)];
+			const uint32_t face_count = caster_light.camera_count;
+			Viewport vp[6];
+			Rect scissors[6];
 			uint32_t camera_count = 0;
 
-			for (uint32_t shcam = 0; shcam < arraysize(cameras); ++shcam)
+			for (uint32_t shcam = 0; shcam < face_count; ++shcam)
 			{
 				// always set up viewport and scissor just to be safe, even if this one is skipped:
 				vp[shcam].top_left_x = float(shadow_rect.x + shcam * shadow_rect.w);
@@ -6839,71 +6974,24 @@ void DrawShadowmaps(
 				vp[shcam].height = float(shadow_rect.h);
 				scissors[shcam].from_viewport(vp[shcam]);
 
-				// Check if cubemap face frustum is visible from main camera, otherwise, it will be skipped:
-				if (cam_frustum.Intersects(cameras[shcam].boundingfrustum))
+				// Only the cubemap faces that are visible from main camera were used in culling:
+				if (shadow_cameras[shcam].culling)
 				{
-					XMStoreFloat4x4(&cb.cameras[camera_count].view_projection, cameras[shcam].view_projection);
+					cb.cameras[camera_count].view_projection = shadow_cameras[shcam].view_projection;
 					// We no longer have a straight mapping from camera to viewport:
 					//	- there will be always 6 viewports
 					//	- there will be only as many cameras, as many cubemap face frustums are visible from main camera
 					//	- output_index is mapping camera to viewport, used by shader to output to SV_ViewportArrayIndex
-					cb.cameras[camera_count].output_index = shcam;
+					cb.cameras[camera_count].output_index = shadow_cameras[shcam].output_index;
 					cb.cameras[camera_count].options = SHADERCAMERA_OPTION_NONE;
 					for (int i = 0; i < arraysize(cb.cameras[camera_count].frustum.planes); ++i)
 					{
-						cb.cameras[camera_count].frustum.planes[i] = cameras[shcam].frustum.planes[i];
+						cb.cameras[camera_count].frustum.planes[i] = shadow_cameras[shcam].frustum.planes[i];
 					}
-					frusta[camera_count] = cameras[shcam].frustum;
 					camera_count++;
 				}
 			}
 
-			for (size_t i = 0; i < vis.scene->aabb_objects.size(); ++i)
-			{
-				const AABB& aabb = vis.scene->aabb_objects[i];
-				if ((aabb.layerMask & vis.layerMask) && boundingsphere.intersects(aabb))
-				{
-					const ObjectComponent& object = vis.scene->objects[i];
-					if (object.IsRenderable() && object.IsCastingShadow())
-					{
-						const float distanceSq = wi::math::DistanceSquared(EYE, object.center);
-						if (distanceSq > sqr(object.draw_distance + object.radius)) // Note: here I use draw_distance instead of fadeDeistance because this doesn't account for impostor switch fade
-							continue;
-
-						// Check for each frustum, if object is visible from it:
-						uint8_t camera_mask = 0;
-						uint8_t shadow_lod = 0xFF;
-						for (uint32_t camera_index = 0; camera_index < camera_count; ++camera_index)
-						{
-							if (frusta[camera_index].CheckBoxFast(aabb))
-							{
-								camera_mask |= 1 << camera_index;
-								if (shadow_lod_override)
-								{
-									const uint8_t candidate_lod = (uint8_t)vis.scene->ComputeObjectLODForView(object, aabb, vis.scene->meshes[object.mesh_index], cameras[camera_index].view_projection);
-									shadow_lod = std::min(shadow_lod, candidate_lod);
-								}
-							}
-						}
-						if (camera_mask == 0)
-							continue;
-
-						RenderBatch batch;
-						batch.Create(object.mesh_index, uint32_t(i), 0, object.sort_bits, camera_mask, shadow_lod);
-
-						const uint32_t filterMask = object.GetFilterMask();
-						if (filterMask & FILTER_OPAQUE)
-						{
-							renderQueue.add(batch);
-						}
-						if ((filterMask & FILTER_TRANSPARENT) || (filterMask & FILTER_WATER))
-						{
-							renderQueue_transparent.add(batch);
-						}
-					}
-				}
-			}
-
 			if (predicationRequest && light.occlusionquery >= 0)
 			{
 				device->PredicationBegin(
@@ -6917,8 +7005,8 @@ void DrawShadowmaps(
 			if (!renderQueue.empty() || renderQueue_transparent.empty())
 			{
 				device->BindDynamicConstantBuffer(cb, CBSLOT_RENDERER_CAMERA, cmd);
-				device->BindViewports(arraysize(vp), vp, cmd);
-				device->BindScissorRects(arraysize(scissors), scissors, cmd);
+				device->BindViewports(face_count, vp, cmd);
+				device->BindScissorRects(face_count, scissors, cmd);
 
 				renderQueue.sort_opaque();
 				renderQueue_transparent.sort_transparent();
@@ -6929,9 +7017,9 @@ void DrawShadowmaps(
 			if (!vis.visibleHairs.empty())
 			{
 				cb.cameras[0].position = vis.camera->Eye;
-				for (uint32_t shcam = 0; shcam < arraysize(cameras); ++shcam)
+				for (uint32_t shcam = 0; shcam < face_count; ++shcam)
 				{
-					XMStoreFloat4x4(&cb.cameras[0].view_projection, cameras[shcam].view_projection);
+					cb.cameras[0].view_projection = shadow_cameras[shcam].view_projection;
 					device->BindDynamicConstantBuffer(cb, CBSLOT_RENDERER_CAMERA, cmd);
 
 					Viewport vp;
@@ -6948,7 +7036,7 @@ void DrawShadowmaps(
 					for (uint32_t hairIndex : vis.visibleHairs)
 					{
 						const HairParticleSystem& hair = vis.scene->hairs[hairIndex];
-						if (!cameras[shcam].frustum.CheckBoxFast(hair.aabb))
+						if (!shadow_cameras[shcam].frustum.CheckBoxFast(hair.aabb))
 							continue;
 						Entity entity = vis.scene->hairs.GetEntity(hairIndex);
 						const MaterialComponent* material = vis.scene->materials.GetComponent(entity);
@@ -6967,6 +7055,8 @@ void DrawShadowmaps(
 
 		}
 		break;
+		default:
+			break;
 		} // terminate switch
 	}
 
@@ -1024,10 +1024,9 @@ namespace wi::lua::renderer
 
 	void Bind()
 	{
-		static bool initialized = false;
-		if (!initialized)
+		static const char binding_key = 0;
+		if (wi::lua::BeginBinding(&binding_key))
 		{
-			initialized = true;
 
 			Luna<PaintTextureParams_BindLua>::Register(wi::lua::GetLuaState());
 			Luna<PaintDecalParams_BindLua>::Register(wi::lua::GetLuaState());
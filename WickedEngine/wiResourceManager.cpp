@@ -853,7 +853,14 @@ namespace wi
 
 			case DataType::SOUND:
 			{
-				success = wi::audio::CreateSound(filedata, filesize, &resource->sound);
+				if (has_flag(flags, Flags::STREAMING))
+				{
+					success = wi::audio::CreateSoundStreaming(filedata, filesize, &resource->sound);
+				}
+				else
+				{
+					success = wi::audio::CreateSound(filedata, filesize, &resource->sound);
+				}
 			}
 			break;
 
@@ -33,6 +33,8 @@ namespace wi::scene
 
 	void Scene::Update(float dt)
 	{
+		auto range = wi::profiler::BeginRangeCPU("Scene::Update");
+
 		this->dt = dt;
 		time += dt;
 
@@ -962,6 +964,8 @@ namespace wi::scene
 			shaderscene.voxelgrid.voxelSize = voxelgrid.voxelSize;
 			shaderscene.voxelgrid.voxelSize_rcp = voxelgrid.voxelSize_rcp;
 		}
+
+		wi::profiler::EndRange(range);
 	}
 	void Scene::Clear()
 	{
@@ -2778,24 +2782,36 @@ namespace wi::scene
 	}
 	void Scene::RunTransformUpdateSystem(wi::jobsystem::context& ctx)
 	{
+		transforms_version = transforms.AdvanceVersion();
+
 		wi::jobsystem::Dispatch(ctx, (uint32_t)transforms.GetCount(), small_subtask_groupsize, [&](wi::jobsystem::JobArgs args) {
 
 			TransformComponent& transform = transforms[args.jobIndex];
+			if (transform.IsChanged())
+			{
+				transform.ClearChanged();
+				transforms.SetChanged(size_t(args.jobIndex));
+			}
 			transform.UpdateTransform();
 		});
 	}
 	void Scene::RunHierarchyUpdateSystem(wi::jobsystem::context& ctx)
 	{
+		// World matrices of children only need to be recomputed when something changed along their parent chain:
+		const uint64_t hierarchy_version = hierarchy.AdvanceVersion();
+		const bool structure_changed = hierarchy.IsRemoved(hierarchy_version) || transforms.IsRemoved(transforms_version);
+
 		wi::jobsystem::Dispatch(ctx, (uint32_t)hierarchy.GetCount(), small_subtask_groupsize, [&](wi::jobsystem::JobArgs args) {
 
 			HierarchyComponent& hier = hierarchy[args.jobIndex];
 			Entity entity = hierarchy.GetEntity(args.jobIndex);
 
-			TransformComponent* transform_child = transforms.GetComponent(entity);
-			XMMATRIX worldmatrix;
+			const size_t transform_child_index = transforms.GetIndex(entity);
+			TransformComponent* transform_child = transform_child_index == ~0ull ? nullptr : &transforms[transform_child_index];
+			bool transform_changed = structure_changed || hierarchy.IsChanged(args.jobIndex, hierarchy_version);
 			if (transform_child != nullptr)
 			{
-				worldmatrix = transform_child->GetLocalMatrix();
+				transform_changed |= transforms.IsChanged(transform_child_index, transforms_version);
 			}
 
 			LayerComponent* layer_child = layers.GetComponent(entity);
@@ -2810,10 +2826,10 @@ namespace wi::scene
 			Entity parentID = hier.parentID;
 			while (parentID != INVALID_ENTITY)
 			{
-				TransformComponent* transform_parent = transforms.GetComponent(parentID);
-				if (transform_child != nullptr && transform_parent != nullptr)
+				if (transform_child != nullptr && !transform_changed)
 				{
-					worldmatrix *= transform_parent->GetLocalMatrix();
+					const size_t transform_parent_index = transforms.GetIndex(parentID);
+					transform_changed = transform_parent_index != ~0ull && transforms.IsChanged(transform_parent_index, transforms_version);
 				}
 
 				LayerComponent* layer_parent = layers.GetComponent(parentID);
@@ -2822,10 +2838,11 @@ namespace wi::scene
 					layer_child->propagationMask &= layer_parent->layerMask;
 				}
 
-				const HierarchyComponent* hier_recursive = hierarchy.GetComponent(parentID);
-				if (hier_recursive != nullptr)
+				const size_t hier_recursive_index = hierarchy.GetIndex(parentID);
+				if (hier_recursive_index != ~0ull)
 				{
-					parentID = hier_recursive->parentID;
+					transform_changed |= hierarchy.IsChanged(hier_recursive_index, hierarchy_version);
+					parentID = hierarchy[hier_recursive_index].parentID;
 				}
 				else
 				{
@@ -2833,8 +2850,30 @@ namespace wi::scene
 				}
 			}
 
-			if (transform_child != nullptr)
+			if (transform_child != nullptr && transform_changed)
 			{
+				XMMATRIX worldmatrix = transform_child->GetLocalMatrix();
+
+				parentID = hier.parentID;
+				while (parentID != INVALID_ENTITY)
+				{
+					const TransformComponent* transform_parent = transforms.GetComponent(parentID);
+					if (transform_parent != nullptr)
+					{
+						worldmatrix *= transform_parent->GetLocalMatrix();
+					}
+
+					const HierarchyComponent* hier_recursive = hierarchy.GetComponent(parentID);
+					if (hier_recursive != nullptr)
+					{
+						parentID = hier_recursive->parentID;
+					}
+					else
+					{
+						parentID = INVALID_ENTITY;
+					}
+				}
+
 				XMStoreFloat4x4(&transform_child->world, worldmatrix);
 			}
 
@@ -2946,10 +2985,14 @@ namespace wi::scene
 				int mouth = expression_mastering.presets[(int)expression_mastering.talking_phoneme];
 				ExpressionComponent::Expression& expression = expression_mastering.expressions[mouth];
 
+				wi::audio::SampleInfo info;
 				if (voice_playing)
+				{
+					info = wi::audio::GetSampleInfo(&sound->soundResource.GetSound());
+				}
+				if (voice_playing && info.samples != nullptr) // streaming sounds don't have samples in memory
 				{
 					// Take voice sample from audio:
-					wi::audio::SampleInfo info = wi::audio::GetSampleInfo(&sound->soundResource.GetSound());
 					uint32_t sample_frequency = info.sample_rate * info.channel_count;
 					uint64_t current_sample = wi::audio::GetTotalSamplesPlayed(&sound->soundinstance);
 					if (sound->IsLooped())
@@ -3652,7 +3695,15 @@ namespace wi::scene
 				}
 
 				// Now the real (not temp) transform world matrix is updated:
-				XMStoreFloat4x4(&transforms[child_index].world, worldmatrix);
+				TransformComponent& transform = transforms[child_index];
+				XMFLOAT4X4 world;
+				XMStoreFloat4x4(&world, worldmatrix);
+				if (std::memcmp(&world, &transform.world, sizeof(world)) != 0)
+				{
+					transform.world = world;
+					// The world matrix no longer matches the local chain, so the hierarchy update must recompute it next frame:
+					transform.SetDirty();
+				}
 
 				});
 
@@ -5062,6 +5113,11 @@ namespace wi::scene
 
 			const TransformComponent& transform = *transforms.GetComponent(entity);
 			emitter.UpdateCPU(transform, dt);
+			if (emitter.IsCPUSimulationEnabled())
+			{
+				emitter.SimulateCPU(*this, meshes.GetComponent(emitter.meshID), material);
+				return; // CPU simulated particles have no render data, skip writing geometry and TLAS instance
+			}
 			if (emitter.IsInactive()) // check after UpdateCPU
 				return; // can skip writing TLAS instace below
 
@@ -5168,6 +5224,17 @@ namespace wi::scene
 		if (ocean.IsValid())
 		{
 			ocean.params = weather.oceanParameters;
+
+			// Without GPU (eg. dedicated server with the null device) or when requested, the ocean queries use the CPU simulation:
+			const GraphicsDevice* device = wi::graphics::GetDevice();
+			if (weather.IsOceanCPUSimulation() || device == nullptr || device->GetShaderFormat() == ShaderFormat::NONE)
+			{
+				ocean.UpdateDisplacementMapCPU(time);
+			}
+			else
+			{
+				ocean.ClearDisplacementMapCPU();
+			}
 		}
 
 		if (weather.rain_amount > 0)
@@ -5417,7 +5484,14 @@ namespace wi::scene
 				}
 				if (!script.script.empty())
 				{
-					wi::lua::RunBinaryData(script.script.data(), script.script.size(), script.filename.c_str());
+					if (script.IsIsolated())
+					{
+						isolated_scripts.push_back(uint32_t(i));
+					}
+					else
+					{
+						wi::lua::RunBinaryData(script.script.data(), script.script.size(), script.filename.c_str());
+					}
 				}
 
 				if (script.IsPlayingOnlyOnce())
@@ -5426,6 +5500,44 @@ namespace wi::scene
 				}
 			}
 		}
+
+		if (!isolated_scripts.empty())
+		{
+			// Isolated scripts run in parallel, every entity's script is always run by the same worker state so that its lua data persists:
+			const uint32_t worker_count = wi::lua::GetWorkerStateCount();
+			auto get_worker = [&](uint32_t index) {
+				return scripts.GetEntity(index) % worker_count;
+			};
+			std::sort(isolated_scripts.begin(), isolated_scripts.end(), [&](uint32_t a, uint32_t b) {
+				const uint32_t worker_a = get_worker(a);
+				const uint32_t worker_b = get_worker(b);
+				return worker_a < worker_b || (worker_a == worker_b && a < b);
+			});
+			isolated_script_offsets.clear();
+			isolated_script_offsets.resize(worker_count + 1);
+			for (uint32_t index : isolated_scripts)
+			{
+				isolated_script_offsets[get_worker(index) + 1]++;
+			}
+			for (uint32_t worker = 0; worker < worker_count; ++worker)
+			{
+				isolated_script_offsets[worker + 1] += isolated_script_offsets[worker];
+			}
+
+			wi::jobsystem::context isolated_ctx;
+			wi::jobsystem::Dispatch(isolated_ctx, worker_count, 1, [&](wi::jobsystem::JobArgs args) {
+				for (uint32_t i = isolated_script_offsets[args.jobIndex]; i < isolated_script_offsets[args.jobIndex + 1]; ++i)
+				{
+					const ScriptComponent& script = scripts[isolated_scripts[i]];
+					wi::lua::RunBinaryDataOnWorker(args.jobIndex, script.script.data(), script.script.size(), script.filename.c_str());
+				}
+			});
+			wi::jobsystem::Wait(isolated_ctx);
+			isolated_scripts.clear();
+		}
+
+		// Modifications that the isolated scripts deferred to the main thread, this is drained even when no isolated scripts are left:
+		wi::lua::RunDeferred();
 		wi::profiler::EndRange(range);
 	}
 	void Scene::RunSpriteUpdateSystem(wi::jobsystem::context& ctx)
@@ -8321,7 +8433,14 @@ namespace wi::scene
 
 		M = XMMatrixScalingFromVector(S) * XMMatrixRotationQuaternion(R) * XMMatrixTranslationFromVector(T);
 
-		XMStoreFloat4x4(&transform.world, M);
+		XMFLOAT4X4 world;
+		XMStoreFloat4x4(&world, M);
+		if (std::memcmp(&world, &transform.world, sizeof(world)) != 0)
+		{
+			transform.world = world;
+			// The world matrix no longer matches the local chain, so the hierarchy update must recompute it next frame (also when the spring gets disabled):
+			transform.SetDirty();
+		}
 
 #if 0
 		// Debug axis:
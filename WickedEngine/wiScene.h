@@ -93,6 +93,7 @@ namespace wi::scene
 		wi::vector<wi::primitive::Capsule> character_capsules;
 		wi::unordered_map<wi::ecs::Entity, wi::vector<wi::ecs::Entity>> topdown_hierarchy; // managed by BuildTopDownHierarchy() in every Update(), allows parent->children traversal
 		wi::jobsystem::context topdown_hierarchy_workload;
+		uint64_t transforms_version = 0; // managed by RunTransformUpdateSystem(), transforms that changed since the previous update have at least this version
 
 		// AABB culling streams:
 		wi::vector<wi::primitive::AABB> aabb_objects;
@@ -269,6 +270,10 @@ namespace wi::scene
 		wi::vector<uint32_t> lightmap_requests;
 		wi::vector<TransformComponent> transforms_temp;
 
+		// Isolated scripts that run in parallel (indices into scripts), grouped by lua worker state:
+		wi::vector<uint32_t> isolated_scripts;
+		wi::vector<uint32_t> isolated_script_offsets;
+
 		// CPU/GPU Colliders:
 		wi::vector<uint8_t> collider_deinterleaved_data;
 		uint32_t collider_count_cpu = 0;
@@ -282,7 +287,7 @@ namespace wi::scene
 		wi::jobsystem::context collider_bvh_workload;
 		void CountCPUandGPUColliders();
 
-		// Ocean GPU state:
+		// Ocean GPU and CPU simulation state:
 		wi::Ocean ocean;
 		void OceanRegenerate() { ocean.Create(weather.oceanParameters); }
 
@@ -578,6 +583,7 @@ namespace wi::scene
 		// Returns the approximate position on the ocean surface seen from a position in world space.
 		//	If current weather doesn't have ocean enabled, returns the world position itself.
 		//	The result position is approximate because it involves reading back from GPU to the CPU, so the result can be delayed compared to the current GPU simulation.
+		//	If there is no graphics device, or ocean.UpdateDisplacementMapCPU() was used, the result will come from the CPU simulation instead.
 		//	Note that the input position to this function will be taken on the XZ plane and modified by the displacement map's XZ value, and the Y (vertical) position will be taken from the ocean water height and displacement map only.
 		XMFLOAT3 GetOceanPosAt(const XMFLOAT3& worldPosition) const;
 
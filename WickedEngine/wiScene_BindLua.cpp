@@ -476,10 +476,9 @@ MetadataPreset = {
 
 void Bind()
 {
-	static bool initialized = false;
-	if (!initialized)
+	static const char binding_key = 0;
+	if (wi::lua::BeginBinding(&binding_key))
 	{
-		initialized = true;
 
 		lua_State* L = wi::lua::GetLuaState();
 
@@ -6106,6 +6105,8 @@ Luna<ScriptComponent_BindLua>::FunctionType ScriptComponent_BindLua::methods[] =
 	lunamethod(ScriptComponent_BindLua, IsPlaying),
 	lunamethod(ScriptComponent_BindLua, SetPlayOnce),
 	lunamethod(ScriptComponent_BindLua, Stop),
+	lunamethod(ScriptComponent_BindLua, SetIsolated),
+	lunamethod(ScriptComponent_BindLua, IsIsolated),
 	{ NULL, NULL }
 };
 Luna<ScriptComponent_BindLua>::PropertyType ScriptComponent_BindLua::properties[] = {
@@ -6151,6 +6152,22 @@ int ScriptComponent_BindLua::Stop(lua_State* L)
 	component->Stop();
 	return 0;
 }
+int ScriptComponent_BindLua::SetIsolated(lua_State* L)
+{
+	int argc = wi::lua::SGetArgCount(L);
+	bool value = true;
+	if (argc > 0)
+	{
+		value = wi::lua::SGetBool(L, 1);
+	}
+	component->SetIsolated(value);
+	return 0;
+}
+int ScriptComponent_BindLua::IsIsolated(lua_State* L)
+{
+	wi::lua::SSetBool(L, component->IsIsolated());
+	return 1;
+}
 
 
 
@@ -6560,6 +6577,7 @@ Luna<WeatherComponent_BindLua>::FunctionType WeatherComponent_BindLua::methods[]
 	lunamethod(WeatherComponent_BindLua, IsRealisticSkyHighQuality),
 	lunamethod(WeatherComponent_BindLua, IsRealisticSkyReceiveShadow),
 	lunamethod(WeatherComponent_BindLua, IsVolumetricCloudsReceiveShadow),
+	lunamethod(WeatherComponent_BindLua, IsOceanCPUSimulation),
 	lunamethod(WeatherComponent_BindLua, SetOceanEnabled),
 	lunamethod(WeatherComponent_BindLua, SetSimpleSky),
 	lunamethod(WeatherComponent_BindLua, SetRealisticSky),
@@ -6571,6 +6589,7 @@ Luna<WeatherComponent_BindLua>::FunctionType WeatherComponent_BindLua::methods[]
 	lunamethod(WeatherComponent_BindLua, SetRealisticSkyHighQuality),
 	lunamethod(WeatherComponent_BindLua, SetRealisticSkyReceiveShadow),
 	lunamethod(WeatherComponent_BindLua, SetVolumetricCloudsReceiveShadow),
+	lunamethod(WeatherComponent_BindLua, SetOceanCPUSimulation),
 	{ NULL, NULL }
 };
 Luna<WeatherComponent_BindLua>::PropertyType WeatherComponent_BindLua::properties[] = {
@@ -6823,6 +6842,25 @@ int WeatherComponent_BindLua::SetVolumetricCloudsReceiveShadow(lua_State* L)
 	}
 	return 0;
 }
+int WeatherComponent_BindLua::IsOceanCPUSimulation(lua_State* L)
+{
+	wi::lua::SSetBool(L, component->IsOceanCPUSimulation());
+	return 1;
+}
+int WeatherComponent_BindLua::SetOceanCPUSimulation(lua_State* L)
+{
+	int argc = wi::lua::SGetArgCount(L);
+	if (argc > 0)
+	{
+		bool value = wi::lua::SGetBool(L, 1);
+		component->SetOceanCPUSimulation(value);
+	}
+	else
+	{
+		wi::lua::SError(L, "SetOceanCPUSimulation(bool value) not enough arguments!");
+	}
+	return 0;
+}
 int WeatherComponent_BindLua::GetSkyMapName(lua_State* L)
 {
 	wi::lua::SSetString(L, component->skyMapName);
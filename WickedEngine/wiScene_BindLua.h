@@ -930,6 +930,8 @@ namespace wi::lua::scene
 		int IsPlaying(lua_State* L);
 		int SetPlayOnce(lua_State* L);
 		int Stop(lua_State* L);
+		int SetIsolated(lua_State* L);
+		int IsIsolated(lua_State* L);
 	};
 
 	class RigidBodyPhysicsComponent_BindLua
@@ -1660,6 +1662,7 @@ namespace wi::lua::scene
 		int IsRealisticSkyHighQuality(lua_State* L);
 		int IsRealisticSkyReceiveShadow(lua_State* L);
 		int IsVolumetricCloudsReceiveShadow(lua_State* L);
+		int IsOceanCPUSimulation(lua_State* L);
 
 		int SetOceanEnabled(lua_State* L);
 		int SetSimpleSky(lua_State* L);
@@ -1672,6 +1675,7 @@ namespace wi::lua::scene
 		int SetRealisticSkyHighQuality(lua_State* L);
 		int SetRealisticSkyReceiveShadow(lua_State* L);
 		int SetVolumetricCloudsReceiveShadow(lua_State* L);
+		int SetOceanCPUSimulation(lua_State* L);
 
 		int GetSkyMapName(lua_State* L);
 		int GetColorGradingMapName(lua_State* L);
@@ -1906,6 +1906,113 @@ namespace wi::scene
 
 		CreateRenderData();
 	}
+	void MeshComponent::Optimize(OptimizationStatistics* statistics)
+	{
+		const size_t vertex_count = vertex_positions.size();
+		if (vertex_count == 0 || indices.empty() || indices.size() % 3 != 0)
+			return;
+		for (uint32_t index : indices)
+		{
+			if (index >= vertex_count)
+				return;
+		}
+
+		auto analyze = [&](float& acmr, float& overdraw, float& overfetch) {
+			acmr = meshopt_analyzeVertexCache(indices.data(), indices.size(), vertex_count, 16, 0, 0).acmr;
+			overdraw = meshopt_analyzeOverdraw(indices.data(), indices.size(), &vertex_positions[0].x, vertex_count, sizeof(XMFLOAT3)).overdraw;
+			overfetch = meshopt_analyzeVertexFetch(indices.data(), indices.size(), vertex_count, sizeof(XMFLOAT3)).overfetch;
+		};
+		if (statistics != nullptr)
+		{
+			analyze(statistics->acmr_before, statistics->overdraw_before, statistics->overfetch_before);
+		}
+
+		// Triangle order is optimized within each subset, so subset ranges remain valid:
+		for (auto& subset : subsets)
+		{
+			if (subset.indexCount < 3 || subset.indexCount % 3 != 0 || size_t(subset.indexOffset) + subset.indexCount > indices.size())
+				continue;
+			uint32_t* subset_indices = indices.data() + subset.indexOffset;
+			meshopt_optimizeVertexCache(subset_indices, subset_indices, subset.indexCount, vertex_count);
+			meshopt_optimizeOverdraw(subset_indices, subset_indices, subset.indexCount, &vertex_positions[0].x, vertex_count, sizeof(XMFLOAT3), 1.05f);
+		}
+
+		// Vertices are ordered by first use in the whole index buffer, the unreferenced vertices are kept at the end:
+		wi::vector<uint32_t> remap(vertex_count);
+		size_t referenced_count = meshopt_optimizeVertexFetchRemap(remap.data(), indices.data(), indices.size(), vertex_count);
+		for (auto& x : remap)
+		{
+			if (x == ~0u)
+			{
+				x = uint32_t(referenced_count++);
+			}
+		}
+		meshopt_remapIndexBuffer(indices.data(), indices.data(), indices.size(), remap.data());
+
+		auto remap_vertices = [&](auto& vertices) {
+			if (vertices.empty())
+				return;
+			vertices.resize(vertex_count); // dense morph targets can be shorter, the missing vertices are not displaced
+			auto vertices_original = vertices;
+			for (size_t i = 0; i < vertex_count; ++i)
+			{
+				vertices[remap[i]] = vertices_original[i];
+			}
+		};
+		remap_vertices(vertex_positions);
+		remap_vertices(vertex_normals);
+		remap_vertices(vertex_tangents);
+		remap_vertices(vertex_uvset_0);
+		remap_vertices(vertex_uvset_1);
+		remap_vertices(vertex_boneindices);
+		remap_vertices(vertex_boneweights);
+		remap_vertices(vertex_boneindices2);
+		remap_vertices(vertex_boneweights2);
+		remap_vertices(vertex_atlas);
+		remap_vertices(vertex_colors);
+		remap_vertices(vertex_windweights);
+
+		auto remap_sparse_indices = [&](wi::vector<uint32_t>& sparse_indices) {
+			for (auto& x : sparse_indices)
+			{
+				if (x < vertex_count)
+				{
+					x = remap[x];
+				}
+			}
+		};
+		for (auto& morph : morph_targets)
+		{
+			if (morph.sparse_indices_positions.empty())
+			{
+				remap_vertices(morph.vertex_positions);
+			}
+			else
+			{
+				remap_sparse_indices(morph.sparse_indices_positions);
+			}
+			if (morph.sparse_indices_normals.empty())
+			{
+				remap_vertices(morph.vertex_normals);
+			}
+			else
+			{
+				remap_sparse_indices(morph.sparse_indices_normals);
+			}
+		}
+
+		if (statistics != nullptr)
+		{
+			analyze(statistics->acmr_after, statistics->overdraw_after, statistics->overfetch_after);
+		}
+
+		CreateRenderData();
+
+		if (IsBVHEnabled())
+		{
+			BuildBVH();
+		}
+	}
 	Sphere MeshComponent::GetBoundingSphere() const
 	{
 		Sphere sphere;
@@ -49,6 +49,7 @@ namespace wi::scene
 		{
 			EMPTY = 0,
 			DIRTY = 1 << 0,
+			CHANGED = 1 << 1,
 		};
 
 		XMFLOAT3 scale_local = XMFLOAT3(1, 1, 1);
@@ -64,9 +65,14 @@ namespace wi::scene
 		//	- or by calling SetDirty() and letting the TransformUpdateSystem handle the updating
 		XMFLOAT4X4 world = wi::math::IDENTITY_MATRIX;
 
-		constexpr void SetDirty(bool value = true) { if (value) { _flags |= DIRTY; } else { _flags &= ~DIRTY; } }
+		constexpr void SetDirty(bool value = true) { if (value) { _flags |= DIRTY | CHANGED; } else { _flags &= ~DIRTY; } }
 		constexpr bool IsDirty() const { return _flags & DIRTY; }
 
+		// The changed flag is set together with dirty, but it is only cleared by the TransformUpdateSystem when it reports the change to the ComponentManager
+		//	So the change is tracked even if the world matrix was already updated with UpdateTransform()
+		constexpr bool IsChanged() const { return _flags & CHANGED; }
+		constexpr void ClearChanged() { _flags &= ~CHANGED; }
+
 		XMFLOAT3 GetPosition() const;
 		XMFLOAT4 GetRotation() const;
 		XMFLOAT3 GetScale() const;
@@ -860,6 +866,23 @@ namespace wi::scene
 		void RecenterToBottom();
 		wi::primitive::Sphere GetBoundingSphere() const;
 
+		struct OptimizationStatistics
+		{
+			float acmr_before = 0; // average cache miss ratio: transformed vertices per triangle with a 16 entry FIFO vertex cache (0.5 is ideal, 3 is the worst)
+			float acmr_after = 0;
+			float overdraw_before = 0; // shaded pixels per covered pixel when rasterizing the mesh from multiple directions (1 is ideal)
+			float overdraw_after = 0;
+			float overfetch_before = 0; // fetched vertex position bytes per vertex position buffer byte with 64 byte cache lines (1 is ideal)
+			float overfetch_after = 0;
+		};
+		// Reorders the mesh data for better GPU performance with the meshoptimizer library:
+		//	- The triangles of every subset are reordered for vertex cache efficiency, then for less overdraw
+		//	- The vertices are reordered in the order the indices reference them, for vertex fetch efficiency
+		//	The subset index ranges, the vertex count and the morph targets are preserved, but vertex data that is stored outside of the mesh
+		//	(like ObjectComponent::vertex_ao or soft body vertex mapping) will need to be recomputed
+		//	statistics	:	if not nullptr, the ACMR, overdraw and overfetch of the mesh before and after the optimization will be written here
+		void Optimize(OptimizationStatistics* statistics = nullptr);
+
 		uint32_t GetBoneInfluenceDiv4() const
 		{
 			uint32_t influence_div4 = 0;
@@ -1803,6 +1826,7 @@ namespace wi::scene
 			REALISTIC_SKY_HIGH_QUALITY = 1 << 8,
 			REALISTIC_SKY_RECEIVE_SHADOW = 1 << 9,
 			VOLUMETRIC_CLOUDS_RECEIVE_SHADOW = 1 << 10,
+			OCEAN_CPU_SIMULATION = 1 << 11,
 		};
 		uint32_t _flags = EMPTY;
 
@@ -1816,6 +1840,9 @@ namespace wi::scene
 		constexpr bool IsRealisticSkyHighQuality() const { return _flags & REALISTIC_SKY_HIGH_QUALITY; }
 		constexpr bool IsRealisticSkyReceiveShadow() const { return _flags & REALISTIC_SKY_RECEIVE_SHADOW; }
 		constexpr bool IsVolumetricCloudsReceiveShadow() const { return _flags & VOLUMETRIC_CLOUDS_RECEIVE_SHADOW; }
+		// The ocean is also simulated on the CPU every frame, so GetOceanPosAt() doesn't depend on GPU readback (eg. for dedicated servers)
+		//	This is automatically done when there is no GPU (no graphics device, or the null device)
+		constexpr bool IsOceanCPUSimulation() const { return _flags & OCEAN_CPU_SIMULATION; }
 
 		constexpr void SetOceanEnabled(bool value = true) { if (value) { _flags |= OCEAN_ENABLED; } else { _flags &= ~OCEAN_ENABLED; } }
 		constexpr void SetRealisticSky(bool value = true) { if (value) { _flags |= REALISTIC_SKY; } else { _flags &= ~REALISTIC_SKY; } }
@@ -1827,6 +1854,7 @@ namespace wi::scene
 		constexpr void SetRealisticSkyHighQuality(bool value = true) { if (value) { _flags |= REALISTIC_SKY_HIGH_QUALITY; } else { _flags &= ~REALISTIC_SKY_HIGH_QUALITY; } }
 		constexpr void SetRealisticSkyReceiveShadow(bool value = true) { if (value) { _flags |= REALISTIC_SKY_RECEIVE_SHADOW; } else { _flags &= ~REALISTIC_SKY_RECEIVE_SHADOW; } }
 		constexpr void SetVolumetricCloudsReceiveShadow(bool value = true) { if (value) { _flags |= VOLUMETRIC_CLOUDS_RECEIVE_SHADOW; } else { _flags &= ~VOLUMETRIC_CLOUDS_RECEIVE_SHADOW; } }
+		constexpr void SetOceanCPUSimulation(bool value = true) { if (value) { _flags |= OCEAN_CPU_SIMULATION; } else { _flags &= ~OCEAN_CPU_SIMULATION; } }
 
 		XMFLOAT3 sunColor = XMFLOAT3(0, 0, 0);
 		XMFLOAT3 sunDirection = XMFLOAT3(0, 1, 0);
@@ -2046,6 +2074,7 @@ namespace wi::scene
 			EMPTY = 0,
 			PLAYING = 1 << 0,
 			PLAY_ONCE = 1 << 1,
+			ISOLATED = 1 << 2,
 		};
 		uint32_t _flags = EMPTY;
 
@@ -2059,9 +2088,14 @@ namespace wi::scene
 		constexpr void Play() { _flags |= PLAYING; }
 		constexpr void SetPlayOnce(bool once = true) { if (once) { _flags |= PLAY_ONCE; } else { _flags &= ~PLAY_ONCE; } }
 		constexpr void Stop() { _flags &= ~PLAYING; }
+		// Isolated scripts run in parallel with each other on the lua worker states (see wi::lua::GetWorkerStateCount())
+		//	They can read the scene and modify the existing components of their own entity, but any other modification to the scene
+		//	(creating/removing entities and components, modifying other entities) must be deferred with RunOnMainThread()
+		constexpr void SetIsolated(bool value = true) { if (value) { _flags |= ISOLATED; } else { _flags &= ~ISOLATED; } }
 
 		constexpr bool IsPlaying() const { return _flags & PLAYING; }
 		constexpr bool IsPlayingOnlyOnce() const { return _flags & PLAY_ONCE; }
+		constexpr bool IsIsolated() const { return _flags & ISOLATED; }
 
 		void CreateFromFile(const std::string& filename);
 
@@ -0,0 +1,570 @@
+#include "wiScene_Replication.h"
+#include "wiScene.h"
+#include "wiUnorderedSet.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace wi::ecs;
+
+namespace wi::scene
+{
+	// Snapshot layout:
+	//	varint snapshot_id, varint baseline_id (0: full snapshot)
+	//	float position_precision, float scale_precision, uint8 rotation_bits
+	//	for every included component type:
+	//		uint8 1, string name, uint64 jump position to the next type
+	//		varint removal count, varint entity[removal count]
+	//		varint change count, { varint entity, component data }[change count]
+	//	uint8 0
+
+	static inline void WriteVarint(wi::Archive& archive, uint64_t value)
+	{
+		while (value >= 0x80)
+		{
+			archive << uint8_t(value | 0x80);
+			value >>= 7;
+		}
+		archive << uint8_t(value);
+	}
+	static inline uint64_t ReadVarint(wi::Archive& archive)
+	{
+		uint64_t value = 0;
+		for (uint32_t shift = 0; shift < 64; shift += 7)
+		{
+			uint8_t byte = 0;
+			archive >> byte;
+			value |= uint64_t(byte & 0x7F) << shift;
+			if ((byte & 0x80) == 0)
+				break;
+		}
+		return value;
+	}
+
+	// Quantized values are written as zigzag encoded varints, so that small values take few bytes regardless of sign
+	static inline void WriteQuantized(wi::Archive& archive, float value, float precision)
+	{
+		if (precision <= 0)
+		{
+			archive << value;
+			return;
+		}
+		const int64_t quantized = (int64_t)std::llround(double(value) / double(precision));
+		WriteVarint(archive, (uint64_t(quantized) << 1) ^ uint64_t(quantized >> 63));
+	}
+	static inline float ReadQuantized(wi::Archive& archive, float precision)
+	{
+		if (precision <= 0)
+		{
+			float value = 0;
+			archive >> value;
+			return value;
+		}
+		const uint64_t zigzag = ReadVarint(archive);
+		const int64_t quantized = int64_t(zigzag >> 1) ^ -int64_t(zigzag & 1);
+		return float(double(quantized) * double(precision));
+	}
+
+	// Rotation is written with the smallest three method:
+	//	the largest quaternion component is omitted (only its index is stored) and reconstructed from the unit length
+	//	the other three are in range [-1/sqrt(2), 1/sqrt(2)] and quantized to rotation_bits each
+	static constexpr float smallest_three_range = 0.707106781f;
+	static inline void WriteRotation(wi::Archive& archive, const XMFLOAT4& rotation, uint32_t bits)
+	{
+		if (bits == 0)
+		{
+			archive << rotation;
+			return;
+		}
+		XMFLOAT4 normalized;
+		XMStoreFloat4(&normalized, XMQuaternionNormalize(XMLoadFloat4(&rotation)));
+		const float q[4] = { normalized.x, normalized.y, normalized.z, normalized.w };
+		uint32_t largest = 0;
+		for (uint32_t i = 1; i < 4; ++i)
+		{
+			if (std::abs(q[i]) > std::abs(q[largest]))
+			{
+				largest = i;
+			}
+		}
+		// q and -q are the same rotation, so the omitted component is made positive:
+		const float sign = q[largest] < 0 ? -1.0f : 1.0f;
+		const uint32_t maxvalue = (1u << bits) - 1;
+		uint64_t packed = largest;
+		for (uint32_t i = 0; i < 4; ++i)
+		{
+			if (i == largest)
+				continue;
+			const float value = wi::math::saturate(q[i] * sign / smallest_three_range * 0.5f + 0.5f);
+			packed = (packed << bits) | uint64_t(value * maxvalue + 0.5f);
+		}
+		const uint32_t bytes = (2 + 3 * bits + 7) / 8;
+		for (uint32_t i = 0; i < bytes; ++i)
+		{
+			archive << uint8_t(packed >> (i * 8));
+		}
+	}
+	static inline XMFLOAT4 ReadRotation(wi::Archive& archive, uint32_t bits)
+	{
+		XMFLOAT4 rotation = XMFLOAT4(0, 0, 0, 1);
+		if (bits == 0)
+		{
+			archive >> rotation;
+			return rotation;
+		}
+		const uint32_t bytes = (2 + 3 * bits + 7) / 8;
+		uint64_t packed = 0;
+		for (uint32_t i = 0; i < bytes; ++i)
+		{
+			uint8_t byte = 0;
+			archive >> byte;
+			packed |= uint64_t(byte) << (i * 8);
+		}
+		const uint32_t maxvalue = (1u << bits) - 1;
+		float smallest[3];
+		for (int i = 2; i >= 0; --i)
+		{
+			smallest[i] = (float(packed & maxvalue) / maxvalue * 2 - 1) * smallest_three_range;
+			packed >>= bits;
+		}
+		const uint32_t largest = uint32_t(packed & 3);
+		float q[4];
+		float sum = 0;
+		for (uint32_t i = 0, j = 0; i < 4; ++i)
+		{
+			if (i == largest)
+				continue;
+			q[i] = smallest[j++];
+			sum += q[i] * q[i];
+		}
+		q[largest] = std::sqrt(std::max(0.0f, 1 - sum));
+		rotation = XMFLOAT4(q[0], q[1], q[2], q[3]);
+		return rotation;
+	}
+
+	static inline void WriteTransform(wi::Archive& archive, const TransformComponent& transform, float position_precision, float scale_precision, uint32_t rotation_bits)
+	{
+		WriteQuantized(archive, transform.translation_local.x, position_precision);
+		WriteQuantized(archive, transform.translation_local.y, position_precision);
+		WriteQuantized(archive, transform.translation_local.z, position_precision);
+		WriteRotation(archive, transform.rotation_local, rotation_bits);
+		WriteQuantized(archive, transform.scale_local.x, scale_precision);
+		WriteQuantized(archive, transform.scale_local.y, scale_precision);
+		WriteQuantized(archive, transform.scale_local.z, scale_precision);
+	}
+	static inline void ReadTransform(wi::Archive& archive, TransformComponent& transform, float position_precision, float scale_precision, uint32_t rotation_bits)
+	{
+		transform.translation_local.x = ReadQuantized(archive, position_precision);
+		transform.translation_local.y = ReadQuantized(archive, position_precision);
+		transform.translation_local.z = ReadQuantized(archive, position_precision);
+		transform.rotation_local = ReadRotation(archive, rotation_bits);
+		transform.scale_local.x = ReadQuantized(archive, scale_precision);
+		transform.scale_local.y = ReadQuantized(archive, scale_precision);
+		transform.scale_local.z = ReadQuantized(archive, scale_precision);
+		transform.SetDirty();
+		transform.UpdateTransform();
+	}
+
+	// FNV-1a hash of the serialized component data, the archive header is skipped
+	static inline uint64_t HashArchive(const wi::Archive& archive)
+	{
+		uint64_t hash = 0xcbf29ce484222325ull;
+		const uint8_t* data = archive.GetData();
+		for (size_t i = sizeof(wi::Archive::Header); i < archive.GetPos(); ++i)
+		{
+			hash ^= data[i];
+			hash *= 0x100000001b3ull;
+		}
+		return hash;
+	}
+
+	uint32_t SnapshotWriter::Write(Scene& scene, wi::Archive& archive)
+	{
+		assert(!archive.IsReadMode());
+
+		if (tracked_scene != &scene)
+		{
+			Reset();
+			tracked_scene = &scene;
+		}
+		if (types.empty())
+		{
+			wi::vector<std::string> names = components;
+			if (names.empty())
+			{
+				for (auto& it : scene.componentLibrary.entries)
+				{
+					names.push_back(it.first);
+				}
+				std::sort(names.begin(), names.end());
+			}
+			for (auto& name : names)
+			{
+				auto it = scene.componentLibrary.entries.find(name);
+				if (it == scene.componentLibrary.entries.end())
+					continue;
+				TrackedType& type = types.emplace_back();
+				type.name = name;
+				type.manager = it->second.component_manager.get();
+				type.transform = type.manager == &scene.transforms;
+			}
+		}
+
+		const uint32_t current = ++snapshot_id;
+		uint32_t baseline = acknowledged_id;
+		if (baseline == 0 || current - baseline > max_baseline_age)
+		{
+			baseline = 0;
+		}
+		const uint32_t clamped_rotation_bits = rotation_bits == 0 ? 0 : std::min(20u, std::max(6u, rotation_bits));
+
+		statistics = {};
+		statistics.snapshot_id = current;
+		statistics.baseline_id = baseline;
+
+		// The change logs are only needed for snapshots that can still be used as a baseline:
+		const uint32_t prune_snapshot = std::max(acknowledged_id, current > max_baseline_age ? current - max_baseline_age : 0u);
+		changes.erase(changes.begin(), std::find_if(changes.begin(), changes.end(), [&](const Change& x) { return x.snapshot > prune_snapshot; }));
+		removals.erase(removals.begin(), std::find_if(removals.begin(), removals.end(), [&](const Removal& x) { return x.snapshot > prune_snapshot; }));
+
+		EntitySerializer seri;
+
+		// Change detection:
+		for (uint32_t type_index = 0; type_index < (uint32_t)types.size(); ++type_index)
+		{
+			TrackedType& type = types[type_index];
+			ComponentManager_Interface* manager = type.manager;
+			seri.version = scene.componentLibrary.GetVersion(type.name);
+			const uint64_t manager_version = manager->GetVersion();
+			const size_t count = manager->GetCount();
+			size_t existing = 0;
+			for (size_t i = 0; i < count; ++i)
+			{
+				const Entity entity = manager->GetEntity(i);
+				auto it = type.lookup.find(entity);
+				if (it != type.lookup.end())
+				{
+					existing++;
+					slots[it->second].seen_snapshot = current;
+					if (manager->GetVersion(i) < type.checked_version)
+						continue; // not changed since the last change detection
+				}
+
+				scratch.SetReadModeAndResetPos(false);
+				if (type.transform)
+				{
+					WriteTransform(scratch, scene.transforms[i], position_precision, scale_precision, clamped_rotation_bits);
+				}
+				else
+				{
+					manager->Component_Serialize(entity, scratch, seri);
+				}
+				const uint64_t hash = HashArchive(scratch);
+				statistics.serialized_components++;
+
+				uint32_t slot_index = 0;
+				if (it == type.lookup.end())
+				{
+					if (free_slots.empty())
+					{
+						slot_index = (uint32_t)slots.size();
+						slots.emplace_back();
+					}
+					else
+					{
+						slot_index = free_slots.back();
+						free_slots.pop_back();
+					}
+					TrackedComponent& slot = slots[slot_index];
+					slot = {};
+					slot.entity = entity;
+					slot.type = type_index;
+					slot.seen_snapshot = current;
+					type.lookup[entity] = slot_index;
+				}
+				else
+				{
+					slot_index = it->second;
+					if (slots[slot_index].hash == hash)
+						continue;
+				}
+				TrackedComponent& slot = slots[slot_index];
+				slot.hash = hash;
+				slot.changed_snapshot = current;
+				changes.push_back({ slot_index, current });
+				statistics.changed_components++;
+			}
+			statistics.tracked_components += count;
+
+			// Not every previously tracked component was found, so some of them were removed:
+			if (existing < type.lookup.size())
+			{
+				for (auto it = type.lookup.begin(); it != type.lookup.end();)
+				{
+					TrackedComponent& slot = slots[it->second];
+					if (slot.seen_snapshot == current)
+					{
+						++it;
+						continue;
+					}
+					removals.push_back({ slot.entity, type_index, current });
+					slot = {};
+					free_slots.push_back(it->second);
+					it = type.lookup.erase(it);
+				}
+			}
+			type.checked_version = manager_version;
+		}
+
+		// Gather the components that changed since the baseline, sorted by type and component order:
+		written.clear();
+		if (baseline == 0)
+		{
+			for (uint32_t slot_index = 0; slot_index < (uint32_t)slots.size(); ++slot_index)
+			{
+				const TrackedComponent& slot = slots[slot_index];
+				if (slot.changed_snapshot == 0)
+					continue;
+				const uint64_t index = types[slot.type].manager->GetIndex(slot.entity);
+				written.push_back({ (uint64_t(slot.type) << 32) | index, slot_index });
+			}
+		}
+		else
+		{
+			for (auto it = changes.rbegin(); it != changes.rend() && it->snapshot > baseline; ++it)
+			{
+				TrackedComponent& slot = slots[it->slot];
+				if (slot.changed_snapshot != it->snapshot || slot.written_snapshot == current)
+					continue; // the log entry is outdated or the component was already gathered
+				slot.written_snapshot = current;
+				const uint64_t index = types[slot.type].manager->GetIndex(slot.entity);
+				written.push_back({ (uint64_t(slot.type) << 32) | index, it->slot });
+			}
+		}
+		std::sort(written.begin(), written.end());
+
+		// Write the snapshot:
+		const size_t begin = archive.GetPos();
+		WriteVarint(archive, current);
+		WriteVarint(archive, baseline);
+		archive << position_precision;
+		archive << scale_precision;
+		archive << uint8_t(clamped_rotation_bits);
+
+		size_t written_offset = 0;
+		for (uint32_t type_index = 0; type_index < (uint32_t)types.size(); ++type_index)
+		{
+			TrackedType& type = types[type_index];
+
+			size_t written_end = written_offset;
+			while (written_end < written.size() && (written[written_end].first >> 32) == type_index)
+			{
+				written_end++;
+			}
+			size_t removal_count = 0;
+			if (baseline > 0)
+			{
+				for (auto& x : removals)
+				{
+					removal_count += x.type == type_index && x.snapshot > baseline ? 1 : 0;
+				}
+			}
+			// Full snapshots contain every type, because the receiver removes the components that are not included:
+			if (baseline > 0 && removal_count == 0 && written_end == written_offset)
+				continue;
+
+			seri.version = scene.componentLibrary.GetVersion(type.name);
+			archive << uint8_t(1);
+			archive << type.name;
+			const size_t jump = archive.WriteUnknownJumpPosition();
+
+			WriteVarint(archive, removal_count);
+			if (removal_count > 0)
+			{
+				for (auto& x : removals)
+				{
+					if (x.type == type_index && x.snapshot > baseline)
+					{
+						WriteVarint(archive, x.entity);
+					}
+				}
+			}
+			statistics.written_removals += removal_count;
+
+			WriteVarint(archive, written_end - written_offset);
+			for (size_t i = written_offset; i < written_end; ++i)
+			{
+				const TrackedComponent& slot = slots[written[i].second];
+				WriteVarint(archive, slot.entity);
+				if (type.transform)
+				{
+					const size_t index = size_t(written[i].first & 0xFFFFFFFF);
+					WriteTransform(archive, scene.transforms[index], position_precision, scale_precision, clamped_rotation_bits);
+				}
+				else
+				{
+					type.manager->Component_Serialize(slot.entity, archive, seri);
+				}
+			}
+			statistics.written_components += written_end - written_offset;
+			written_offset = written_end;
+
+			archive.PatchUnknownJumpPosition(jump);
+		}
+		archive << uint8_t(0);
+
+		statistics.snapshot_size = archive.GetPos() - begin;
+		return current;
+	}
+
+	void SnapshotWriter::Acknowledge(uint32_t snapshot_id)
+	{
+		if (snapshot_id <= this->snapshot_id)
+		{
+			acknowledged_id = std::max(acknowledged_id, snapshot_id);
+		}
+	}
+
+	void SnapshotWriter::Reset()
+	{
+		tracked_scene = nullptr;
+		types.clear();
+		slots.clear();
+		free_slots.clear();
+		changes.clear();
+		removals.clear();
+		written.clear();
+		acknowledged_id = 0;
+		statistics = {};
+	}
+
+	bool SnapshotReader::Apply(Scene& scene, wi::Archive& archive, uint32_t* snapshot_id)
+	{
+		assert(archive.IsReadMode());
+
+		const uint32_t id = (uint32_t)ReadVarint(archive);
+		const uint32_t baseline = (uint32_t)ReadVarint(archive);
+		if (id <= last_applied_id)
+			return false; // outdated
+		if (baseline > last_applied_id)
+			return false; // the changes before the baseline are missing
+
+		float position_precision = 0;
+		float scale_precision = 0;
+		uint8_t rotation_bits = 0;
+		archive >> position_precision;
+		archive >> scale_precision;
+		archive >> rotation_bits;
+
+		auto map_entity = [&](uint64_t remote) {
+			if (remote == INVALID_ENTITY)
+				return INVALID_ENTITY;
+			auto it = seri.remap.find(remote);
+			if (it != seri.remap.end())
+				return it->second;
+			const Entity entity = CreateEntity();
+			seri.remap[remote] = entity;
+			return entity;
+		};
+
+		// A full snapshot replaces the replicated state, so the components of replicated entities that it doesn't contain are removed:
+		const bool full = baseline == 0;
+		wi::unordered_set<Entity> replicated;
+		wi::unordered_set<Entity> included;
+		if (full)
+		{
+			for (auto& it : seri.remap)
+			{
+				replicated.insert(it.second);
+			}
+		}
+
+		seri.componentlibrary = &scene.componentLibrary;
+		uint8_t has_next = 0;
+		archive >> has_next;
+		while (has_next)
+		{
+			std::string name;
+			archive >> name;
+			uint64_t jump_pos = 0;
+			archive >> jump_pos;
+			auto entry = scene.componentLibrary.entries.find(name);
+			if (entry == scene.componentLibrary.entries.end())
+			{
+				// component manager of this name was not registered, skip the data
+				archive.Jump(jump_pos);
+				archive >> has_next;
+				continue;
+			}
+			ComponentManager_Interface* manager = entry->second.component_manager.get();
+			const bool transform = manager == &scene.transforms;
+			seri.version = entry->second.version;
+
+			const uint64_t removal_count = ReadVarint(archive);
+			for (uint64_t i = 0; i < removal_count; ++i)
+			{
+				auto it = seri.remap.find(ReadVarint(archive));
+				if (it != seri.remap.end())
+				{
+					manager->Remove_KeepSorted(it->second);
+				}
+			}
+
+			included.clear();
+			const uint64_t change_count = ReadVarint(archive);
+			for (uint64_t i = 0; i < change_count; ++i)
+			{
+				const Entity entity = map_entity(ReadVarint(archive));
+				if (transform)
+				{
+					TransformComponent* component = scene.transforms.GetComponent(entity);
+					if (component == nullptr)
+					{
+						component = &scene.transforms.Create(entity);
+					}
+					ReadTransform(archive, *component, position_precision, scale_precision, rotation_bits);
+				}
+				else
+				{
+					manager->Component_Serialize(entity, archive, seri);
+				}
+				if (full)
+				{
+					included.insert(entity);
+				}
+			}
+
+			if (full)
+			{
+				for (size_t i = manager->GetCount(); i > 0; --i)
+				{
+					const Entity entity = manager->GetEntity(i - 1);
+					if (replicated.count(entity) > 0 && included.count(entity) == 0)
+					{
+						manager->Remove_KeepSorted(entity);
+					}
+				}
+			}
+
+			archive >> has_next;
+		}
+
+		wi::jobsystem::Wait(seri.ctx);
+		last_applied_id = id;
+		if (snapshot_id != nullptr)
+		{
+			*snapshot_id = id;
+		}
+		return true;
+	}
+
+	Entity SnapshotReader::GetLocalEntity(Entity remote_entity) const
+	{
+		auto it = seri.remap.find(remote_entity);
+		if (it != seri.remap.end())
+		{
+			return it->second;
+		}
+		return INVALID_ENTITY;
+	}
+}
@@ -0,0 +1,120 @@
+#pragma once
+#include "CommonInclude.h"
+#include "wiECS.h"
+#include "wiArchive.h"
+#include "wiVector.h"
+#include "wiUnorderedMap.h"
+
+#include <string>
+
+namespace wi::scene
+{
+	struct Scene;
+
+	// Creates delta compressed snapshots of a scene to replicate it over the network
+	//	A snapshot only contains the components that changed (or were removed) since the last snapshot that the receiver acknowledged,
+	//	so one SnapshotWriter must be used for every receiver
+	//	The components are detected as changed by comparing their serialized data with the previous snapshot. If a component manager
+	//	uses change versions (ComponentManager::AdvanceVersion()), the components that weren't changed since the previous snapshot are not serialized
+	class SnapshotWriter
+	{
+	public:
+		// Names of the replicated component managers from the scene's component library (empty = all of them)
+		wi::vector<std::string> components;
+
+		// Transform quantization, these only affect the TransformComponents:
+		float position_precision = 0.001f; // translation is quantized to this precision (0 = full precision float)
+		float scale_precision = 0.001f; // scale is quantized to this precision (0 = full precision float)
+		uint32_t rotation_bits = 15; // bits per quaternion component, in range [6, 20] (0 = full precision float)
+
+		// If the receiver doesn't acknowledge snapshots for this many snapshots, the snapshots will contain the whole state again
+		uint32_t max_baseline_age = 128;
+
+		struct Statistics
+		{
+			uint32_t snapshot_id = 0;
+			uint32_t baseline_id = 0; // 0: full snapshot
+			size_t tracked_components = 0; // number of replicated components in the scene
+			size_t serialized_components = 0; // number of components that were serialized for change detection
+			size_t changed_components = 0; // number of components that changed since the previous snapshot
+			size_t written_components = 0; // number of components written into the snapshot
+			size_t written_removals = 0; // number of component removals written into the snapshot
+			size_t snapshot_size = 0; // size of the snapshot data in bytes
+		};
+
+		// Detects the changes in the scene and writes the snapshot into the archive (which must be in write mode)
+		//	returns the snapshot id, which the receiver should acknowledge after applying it
+		uint32_t Write(Scene& scene, wi::Archive& archive);
+
+		// Call this when the receiver applied a snapshot, the later snapshots will only contain the changes relative to it
+		void Acknowledge(uint32_t snapshot_id);
+
+		// Forget all replication state, the next snapshot will contain the whole state
+		void Reset();
+
+		const Statistics& GetStatistics() const { return statistics; }
+
+	private:
+		struct TrackedComponent
+		{
+			wi::ecs::Entity entity = wi::ecs::INVALID_ENTITY;
+			uint32_t type = 0;
+			uint32_t changed_snapshot = 0; // the snapshot in which the component last changed (0: free slot)
+			uint32_t seen_snapshot = 0; // the last snapshot in which the component still existed
+			uint32_t written_snapshot = 0; // the last snapshot into which the component was written
+			uint64_t hash = 0; // hash of the serialized (or quantized) data
+		};
+		struct TrackedType
+		{
+			std::string name;
+			wi::ecs::ComponentManager_Interface* manager = nullptr;
+			bool transform = false;
+			uint64_t checked_version = 0; // manager version at the last change detection
+			wi::unordered_map<wi::ecs::Entity, uint32_t> lookup; // entity -> tracked component index
+		};
+		struct Change
+		{
+			uint32_t slot = 0;
+			uint32_t snapshot = 0;
+		};
+		struct Removal
+		{
+			wi::ecs::Entity entity = wi::ecs::INVALID_ENTITY;
+			uint32_t type = 0;
+			uint32_t snapshot = 0;
+		};
+		const Scene* tracked_scene = nullptr;
+		wi::vector<TrackedType> types;
+		wi::vector<TrackedComponent> slots;
+		wi::vector<uint32_t> free_slots;
+		wi::vector<Change> changes; // log of component changes in snapshot order
+		wi::vector<Removal> removals; // log of component removals in snapshot order
+		wi::vector<std::pair<uint64_t, uint32_t>> written; // temporary list of (type << 32 | component index, slot) to write
+		wi::Archive scratch;
+		uint32_t snapshot_id = 0;
+		uint32_t acknowledged_id = 0;
+		Statistics statistics;
+	};
+
+	// Applies the snapshots that were created by a SnapshotWriter to a scene
+	//	The entities of the writer are mapped to new entities in the receiving scene
+	class SnapshotReader
+	{
+	public:
+		// Applies the snapshot from the archive (which must be in read mode) to the scene
+		//	Snapshots can arrive out of order or get lost, but only snapshots that are newer than the last applied one
+		//	and whose baseline was already applied (or full snapshots) can be applied
+		//	snapshot_id	:	the id of the applied snapshot will be written here, this should be acknowledged to the writer
+		//	returns false if the snapshot can't be applied, because it is older than the last applied snapshot or its baseline wasn't applied
+		bool Apply(Scene& scene, wi::Archive& archive, uint32_t* snapshot_id = nullptr);
+
+		// Returns the local entity that corresponds to the entity of the writer, or INVALID_ENTITY if it wasn't replicated yet
+		wi::ecs::Entity GetLocalEntity(wi::ecs::Entity remote_entity) const;
+
+		uint32_t GetLastAppliedSnapshot() const { return last_applied_id; }
+
+	private:
+		wi::ecs::EntitySerializer seri; // keeps the entity remapping between snapshots
+		uint32_t last_applied_id = 0;
+	};
+}
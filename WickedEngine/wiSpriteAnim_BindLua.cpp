@@ -277,10 +277,9 @@ namespace wi::lua
 
 	void SpriteAnim_BindLua::Bind()
 	{
-		static bool initialized = false;
-		if (!initialized)
+		static const char binding_key = 0;
+		if (wi::lua::BeginBinding(&binding_key))
 		{
-			initialized = true;
 			Luna<SpriteAnim_BindLua>::Register(wi::lua::GetLuaState());
 			Luna<MovingTexAnim_BindLua>::Register(wi::lua::GetLuaState());
 			Luna<DrawRectAnim_BindLua>::Register(wi::lua::GetLuaState());
@@ -520,10 +520,9 @@ namespace wi::lua
 
 	void SpriteFont_BindLua::Bind()
 	{
-		static bool initialized = false;
-		if (!initialized)
+		static const char binding_key = 0;
+		if (wi::lua::BeginBinding(&binding_key))
 		{
-			initialized = true;
 			Luna<SpriteFont_BindLua>::Register(wi::lua::GetLuaState());
 
 			wi::lua::RunText(R"(
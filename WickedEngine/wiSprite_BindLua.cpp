@@ -178,10 +178,9 @@ namespace wi::lua
 
 	void Sprite_BindLua::Bind()
 	{
-		static bool initialized = false;
-		if (!initialized)
+		static const char binding_key = 0;
+		if (wi::lua::BeginBinding(&binding_key))
 		{
-			initialized = true;
 			Luna<Sprite_BindLua>::Register(wi::lua::GetLuaState());
 		}
 	}
@@ -252,10 +252,9 @@ namespace wi::lua
 
 	void Texture_BindLua::Bind()
 	{
-		static bool initialized = false;
-		if (!initialized)
+		static const char binding_key = 0;
+		if (wi::lua::BeginBinding(&binding_key))
 		{
-			initialized = true;
 			Luna<Texture_BindLua>::Register(wi::lua::GetLuaState());
 			Luna<Texture_BindLua>::push_global(wi::lua::GetLuaState(), "texturehelper");
 			wi::lua::RunText(R"(
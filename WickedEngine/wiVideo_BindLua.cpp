@@ -36,10 +36,9 @@ namespace wi::lua
 
 	void Video_BindLua::Bind()
 	{
-		static bool initialized = false;
-		if (!initialized)
+		static const char binding_key = 0;
+		if (wi::lua::BeginBinding(&binding_key))
 		{
-			initialized = true;
 			Luna<Video_BindLua>::Register(wi::lua::GetLuaState());
 		}
 	}
@@ -160,10 +159,9 @@ namespace wi::lua
 
 	void VideoInstance_BindLua::Bind()
 	{
-		static bool initialized = false;
-		if (!initialized)
+		static const char binding_key = 0;
+		if (wi::lua::BeginBinding(&binding_key))
 		{
-			initialized = true;
 			Luna<VideoInstance_BindLua>::Register(wi::lua::GetLuaState());
 		}
 	}
@@ -6,11 +6,19 @@
 
 #include "Utility/meshoptimizer/meshoptimizer.h"
 
+#include <atomic>
+
 using namespace wi::graphics;
 using namespace wi::primitive;
 
 namespace wi
 {
+	uint64_t VoxelGrid::InstanceID::next()
+	{
+		static std::atomic<uint64_t> next_id{ 1 };
+		return next_id.fetch_add(1, std::memory_order_relaxed);
+	}
+
 	void VoxelGrid::init(uint32_t dimX, uint32_t dimY, uint32_t dimZ)
 	{
 		resolution.x = std::max(4u, dimX);
@@ -24,10 +32,12 @@ namespace wi
 		resolution_rcp.z = 1.0f / resolution.z;
 		voxels.clear();
 		voxels.resize(resolution_div4.x * resolution_div4.y * resolution_div4.z);
+		version++;
 	}
 	void VoxelGrid::cleardata()
 	{
 		std::fill(voxels.begin(), voxels.end(), 0ull);
+		version++;
 	}
 
 	// 3D array index to flattened 1D array index
@@ -81,6 +91,7 @@ namespace wi
 		XMStoreUInt3(&maxi, MAX);
 
 		volatile long long* data = (volatile long long*)voxels.data();
+		AtomicAdd((volatile long long*)&version, 1ll); // injection can run on multiple threads
 		for (uint32_t x = mini.x; x < maxi.x; ++x)
 		{
 			for (uint32_t y = mini.y; y < maxi.y; ++y)
@@ -145,6 +156,7 @@ namespace wi
 		XMStoreFloat3(&aabb_src._max, MAX);
 
 		volatile long long* data = (volatile long long*)voxels.data();
+		AtomicAdd((volatile long long*)&version, 1ll);
 		for (uint32_t x = mini.x; x < maxi.x; ++x)
 		{
 			for (uint32_t y = mini.y; y < maxi.y; ++y)
@@ -204,6 +216,7 @@ namespace wi
 		XMStoreUInt3(&maxi, MAX);
 
 		volatile long long* data = (volatile long long*)voxels.data();
+		AtomicAdd((volatile long long*)&version, 1ll);
 		for (uint32_t x = mini.x; x < maxi.x; ++x)
 		{
 			for (uint32_t y = mini.y; y < maxi.y; ++y)
@@ -269,6 +282,7 @@ namespace wi
 		XMStoreUInt3(&maxi, MAX);
 
 		volatile long long* data = (volatile long long*)voxels.data();
+		AtomicAdd((volatile long long*)&version, 1ll);
 		for (uint32_t x = mini.x; x < maxi.x; ++x)
 		{
 			for (uint32_t y = mini.y; y < maxi.y; ++y)
@@ -392,6 +406,7 @@ namespace wi
 		{
 			voxels[idx] &= ~mask;
 		}
+		version++;
 	}
 	void VoxelGrid::set_voxel(const XMFLOAT3& worldpos, bool value)
 	{
@@ -563,6 +578,7 @@ namespace wi
 		{
 			voxels[i] |= other.voxels[i];
 		}
+		version++;
 	}
 	void VoxelGrid::subtract(const VoxelGrid& other)
 	{
@@ -575,6 +591,7 @@ namespace wi
 		{
 			voxels[i] &= ~other.voxels[i];
 		}
+		version++;
 	}
 	void VoxelGrid::flood_fill()
 	{
@@ -665,6 +682,7 @@ namespace wi
 			resolution_rcp.y = 1.0f / resolution.y;
 			resolution_rcp.z = 1.0f / resolution.z;
 			set_voxelsize(voxelSize);
+			version++;
 		}
 		else
 		{
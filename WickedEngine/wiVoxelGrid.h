@@ -22,6 +22,19 @@ namespace wi
 		XMUINT3 resolution_div4 = XMUINT3(0, 0, 0);
 		XMFLOAT3 resolution_rcp = XMFLOAT3(0, 0, 0);
 		wi::vector<uint64_t> voxels; // 1 array element stores 4 * 4 * 4 = 64 voxels
+		uint64_t version = 0; // incremented when the voxels are modified by the member functions, increment it manually when modifying the voxels directly
+
+		// Identifies the voxel grid object together with version, a copy receives a new id so it can't be mistaken for the original one
+		struct InstanceID
+		{
+			uint64_t value = next();
+			InstanceID() = default;
+			InstanceID(const InstanceID&) : value(next()) {}
+			InstanceID(InstanceID&& other) noexcept : value(other.value) { other.value = next(); }
+			InstanceID& operator=(const InstanceID&) { value = next(); return *this; }
+			InstanceID& operator=(InstanceID&& other) noexcept { value = other.value; other.value = next(); return *this; }
+			static uint64_t next();
+		} instance_id;
 
 		XMFLOAT3 center = XMFLOAT3(0, 0, 0);
 		XMFLOAT3 voxelSize = XMFLOAT3(0.25f, 0.25f, 0.25f);